@@ -0,0 +1,1093 @@
+#include "benchmarkclass.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <thread>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+// every allocation of the program on any thread, the replacements below count them.
+static std::atomic<long long> s_heapAllocations(0);
+static std::atomic<long long> s_heapBytes(0);
+
+static void* CountedAllocate(size_t size, size_t alignment)
+{
+	void* memory;
+
+	s_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+	s_heapBytes.fetch_add((long long)size, std::memory_order_relaxed);
+
+	size = size > 0 ? size : 1;
+	if(alignment <= alignof(std::max_align_t))
+	{
+		return malloc(size);
+	}
+
+#ifdef _WIN32
+	memory = _aligned_malloc(size, alignment);
+#else
+	if(posix_memalign(&memory, alignment, size) != 0)
+	{
+		memory = nullptr;
+	}
+#endif
+
+	return memory;
+}
+
+// the throwing forms are the ones everything else falls back on, the nothrow and array forms only need to be counted once through them.
+void* operator new(size_t size)
+{
+	void* memory;
+
+	memory = CountedAllocate(size, 0);
+	if(!memory)
+	{
+		throw std::bad_alloc();
+	}
+
+	return memory;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return CountedAllocate(size, 0);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return CountedAllocate(size, 0);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	void* memory;
+
+	memory = CountedAllocate(size, (size_t)alignment);
+	if(!memory)
+	{
+		throw std::bad_alloc();
+	}
+
+	return memory;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+	return;
+}
+
+void operator delete[](void* memory) noexcept
+{
+	free(memory);
+	return;
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+	return;
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	free(memory);
+	return;
+}
+
+void operator delete(void* memory, std::align_val_t alignment) noexcept
+{
+	// blocks with no more than the default alignment came from malloc.
+	if((size_t)alignment <= alignof(std::max_align_t))
+	{
+		free(memory);
+		return;
+	}
+
+#ifdef _WIN32
+	_aligned_free(memory);
+#else
+	free(memory);
+#endif
+
+	return;
+}
+
+void operator delete[](void* memory, std::align_val_t alignment) noexcept
+{
+	operator delete(memory, alignment);
+	return;
+}
+
+void operator delete(void* memory, size_t, std::align_val_t alignment) noexcept
+{
+	operator delete(memory, alignment);
+	return;
+}
+
+void operator delete[](void* memory, size_t, std::align_val_t alignment) noexcept
+{
+	operator delete(memory, alignment);
+	return;
+}
+
+static FILE* OpenFile(const char* filename, const char* mode)
+{
+	FILE* file;
+
+#ifdef _WIN32
+	if(fopen_s(&file, filename, mode) != 0)
+	{
+		file = nullptr;
+	}
+#else
+	file = fopen(filename, mode);
+#endif
+
+	return file;
+}
+
+// a json string, or null for a null pointer. scope and file names are all this has to escape.
+static void WriteString(FILE* file, const char* text)
+{
+	if(!text)
+	{
+		fprintf(file, "null");
+		return;
+	}
+
+	fputc('"', file);
+	for(; *text; text++)
+	{
+		if(*text == '"' || *text == '\\')
+		{
+			fputc('\\', file);
+		}
+		fputc(*text, file);
+	}
+	fputc('"', file);
+
+	return;
+}
+
+// the number after key, looking from the first place where section is found. only has to read reports WriteReport wrote.
+static bool FindNumber(const std::string& text, const std::string& section, const char* key, double& value)
+{
+	std::string quotedKey;
+	size_t position;
+
+	position = text.find(section);
+	if(position == std::string::npos)
+	{
+		return false;
+	}
+
+	quotedKey = std::string("\"") + key + "\":";
+	position = text.find(quotedKey, position);
+	if(position == std::string::npos)
+	{
+		return false;
+	}
+
+	value = strtod(text.c_str() + position + quotedKey.size(), nullptr);
+
+	return true;
+}
+
+BenchmarkClass::BenchmarkClass()
+{
+	GetDefaultSettings(m_settings);
+	m_Graphics = nullptr;
+	m_Profiler = nullptr;
+	m_Path = nullptr;
+	m_allocationFrames = 0;
+	m_allocations = 0;
+	m_allocatedBytes = 0;
+	memset(m_memory, 0, sizeof(m_memory));
+	memset(&m_import, 0, sizeof(m_import));
+	memset(&m_drawSort, 0, sizeof(m_drawSort));
+}
+
+BenchmarkClass::BenchmarkClass(const BenchmarkClass&)
+{
+}
+
+BenchmarkClass::~BenchmarkClass()
+{
+}
+
+void BenchmarkClass::GetDefaultSettings(SettingsType& settings)
+{
+	settings.screenWidth = BENCHMARK_SCREEN_WIDTH;
+	settings.screenHeight = BENCHMARK_SCREEN_HEIGHT;
+	settings.warmupFrames = BENCHMARK_WARMUP_FRAMES;
+	settings.frames = BENCHMARK_FRAMES;
+	settings.modelFilename = nullptr;
+	settings.sceneFilename = nullptr;
+	settings.gridSize = SCENE_GRID_SIZE;
+	settings.gridSpacing = SCENE_GRID_SPACING;
+	settings.pathFilename = nullptr;
+	settings.jobScaling = true;
+	settings.importFilename = nullptr;
+
+	return;
+}
+
+bool BenchmarkClass::Initialize(const SettingsType& settings)
+{
+	GraphicsClass::SceneDescType scene;
+	CameraPathClass::KeyType keys[8];
+	int keyCount;
+	bool result;
+
+	m_settings = settings;
+	if(m_settings.frames < 1 || m_settings.warmupFrames < 0)
+	{
+		return false;
+	}
+
+	GraphicsClass::GetDefaultSceneDesc(scene);
+	scene.modelFilename = m_settings.modelFilename;
+	scene.gridSize = m_settings.gridSize;
+	scene.gridSpacing = m_settings.gridSpacing;
+
+	if(m_settings.sceneFilename)
+	{
+		result = LoadScene(m_settings.sceneFilename);
+		if(!result)
+		{
+			fprintf(stderr, "could not load the scene %s\n", m_settings.sceneFilename);
+			return false;
+		}
+
+		scene.objects = m_objects.data();
+		scene.objectCount = (int)m_objects.size() / 4;
+	}
+
+	m_Path = new CameraPathClass;
+	if(!m_Path)
+	{
+		return false;
+	}
+
+	if(m_settings.pathFilename)
+	{
+		result = m_Path->Load(m_settings.pathFilename);
+		if(!result)
+		{
+			fprintf(stderr, "could not load the camera path %s\n", m_settings.pathFilename);
+			return false;
+		}
+	} else
+	{
+		MakePath(scene, keys, keyCount);
+		result = m_Path->Initialize(keys, keyCount);
+		if(!result)
+		{
+			return false;
+		}
+	}
+
+	// the profiler is there before the graphics obj starts any of the threads that record into it.
+	m_Profiler = new ProfilerClass;
+	if(!m_Profiler)
+	{
+		return false;
+	}
+
+	result = m_Profiler->Initialize();
+	if(!result)
+	{
+		return false;
+	}
+
+	// no window, so graphics class draws with the software rasterizer.
+	m_Graphics = new GraphicsClass;
+	if(!m_Graphics)
+	{
+		return false;
+	}
+
+	result = m_Graphics->Initialize(m_settings.screenWidth, m_settings.screenHeight, NULL, nullptr, &scene);
+	if(!result)
+	{
+		fprintf(stderr, "could not initialize the graphics object\n");
+		return false;
+	}
+
+	return true;
+}
+
+void BenchmarkClass::Shutdown()
+{
+	if(m_Graphics)
+	{
+		m_Graphics->Shutdown();
+		delete m_Graphics;
+		m_Graphics = nullptr;
+	}
+
+	if(m_Profiler)
+	{
+		m_Profiler->Shutdown();
+		delete m_Profiler;
+		m_Profiler = nullptr;
+	}
+
+	if(m_Path)
+	{
+		m_Path->Shutdown();
+		delete m_Path;
+		m_Path = nullptr;
+	}
+
+	m_objects.clear();
+
+	return;
+}
+
+bool BenchmarkClass::Run()
+{
+	double profileDuration;
+	int profileFrames;
+	bool result;
+
+	// the warmup holds the camera at the start of the path, the timed flight starts from a settled first frame.
+	fprintf(stderr, "warming up, %d frames\n", m_settings.warmupFrames);
+	result = Fly(m_settings.warmupFrames, 0.0f, 0.0f, false);
+	if(!result)
+	{
+		return false;
+	}
+
+	fprintf(stderr, "timing, %d frames\n", m_settings.frames);
+	result = Fly(m_settings.frames, 0.0f, 1.0f, true);
+	if(!result)
+	{
+		return false;
+	}
+
+	m_sortedFrameTimes = m_frameTimes;
+	std::sort(m_sortedFrameTimes.begin(), m_sortedFrameTimes.end());
+
+	fprintf(stderr, "counting allocations, %d frames\n", std::min(m_settings.frames, BENCHMARK_ALLOCATION_FRAMES));
+	result = CountAllocations();
+	if(!result)
+	{
+		return false;
+	}
+
+	// the same path once more in a few frames, with the markers recording.
+	fprintf(stderr, "profiling, %d frames\n", BENCHMARK_PROFILE_FRAMES);
+	m_Profiler->BeginCapture(BENCHMARK_PROFILE_FRAMES);
+	result = Fly(BENCHMARK_PROFILE_FRAMES, 0.0f, 1.0f, false);
+	if(!result)
+	{
+		return false;
+	}
+
+	result = m_Profiler->GetSummary(m_stages, profileFrames, profileDuration);
+	if(!result)
+	{
+		return false;
+	}
+
+	if(m_settings.jobScaling)
+	{
+		fprintf(stderr, "measuring job system scaling\n");
+		result = MeasureScaling();
+		if(!result)
+		{
+			return false;
+		}
+	}
+
+	fprintf(stderr, "sorting %d draw packets\n", BENCHMARK_DRAW_SORT_PACKETS);
+	result = MeasureDrawSort();
+	if(!result)
+	{
+		return false;
+	}
+
+	if(m_settings.importFilename)
+	{
+		fprintf(stderr, "importing %s, %d times\n", m_settings.importFilename, BENCHMARK_IMPORT_REPEATS);
+		result = MeasureImport();
+		if(!result)
+		{
+			fprintf(stderr, "could not import %s\n", m_settings.importFilename);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool BenchmarkClass::WriteReport(const char* filename)
+{
+	FILE* file;
+	size_t i;
+
+	if(m_sortedFrameTimes.empty())
+	{
+		return false;
+	}
+
+	if(filename)
+	{
+		file = OpenFile(filename, "w");
+		if(!file)
+		{
+			return false;
+		}
+	} else
+	{
+		file = stdout;
+	}
+
+	// every time is in milliseconds. a debug build's numbers are not comparable to a release build's, so the build is part of the report.
+	fprintf(file, "{\n");
+	fprintf(file, "  \"version\": %d,\n", BENCHMARK_FORMAT_VERSION);
+#ifdef _DEBUG
+	fprintf(file, "  \"build\": \"debug\",\n");
+#else
+	fprintf(file, "  \"build\": \"release\",\n");
+#endif
+	fprintf(file, "  \"settings\": {\n");
+	fprintf(file, "    \"screenWidth\": %d,\n", m_settings.screenWidth);
+	fprintf(file, "    \"screenHeight\": %d,\n", m_settings.screenHeight);
+	fprintf(file, "    \"warmupFrames\": %d,\n", m_settings.warmupFrames);
+	fprintf(file, "    \"frames\": %d,\n", m_settings.frames);
+	fprintf(file, "    \"model\": ");
+	WriteString(file, m_settings.modelFilename);
+	fprintf(file, ",\n    \"scene\": ");
+	WriteString(file, m_settings.sceneFilename);
+	fprintf(file, ",\n    \"objects\": %d,\n", GetObjectCount());
+	fprintf(file, "    \"path\": ");
+	WriteString(file, m_settings.pathFilename);
+	fprintf(file, ",\n    \"import\": ");
+	WriteString(file, m_settings.importFilename);
+	fprintf(file, ",\n    \"cores\": %u\n", std::thread::hardware_concurrency());
+	fprintf(file, "  },\n");
+
+	fprintf(file, "  \"frameTime\": {\n");
+	fprintf(file, "    \"min\": %.4f,\n", m_sortedFrameTimes.front());
+	fprintf(file, "    \"mean\": %.4f,\n", GetFrameTime(-1.0));
+	fprintf(file, "    \"p50\": %.4f,\n", GetFrameTime(50.0));
+	fprintf(file, "    \"p90\": %.4f,\n", GetFrameTime(90.0));
+	fprintf(file, "    \"p95\": %.4f,\n", GetFrameTime(95.0));
+	fprintf(file, "    \"p99\": %.4f,\n", GetFrameTime(99.0));
+	fprintf(file, "    \"max\": %.4f\n", m_sortedFrameTimes.back());
+	fprintf(file, "  },\n");
+
+	// inclusive like the profiler's summary, most time per frame first.
+	fprintf(file, "  \"stages\": [");
+	for(i = 0; i < m_stages.size(); i++)
+	{
+		fprintf(file, "%s\n    {\"name\": ", i == 0 ? "" : ",");
+		WriteString(file, m_stages[i].name.c_str());
+		fprintf(file, ", \"calls\": %d, \"callsPerFrame\": %.1f, \"mean\": %.4f, \"p99\": %.4f, \"totalPerFrame\": %.4f}", m_stages[i].calls,
+			m_stages[i].callsPerFrame, m_stages[i].mean, m_stages[i].p99, m_stages[i].totalPerFrame);
+	}
+	fprintf(file, "\n  ],\n");
+
+	// blocks of the engine's heap by subsystem, as they were after the allocation flight.
+	fprintf(file, "  \"allocations\": {\"frames\": %d, \"count\": %lld, \"bytes\": %lld},\n", m_allocationFrames, m_allocations, m_allocatedBytes);
+	fprintf(file, "  \"memory\": [");
+	for(i = 0; i < (size_t)MEMORY_TAG_COUNT; i++)
+	{
+		fprintf(file, "%s\n    {\"tag\": ", i == 0 ? "" : ",");
+		WriteString(file, MemoryClass::GetTagName((MemoryTagType)i));
+		fprintf(file, ", \"bytes\": %lld, \"peakBytes\": %lld, \"allocations\": %lld, \"totalAllocations\": %lld}", m_memory[i].bytes,
+			m_memory[i].peakBytes, m_memory[i].allocations, m_memory[i].totalAllocations);
+	}
+	fprintf(file, "\n  ],\n");
+
+	// parse covers parsing and welding, total adds reading the source. nothing is cooked, the optimizer's cache miss ratios are of a separate run.
+	if(m_settings.importFilename)
+	{
+		fprintf(file, "  \"import\": {\"sourceBytes\": %llu, \"sourceVertices\": %u, \"vertices\": %u, \"indices\": %u, \"parse\": %.4f, \"total\": %.4f, "
+			"\"megabytesPerSecond\": %.1f, \"acmrBefore\": %.3f, \"acmrAfter\": %.3f, \"atvrBefore\": %.3f, \"atvrAfter\": %.3f},\n", m_import.sourceBytes,
+			m_import.sourceVertices, m_import.vertices, m_import.indices, m_import.parseSeconds * 1000.0, m_import.totalSeconds * 1000.0,
+			m_import.megabytesPerSecond, m_import.acmrBefore, m_import.acmrAfter, m_import.atvrBefore, m_import.atvrAfter);
+	}
+
+	fprintf(file, "  \"drawSort\": {\"packets\": %d, \"depth\": %.4f, \"typical\": %.4f, \"random\": %.4f},\n", BENCHMARK_DRAW_SORT_PACKETS,
+		m_drawSort.depth, m_drawSort.typical, m_drawSort.random);
+
+	fprintf(file, "  \"jobScaling\": [");
+	for(i = 0; i < m_scaling.size(); i++)
+	{
+		fprintf(file, "%s\n    {\"threads\": %d, \"time\": %.4f, \"speedup\": %.2f, \"emptyJobNs\": %.1f, \"roundTripNs\": %.1f, \"nestedJobNs\": %.1f}",
+			i == 0 ? "" : ",", m_scaling[i].threadCount, m_scaling[i].time, m_scaling[0].time / m_scaling[i].time, m_scaling[i].emptyJob,
+			m_scaling[i].roundTrip, m_scaling[i].nestedJob);
+	}
+	fprintf(file, "\n  ]\n");
+	fprintf(file, "}\n");
+
+	if(file == stdout)
+	{
+		fflush(file);
+		return true;
+	}
+
+	if(fclose(file) != 0)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+bool BenchmarkClass::CompareBaseline(const char* filename, float tolerance, bool& regressed)
+{
+	static const char* const frameTimeKeys[] = { "mean", "p50", "p90", "p95", "p99" };
+	std::string text;
+	FILE* file;
+	char buffer[4096];
+	double baseline, current, version, frames;
+	size_t length, i;
+
+	regressed = false;
+
+	file = OpenFile(filename, "r");
+	if(!file)
+	{
+		return false;
+	}
+
+	while((length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		text.append(buffer, length);
+	}
+	fclose(file);
+
+	// reports of another format are not compared at all, the numbers may mean something else.
+	if(!FindNumber(text, "{", "version", version) || (int)version != BENCHMARK_FORMAT_VERSION)
+	{
+		fprintf(stderr, "%s is not a version %d report\n", filename, BENCHMARK_FORMAT_VERSION);
+		return false;
+	}
+
+	// runs of different sizes still get compared, but not silently.
+	if(!FindNumber(text, "\"settings\"", "screenWidth", baseline) || (int)baseline != m_settings.screenWidth ||
+		!FindNumber(text, "\"settings\"", "screenHeight", baseline) || (int)baseline != m_settings.screenHeight ||
+		!FindNumber(text, "\"settings\"", "frames", baseline) || (int)baseline != m_settings.frames ||
+		!FindNumber(text, "\"settings\"", "objects", baseline) || (int)baseline != GetObjectCount())
+	{
+		fprintf(stderr, "%s was run with other settings, the numbers may not be comparable\n", filename);
+	}
+
+	fprintf(stderr, "%-48s %12s %12s %8s\n", "frame time", "baseline ms", "current ms", "change");
+	for(i = 0; i < sizeof(frameTimeKeys) / sizeof(frameTimeKeys[0]); i++)
+	{
+		if(!FindNumber(text, "\"frameTime\"", frameTimeKeys[i], baseline))
+		{
+			return false;
+		}
+
+		current = strcmp(frameTimeKeys[i], "mean") == 0 ? GetFrameTime(-1.0) : GetFrameTime(atof(frameTimeKeys[i] + 1));
+		fprintf(stderr, "%-48s %12.4f %12.4f %+7.1f%%%s\n", frameTimeKeys[i], baseline, current, (current / baseline - 1.0) * 100.0,
+			current > baseline * (1.0 + tolerance) ? " regressed" : "");
+		if(current > baseline * (1.0 + tolerance))
+		{
+			regressed = true;
+		}
+	}
+
+	// stages the baseline did not have, or that are gone now, are left out.
+	fprintf(stderr, "%-48s %12s %12s %8s\n", "stage total per frame", "baseline ms", "current ms", "change");
+	for(i = 0; i < m_stages.size(); i++)
+	{
+		if(!FindNumber(text, "\"name\": \"" + m_stages[i].name + "\"", "totalPerFrame", baseline))
+		{
+			continue;
+		}
+
+		current = m_stages[i].totalPerFrame;
+		fprintf(stderr, "%-48s %12.4f %12.4f %+7.1f%%\n", m_stages[i].name.c_str(), baseline, current, baseline > 0.0 ? (current / baseline - 1.0) * 100.0 : 0.0);
+	}
+
+	// per frame, the allocation flights of the two runs may not have been equally long. reports from before it was counted have none.
+	if(FindNumber(text, "\"allocations\"", "count", baseline) && FindNumber(text, "\"allocations\"", "frames", frames) && frames > 0.0)
+	{
+		baseline /= frames;
+		current = m_allocationFrames > 0 ? (double)m_allocations / (double)m_allocationFrames : 0.0;
+		fprintf(stderr, "%-48s %12.2f %12.2f%s\n", "heap allocations per frame", baseline, current, current > baseline ? " regressed" : "");
+		if(current > baseline)
+		{
+			regressed = true;
+		}
+	}
+
+	return true;
+}
+
+bool BenchmarkClass::LoadScene(const char* filename)
+{
+	FILE* file;
+	char line[256];
+	float x, y, z, scale;
+
+	file = OpenFile(filename, "r");
+	if(!file)
+	{
+		return false;
+	}
+
+	m_objects.clear();
+	while(fgets(line, sizeof(line), file))
+	{
+		if(line[0] == '#')
+		{
+			continue;
+		}
+
+		if(sscanf(line, "%f %f %f %f", &x, &y, &z, &scale) == 4)
+		{
+			m_objects.push_back(x);
+			m_objects.push_back(y);
+			m_objects.push_back(z);
+			m_objects.push_back(scale);
+		}
+	}
+
+	fclose(file);
+
+	return !m_objects.empty();
+}
+
+void BenchmarkClass::MakePath(const GraphicsClass::SceneDescType& scene, CameraPathClass::KeyType* keys, int& keyCount)
+{
+	static const float shape[8][6] =
+	{
+		// x and z across the scene's bounds, height in units of its size, then the rotation in degrees.
+		{  0.5f, -0.2f, 0.3f,  25.0f,   0.0f, 0.0f },
+		{  0.8f,  0.2f, 0.1f,  15.0f, -30.0f, 0.0f },
+		{  0.2f,  0.4f, 0.05f,  5.0f,  30.0f, 0.0f },
+		{  0.5f,  0.6f, 0.02f,  0.0f,   0.0f, 0.0f },
+		{  0.8f,  0.9f, 0.1f,  20.0f, -90.0f, 0.0f },
+		{  0.5f,  1.1f, 0.3f,  30.0f, -180.0f, 0.0f },
+		{  0.2f,  0.6f, 0.6f,  60.0f, -200.0f, 0.0f },
+		{  0.5f,  0.3f, 0.8f,  80.0f, -180.0f, 0.0f }
+	};
+	float minX, maxX, minZ, maxZ, size;
+	int i;
+
+	// the grid's bounds, or the recorded objects'.
+	if(scene.objects)
+	{
+		minX = maxX = scene.objects[0];
+		minZ = maxZ = scene.objects[2];
+		for(i = 1; i < scene.objectCount; i++)
+		{
+			minX = std::min(minX, scene.objects[i * 4 + 0]);
+			maxX = std::max(maxX, scene.objects[i * 4 + 0]);
+			minZ = std::min(minZ, scene.objects[i * 4 + 2]);
+			maxZ = std::max(maxZ, scene.objects[i * 4 + 2]);
+		}
+	} else
+	{
+		maxX = (scene.gridSize - 1) * 0.5f * scene.gridSpacing;
+		minX = -maxX;
+		minZ = 0.0f;
+		maxZ = (scene.gridSize - 1) * scene.gridSpacing;
+	}
+
+	// in from behind the scene, low along it, a turn at the far end and back over it looking down more and more.
+	size = std::max(std::max(maxX - minX, maxZ - minZ), 1.0f);
+	for(i = 0; i < 8; i++)
+	{
+		keys[i].position = XMFLOAT3(minX + shape[i][0] * (maxX - minX), 1.0f + shape[i][2] * size, minZ + shape[i][1] * (maxZ - minZ));
+		keys[i].rotation = XMFLOAT3(shape[i][3], shape[i][4], shape[i][5]);
+	}
+	keyCount = 8;
+
+	return;
+}
+
+bool BenchmarkClass::Fly(int frameCount, float startTime, float endTime, bool measure)
+{
+	std::chrono::steady_clock::time_point begin, end;
+	CameraPathClass::KeyType key;
+	CameraClass* camera;
+	float time;
+	int i;
+	bool result;
+
+	if(measure)
+	{
+		m_frameTimes.clear();
+		m_frameTimes.reserve(frameCount);
+	}
+
+	camera = m_Graphics->GetCamera();
+	for(i = 0; i < frameCount; i++)
+	{
+		// by frame and not by time, the same frames are drawn however long they take.
+		time = frameCount > 1 ? startTime + (endTime - startTime) * (float)i / (float)(frameCount - 1) : startTime;
+		m_Path->GetKey(time, key);
+		camera->SetPosition(key.position.x, key.position.y, key.position.z);
+		camera->SetRotation(key.rotation.x, key.rotation.y, key.rotation.z);
+
+		m_Profiler->BeginFrame();
+		begin = std::chrono::steady_clock::now();
+		result = m_Graphics->Frame();
+		end = std::chrono::steady_clock::now();
+		m_Profiler->EndFrame();
+		if(!result)
+		{
+			return false;
+		}
+
+		if(measure)
+		{
+			m_frameTimes.push_back(std::chrono::duration<double, std::milli>(end - begin).count());
+		}
+	}
+
+	return true;
+}
+
+bool BenchmarkClass::CountAllocations()
+{
+	long long allocations, bytes;
+	float time;
+	int i, frame;
+	bool result;
+
+	m_allocationFrames = std::min(m_settings.frames, BENCHMARK_ALLOCATION_FRAMES);
+
+	// frames picked evenly from the timed flight's, the camera is exactly where it was for them.
+	allocations = s_heapAllocations.load();
+	bytes = s_heapBytes.load();
+	for(i = 0; i < m_allocationFrames; i++)
+	{
+		frame = m_allocationFrames > 1 ? (int)((long long)i * (m_settings.frames - 1) / (m_allocationFrames - 1)) : 0;
+		time = m_settings.frames > 1 ? (float)frame / (float)(m_settings.frames - 1) : 0.0f;
+
+		result = Fly(1, time, time, false);
+		if(!result)
+		{
+			return false;
+		}
+	}
+	m_allocations = s_heapAllocations.load() - allocations;
+	m_allocatedBytes = s_heapBytes.load() - bytes;
+
+	for(i = 0; i < MEMORY_TAG_COUNT; i++)
+	{
+		MemoryClass::GetStatistics((MemoryTagType)i, m_memory[i]);
+	}
+
+	return true;
+}
+
+long long BenchmarkClass::GetSteadyStateAllocations()
+{
+	return m_allocations;
+}
+
+// the median of repeats of function, in milliseconds.
+template<typename FunctionType>
+static double MedianTime(const FunctionType& function)
+{
+	std::chrono::steady_clock::time_point begin, end;
+	double times[BENCHMARK_JOB_REPEATS];
+	int repeat;
+
+	for(repeat = 0; repeat < BENCHMARK_JOB_REPEATS; repeat++)
+	{
+		begin = std::chrono::steady_clock::now();
+		function();
+		end = std::chrono::steady_clock::now();
+		times[repeat] = std::chrono::duration<double, std::milli>(end - begin).count();
+	}
+
+	std::sort(times, times + BENCHMARK_JOB_REPEATS);
+
+	return times[BENCHMARK_JOB_REPEATS / 2];
+}
+
+static void EmptyJob(void*, int, int)
+{
+	return;
+}
+
+bool BenchmarkClass::MeasureScaling()
+{
+	std::vector<float> input, output;
+	std::vector<int> threadCounts;
+	std::thread thread;
+	int i;
+	bool result;
+
+	input.resize(BENCHMARK_JOB_ITEMS);
+	output.resize(BENCHMARK_JOB_ITEMS);
+	for(i = 0; i < BENCHMARK_JOB_ITEMS; i++)
+	{
+		input[i] = (float)(i % 1000) + 1.0f;
+	}
+
+	// one, two, four and so on. past the core count the threads share cores, which shows what oversubscription costs.
+	for(i = 1; i <= BENCHMARK_JOB_MAX_THREADS; i *= 2)
+	{
+		threadCounts.push_back(i);
+	}
+
+	// a thread belongs to one job system only and this one is the graphics obj's, so the systems under test are driven from a thread of their own.
+	m_scaling.clear();
+	result = true;
+	thread = std::thread([&]()
+	{
+		JobSystemClass jobSystem;
+		ScalingType scaling;
+		size_t j;
+
+		for(j = 0; j < threadCounts.size(); j++)
+		{
+			if(!jobSystem.Initialize(threadCounts[j]))
+			{
+				result = false;
+				return;
+			}
+
+			scaling.threadCount = threadCounts[j];
+
+			// a fixed amount of arithmetic per item and nothing shared, so the only limits are the cores and the scheduling.
+			scaling.time = MedianTime([&]()
+			{
+				jobSystem.ParallelFor(BENCHMARK_JOB_ITEMS, 0, [&](int first, int last)
+				{
+					float value;
+					int item, k;
+
+					for(item = first; item < last; item++)
+					{
+						value = input[item];
+						for(k = 0; k < 32; k++)
+						{
+							value = sqrtf(value * value + 1.0f) * 0.5f + 1.0f;
+						}
+						output[item] = value;
+					}
+				});
+			});
+
+			// the rest only schedule, what a job costs is the time over the number of jobs.
+			// every index is a job of its own, split off and pushed, popped or stolen and counted down. one thread calls the function directly.
+			scaling.emptyJob = MedianTime([&]()
+			{
+				jobSystem.ParallelFor(BENCHMARK_EMPTY_JOBS, 1, EmptyJob, nullptr);
+			}) * 1.0e6 / BENCHMARK_EMPTY_JOBS;
+
+			// one job queued and waited for at a time, the latency of handing out work too small to split.
+			scaling.roundTrip = MedianTime([&]()
+			{
+				JobSystemClass::CounterType counter(0);
+				int k;
+
+				for(k = 0; k < BENCHMARK_ROUND_TRIPS; k++)
+				{
+					jobSystem.Run(EmptyJob, nullptr, 0, 1, 1, &counter);
+					jobSystem.Wait(&counter);
+				}
+			}) * 1.0e6 / BENCHMARK_ROUND_TRIPS;
+
+			// jobs that run a ParallelFor of their own and wait for it inside the job, the way the culling and recording stages nest.
+			scaling.nestedJob = MedianTime([&]()
+			{
+				jobSystem.ParallelFor(BENCHMARK_NESTED_JOBS, 1, [&](int first, int last)
+				{
+					int k;
+
+					for(k = first; k < last; k++)
+					{
+						jobSystem.ParallelFor(BENCHMARK_NESTED_JOBS, 1, EmptyJob, nullptr);
+					}
+				});
+			}) * 1.0e6 / ((double)BENCHMARK_NESTED_JOBS * BENCHMARK_NESTED_JOBS);
+
+			jobSystem.Shutdown();
+
+			m_scaling.push_back(scaling);
+		}
+	});
+	thread.join();
+
+	return result;
+}
+
+bool BenchmarkClass::MeasureImport()
+{
+	std::vector<MeshImporterClass::StatisticsType> imports;
+	std::vector<MeshImporterClass::VertexType> vertices;
+	std::vector<unsigned int> indices;
+	MeshImporterClass::StatisticsType statistics;
+	MeshImporterClass importer;
+	int repeat;
+	bool result;
+
+	if(!MeshImporterClass::IsSupported(m_settings.importFilename))
+	{
+		return false;
+	}
+
+	// parsed on the same threads the mesh loaders hand their sources to.
+	result = importer.Initialize(m_Graphics->GetJobSystem());
+	if(!result)
+	{
+		return false;
+	}
+
+	// Import never looks at the cooked file, every repeat parses the source. the first one also brings the file into the os cache.
+	for(repeat = 0; repeat < BENCHMARK_IMPORT_REPEATS; repeat++)
+	{
+		vertices.clear();
+		indices.clear();
+		result = importer.Import(m_settings.importFilename, vertices, indices);
+		if(!result)
+		{
+			importer.Shutdown();
+			return false;
+		}
+
+		importer.GetStatistics(statistics);
+		imports.push_back(statistics);
+	}
+
+	// the last import optimized once the way it would be cooked, outside the timings, for what that does to the vertex cache.
+	result = importer.Optimize(vertices, indices);
+	importer.GetStatistics(statistics);
+	importer.Shutdown();
+	if(!result)
+	{
+		return false;
+	}
+
+	std::sort(imports.begin(), imports.end(), [](const MeshImporterClass::StatisticsType& a, const MeshImporterClass::StatisticsType& b)
+	{
+		return a.parseSeconds < b.parseSeconds;
+	});
+	m_import = imports[imports.size() / 2];
+	m_import.acmrBefore = statistics.acmrBefore;
+	m_import.acmrAfter = statistics.acmrAfter;
+	m_import.atvrBefore = statistics.atvrBefore;
+	m_import.atvrAfter = statistics.atvrAfter;
+
+	return true;
+}
+
+bool BenchmarkClass::MeasureDrawSort()
+{
+	std::thread thread;
+	bool result;
+
+	// one thread, so the time is the sort's own and not how many cores there are.
+	// like the scaling test's systems this one is driven from a thread of its own.
+	result = true;
+	thread = std::thread([&]()
+	{
+		JobSystemClass jobSystem;
+		DrawListClass drawList;
+		std::mt19937_64 random(1);
+		double* times[3];
+		int keySet, i;
+
+		if(!jobSystem.Initialize(1) || !drawList.Initialize(BENCHMARK_DRAW_SORT_PACKETS, &jobSystem))
+		{
+			result = false;
+			return;
+		}
+
+		times[0] = &m_drawSort.depth;
+		times[1] = &m_drawSort.typical;
+		times[2] = &m_drawSort.random;
+		for(keySet = 0; keySet < 3; keySet++)
+		{
+			drawList.Clear();
+			for(i = 0; i < BENCHMARK_DRAW_SORT_PACKETS; i++)
+			{
+				switch(keySet)
+				{
+					case 0:
+						drawList.Add(DrawListClass::MakeKey(DRAW_LAYER_OPAQUE, 3, 0, (float)(random() % 100000) / 100000.0f, 0), 3, 0, i);
+						break;
+					case 1:
+						drawList.Add(DrawListClass::MakeKey((unsigned int)(random() % 2), (unsigned int)(random() % 16), (unsigned int)(random() % 256),
+							(float)(random() % 100000) / 100000.0f, (unsigned int)(random() % 256)), 0, 0, i);
+						break;
+					case 2:
+						drawList.Add(random(), 0, 0, i);
+						break;
+				}
+			}
+
+			// every sort starts from the keys in the order they were added, the same list can be sorted again and again.
+			*times[keySet] = MedianTime([&]()
+			{
+				drawList.Sort();
+			});
+		}
+
+		drawList.Shutdown();
+		jobSystem.Shutdown();
+	});
+	thread.join();
+
+	return result;
+}
+
+int BenchmarkClass::GetObjectCount()
+{
+	return m_settings.sceneFilename ? (int)m_objects.size() / 4 : m_settings.gridSize * m_settings.gridSize;
+}
+
+double BenchmarkClass::GetFrameTime(double percentile)
+{
+	double total;
+	size_t i;
+
+	// a negative percentile is the mean.
+	if(percentile < 0.0)
+	{
+		total = 0.0;
+		for(i = 0; i < m_sortedFrameTimes.size(); i++)
+		{
+			total += m_sortedFrameTimes[i];
+		}
+		return total / (double)m_sortedFrameTimes.size();
+	}
+
+	// nearest rank, the smallest time that percentile of the frames are at or below.
+	i = (size_t)ceil(percentile / 100.0 * (double)m_sortedFrameTimes.size());
+	if(i > 0)
+	{
+		i--;
+	}
+	if(i >= m_sortedFrameTimes.size())
+	{
+		i = m_sortedFrameTimes.size() - 1;
+	}
+
+	return m_sortedFrameTimes[i];
+}
@@ -0,0 +1,151 @@
+#pragma once
+#ifndef _BENCHMARKCLASS_H_
+#define _BENCHMARKCLASS_H_
+
+#include <string>
+#include <vector>
+
+#include "graphicsclass.h"
+#include "profilerclass.h"
+#include "camerapathclass.h"
+
+// goes up whenever the report changes in a way that makes older reports incomparable.
+const int BENCHMARK_FORMAT_VERSION = 1;
+const int BENCHMARK_SCREEN_WIDTH = 1280;
+const int BENCHMARK_SCREEN_HEIGHT = 720;
+// frames drawn before the measured ones, at the start of the path, for caches, the shader cache and streaming to settle.
+const int BENCHMARK_WARMUP_FRAMES = 60;
+const int BENCHMARK_FRAMES = 1000;
+// frames of the separate profiled flight the stage costs come from. markers cost time, so the timed flight runs without them,
+// and every thread's ring has to hold all of these frames' scopes.
+const int BENCHMARK_PROFILE_FRAMES = 10;
+// a frame time percentile more than this fraction above the baseline's is a regression. stage costs are only printed next to
+// the baseline's, a few profiled frames are too noisy to fail a run on.
+const float BENCHMARK_TOLERANCE = 0.1f;
+// work items and repeats of the job system scaling test, the median repeat is reported.
+const int BENCHMARK_JOB_ITEMS = 1 << 18;
+const int BENCHMARK_JOB_REPEATS = 9;
+// the job system is measured with 1, 2, 4 and so on up to this many threads, however many cores there are.
+const int BENCHMARK_JOB_MAX_THREADS = 64;
+// jobs that do nothing, run by one ParallelFor with a grain of 1.
+const int BENCHMARK_EMPTY_JOBS = 1 << 14;
+// single Run and Wait pairs from the thread that owns the system.
+const int BENCHMARK_ROUND_TRIPS = 4096;
+// outer ranges of the nested test, each running a ParallelFor over as many empty jobs of its own.
+const int BENCHMARK_NESTED_JOBS = 128;
+// imports of the import test, the median parse time is reported.
+const int BENCHMARK_IMPORT_REPEATS = 5;
+// packets of the draw list sort test, sorted on one thread, the median repeat is reported.
+const int BENCHMARK_DRAW_SORT_PACKETS = 100000;
+// frames of the timed flight drawn once more while heap allocations are counted. by then every grow only buffer
+// has seen these frames, so a frame that still allocates is one that allocates every time.
+const int BENCHMARK_ALLOCATION_FRAMES = 100;
+
+/*
+ * flies the camera along a scripted path through a scene and reports what the frames cost, as json.
+ * graphics class is driven without a window, so it draws with the software rasterizer and runs the same culling, sorting
+ * and recording stages the device does. the path is played back by frame and not by time, every run draws the same frames.
+ * the report has the frame time percentiles of the timed flight, the per stage costs of a short profiled flight
+ * and how the job system scales with its thread count and what scheduling a job costs, and what sorting a long draw list costs.
+ * an obj or gltf file can be given to time the mesh importer on, parsed straight from the source every time without the cooked cache.
+ * an earlier report can be given as the baseline to compare against.
+ * the program replaces the global operator new to count what the frames allocate. after the timed flight some of its frames
+ * are drawn again, anything they take from the heap is a steady state allocation and is reported along with MemoryClass's tags.
+ */
+class BenchmarkClass
+{
+public:
+	struct SettingsType
+	{
+		int screenWidth;
+		int screenHeight;
+		int warmupFrames;
+		int frames;
+		// mesh file every object draws, null for the built in triangle.
+		const char* modelFilename;
+		// a recorded scene, a text file with an object per line as position x y z and scale. null lays out a grid.
+		const char* sceneFilename;
+		int gridSize;
+		float gridSpacing;
+		// see CameraPathClass::Load, null flies the built in path over the grid.
+		const char* pathFilename;
+		bool jobScaling;
+		// an obj or gltf file the importer is timed on, null skips the import test.
+		const char* importFilename;
+	};
+
+public:
+	BenchmarkClass();
+	BenchmarkClass(const BenchmarkClass&);
+	~BenchmarkClass();
+
+	static void GetDefaultSettings(SettingsType& settings);
+
+	bool Initialize(const SettingsType& settings);
+	void Shutdown();
+
+	bool Run();
+
+	// null writes to stdout.
+	bool WriteReport(const char* filename);
+	// prints every compared value to stderr, regressed is set when any of them is worse than the tolerance allows
+	// or when the frames allocate more often than the baseline's did.
+	bool CompareBaseline(const char* filename, float tolerance, bool& regressed);
+
+	// heap allocations of the frames drawn again after the timed flight, 0 when the frame loop never touches the heap.
+	long long GetSteadyStateAllocations();
+
+private:
+	// milliseconds of the scaling test, nanoseconds per job of the overhead tests.
+	struct ScalingType
+	{
+		int threadCount;
+		double time;
+		double emptyJob;
+		double roundTrip;
+		double nestedJob;
+	};
+
+	// milliseconds per sort, of keys that only differ in depth as graphics class makes them so far, of keys with every field in use
+	// and of random ones.
+	struct DrawSortType
+	{
+		double depth;
+		double typical;
+		double random;
+	};
+
+	bool LoadScene(const char* filename);
+	void MakePath(const GraphicsClass::SceneDescType& scene, CameraPathClass::KeyType* keys, int& keyCount);
+	bool Fly(int frameCount, float startTime, float endTime, bool measure);
+	bool CountAllocations();
+	bool MeasureScaling();
+	bool MeasureImport();
+	bool MeasureDrawSort();
+	int GetObjectCount();
+	double GetFrameTime(double percentile);
+
+private:
+	SettingsType m_settings;
+	std::vector<float> m_objects;
+	GraphicsClass* m_Graphics;
+	ProfilerClass* m_Profiler;
+	CameraPathClass* m_Path;
+
+	// milliseconds, of the timed flight's frames in the order they were drawn and sorted.
+	std::vector<double> m_frameTimes;
+	std::vector<double> m_sortedFrameTimes;
+	std::vector<ProfilerClass::ScopeType> m_stages;
+	std::vector<ScalingType> m_scaling;
+	DrawSortType m_drawSort;
+	// the import with the median parse time.
+	MeshImporterClass::StatisticsType m_import;
+
+	// what the allocation flight took from the heap, and MemoryClass's statistics after it.
+	int m_allocationFrames;
+	long long m_allocations;
+	long long m_allocatedBytes;
+	MemoryClass::StatisticsType m_memory[MEMORY_TAG_COUNT];
+};
+
+#endif
@@ -0,0 +1,119 @@
+#include "camerapathclass.h"
+
+#include <cstdio>
+
+CameraPathClass::CameraPathClass()
+{
+}
+
+CameraPathClass::CameraPathClass(const CameraPathClass&)
+{
+}
+
+CameraPathClass::~CameraPathClass()
+{
+}
+
+bool CameraPathClass::Initialize(const KeyType* keys, int keyCount)
+{
+	if(keyCount < 2)
+	{
+		return false;
+	}
+
+	m_keys.assign(keys, keys + keyCount);
+
+	return true;
+}
+
+bool CameraPathClass::Load(const char* filename)
+{
+	std::vector<KeyType> keys;
+	KeyType key;
+	FILE* file;
+	char line[256];
+
+#ifdef _WIN32
+	if(fopen_s(&file, filename, "r") != 0)
+	{
+		file = nullptr;
+	}
+#else
+	file = fopen(filename, "r");
+#endif
+	if(!file)
+	{
+		return false;
+	}
+
+	while(fgets(line, sizeof(line), file))
+	{
+		if(line[0] == '#')
+		{
+			continue;
+		}
+
+		if(sscanf(line, "%f %f %f %f %f %f", &key.position.x, &key.position.y, &key.position.z, &key.rotation.x, &key.rotation.y,
+			&key.rotation.z) == 6)
+		{
+			keys.push_back(key);
+		}
+	}
+
+	fclose(file);
+
+	return Initialize(keys.data(), (int)keys.size());
+}
+
+void CameraPathClass::Shutdown()
+{
+	m_keys.clear();
+	return;
+}
+
+void CameraPathClass::GetKey(float time, KeyType& key)
+{
+	XMVECTOR positions[4], rotations[4];
+	float segment, t;
+	int first, index, i;
+
+	// which segment the time falls into and how far along it, the last key ends the last segment.
+	segment = time * (float)(m_keys.size() - 1);
+	if(segment < 0.0f)
+	{
+		segment = 0.0f;
+	}
+	if(segment > (float)(m_keys.size() - 1))
+	{
+		segment = (float)(m_keys.size() - 1);
+	}
+
+	first = (int)segment;
+	if(first > (int)m_keys.size() - 2)
+	{
+		first = (int)m_keys.size() - 2;
+	}
+	t = segment - (float)first;
+
+	// the keys around the segment, the end keys stand in for the missing neighbours at either end.
+	for(i = 0; i < 4; i++)
+	{
+		index = first - 1 + i;
+		if(index < 0)
+		{
+			index = 0;
+		}
+		if(index > (int)m_keys.size() - 1)
+		{
+			index = (int)m_keys.size() - 1;
+		}
+
+		positions[i] = XMLoadFloat3(&m_keys[index].position);
+		rotations[i] = XMLoadFloat3(&m_keys[index].rotation);
+	}
+
+	XMStoreFloat3(&key.position, XMVectorCatmullRom(positions[0], positions[1], positions[2], positions[3], t));
+	XMStoreFloat3(&key.rotation, XMVectorCatmullRom(rotations[0], rotations[1], rotations[2], rotations[3], t));
+
+	return;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#ifndef _CAMERAPATHCLASS_H_
+#define _CAMERAPATHCLASS_H_
+
+#include <DirectXMath.h>
+#include <vector>
+using namespace DirectX;
+
+/*
+ * a scripted camera flight, a catmull rom spline through a list of keys.
+ * a key is a position and a rotation in degrees the way CameraClass takes them, both are interpolated the same way.
+ * the spline passes through every key and the keys are spread evenly over the path, so a path is played back the same
+ * no matter how long the frames take. that is what makes two benchmark runs comparable.
+ */
+class CameraPathClass
+{
+public:
+	struct KeyType
+	{
+		XMFLOAT3 position;
+		XMFLOAT3 rotation;
+	};
+
+public:
+	CameraPathClass();
+	CameraPathClass(const CameraPathClass&);
+	~CameraPathClass();
+
+	// a path needs two keys at least.
+	bool Initialize(const KeyType* keys, int keyCount);
+	// a text file of keys, six numbers per line: position x y z and rotation x y z. lines starting with # are skipped.
+	bool Load(const char* filename);
+	void Shutdown();
+
+	// time goes from 0 at the first key to 1 at the last.
+	void GetKey(float time, KeyType& key);
+
+private:
+	std::vector<KeyType> m_keys;
+};
+
+#endif
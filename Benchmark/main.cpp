@@ -0,0 +1,172 @@
+#include "benchmarkclass.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static void PrintUsage()
+{
+	fprintf(stderr,
+		"usage: benchmark [options]\n"
+		"  --frames n         timed frames, %d by default\n"
+		"  --warmup n         frames drawn before them, %d by default\n"
+		"  --width n          screen width, %d by default\n"
+		"  --height n         screen height, %d by default\n"
+		"  --model file       mesh file every object draws, the built in triangle by default\n"
+		"  --scene file       recorded scene, an object per line as x y z scale\n"
+		"  --grid n           objects per side of the synthetic grid, %d by default\n"
+		"  --spacing f        distance between grid objects, %.1f by default\n"
+		"  --path file        camera path, a key per line as x y z pitch yaw roll\n"
+		"  --no-job-scaling   skip the job system scaling and overhead tests\n"
+		"  --import file      obj or gltf file to time the mesh importer on, parsed without the cooked cache\n"
+		"  --output file      where the json report goes, stdout by default\n"
+		"  --baseline file    an earlier report to compare against\n"
+		"  --tolerance f      fraction a frame time may grow by before it is a regression, %.2f by default\n"
+		"  --check-allocations  fail when the frames still allocate from the heap once warmed up\n"
+		"exits with 1 when the benchmark failed, with 2 when it regressed against the baseline\n"
+		"and with 3 when the frames allocated and that was checked.\n",
+		BENCHMARK_FRAMES, BENCHMARK_WARMUP_FRAMES, BENCHMARK_SCREEN_WIDTH, BENCHMARK_SCREEN_HEIGHT, SCENE_GRID_SIZE, SCENE_GRID_SPACING,
+		BENCHMARK_TOLERANCE);
+
+	return;
+}
+
+int main(int argc, char* argv[])
+{
+	BenchmarkClass::SettingsType settings;
+	BenchmarkClass* Benchmark;
+	const char* outputFilename;
+	const char* baselineFilename;
+	float tolerance;
+	int i;
+	bool result, regressed, checkAllocations, allocated;
+
+	BenchmarkClass::GetDefaultSettings(settings);
+	outputFilename = nullptr;
+	baselineFilename = nullptr;
+	tolerance = BENCHMARK_TOLERANCE;
+	checkAllocations = false;
+
+	for(i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "--no-job-scaling") == 0)
+		{
+			settings.jobScaling = false;
+			continue;
+		}
+
+		if(strcmp(argv[i], "--check-allocations") == 0)
+		{
+			checkAllocations = true;
+			continue;
+		}
+
+		// every other option takes a value.
+		if(i + 1 >= argc)
+		{
+			PrintUsage();
+			return 1;
+		}
+
+		if(strcmp(argv[i], "--frames") == 0)
+		{
+			settings.frames = atoi(argv[++i]);
+		} else if(strcmp(argv[i], "--warmup") == 0)
+		{
+			settings.warmupFrames = atoi(argv[++i]);
+		} else if(strcmp(argv[i], "--width") == 0)
+		{
+			settings.screenWidth = atoi(argv[++i]);
+		} else if(strcmp(argv[i], "--height") == 0)
+		{
+			settings.screenHeight = atoi(argv[++i]);
+		} else if(strcmp(argv[i], "--model") == 0)
+		{
+			settings.modelFilename = argv[++i];
+		} else if(strcmp(argv[i], "--scene") == 0)
+		{
+			settings.sceneFilename = argv[++i];
+		} else if(strcmp(argv[i], "--grid") == 0)
+		{
+			settings.gridSize = atoi(argv[++i]);
+		} else if(strcmp(argv[i], "--spacing") == 0)
+		{
+			settings.gridSpacing = (float)atof(argv[++i]);
+		} else if(strcmp(argv[i], "--path") == 0)
+		{
+			settings.pathFilename = argv[++i];
+		} else if(strcmp(argv[i], "--import") == 0)
+		{
+			settings.importFilename = argv[++i];
+		} else if(strcmp(argv[i], "--output") == 0)
+		{
+			outputFilename = argv[++i];
+		} else if(strcmp(argv[i], "--baseline") == 0)
+		{
+			baselineFilename = argv[++i];
+		} else if(strcmp(argv[i], "--tolerance") == 0)
+		{
+			tolerance = (float)atof(argv[++i]);
+		} else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	// create the benchmark object.
+	Benchmark = new BenchmarkClass;
+	if(!Benchmark)
+	{
+		return 1;
+	}
+
+	result = Benchmark->Initialize(settings);
+	if(result)
+	{
+		result = Benchmark->Run();
+	}
+
+	if(result)
+	{
+		result = Benchmark->WriteReport(outputFilename);
+		if(!result)
+		{
+			fprintf(stderr, "could not write the report\n");
+		}
+	}
+
+	regressed = false;
+	if(result && baselineFilename)
+	{
+		result = Benchmark->CompareBaseline(baselineFilename, tolerance, regressed);
+		if(!result)
+		{
+			fprintf(stderr, "could not compare against %s\n", baselineFilename);
+		}
+	}
+
+	allocated = false;
+	if(result && checkAllocations && Benchmark->GetSteadyStateAllocations() > 0)
+	{
+		fprintf(stderr, "the frames allocated from the heap %lld times once warmed up\n", Benchmark->GetSteadyStateAllocations());
+		allocated = true;
+	}
+
+	// shutdown and release the benchmark object
+	Benchmark->Shutdown();
+	delete Benchmark;
+	Benchmark = nullptr;
+
+	if(!result)
+	{
+		return 1;
+	}
+
+	if(regressed)
+	{
+		return 2;
+	}
+
+	return allocated ? 3 : 0;
+}
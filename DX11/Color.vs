@@ -1,13 +1,31 @@
-cbuffer MatrixBuffer
+// keywords, ColorShaderClass compiles a variant for every combination it can draw with.
+// VERTEX_COLOR: the vertices carry a color, without it everything is drawn white.
+// QUANTIZED_POSITIONS: positions are normalized to the mesh bounds and scaled back by the dequantize matrix.
+// INSTANCING: every instance reads its own position and scale from the second vertex stream, the object block holds what all of them share.
+
+// written once per frame.
+cbuffer FrameBuffer : register(b0)
 {
-	matrix worldMatrix;
 	matrix viewMatrix;
 	matrix projectionMatrix;
+	matrix dequantizeMatrix;
+};
+
+// one block per object, see ConstantDataClass. instanced draws bind one block for the whole draw.
+cbuffer ObjectBuffer : register(b1)
+{
+	matrix worldMatrix;
 };
 
 struct VertexInputType {
 	float4 position : POSITION;
+#if VERTEX_COLOR
 	float4 color : COLOR;
+#endif
+#if INSTANCING
+	// xyz position, w uniform scale, see InstanceBufferClass.
+	float4 instance : INSTANCE;
+#endif
 };
 
 struct PixelInputType {
@@ -20,11 +38,22 @@ PixelInputType ColorVertexShader(VertexInputType input) {
 
 	input.position.w = 1.0f;
 
+#if QUANTIZED_POSITIONS
+	input.position = mul(input.position, dequantizeMatrix);
+#endif
+#if INSTANCING
+	// the instance's scale and translation, in the order SceneClass::GetWorldMatrix multiplies them.
+	input.position.xyz = input.position.xyz * input.instance.w + input.instance.xyz;
+#endif
 	output.position = mul(input.position, worldMatrix);
 	output.position = mul(output.position, viewMatrix);
 	output.position = mul(output.position, projectionMatrix);
 
+#if VERTEX_COLOR
 	output.color = input.color;
+#else
+	output.color = float4(1.0f, 1.0f, 1.0f, 1.0f);
+#endif
 	
 	return output;
-}
\ No newline at end of file
+}
@@ -1 +1,30 @@
 #pragma once
+#ifndef _DXDEFINE_H_
+#define _DXDEFINE_H_
+
+// the little of windows.h the headless engine needs. direct 3d is only built on windows, everywhere else there is no window,
+// HWND is always null and the software rasterizer draws.
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cstdio>
+
+typedef struct HWND__* HWND;
+
+const unsigned int MB_OK = 0;
+
+// without a window to own a message box the message goes to stderr.
+inline int MessageBox(HWND, const wchar_t* text, const wchar_t* caption, unsigned int)
+{
+	fprintf(stderr, "%ls: %ls\n", caption, text);
+	return 0;
+}
+
+inline int MessageBoxA(HWND, const char* text, const char* caption, unsigned int)
+{
+	fprintf(stderr, "%s: %s\n", caption, text);
+	return 0;
+}
+#endif
+
+#endif
@@ -0,0 +1,167 @@
+#pragma once
+#ifndef _BOUNDEDQUEUECLASS_H_
+#define _BOUNDEDQUEUECLASS_H_
+
+#include <atomic>
+#include <cstddef>
+
+/*
+ * fixed size lock free queue any number of threads can push to and pop from (dmitry vyukov's bounded mpmc queue).
+ * every slot carries a sequence number that says whether it is ready to be written or read on the current lap,
+ * so a push or pop is one compare exchange on the head or tail and never waits on another thread.
+ * a full queue makes Push fail instead of growing, the caller decides whether to wait or drop.
+ * the capacity is rounded up to a power of two.
+ */
+template<typename T>
+class BoundedQueueClass
+{
+public:
+	BoundedQueueClass()
+	{
+		m_slots = nullptr;
+		m_mask = 0;
+		m_head.store(0, std::memory_order_relaxed);
+		m_tail.store(0, std::memory_order_relaxed);
+	}
+
+	BoundedQueueClass(const BoundedQueueClass&)
+	{
+	}
+
+	~BoundedQueueClass()
+	{
+	}
+
+	bool Initialize(size_t capacity)
+	{
+		size_t size, i;
+
+		size = 2;
+		while(size < capacity)
+		{
+			size *= 2;
+		}
+
+		m_slots = new SlotType[size];
+		if(!m_slots)
+		{
+			return false;
+		}
+
+		for(i = 0; i < size; i++)
+		{
+			m_slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		m_mask = size - 1;
+		m_head.store(0, std::memory_order_relaxed);
+		m_tail.store(0, std::memory_order_relaxed);
+
+		return true;
+	}
+
+	void Shutdown()
+	{
+		if(m_slots)
+		{
+			delete[] m_slots;
+			m_slots = nullptr;
+		}
+
+		return;
+	}
+
+	bool Push(const T& value)
+	{
+		SlotType* slot;
+		size_t position, sequence;
+
+		position = m_tail.load(std::memory_order_relaxed);
+		for(;;)
+		{
+			slot = &m_slots[position & m_mask];
+			sequence = slot->sequence.load(std::memory_order_acquire);
+
+			// the slot is free on this lap, try to claim it.
+			if(sequence == position)
+			{
+				if(m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			} else if((ptrdiff_t)(sequence - position) < 0)
+			{
+				// still holds last lap's value, the queue is full.
+				return false;
+			} else
+			{
+				position = m_tail.load(std::memory_order_relaxed);
+			}
+		}
+
+		slot->value = value;
+		slot->sequence.store(position + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	bool Pop(T& value)
+	{
+		SlotType* slot;
+		size_t position, sequence;
+
+		position = m_head.load(std::memory_order_relaxed);
+		for(;;)
+		{
+			slot = &m_slots[position & m_mask];
+			sequence = slot->sequence.load(std::memory_order_acquire);
+
+			if(sequence == position + 1)
+			{
+				if(m_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			} else if((ptrdiff_t)(sequence - (position + 1)) < 0)
+			{
+				// nothing written here yet, the queue is empty.
+				return false;
+			} else
+			{
+				position = m_head.load(std::memory_order_relaxed);
+			}
+		}
+
+		value = slot->value;
+		slot->sequence.store(position + m_mask + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	// only a snapshot, other threads may push or pop right after.
+	size_t GetSize()
+	{
+		size_t head, tail;
+
+		head = m_head.load(std::memory_order_relaxed);
+		tail = m_tail.load(std::memory_order_relaxed);
+
+		return tail > head ? tail - head : 0;
+	}
+
+private:
+	struct SlotType
+	{
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+private:
+	SlotType* m_slots;
+	size_t m_mask;
+	// head and tail on their own cache lines so producers and consumers do not fight over one.
+	alignas(64) std::atomic<size_t> m_head;
+	alignas(64) std::atomic<size_t> m_tail;
+};
+
+#endif
@@ -2,7 +2,7 @@
 #ifndef _CAMERACLASS_H_
 #define _CAMERACLASS_H_
 
-#include <directxmath.h>
+#include <DirectXMath.h>
 using namespace DirectX;
 
 class CameraClass
@@ -1,11 +1,29 @@
 #include "colorshaderclass.h"
 
+#ifdef _WIN32
+#include <d3dcompiler.h>
+#include "constantdataclass.h"
+#include "instancebufferclass.h"
+#include "pipelinestateclass.h"
+#else
+// there are no pipeline states without direct 3d, every handle stays invalid.
+static const unsigned int PIPELINE_STATE_INVALID = 0xFFFFFFFF;
+#endif
+
+// the defines for the COLOR_SHADER_ keyword bits, in bit order.
+static const char* const COLOR_SHADER_KEYWORDS[COLOR_SHADER_KEYWORD_COUNT] = { "VERTEX_COLOR", "QUANTIZED_POSITIONS", "INSTANCING" };
+
 ColorShaderClass::ColorShaderClass()
 {
-	m_vertexShader = nullptr;
-	m_pixelShader = nullptr;
-	m_layout = nullptr;
-	m_matrixBuffer = nullptr;
+	int i;
+
+	m_PipelineStates = nullptr;
+	for(i = 0; i < COLOR_SHADER_VARIANT_COUNT; i++)
+	{
+		m_pipelines[i] = PIPELINE_STATE_INVALID;
+	}
+	m_variant = 0;
+	m_dequantizeMatrix = XMMatrixIdentity();
 }
 
 ColorShaderClass::ColorShaderClass(const ColorShaderClass&)
@@ -16,12 +34,27 @@ ColorShaderClass::~ColorShaderClass()
 {
 }
 
-bool ColorShaderClass::Initialize(ID3D11Device* device, HWND hwnd)
+bool ColorShaderClass::Initialize(ID3D11Device* device, HWND hwnd, unsigned int vertexFormat, ShaderCacheClass* shaderCache,
+	JobSystemClass* jobSystem, PipelineStateClass* pipelineStates)
 {
 	bool result;
-	WCHAR* vs = const_cast<WCHAR*>(L"../DX11/Color.vs");
-	WCHAR* ps = const_cast<WCHAR*>(L"../DX11/Color.ps");
-	result = InitializeShader(device, hwnd, vs, ps);
+	const char* vs = "../DX11/Color.vs";
+	const char* ps = "../DX11/Color.ps";
+
+	// the software rasterizer has the color shader built in, there is nothing to compile.
+	if(!device)
+	{
+		return true;
+	}
+
+	if(!pipelineStates)
+	{
+		return false;
+	}
+
+	m_PipelineStates = pipelineStates;
+
+	result = InitializeShader(hwnd, vs, ps, vertexFormat, shaderCache, jobSystem);
 	if(!result)
 	{
 		return false;
@@ -36,228 +69,232 @@ void ColorShaderClass::Shutdown()
 	return;
 }
 
-bool ColorShaderClass::Render(ID3D11DeviceContext* deviceContext, int indexCount, 
-	XMMATRIX worldMatrix, XMMATRIX viewMatrix, XMMATRIX projectionMatrix)
+unsigned int ColorShaderClass::GetVariant(unsigned int vertexFormat)
 {
-	bool result;
+	unsigned int variant;
 
-	result = SetShaderParameters(deviceContext, worldMatrix, viewMatrix, projectionMatrix);
-	if(!result)
+	// every vertex format carries a color so far, the variants without one are never reachable and never compiled.
+	variant = COLOR_SHADER_VERTEX_COLOR;
+	if(vertexFormat & VERTEX_FORMAT_POSITION_SNORM16)
 	{
-		return false;
+		variant |= COLOR_SHADER_QUANTIZED_POSITIONS;
 	}
 
-	RenderShader(deviceContext, indexCount);
+	return variant;
+}
+
+unsigned int ColorShaderClass::GetPipeline(bool instanced)
+{
+	return m_pipelines[instanced ? m_variant | COLOR_SHADER_INSTANCING : m_variant];
+}
+
+void ColorShaderClass::SetDequantizeMatrix(const XMMATRIX& dequantizeMatrix)
+{
+	m_dequantizeMatrix = dequantizeMatrix;
+	return;
+}
+
+#ifdef _WIN32
+void ColorShaderClass::SetFrameConstants(DeviceStateClass* deviceState, ConstantDataClass* constantData)
+{
+	constantData->BindFrame(deviceState, COLOR_SHADER_FRAME_SLOT);
+	return;
+}
+
+bool ColorShaderClass::Render(DeviceStateClass* deviceState, ConstantDataClass* constantData, int object, int indexCount, int startIndex,
+	int baseVertex)
+{
+	ProfileScopeClass profileScope("ColorShaderClass::Render");
+	// the object's matrices were uploaded with the rest of its batch, the draw only points the shader at them.
+	constantData->BindObject(deviceState, COLOR_SHADER_OBJECT_SLOT, object);
+
+	RenderShader(deviceState, indexCount, startIndex, baseVertex);
 
 	return true;
 }
 
-bool ColorShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR* vsFileName, WCHAR* psFilename)
+bool ColorShaderClass::RenderInstanced(DeviceStateClass* deviceState, ConstantDataClass* constantData, int object, int indexCount, int instanceCount,
+	int startIndex, int baseVertex, unsigned int startInstance)
 {
-	HRESULT result;
-	ID3D10Blob* errorMessage;
-	ID3D10Blob* vertexShaderBuffer;
-	ID3D10Blob* pixelShaderBuffer;
-	D3D11_INPUT_ELEMENT_DESC polygonLayout[2];
-	unsigned int numElements;
-	D3D11_BUFFER_DESC matrixBufferDesc;
-
-	errorMessage = nullptr;
-	vertexShaderBuffer = nullptr;
-	pixelShaderBuffer = nullptr;
-
-	result = D3DCompileFromFile(vsFileName, NULL, NULL, "ColorVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0
-		, &vertexShaderBuffer, &errorMessage);
-
-	if(FAILED(result))
-	{
-		if(errorMessage)
-		{
-			OutputShaderErrorMessage(errorMessage, hwnd, vsFileName);
-		}else
-		{
-			MessageBox(hwnd, vsFileName , L"Missing Shader File", MB_OK);
-		}
+	ProfileScopeClass profileScope("ColorShaderClass::RenderInstanced");
+	constantData->BindObject(deviceState, COLOR_SHADER_OBJECT_SLOT, object);
 
-		return false;
-	}
+	m_PipelineStates->Bind(deviceState, m_pipelines[m_variant | COLOR_SHADER_INSTANCING]);
 
-	result = D3DCompileFromFile(psFilename, NULL, NULL, "ColorPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0,
-		&pixelShaderBuffer, &errorMessage);
-	if(FAILED(result))
-	{
-		if(errorMessage)
-		{
-			OutputShaderErrorMessage(errorMessage, hwnd, psFilename);
-		} else
-		{
-			MessageBox(hwnd, psFilename, L"Missing Shader File", MB_OK);
-		}
-		
-		return false;
-	}
+	deviceState->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+
+	return true;
+}
+#endif
 
-	result = device->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, &m_vertexShader);
-	if(FAILED(result))
+bool ColorShaderClass::Render(SoftwareCommandListClass* commandList, int indexCount, int startIndex, int baseVertex,
+	XMMATRIX worldMatrix, XMMATRIX viewMatrix, XMMATRIX projectionMatrix)
+{
+	ProfileScopeClass profileScope("ColorShaderClass::Render");
+	// same steps as on the device: set the matrices then draw the bound model. there are no variants, the dequantize matrix is applied here.
+	commandList->VSSetMatrices(XMMatrixMultiply(m_dequantizeMatrix, worldMatrix), viewMatrix, projectionMatrix);
+	commandList->DrawIndexed(indexCount, startIndex, baseVertex);
+
+	return true;
+}
+
+#ifdef _WIN32
+bool ColorShaderClass::InitializeShader(HWND hwnd, const char* vsFilename, const char* psFilename, unsigned int vertexFormat,
+	ShaderCacheClass* shaderCache, JobSystemClass* jobSystem)
+{
+	bool compiled;
+	string errorMessage;
+	ShaderPermutationClass permutation;
+	ShaderPermutationClass::StageType vertexStage, pixelStage;
+	unsigned int variants[2];
+	int i, variantCount;
+
+	vertexStage.filename = vsFilename;
+	vertexStage.entryPoint = "ColorVertexShader";
+	vertexStage.profile = "vs_5_0";
+	vertexStage.flags = D3D10_SHADER_ENABLE_STRICTNESS;
+	vertexStage.keywords = COLOR_SHADER_VERTEX_COLOR | COLOR_SHADER_QUANTIZED_POSITIONS | COLOR_SHADER_INSTANCING;
+
+	// the pixel shader reads no keyword, every variant shares it.
+	pixelStage.filename = psFilename;
+	pixelStage.entryPoint = "ColorPixelShader";
+	pixelStage.profile = "ps_5_0";
+	pixelStage.flags = D3D10_SHADER_ENABLE_STRICTNESS;
+	pixelStage.keywords = 0;
+
+	compiled = permutation.Initialize(shaderCache, jobSystem, COLOR_SHADER_KEYWORDS, COLOR_SHADER_KEYWORD_COUNT, vertexStage, pixelStage);
+	if(!compiled)
 	{
 		return false;
 	}
 
-	result = device->CreatePixelShader(pixelShaderBuffer->GetBufferPointer(), pixelShaderBuffer->GetBufferSize(), NULL, &m_pixelShader);
-	if(FAILED(result))
+	// only what the model's vertex format is drawn with is reachable, per object and instanced.
+	variants[0] = GetVariant(vertexFormat);
+	variants[1] = variants[0] | COLOR_SHADER_INSTANCING;
+	variantCount = 2;
+
+	compiled = permutation.Compile(variants, variantCount, errorMessage);
+	if(!compiled)
 	{
+		OutputShaderErrorMessage(errorMessage, hwnd, vsFilename);
+		permutation.Shutdown();
 		return false;
 	}
 
-	// Create the vertex input layout description.
-	// This setup needs to match the VertexType structure in the ModelClass and in the shader.
-	polygonLayout[0].SemanticName = "POSITION";
-	polygonLayout[0].SemanticIndex = 0;
-	polygonLayout[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-	polygonLayout[0].InputSlot = 0;
-	polygonLayout[0].AlignedByteOffset = 0;
-	polygonLayout[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-	polygonLayout[0].InstanceDataStepRate = 0;
-
-	polygonLayout[1].SemanticName = "COLOR";
-	polygonLayout[1].SemanticIndex = 0;
-	polygonLayout[1].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-	polygonLayout[1].InputSlot = 0;
-	polygonLayout[1].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
-	polygonLayout[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-	polygonLayout[1].InstanceDataStepRate = 0;
-
-	// get a count of elements in the layout.
-	numElements = sizeof(polygonLayout) / sizeof(polygonLayout[0]);
-
-	// create the vertex input layout
-	result = device->CreateInputLayout(polygonLayout, numElements, vertexShaderBuffer->GetBufferPointer(),
-		vertexShaderBuffer->GetBufferSize(), &m_layout);
-	if(FAILED(result))
+	for(i = 0; i < variantCount; i++)
 	{
-		return false;
+		compiled = CreateVariant(hwnd, permutation.GetVariant(variants[i]), variants[i], vertexFormat);
+		if(!compiled)
+		{
+			permutation.Shutdown();
+			return false;
+		}
 	}
 
-	// release the vertex shader buffer and pixel shader buffer since they are no longer needed.
-	vertexShaderBuffer->Release();
-	vertexShaderBuffer = nullptr;
-
-	pixelShaderBuffer->Release();
-	pixelShaderBuffer = nullptr;
-
-	// setup the description of the dynamic matrix constant buffer that is in the vertex shader.
-	matrixBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	matrixBufferDesc.ByteWidth = sizeof(MatrixBufferType);
-	matrixBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	matrixBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	matrixBufferDesc.MiscFlags = 0;
-	matrixBufferDesc.StructureByteStride = 0;
+	permutation.Shutdown();
+	m_variant = variants[0];
 
-	// create the constant buffer pointer so we can access the vertex shader constant buffer from within this class.
-	result = device->CreateBuffer(&matrixBufferDesc, NULL, &m_matrixBuffer);
-	if(FAILED(result))
-	{
-		return false;
-	}
-	
 	return true;
 }
 
-void ColorShaderClass::ShutdownShader()
+bool ColorShaderClass::CreateVariant(HWND hwnd, const ShaderPermutationClass::VariantType* variant, unsigned int variantIndex,
+	unsigned int vertexFormat)
 {
-	if(m_matrixBuffer)
+	PipelineStateClass::DescType pipelineDesc;
+	const ShaderCacheClass::ShaderType* vertexShader;
+	const ShaderCacheClass::ShaderType* pixelShader;
+	D3D11_INPUT_ELEMENT_DESC polygonLayout[VERTEX_FORMAT_MAX_ELEMENTS + 1];
+	unsigned int i, slot, size, elementCount;
+
+	if(!variant)
 	{
-		m_matrixBuffer->Release();
-		m_matrixBuffer = nullptr;
+		return false;
 	}
 
-	if(m_layout)
+	vertexShader = variant->vertexShader;
+	pixelShader = variant->pixelShader;
+
+	// the constant blocks have to be the size the vertex shader was compiled with.
+	for(i = 0; i < (unsigned int)vertexShader->reflection.constantBuffers.size(); i++)
 	{
-		m_layout->Release();
-		m_layout = nullptr;
+		slot = vertexShader->reflection.constantBuffers[i].slot;
+		size = vertexShader->reflection.constantBuffers[i].size;
+		if((slot == COLOR_SHADER_FRAME_SLOT && size != sizeof(ConstantDataClass::FrameType)) ||
+			(slot == COLOR_SHADER_OBJECT_SLOT && size != sizeof(ConstantDataClass::ObjectType)))
+		{
+			OutputShaderErrorMessage("constant buffers do not match ConstantDataClass", hwnd, "ColorVertexShader");
+			return false;
+		}
 	}
 
-	if(m_pixelShader)
+	// the device's own rasterizer, depth stencil and blend states, with this variant's shaders and the model's input layout.
+	// This setup needs to match the vertex format the ModelClass stored its buffer in, the shader reads every format as float4.
+	m_PipelineStates->GetDefaultDesc(pipelineDesc);
+	elementCount = VertexFormatClass::GetInputLayout(vertexFormat, polygonLayout);
+	if(variantIndex & COLOR_SHADER_INSTANCING)
 	{
-		m_pixelShader->Release();
-		m_pixelShader = nullptr;
+		elementCount += InstanceBufferClass::GetInputLayout(COLOR_SHADER_INSTANCE_SLOT, polygonLayout + elementCount);
 	}
-
-	if(m_vertexShader)
+	pipelineDesc.inputElementCount = elementCount;
+	pipelineDesc.inputElements = polygonLayout;
+	pipelineDesc.vertexShader = vertexShader->bytecode;
+	pipelineDesc.vertexShaderSize = vertexShader->bytecodeSize;
+	pipelineDesc.pixelShader = pixelShader->bytecode;
+	pipelineDesc.pixelShaderSize = pixelShader->bytecodeSize;
+
+	m_pipelines[variantIndex] = m_PipelineStates->Create(pipelineDesc);
+	if(m_pipelines[variantIndex] == PIPELINE_STATE_INVALID)
 	{
-		m_vertexShader->Release();
-		m_vertexShader = nullptr;
+		return false;
 	}
 
-	return;
+	return true;
 }
 
-void ColorShaderClass::OutputShaderErrorMessage(ID3D10Blob* errorMessage, HWND hwnd, WCHAR* shaderFileName)
+#else
+// Initialize never gets this far without a device.
+bool ColorShaderClass::InitializeShader(HWND, const char*, const char*, unsigned int, ShaderCacheClass*, JobSystemClass*)
 {
-	char* compileErrors;
-	unsigned long long bufferSize, i;
-	ofstream fout;
-
-	compileErrors = (char*)(errorMessage->GetBufferPointer());
-
-	bufferSize = errorMessage->GetBufferSize();
+	return false;
+}
+#endif
 
-	fout.open("shader-error.txt");
+void ColorShaderClass::ShutdownShader()
+{
+	int i;
 
-	for(i=0;i<bufferSize;i++)
+	// the shaders and layouts belong to the pipeline states, they are released with the device.
+	for(i = 0; i < COLOR_SHADER_VARIANT_COUNT; i++)
 	{
-		fout << compileErrors[i];
+		m_pipelines[i] = PIPELINE_STATE_INVALID;
 	}
-
-	fout.close();
-
-	errorMessage->Release();
-	errorMessage = nullptr;
-
-	MessageBox(hwnd, L"Error compiling shader. Check shader-error.txt for message.", shaderFileName, MB_OK);
+	m_PipelineStates = nullptr;
 
 	return;
 }
 
-bool ColorShaderClass::SetShaderParameters(ID3D11DeviceContext* deviceContext, XMMATRIX worldMatrix, XMMATRIX viewMatrix, XMMATRIX projectionMatrix)
+void ColorShaderClass::OutputShaderErrorMessage(const string& errorMessage, HWND hwnd, const char* shaderFileName)
 {
-	HRESULT result;
-	D3D11_MAPPED_SUBRESOURCE mappedResource;
-	MatrixBufferType* dataPtr;
-	unsigned int bufferNumber;
-
-	worldMatrix = XMMatrixTranspose(worldMatrix);
-	viewMatrix = XMMatrixTranspose(viewMatrix);
-	projectionMatrix = XMMatrixTranspose(projectionMatrix);
-
-	result = deviceContext->Map(m_matrixBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if(FAILED(result))
-	{
-		return false;
-	}
+	ofstream fout;
 
-	dataPtr = (MatrixBufferType*)mappedResource.pData;
+	fout.open("shader-error.txt");
 
-	dataPtr->world = worldMatrix;
-	dataPtr->view = viewMatrix;
-	dataPtr->projection = projectionMatrix;
+	fout << errorMessage;
 
-	deviceContext->Unmap(m_matrixBuffer, 0);
+	fout.close();
 
-	bufferNumber = 0;
+	MessageBoxA(hwnd, "Error compiling shader. Check shader-error.txt for message.", shaderFileName, MB_OK);
 
-	deviceContext->VSSetConstantBuffers(bufferNumber, 1, &m_matrixBuffer);
-	
-	return true;
+	return;
 }
 
-void ColorShaderClass::RenderShader(ID3D11DeviceContext* deviceContext, int indexCount)
+#ifdef _WIN32
+void ColorShaderClass::RenderShader(DeviceStateClass* deviceState, int indexCount, int startIndex, int baseVertex)
 {
-	deviceContext->IASetInputLayout(m_layout);
-
-	deviceContext->VSSetShader(m_vertexShader, NULL, 0);
-	deviceContext->PSSetShader(m_pixelShader, NULL, 0);
+	// the variant's whole pipeline is one handle, binding it again for the next object never reaches the driver.
+	m_PipelineStates->Bind(deviceState, m_pipelines[m_variant]);
 
-	deviceContext->DrawIndexed(indexCount, 0, 0);
+	deviceState->DrawIndexed(indexCount, startIndex, baseVertex);
 	return;
 }
+#endif
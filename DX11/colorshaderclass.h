@@ -3,46 +3,80 @@
 #ifndef _COLORSHADERCLASS_H_
 #define _COLORSHADERCLASS_H_
 
-#include <d3d11.h>
-#include <d3dcompiler.h>
-#include <directxmath.h>
+#include <DirectXMath.h>
 #include <fstream>
+#include <string>
+
+#include "DxDefine.h"
+#include "profilerclass.h"
+#include "shaderpermutationclass.h"
+#include "softwarecommandlistclass.h"
+#include "softwarerasterizerclass.h"
+#include "vertexformatclass.h"
 
 using namespace DirectX;
 using namespace std;
 
+// forward declarations so the software backends can use the shader without the direct 3d headers.
+struct ID3D11Device;
+class ConstantDataClass;
+class DeviceStateClass;
+class JobSystemClass;
+class PipelineStateClass;
+
+// the keywords Color.vs is compiled with, a variant is the bitmask of the ones it was compiled with.
+const unsigned int COLOR_SHADER_VERTEX_COLOR = 1;
+const unsigned int COLOR_SHADER_QUANTIZED_POSITIONS = 2;
+const unsigned int COLOR_SHADER_INSTANCING = 4;
+const int COLOR_SHADER_KEYWORD_COUNT = 3;
+const int COLOR_SHADER_VARIANT_COUNT = 1 << COLOR_SHADER_KEYWORD_COUNT;
+// constant buffer registers of the FrameBuffer and ObjectBuffer blocks in Color.vs.
+const unsigned int COLOR_SHADER_FRAME_SLOT = 0;
+const unsigned int COLOR_SHADER_OBJECT_SLOT = 1;
+// input slot the instanced variants read their instance stream from, the model's vertices are in slot 0.
+const unsigned int COLOR_SHADER_INSTANCE_SLOT = 1;
+
 class ColorShaderClass
 {
-private:
-	struct MatrixBufferType
-	{
-		XMMATRIX world;
-		XMMATRIX view;
-		XMMATRIX projection;
-	};
-
 public:
 	ColorShaderClass();
 	ColorShaderClass(const ColorShaderClass&);
 	~ColorShaderClass();
 
-	bool Initialize(ID3D11Device* device, HWND hwnd);
+	// compiles the variants the vertex format can be drawn with, one per object and one instanced. the bytecode comes from the shader cache, hlsl is only compiled when it misses.
+	// the variants compile together on the job system's threads. each variant becomes one pipeline of the device's pipeline states.
+	bool Initialize(ID3D11Device* device, HWND hwnd, unsigned int vertexFormat, ShaderCacheClass* shaderCache, JobSystemClass* jobSystem,
+		PipelineStateClass* pipelineStates);
 	void Shutdown();
-	bool Render(ID3D11DeviceContext* deviceContext, int, XMMATRIX worldMatrix, XMMATRIX viewMatrix, XMMATRIX projectionMatrix);
+
+	static unsigned int GetVariant(unsigned int vertexFormat);
+	// the pipeline handle draws with the current variant use, RenderInstanced uses the instanced one.
+	unsigned int GetPipeline(bool instanced);
+	// the dequantize matrix of the model about to be drawn. on the device it goes into the frame's constant data instead.
+	void SetDequantizeMatrix(const XMMATRIX& dequantizeMatrix);
+	// binds the frame block once, every Render after it only selects its object's block.
+	void SetFrameConstants(DeviceStateClass* deviceState, ConstantDataClass* constantData);
+	bool Render(DeviceStateClass* deviceState, ConstantDataClass* constantData, int object, int, int, int);
+	// draws instanceCount copies with a single call. the object block is shared by all of them and the instance stream has to be bound
+	// to COLOR_SHADER_INSTANCE_SLOT, startInstance is where the draw's instances start in it.
+	bool RenderInstanced(DeviceStateClass* deviceState, ConstantDataClass* constantData, int object, int indexCount, int instanceCount, int startIndex,
+		int baseVertex, unsigned int startInstance);
+	bool Render(SoftwareCommandListClass* commandList, int, int, int, XMMATRIX worldMatrix, XMMATRIX viewMatrix, XMMATRIX projectionMatrix);
 
 private:
-	bool InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR*, WCHAR*);
+	bool InitializeShader(HWND hwnd, const char*, const char*, unsigned int vertexFormat, ShaderCacheClass* shaderCache, JobSystemClass* jobSystem);
+	bool CreateVariant(HWND hwnd, const ShaderPermutationClass::VariantType* variant, unsigned int variantIndex, unsigned int vertexFormat);
 	void ShutdownShader();
-	void OutputShaderErrorMessage(ID3D10Blob*, HWND hwnd, WCHAR*);
+	void OutputShaderErrorMessage(const string&, HWND hwnd, const char*);
 
-	bool SetShaderParameters(ID3D11DeviceContext* deviceContext, XMMATRIX worldMatrix, XMMATRIX viewMatrix, XMMATRIX projectionMatrix);
-	void RenderShader(ID3D11DeviceContext* deviceContext, int);
+	void RenderShader(DeviceStateClass* deviceState, int, int, int);
 
 private:
-	ID3D11VertexShader* m_vertexShader;
-	ID3D11PixelShader* m_pixelShader;
-	ID3D11InputLayout* m_layout;
-	ID3D11Buffer* m_matrixBuffer;
+	PipelineStateClass* m_PipelineStates;
+	// indexed by variant, PIPELINE_STATE_INVALID for the ones that were not compiled.
+	unsigned int m_pipelines[COLOR_SHADER_VARIANT_COUNT];
+	unsigned int m_variant;
+	XMMATRIX m_dequantizeMatrix;
 };
 
 #endif
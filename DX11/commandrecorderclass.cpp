@@ -0,0 +1,305 @@
+#include "commandrecorderclass.h"
+
+#ifdef _WIN32
+#include "devicestateclass.h"
+#endif
+
+CommandRecorderClass::CommandRecorderClass()
+{
+	m_threadCount = 0;
+	m_record = nullptr;
+	m_recordData = nullptr;
+	m_drawCount = 0;
+	m_chunkCount = 0;
+	m_failed = false;
+	m_jobSystem = nullptr;
+}
+
+CommandRecorderClass::CommandRecorderClass(const CommandRecorderClass&)
+{
+}
+
+CommandRecorderClass::~CommandRecorderClass()
+{
+}
+
+bool CommandRecorderClass::Initialize(ID3D11Device* device, SoftwareRasterizerClass* rasterizer, JobSystemClass* jobSystem)
+{
+#ifdef _WIN32
+	HRESULT result;
+	ID3D11DeviceContext* deferredContext;
+	DeviceStateClass* deviceState;
+#endif
+	SoftwareCommandListClass* commandList;
+	int i;
+
+	if((!device && !rasterizer) || !jobSystem)
+	{
+		return false;
+	}
+
+	m_jobSystem = jobSystem;
+	m_threadCount = jobSystem->GetThreadCount();
+
+	for(i = 0; i < m_threadCount; i++)
+	{
+#ifdef _WIN32
+		if(device)
+		{
+			result = device->CreateDeferredContext(0, &deferredContext);
+			if(FAILED(result))
+			{
+				return false;
+			}
+			m_deferredContexts.push_back(deferredContext);
+
+			deviceState = new DeviceStateClass;
+			if(!deviceState)
+			{
+				return false;
+			}
+			m_deviceStates.push_back(deviceState);
+
+			if(!deviceState->Initialize(deferredContext))
+			{
+				return false;
+			}
+
+			m_commandLists.push_back(nullptr);
+		}
+		else
+#endif
+		{
+			commandList = new SoftwareCommandListClass;
+			if(!commandList)
+			{
+				return false;
+			}
+			m_softwareLists.push_back(commandList);
+
+			if(!commandList->Initialize(rasterizer))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void CommandRecorderClass::Shutdown()
+{
+	unsigned int i;
+
+	ReleaseCommandLists();
+	m_commandLists.clear();
+
+#ifdef _WIN32
+	for(i = 0; i < m_deviceStates.size(); i++)
+	{
+		m_deviceStates[i]->Shutdown();
+		delete m_deviceStates[i];
+	}
+
+	for(i = 0; i < m_deferredContexts.size(); i++)
+	{
+		m_deferredContexts[i]->Release();
+	}
+#endif
+	m_deviceStates.clear();
+	m_deferredContexts.clear();
+
+	for(i = 0; i < m_softwareLists.size(); i++)
+	{
+		m_softwareLists[i]->Shutdown();
+		delete m_softwareLists[i];
+	}
+	m_softwareLists.clear();
+
+	m_threadCount = 0;
+	m_chunkCount = 0;
+	m_jobSystem = nullptr;
+
+	return;
+}
+
+int CommandRecorderClass::GetThreadCount()
+{
+	return m_threadCount;
+}
+
+DeviceStateClass* CommandRecorderClass::GetDeviceState(int chunk)
+{
+	if(chunk < 0 || chunk >= (int)m_deviceStates.size())
+	{
+		return nullptr;
+	}
+
+	return m_deviceStates[chunk];
+}
+
+SoftwareCommandListClass* CommandRecorderClass::GetCommandList(int chunk)
+{
+	if(chunk < 0 || chunk >= (int)m_softwareLists.size())
+	{
+		return nullptr;
+	}
+
+	return m_softwareLists[chunk];
+}
+
+bool CommandRecorderClass::Record(int drawCount, RecordFunction record, void* data)
+{
+	// lists that were recorded and never executed are dropped.
+	ReleaseCommandLists();
+
+	m_chunkCount = 0;
+	if(drawCount <= 0)
+	{
+		return true;
+	}
+
+	// as many threads as the draws are worth, each with the same share.
+	m_chunkCount = (drawCount + COMMAND_RECORDER_MIN_CHUNK - 1) / COMMAND_RECORDER_MIN_CHUNK;
+	m_chunkCount = m_chunkCount < m_threadCount ? m_chunkCount : m_threadCount;
+
+	m_record = record;
+	m_recordData = data;
+	m_drawCount = drawCount;
+	m_failed = false;
+
+	m_jobSystem->ParallelFor(m_chunkCount, 1, [this](int first, int last)
+	{
+		int chunk;
+
+		for(chunk = first; chunk < last; chunk++)
+		{
+			RecordChunk(chunk);
+		}
+	});
+
+	m_record = nullptr;
+	m_recordData = nullptr;
+
+	if(m_failed)
+	{
+		ReleaseCommandLists();
+		m_chunkCount = 0;
+		return false;
+	}
+
+	return true;
+}
+
+#ifdef _WIN32
+void CommandRecorderClass::Execute(DeviceStateClass* deviceState)
+{
+	ID3D11DeviceContext* deviceContext;
+	DeviceStateClass::StatisticsType statistics;
+	int i;
+
+	if(m_chunkCount == 0)
+	{
+		return;
+	}
+
+	deviceContext = deviceState->GetDeviceContext();
+
+	for(i = 0; i < m_chunkCount; i++)
+	{
+		// false clears the immediate context's state after each list instead of saving and restoring it, the next chunk binds its own anyway.
+		deviceContext->ExecuteCommandList(m_commandLists[i], FALSE);
+		m_commandLists[i]->Release();
+		m_commandLists[i] = nullptr;
+
+		m_deviceStates[i]->GetStatistics(statistics);
+		deviceState->AddStatistics(statistics);
+	}
+
+	deviceState->Invalidate();
+	m_chunkCount = 0;
+
+	return;
+}
+#endif
+
+void CommandRecorderClass::Execute(SoftwareRasterizerClass* rasterizer)
+{
+	int i;
+
+	for(i = 0; i < m_chunkCount; i++)
+	{
+		rasterizer->ExecuteCommandList(m_softwareLists[i]);
+	}
+
+	m_chunkCount = 0;
+
+	return;
+}
+
+void CommandRecorderClass::RecordChunk(int chunk)
+{
+#ifdef _WIN32
+	HRESULT result;
+	DeviceStateClass* deviceState;
+	bool recorded;
+#endif
+	int first, last;
+
+	first = (int)((long long)m_drawCount * chunk / m_chunkCount);
+	last = (int)((long long)m_drawCount * (chunk + 1) / m_chunkCount);
+
+	if(m_deferredContexts.empty())
+	{
+		m_softwareLists[chunk]->Reset();
+		if(!m_record(m_recordData, chunk, first, last))
+		{
+			m_failed = true;
+		}
+		return;
+	}
+
+#ifdef _WIN32
+	// a deferred context starts every list with nothing bound, and its shadow has to know that.
+	deviceState = m_deviceStates[chunk];
+	deviceState->BeginFrame();
+	deviceState->Invalidate();
+
+	recorded = m_record(m_recordData, chunk, first, last);
+
+	// the list is finished even when recording failed, that is what resets the context for the next frame.
+	result = m_deferredContexts[chunk]->FinishCommandList(FALSE, &m_commandLists[chunk]);
+	if(FAILED(result))
+	{
+		m_commandLists[chunk] = nullptr;
+		recorded = false;
+	}
+
+	deviceState->EndFrame();
+
+	if(!recorded)
+	{
+		m_failed = true;
+	}
+#endif
+
+	return;
+}
+
+void CommandRecorderClass::ReleaseCommandLists()
+{
+#ifdef _WIN32
+	unsigned int i;
+
+	for(i = 0; i < m_commandLists.size(); i++)
+	{
+		if(m_commandLists[i])
+		{
+			m_commandLists[i]->Release();
+			m_commandLists[i] = nullptr;
+		}
+	}
+#endif
+
+	return;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#ifndef _COMMANDRECORDERCLASS_H_
+#define _COMMANDRECORDERCLASS_H_
+
+#include <atomic>
+#include <vector>
+
+#include "jobsystemclass.h"
+#include "softwarecommandlistclass.h"
+#include "softwarerasterizerclass.h"
+
+// forward declarations so the software rasterizer can record without the direct 3d headers.
+struct ID3D11Device;
+struct ID3D11DeviceContext;
+struct ID3D11CommandList;
+class DeviceStateClass;
+
+// draws a chunk has at least, below that recording is split over fewer threads. every chunk pays for binding everything again.
+const int COMMAND_RECORDER_MIN_CHUNK = 256;
+
+/*
+ * records a frame's draws on several threads at once and plays them back on the render thread in a fixed order.
+ * the draws are split into one contiguous chunk per thread of the job system, every chunk is a job. on the device every chunk is recorded into a deferred context of its own,
+ * through a device state shadowing that context, and finished into a command list. on the software rasterizer a chunk is recorded into a SoftwareCommandListClass.
+ * Execute then runs the chunks' lists on the immediate context (or rasterizer) in chunk order, so the frame is the one recording every draw
+ * on one thread would have given, whichever thread finished first.
+ * a chunk starts with nothing bound and has to bind everything its draws use. resources are only mapped on the immediate context, between Execute calls.
+ */
+class CommandRecorderClass
+{
+public:
+	// records the draws first to last - 1 into GetDeviceState(chunk) or GetCommandList(chunk), false stops the frame.
+	typedef bool (*RecordFunction)(void* data, int chunk, int first, int last);
+
+public:
+	CommandRecorderClass();
+	CommandRecorderClass(const CommandRecorderClass&);
+	~CommandRecorderClass();
+
+	// one of device or rasterizer, whichever the frame draws with.
+	bool Initialize(ID3D11Device* device, SoftwareRasterizerClass* rasterizer, JobSystemClass* jobSystem);
+	void Shutdown();
+
+	int GetThreadCount();
+	DeviceStateClass* GetDeviceState(int chunk);
+	SoftwareCommandListClass* GetCommandList(int chunk);
+
+	// splits drawCount draws into chunks and records them as jobs. false when any chunk failed, nothing is executed then.
+	bool Record(int drawCount, RecordFunction record, void* data);
+
+	// the same over a lambda called as record(chunk, first, last), through a pointer to it so recording allocates nothing.
+	template<typename FunctionType>
+	bool Record(int drawCount, const FunctionType& record)
+	{
+		return Record(drawCount, CallRecord<FunctionType>, (void*)&record);
+	}
+
+	// plays back the last Record in chunk order. the immediate context is left with nothing bound, its shadow is invalidated
+	// and the chunks' counters are added to its frame.
+	void Execute(DeviceStateClass* deviceState);
+	void Execute(SoftwareRasterizerClass* rasterizer);
+
+private:
+	void RecordChunk(int chunk);
+
+	template<typename FunctionType>
+	static bool CallRecord(void* data, int chunk, int first, int last)
+	{
+		return (*(const FunctionType*)data)(chunk, first, last);
+	}
+
+	void ReleaseCommandLists();
+
+private:
+	// one of each per thread, the device's or the rasterizer's depending on which Initialize got.
+	std::vector<ID3D11DeviceContext*> m_deferredContexts;
+	std::vector<DeviceStateClass*> m_deviceStates;
+	std::vector<ID3D11CommandList*> m_commandLists;
+	std::vector<SoftwareCommandListClass*> m_softwareLists;
+	int m_threadCount;
+	JobSystemClass* m_jobSystem;
+
+	// the Record in flight.
+	RecordFunction m_record;
+	void* m_recordData;
+	int m_drawCount;
+	int m_chunkCount;
+	std::atomic<bool> m_failed;
+};
+
+#endif
@@ -0,0 +1,333 @@
+#include "constantdataclass.h"
+
+#include <cstring>
+#include <xmmintrin.h>
+
+// 16 constants of 16 bytes, the size of one block in the units VSSetConstantBuffers1 counts in.
+static const UINT CONSTANT_BLOCK_CONSTANTS = CONSTANT_BLOCK_ALIGNMENT / 16;
+
+/*
+ * transposes the matrices into the mapping, one every stride bytes.
+ * mapped dynamic buffers are write combined memory, the streaming stores fill whole lines without reading them first
+ * and stay out of the cache the cpu is using.
+ */
+static void TransposeMatrices(const XMMATRIX* matrices, int count, unsigned char* destination, unsigned int stride)
+{
+	__m128 row0, row1, row2, row3;
+	const float* source;
+	float* output;
+	int i;
+
+	for(i = 0; i < count; i++)
+	{
+		source = (const float*)&matrices[i];
+		row0 = _mm_load_ps(source);
+		row1 = _mm_load_ps(source + 4);
+		row2 = _mm_load_ps(source + 8);
+		row3 = _mm_load_ps(source + 12);
+
+		_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+
+		output = (float*)(destination + (size_t)i * stride);
+		_mm_stream_ps(output, row0);
+		_mm_stream_ps(output + 4, row1);
+		_mm_stream_ps(output + 8, row2);
+		_mm_stream_ps(output + 12, row3);
+	}
+
+	// streaming stores are weakly ordered, they have to land before the unmap.
+	_mm_sfence();
+
+	return;
+}
+
+ConstantDataClass::ConstantDataClass()
+{
+	int i;
+
+	m_frameBuffer = nullptr;
+	m_ringBuffer = nullptr;
+	m_noOverwrite = false;
+	for(i = 0; i < CONSTANT_STAGING_BUFFERS; i++)
+	{
+		m_stagingBuffers[i] = nullptr;
+	}
+	m_objectBuffer = nullptr;
+	m_stagingIndex = 0;
+	m_capacity = 0;
+	m_ringHead = 0;
+	m_uploadStart = 0;
+	m_uploadCount = 0;
+	memset(&m_statistics, 0, sizeof(m_statistics));
+}
+
+ConstantDataClass::ConstantDataClass(const ConstantDataClass&)
+{
+}
+
+ConstantDataClass::~ConstantDataClass()
+{
+}
+
+bool ConstantDataClass::Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext, int objectCapacity)
+{
+	HRESULT result;
+	D3D11_BUFFER_DESC bufferDesc;
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options;
+	ID3D11DeviceContext1* deviceContext1;
+	int i;
+
+	if(objectCapacity <= 0)
+	{
+		return false;
+	}
+
+	m_capacity = objectCapacity;
+	// a full ring makes the first upload discard, a buffer is never appended to before it was mapped once.
+	m_ringHead = objectCapacity;
+
+	bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	bufferDesc.ByteWidth = sizeof(FrameType);
+	bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	bufferDesc.MiscFlags = 0;
+	bufferDesc.StructureByteStride = 0;
+
+	result = device->CreateBuffer(&bufferDesc, NULL, &m_frameBuffer);
+	if(FAILED(result))
+	{
+		return false;
+	}
+
+	// offset binding needs the 11.1 context and a driver that says it can, appending without a discard needs the second option too.
+	// the binds themselves go through the device state, which has its own reference to the 11.1 context.
+	deviceContext1 = nullptr;
+	memset(&options, 0, sizeof(options));
+	result = device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options));
+	if(SUCCEEDED(result) && options.ConstantBufferOffsetting)
+	{
+		result = deviceContext->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)&deviceContext1);
+		if(FAILED(result))
+		{
+			deviceContext1 = nullptr;
+		}
+	}
+
+	if(deviceContext1)
+	{
+		deviceContext1->Release();
+
+		m_noOverwrite = options.MapNoOverwriteOnDynamicConstantBuffer != 0;
+
+		bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+		bufferDesc.ByteWidth = (UINT)objectCapacity * CONSTANT_BLOCK_ALIGNMENT;
+		bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+		result = device->CreateBuffer(&bufferDesc, NULL, &m_ringBuffer);
+		if(FAILED(result))
+		{
+			return false;
+		}
+
+		return true;
+	}
+
+	// without offsets the blocks are packed in staging buffers and copied one at a time into the buffer the shader reads.
+	bufferDesc.Usage = D3D11_USAGE_STAGING;
+	bufferDesc.ByteWidth = (UINT)objectCapacity * sizeof(ObjectType);
+	bufferDesc.BindFlags = 0;
+	bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+	for(i = 0; i < CONSTANT_STAGING_BUFFERS; i++)
+	{
+		result = device->CreateBuffer(&bufferDesc, NULL, &m_stagingBuffers[i]);
+		if(FAILED(result))
+		{
+			return false;
+		}
+	}
+
+	bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+	bufferDesc.ByteWidth = sizeof(ObjectType);
+	bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	bufferDesc.CPUAccessFlags = 0;
+
+	result = device->CreateBuffer(&bufferDesc, NULL, &m_objectBuffer);
+	if(FAILED(result))
+	{
+		return false;
+	}
+
+	return true;
+}
+
+void ConstantDataClass::Shutdown()
+{
+	int i;
+
+	if(m_objectBuffer)
+	{
+		m_objectBuffer->Release();
+		m_objectBuffer = nullptr;
+	}
+
+	for(i = 0; i < CONSTANT_STAGING_BUFFERS; i++)
+	{
+		if(m_stagingBuffers[i])
+		{
+			m_stagingBuffers[i]->Release();
+			m_stagingBuffers[i] = nullptr;
+		}
+	}
+
+	if(m_ringBuffer)
+	{
+		m_ringBuffer->Release();
+		m_ringBuffer = nullptr;
+	}
+
+	if(m_frameBuffer)
+	{
+		m_frameBuffer->Release();
+		m_frameBuffer = nullptr;
+	}
+
+	m_capacity = 0;
+
+	return;
+}
+
+bool ConstantDataClass::BeginFrame(DeviceStateClass* deviceState, const XMMATRIX& viewMatrix, const XMMATRIX& projectionMatrix,
+	const XMMATRIX& dequantizeMatrix)
+{
+	HRESULT result;
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	XMMATRIX matrices[3];
+
+	memset(&m_statistics, 0, sizeof(m_statistics));
+	m_statistics.offsetBinding = m_ringBuffer != nullptr;
+	m_uploadCount = 0;
+
+	matrices[0] = viewMatrix;
+	matrices[1] = projectionMatrix;
+	matrices[2] = dequantizeMatrix;
+
+	result = deviceState->Map(m_frameBuffer, D3D11_MAP_WRITE_DISCARD, &mappedResource, sizeof(FrameType));
+	if(FAILED(result))
+	{
+		return false;
+	}
+
+	TransposeMatrices(matrices, 3, (unsigned char*)mappedResource.pData, sizeof(XMMATRIX));
+	deviceState->Unmap(m_frameBuffer);
+
+	m_statistics.maps++;
+	m_statistics.bytesMapped += sizeof(FrameType);
+
+	return true;
+}
+
+int ConstantDataClass::UploadObjects(DeviceStateClass* deviceState, const XMMATRIX* worldMatrices, int count)
+{
+	HRESULT result;
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	ID3D11Buffer* stagingBuffer;
+	D3D11_MAP mapType;
+
+	count = count < m_capacity ? count : m_capacity;
+	if(count <= 0)
+	{
+		return 0;
+	}
+
+	if(m_ringBuffer)
+	{
+		// append behind the blocks the gpu may still be reading, and only start over with a fresh buffer once the ring is full.
+		if(m_noOverwrite && m_ringHead + count <= m_capacity)
+		{
+			mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+		}
+		else
+		{
+			mapType = D3D11_MAP_WRITE_DISCARD;
+			m_ringHead = 0;
+		}
+
+		result = deviceState->Map(m_ringBuffer, mapType, &mappedResource, (unsigned long long)count * sizeof(ObjectType));
+		if(FAILED(result))
+		{
+			return 0;
+		}
+
+		TransposeMatrices(worldMatrices, count, (unsigned char*)mappedResource.pData + (size_t)m_ringHead * CONSTANT_BLOCK_ALIGNMENT, CONSTANT_BLOCK_ALIGNMENT);
+		deviceState->Unmap(m_ringBuffer);
+
+		m_uploadStart = m_ringHead;
+		m_ringHead += count;
+	}
+	else
+	{
+		stagingBuffer = m_stagingBuffers[m_stagingIndex];
+
+		result = deviceState->Map(stagingBuffer, D3D11_MAP_WRITE, &mappedResource, (unsigned long long)count * sizeof(ObjectType));
+		if(FAILED(result))
+		{
+			return 0;
+		}
+
+		TransposeMatrices(worldMatrices, count, (unsigned char*)mappedResource.pData, sizeof(ObjectType));
+		deviceState->Unmap(stagingBuffer);
+
+		m_uploadStart = m_stagingIndex;
+		m_stagingIndex = (m_stagingIndex + 1) % CONSTANT_STAGING_BUFFERS;
+	}
+
+	m_uploadCount = count;
+	m_statistics.maps++;
+	m_statistics.objects += count;
+	m_statistics.bytesMapped += (unsigned long long)count * sizeof(ObjectType);
+
+	return count;
+}
+
+void ConstantDataClass::BindFrame(DeviceStateClass* deviceState, unsigned int slot)
+{
+	deviceState->VSSetConstantBuffer(slot, m_frameBuffer);
+	return;
+}
+
+void ConstantDataClass::BindObject(DeviceStateClass* deviceState, unsigned int slot, int object)
+{
+	D3D11_BOX box;
+
+	if(object < 0 || object >= m_uploadCount)
+	{
+		return;
+	}
+
+	if(m_ringBuffer)
+	{
+		deviceState->VSSetConstantBufferRange(slot, m_ringBuffer, (UINT)(m_uploadStart + object) * CONSTANT_BLOCK_CONSTANTS, CONSTANT_BLOCK_CONSTANTS);
+		return;
+	}
+
+	// the upload start is the staging buffer the objects went into.
+	box.left = (UINT)object * sizeof(ObjectType);
+	box.right = box.left + sizeof(ObjectType);
+	box.top = 0;
+	box.bottom = 1;
+	box.front = 0;
+	box.back = 1;
+
+	deviceState->CopySubresourceRegion(m_objectBuffer, 0, m_stagingBuffers[m_uploadStart], &box);
+	deviceState->VSSetConstantBuffer(slot, m_objectBuffer);
+
+	return;
+}
+
+void ConstantDataClass::GetStatistics(StatisticsType& statistics)
+{
+	statistics = m_statistics;
+	return;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#ifndef _CONSTANTDATACLASS_H_
+#define _CONSTANTDATACLASS_H_
+
+#include <d3d11_1.h>
+#include <DirectXMath.h>
+using namespace DirectX;
+
+#include "devicestateclass.h"
+
+// constant buffer offsets count 16 byte constants and have to be a multiple of 16 of them, so every object block starts 256 bytes after the last.
+const unsigned int CONSTANT_BLOCK_ALIGNMENT = 256;
+// staging buffers the copy fallback rotates through, so a map does not wait for copies the gpu has not done yet.
+const int CONSTANT_STAGING_BUFFERS = 3;
+
+/*
+ * constant data split by how often it changes.
+ * the per frame block (view, projection, dequantize) is written once per frame. the per object blocks (world) are written for a whole batch
+ * of objects with a single map into a big ring buffer, transposed four rows at a time with SSE and streamed straight into the mapping.
+ * a draw then only selects its block: with direct 3d 11.1 by binding the ring at the block's offset, otherwise by one gpu side copy
+ * of the block into a small constant buffer. either way a frame maps two buffers, however many objects it draws.
+ */
+class ConstantDataClass
+{
+public:
+	// what the shaders see in FrameBuffer and ObjectBuffer, the matrices are stored transposed.
+	struct FrameType
+	{
+		XMMATRIX view;
+		XMMATRIX projection;
+		XMMATRIX dequantize;
+	};
+
+	struct ObjectType
+	{
+		XMMATRIX world;
+	};
+
+	// counted since the last BeginFrame. the copies of the fallback are counted by the device state of the context they were recorded on.
+	struct StatisticsType
+	{
+		int maps;
+		int objects;
+		unsigned long long bytesMapped;
+		bool offsetBinding;
+	};
+
+public:
+	ConstantDataClass();
+	ConstantDataClass(const ConstantDataClass&);
+	~ConstantDataClass();
+
+	// the ring holds objectCapacity blocks, a batch of objects bigger than that is uploaded in several parts.
+	bool Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext, int objectCapacity);
+	void Shutdown();
+
+	bool BeginFrame(DeviceStateClass* deviceState, const XMMATRIX& viewMatrix, const XMMATRIX& projectionMatrix, const XMMATRIX& dequantizeMatrix);
+
+	// uploads as many of the world matrices as fit and returns how many that was, they are bound as objects 0 to count - 1.
+	// the objects of the previous upload can not be bound any more.
+	int UploadObjects(DeviceStateClass* deviceState, const XMMATRIX* worldMatrices, int count);
+
+	// the binds change nothing here, several threads can record them into their own contexts at once.
+	void BindFrame(DeviceStateClass* deviceState, unsigned int slot);
+	void BindObject(DeviceStateClass* deviceState, unsigned int slot, int object);
+
+	void GetStatistics(StatisticsType& statistics);
+
+private:
+	ID3D11Buffer* m_frameBuffer;
+
+	// offset binding, the ring is null when the device can not do it.
+	ID3D11Buffer* m_ringBuffer;
+	bool m_noOverwrite;
+
+	// copy fallback.
+	ID3D11Buffer* m_stagingBuffers[CONSTANT_STAGING_BUFFERS];
+	ID3D11Buffer* m_objectBuffer;
+	int m_stagingIndex;
+
+	int m_capacity;
+	// the next free block in the ring and the first block of the current upload.
+	int m_ringHead;
+	int m_uploadStart;
+	int m_uploadCount;
+
+	StatisticsType m_statistics;
+};
+
+#endif
@@ -2,14 +2,25 @@
 
 D3DClass::D3DClass()
 {
+	int i;
+
 	m_swapChain = 0;
 	m_device = 0;
 	m_deviceContext = 0;
 	m_renderTargetView = 0;
 	m_depthStencilBuffer = 0;
+	m_PipelineStates = 0;
+	m_DeviceState = 0;
 	m_depthStencilState = 0;
 	m_depthStencilView = 0;
 	m_rasterState = 0;
+	m_blendState = 0;
+	for(i = 0; i < FRAME_QUERY_COUNT; i++)
+	{
+		m_frameQueries[i] = 0;
+	}
+	m_submittedFrame = 0;
+	m_completedFrame = 0;
 }
 
 D3DClass::D3DClass(const D3DClass&)
@@ -39,7 +50,9 @@ bool D3DClass::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hw
 	D3D11_DEPTH_STENCIL_DESC depthStencilDesc;
 	D3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc;
 	D3D11_RASTERIZER_DESC rasterDesc;
+	D3D11_BLEND_DESC blendDesc;
 	D3D11_VIEWPORT viewport;
+	D3D11_QUERY_DESC queryDesc;
 	float fieldOfView, screenAspect;
 
 	// store the vsync setting
@@ -349,9 +362,24 @@ bool D3DClass::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hw
 	 * With the description filled out we can now create a depth stencil state.
 	 */
 
+	/*
+	 * states are not created straight on the device but through the pipeline state cache.
+	 * it hands back the same object for the same description, so the pipelines the shaders make later share these.
+	 */
+	m_PipelineStates = new PipelineStateClass;
+	if(!m_PipelineStates)
+	{
+		return false;
+	}
+
+	if(!m_PipelineStates->Initialize(m_device))
+	{
+		return false;
+	}
+
 	// create the depth stencil state.
-	result = m_device->CreateDepthStencilState(&depthStencilDesc, &m_depthStencilState);
-	if(FAILED(result))
+	m_depthStencilState = m_PipelineStates->GetDepthStencilState(depthStencilDesc);
+	if(!m_depthStencilState)
 	{
 		return false;
 	}
@@ -418,8 +446,8 @@ bool D3DClass::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hw
 	rasterDesc.SlopeScaledDepthBias = 0.0f;
 
 	// create the rasterizer state from the description we just filled out.
-	result = m_device->CreateRasterizerState(&rasterDesc, &m_rasterState);
-	if(FAILED(result))
+	m_rasterState = m_PipelineStates->GetRasterizerState(rasterDesc);
+	if(!m_rasterState)
 	{
 		return false;
 	}
@@ -427,6 +455,53 @@ bool D3DClass::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hw
 	// now set the rasterizer state.
 	m_deviceContext->RSSetState(m_rasterState);
 
+	// blending stays off, the state is made anyway so pipelines have a description to start from.
+	ZeroMemory(&blendDesc, sizeof(blendDesc));
+	blendDesc.RenderTarget[0].BlendEnable = false;
+	blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_ONE;
+	blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_ZERO;
+	blendDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+	blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+	blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ZERO;
+	blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+	blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+
+	m_blendState = m_PipelineStates->GetBlendState(blendDesc);
+	if(!m_blendState)
+	{
+		return false;
+	}
+
+	m_deviceContext->OMSetBlendState(m_blendState, NULL, 0xFFFFFFFF);
+
+	m_PipelineStates->SetDefaultStates(rasterDesc, depthStencilDesc, blendDesc, 1);
+
+	// binds from here on go through the shadow, it starts out knowing nothing about what the states above set.
+	m_DeviceState = new DeviceStateClass;
+	if(!m_DeviceState)
+	{
+		return false;
+	}
+
+	if(!m_DeviceState->Initialize(m_deviceContext))
+	{
+		return false;
+	}
+
+	// the end of every frame is marked with an event, so it is known when the gpu is done with what the frame used.
+	queryDesc.Query = D3D11_QUERY_EVENT;
+	queryDesc.MiscFlags = 0;
+	for(i = 0; i < FRAME_QUERY_COUNT; i++)
+	{
+		result = m_device->CreateQuery(&queryDesc, &m_frameQueries[i]);
+		if(FAILED(result))
+		{
+			return false;
+		}
+	}
+	m_submittedFrame = 0;
+	m_completedFrame = 0;
+
 	/*
 	 * the viewport also needs to be setup so that direct3d can map clip space coordinates to the render target space.
 	 * set this to be the entire size of the window.
@@ -486,28 +561,47 @@ bool D3DClass::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hw
 
 void D3DClass::Shutdown()
 {
+	int i;
+
 	// Before shutting down set to windowed mode or when you release the swap chain it will throw an exception.
 	if (m_swapChain)
 	{
 		m_swapChain->SetFullscreenState(false, NULL);
 	}
 
-	if (m_rasterState)
+	for(i = 0; i < FRAME_QUERY_COUNT; i++)
 	{
-		m_rasterState->Release();
-		m_rasterState = 0;
+		if(m_frameQueries[i])
+		{
+			m_frameQueries[i]->Release();
+			m_frameQueries[i] = 0;
+		}
 	}
 
-	if (m_depthStencilView)
+	if (m_DeviceState)
 	{
-		m_depthStencilView->Release();
-		m_depthStencilView = 0;
+		m_DeviceState->Shutdown();
+		delete m_DeviceState;
+		m_DeviceState = 0;
 	}
 
-	if (m_depthStencilState)
+	// the states go with the cache that made them.
+	m_blendState = 0;
+	m_rasterState = 0;
+	m_depthStencilState = 0;
+
+	if (m_PipelineStates)
+	{
+		m_PipelineStates->Shutdown();
+		delete m_PipelineStates;
+		m_PipelineStates = 0;
+	m_DeviceState = 0;
+	}
+
+	if (m_depthStencilView)
 	{
-		m_depthStencilState->Release();
-		m_depthStencilState = 0;
+		m_depthStencilView->Release();
+		m_depthStencilView = 0;
 	}
 
 	if (m_depthStencilBuffer)
@@ -561,6 +655,16 @@ void D3DClass::BeginScene(float red, float green, float blue, float alpha)
 
 void D3DClass::EndScene()
 {
+	// the query is reused from FRAME_QUERY_COUNT frames back, that frame has to be finished first. DXGI blocks Present
+	// long before the cpu gets this far ahead, so this hardly ever waits.
+	while(m_submittedFrame >= FRAME_QUERY_COUNT && GetCompletedFrame() <= m_submittedFrame - FRAME_QUERY_COUNT)
+	{
+		m_deviceContext->Flush();
+	}
+
+	m_deviceContext->End(m_frameQueries[m_submittedFrame % FRAME_QUERY_COUNT]);
+	m_submittedFrame++;
+
 	// Present the back buffer to the screen since rendering is complete.
 	if (m_vsync_enabled)
 	{
@@ -574,6 +678,30 @@ void D3DClass::EndScene()
 	}
 }
 
+unsigned long long D3DClass::GetSubmittedFrame()
+{
+	return m_submittedFrame;
+}
+
+unsigned long long D3DClass::GetCompletedFrame()
+{
+	HRESULT result;
+
+	// frames finish in order, stop at the first one that is still running. polling does not flush, the frame is submitted anyway.
+	while(m_completedFrame < m_submittedFrame)
+	{
+		result = m_deviceContext->GetData(m_frameQueries[m_completedFrame % FRAME_QUERY_COUNT], NULL, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH);
+		if(result != S_OK)
+		{
+			break;
+		}
+
+		m_completedFrame++;
+	}
+
+	return m_completedFrame;
+}
+
 ID3D11Device* D3DClass::GetDevice()
 {
 	return m_device;
@@ -584,6 +712,16 @@ ID3D11DeviceContext* D3DClass::GetDeviceContext()
 	return m_deviceContext;
 }
 
+PipelineStateClass* D3DClass::GetPipelineStates()
+{
+	return m_PipelineStates;
+}
+
+DeviceStateClass* D3DClass::GetDeviceState()
+{
+	return m_DeviceState;
+}
+
 
 void D3DClass::GetProjectionMatrix(XMMATRIX& projectionMatrix)
 {
@@ -609,3 +747,13 @@ void D3DClass::GetVideoCardInfo(char* cardName, int& memory)
 	memory = m_videoCardMemory;
 	return;
 }
+
+void D3DClass::PublishMetrics(MetricsClass* metrics)
+{
+	int videoMemory;
+
+	videoMemory = metrics->AddGauge("engine_video_memory_bytes", "Dedicated video memory of the adapter the device was created on.");
+	metrics->Set(videoMemory, (double)m_videoCardMemory * 1024.0 * 1024.0);
+
+	return;
+}
@@ -7,10 +7,17 @@
 #pragma comment(lib, "d3dcompiler.lib")
 
 #include <d3d11.h>
-#include <directxmath.h>
+#include <DirectXMath.h>
 using namespace DirectX;
 
-class D3DClass
+#include "metricsclass.h"
+#include "renderbackendclass.h"
+#include "pipelinestateclass.h"
+
+// event queries marking the end of each frame, more than the frames DXGI lets the cpu queue up ahead of the gpu.
+const int FRAME_QUERY_COUNT = 8;
+
+class D3DClass : public RenderBackendClass
 {
 public:
 	D3DClass();
@@ -28,6 +35,10 @@ public:
 
 	ID3D11Device* GetDevice();
 	ID3D11DeviceContext* GetDeviceContext();
+	// the state cache every pipeline on this device comes from, its defaults are the states set up below.
+	PipelineStateClass* GetPipelineStates();
+	// the immediate context with redundant binds filtered out, everything the renderer binds goes through it.
+	DeviceStateClass* GetDeviceState();
 
 	void GetProjectionMatrix(XMMATRIX& projectionMatrix);
 
@@ -35,6 +46,10 @@ public:
 	void GetOrthoMatrix(XMMATRIX& orthoMatrix);
 
 	void GetVideoCardInfo(char*, int&);
+	unsigned long long GetSubmittedFrame();
+	unsigned long long GetCompletedFrame();
+	// registers the adapter's gauges with the registry and sets them, they do not change after Initialize.
+	void PublishMetrics(MetricsClass* metrics);
 
 private:
 	bool m_vsync_enabled;
@@ -45,10 +60,18 @@ private:
 	ID3D11DeviceContext* m_deviceContext;
 	ID3D11RenderTargetView* m_renderTargetView;
 	ID3D11Texture2D* m_depthStencilBuffer;
+	PipelineStateClass* m_PipelineStates;
+	DeviceStateClass* m_DeviceState;
+	// owned by the pipeline states.
 	ID3D11DepthStencilState* m_depthStencilState;
 	ID3D11DepthStencilView* m_depthStencilView;
 	ID3D11RasterizerState* m_rasterState;
+	ID3D11BlendState* m_blendState;
 	XMMATRIX m_projectionMatrix;
 	XMMATRIX m_worldMatrix;
 	XMMATRIX m_orthoMatrix;
+	// frame n's query is m_frameQueries[(n - 1) % FRAME_QUERY_COUNT].
+	ID3D11Query* m_frameQueries[FRAME_QUERY_COUNT];
+	unsigned long long m_submittedFrame;
+	unsigned long long m_completedFrame;
 };
\ No newline at end of file
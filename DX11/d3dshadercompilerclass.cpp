@@ -0,0 +1,178 @@
+#include "d3dshadercompilerclass.h"
+
+#include <cstdio>
+
+static void CopyName(char* destination, const char* source)
+{
+	unsigned int i;
+
+	for(i = 0; source && source[i] && i < SHADER_NAME_LENGTH - 1; i++)
+	{
+		destination[i] = source[i];
+	}
+	destination[i] = 0;
+
+	return;
+}
+
+D3DShaderCompilerClass::D3DShaderCompilerClass()
+{
+	snprintf(m_name, sizeof(m_name), "d3dcompiler_%d", (int)D3D_COMPILER_VERSION);
+}
+
+D3DShaderCompilerClass::D3DShaderCompilerClass(const D3DShaderCompilerClass&)
+{
+}
+
+D3DShaderCompilerClass::~D3DShaderCompilerClass()
+{
+}
+
+const char* D3DShaderCompilerClass::GetName()
+{
+	return m_name;
+}
+
+bool D3DShaderCompilerClass::Compile(const char* source, unsigned long long sourceSize, const char* sourceName, const char* const* defines, int defineCount,
+	const char* entryPoint, const char* profile, unsigned int flags, std::vector<unsigned char>& bytecode, ShaderReflectionType& reflection,
+	std::string& errors)
+{
+	HRESULT result;
+	std::vector<D3D_SHADER_MACRO> macros;
+	D3D_SHADER_MACRO macro;
+	ID3D10Blob* shaderBuffer;
+	ID3D10Blob* errorMessage;
+	const unsigned char* data;
+	bool reflected;
+	int i;
+
+	shaderBuffer = nullptr;
+	errorMessage = nullptr;
+
+	// the macro list ends with an empty one.
+	for(i = 0; i < defineCount; i++)
+	{
+		macro.Name = defines[i];
+		macro.Definition = "1";
+		macros.push_back(macro);
+	}
+	macro.Name = NULL;
+	macro.Definition = NULL;
+	macros.push_back(macro);
+
+	result = D3DCompile(source, (SIZE_T)sourceSize, sourceName, macros.data(), D3D_COMPILE_STANDARD_FILE_INCLUDE, entryPoint, profile, flags, 0,
+		&shaderBuffer, &errorMessage);
+	if(errorMessage)
+	{
+		errors.assign((const char*)errorMessage->GetBufferPointer(), errorMessage->GetBufferSize());
+		errorMessage->Release();
+		errorMessage = nullptr;
+	}
+
+	if(FAILED(result) || !shaderBuffer)
+	{
+		if(shaderBuffer)
+		{
+			shaderBuffer->Release();
+		}
+		return false;
+	}
+
+	data = (const unsigned char*)shaderBuffer->GetBufferPointer();
+	bytecode.assign(data, data + shaderBuffer->GetBufferSize());
+
+	reflected = Reflect(shaderBuffer->GetBufferPointer(), shaderBuffer->GetBufferSize(), reflection);
+
+	shaderBuffer->Release();
+	shaderBuffer = nullptr;
+
+	if(!reflected)
+	{
+		errors += "shader reflection failed\n";
+		return false;
+	}
+
+	return true;
+}
+
+bool D3DShaderCompilerClass::Reflect(const void* bytecode, SIZE_T bytecodeSize, ShaderReflectionType& reflection)
+{
+	HRESULT result;
+	ID3D11ShaderReflection* reflector;
+	ID3D11ShaderReflectionConstantBuffer* constantBuffer;
+	D3D11_SHADER_DESC shaderDesc;
+	D3D11_SHADER_BUFFER_DESC bufferDesc;
+	D3D11_SHADER_INPUT_BIND_DESC bindDesc;
+	D3D11_SIGNATURE_PARAMETER_DESC parameterDesc;
+	ShaderConstantBufferType constantBufferRecord;
+	ShaderInputType inputRecord;
+	ShaderResourceType resourceRecord;
+	unsigned int i;
+
+	reflection.constantBuffers.clear();
+	reflection.inputs.clear();
+	reflection.resources.clear();
+
+	result = D3DReflect(bytecode, bytecodeSize, IID_ID3D11ShaderReflection, (void**)&reflector);
+	if(FAILED(result))
+	{
+		return false;
+	}
+
+	result = reflector->GetDesc(&shaderDesc);
+	if(FAILED(result))
+	{
+		reflector->Release();
+		return false;
+	}
+
+	for(i = 0; i < shaderDesc.InputParameters; i++)
+	{
+		if(FAILED(reflector->GetInputParameterDesc(i, &parameterDesc)))
+		{
+			continue;
+		}
+
+		CopyName(inputRecord.semanticName, parameterDesc.SemanticName);
+		inputRecord.semanticIndex = parameterDesc.SemanticIndex;
+		inputRecord.componentType = (unsigned int)parameterDesc.ComponentType;
+		inputRecord.mask = parameterDesc.Mask;
+		reflection.inputs.push_back(inputRecord);
+	}
+
+	// the bindings say where everything goes, constant buffers get their size from the buffer of the same name.
+	for(i = 0; i < shaderDesc.BoundResources; i++)
+	{
+		if(FAILED(reflector->GetResourceBindingDesc(i, &bindDesc)))
+		{
+			continue;
+		}
+
+		if(bindDesc.Type == D3D_SIT_CBUFFER)
+		{
+			constantBuffer = reflector->GetConstantBufferByName(bindDesc.Name);
+			if(!constantBuffer || FAILED(constantBuffer->GetDesc(&bufferDesc)))
+			{
+				continue;
+			}
+
+			CopyName(constantBufferRecord.name, bindDesc.Name);
+			constantBufferRecord.slot = bindDesc.BindPoint;
+			constantBufferRecord.size = bufferDesc.Size;
+			reflection.constantBuffers.push_back(constantBufferRecord);
+		}
+		else
+		{
+			CopyName(resourceRecord.name, bindDesc.Name);
+			resourceRecord.type = (unsigned int)bindDesc.Type;
+			resourceRecord.slot = bindDesc.BindPoint;
+			resourceRecord.count = bindDesc.BindCount;
+			reflection.resources.push_back(resourceRecord);
+		}
+	}
+
+	reflector->Release();
+	reflector = nullptr;
+
+	return true;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#ifndef _D3DSHADERCOMPILERCLASS_H_
+#define _D3DSHADERCOMPILERCLASS_H_
+
+#pragma comment(lib, "d3dcompiler.lib")
+#pragma comment(lib, "dxguid.lib")
+
+#include <d3d11.h>
+#include <d3dcompiler.h>
+#include <d3d11shader.h>
+
+#include "shadercompilerclass.h"
+
+// compiles with d3dcompiler and fills the reflection data from ID3D11ShaderReflection.
+class D3DShaderCompilerClass : public ShaderCompilerClass
+{
+public:
+	D3DShaderCompilerClass();
+	D3DShaderCompilerClass(const D3DShaderCompilerClass&);
+	~D3DShaderCompilerClass();
+
+	const char* GetName();
+	bool Compile(const char* source, unsigned long long sourceSize, const char* sourceName, const char* const* defines, int defineCount,
+		const char* entryPoint, const char* profile, unsigned int flags, std::vector<unsigned char>& bytecode, ShaderReflectionType& reflection,
+		std::string& errors);
+
+private:
+	bool Reflect(const void* bytecode, SIZE_T bytecodeSize, ShaderReflectionType& reflection);
+
+private:
+	char m_name[32];
+};
+
+#endif
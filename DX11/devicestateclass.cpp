@@ -0,0 +1,367 @@
+#include "devicestateclass.h"
+
+#include <cstring>
+
+DeviceStateClass::DeviceStateClass()
+{
+	m_deviceContext = nullptr;
+	m_deviceContext1 = nullptr;
+	memset(&m_frame, 0, sizeof(m_frame));
+	memset(&m_lastFrame, 0, sizeof(m_lastFrame));
+	Invalidate();
+}
+
+DeviceStateClass::DeviceStateClass(const DeviceStateClass&)
+{
+}
+
+DeviceStateClass::~DeviceStateClass()
+{
+}
+
+bool DeviceStateClass::Initialize(ID3D11DeviceContext* deviceContext)
+{
+	HRESULT result;
+
+	if(!deviceContext)
+	{
+		return false;
+	}
+
+	m_deviceContext = deviceContext;
+
+	// only there on direct 3d 11.1 and later, range binds fail without it.
+	result = deviceContext->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)&m_deviceContext1);
+	if(FAILED(result))
+	{
+		m_deviceContext1 = nullptr;
+	}
+
+	Invalidate();
+
+	return true;
+}
+
+void DeviceStateClass::Shutdown()
+{
+	if(m_deviceContext1)
+	{
+		m_deviceContext1->Release();
+		m_deviceContext1 = nullptr;
+	}
+
+	m_deviceContext = nullptr;
+
+	return;
+}
+
+ID3D11DeviceContext* DeviceStateClass::GetDeviceContext()
+{
+	return m_deviceContext;
+}
+
+void DeviceStateClass::Invalidate()
+{
+	int i;
+
+	for(i = 0; i < STATE_COUNT; i++)
+	{
+		m_stateKnown[i] = false;
+	}
+
+	for(i = 0; i < DEVICE_STATE_VERTEX_SLOTS; i++)
+	{
+		m_vertexBufferKnown[i] = false;
+	}
+
+	for(i = 0; i < DEVICE_STATE_CONSTANT_SLOTS; i++)
+	{
+		m_constantBufferKnown[i] = false;
+	}
+
+	return;
+}
+
+void DeviceStateClass::BeginFrame()
+{
+	memset(&m_frame, 0, sizeof(m_frame));
+	return;
+}
+
+void DeviceStateClass::EndFrame()
+{
+	m_lastFrame = m_frame;
+	return;
+}
+
+void DeviceStateClass::GetStatistics(StatisticsType& statistics)
+{
+	statistics = m_lastFrame;
+	return;
+}
+
+void DeviceStateClass::AddStatistics(const StatisticsType& statistics)
+{
+	m_frame.issued += statistics.issued;
+	m_frame.elided += statistics.elided;
+	m_frame.draws += statistics.draws;
+	m_frame.maps += statistics.maps;
+	m_frame.copies += statistics.copies;
+	m_frame.bytesMapped += statistics.bytesMapped;
+	return;
+}
+
+void DeviceStateClass::IASetInputLayout(ID3D11InputLayout* inputLayout)
+{
+	if(m_stateKnown[STATE_INPUT_LAYOUT] && m_inputLayout == inputLayout)
+	{
+		m_frame.elided++;
+		return;
+	}
+
+	m_deviceContext->IASetInputLayout(inputLayout);
+	m_inputLayout = inputLayout;
+	m_stateKnown[STATE_INPUT_LAYOUT] = true;
+	m_frame.issued++;
+
+	return;
+}
+
+void DeviceStateClass::IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+	if(m_stateKnown[STATE_TOPOLOGY] && m_topology == topology)
+	{
+		m_frame.elided++;
+		return;
+	}
+
+	m_deviceContext->IASetPrimitiveTopology(topology);
+	m_topology = topology;
+	m_stateKnown[STATE_TOPOLOGY] = true;
+	m_frame.issued++;
+
+	return;
+}
+
+void DeviceStateClass::IASetVertexBuffer(unsigned int slot, ID3D11Buffer* buffer, unsigned int stride, unsigned int offset)
+{
+	bool shadowed;
+
+	shadowed = slot < (unsigned int)DEVICE_STATE_VERTEX_SLOTS;
+	if(shadowed && m_vertexBufferKnown[slot] && m_vertexBuffers[slot].buffer == buffer && m_vertexBuffers[slot].stride == stride &&
+		m_vertexBuffers[slot].offset == offset)
+	{
+		m_frame.elided++;
+		return;
+	}
+
+	m_deviceContext->IASetVertexBuffers(slot, 1, &buffer, &stride, &offset);
+	if(shadowed)
+	{
+		m_vertexBuffers[slot].buffer = buffer;
+		m_vertexBuffers[slot].stride = stride;
+		m_vertexBuffers[slot].offset = offset;
+		m_vertexBufferKnown[slot] = true;
+	}
+	m_frame.issued++;
+
+	return;
+}
+
+void DeviceStateClass::IASetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset)
+{
+	if(m_stateKnown[STATE_INDEX_BUFFER] && m_indexBuffer == buffer && m_indexFormat == format && m_indexOffset == offset)
+	{
+		m_frame.elided++;
+		return;
+	}
+
+	m_deviceContext->IASetIndexBuffer(buffer, format, offset);
+	m_indexBuffer = buffer;
+	m_indexFormat = format;
+	m_indexOffset = offset;
+	m_stateKnown[STATE_INDEX_BUFFER] = true;
+	m_frame.issued++;
+
+	return;
+}
+
+void DeviceStateClass::VSSetShader(ID3D11VertexShader* shader)
+{
+	if(m_stateKnown[STATE_VERTEX_SHADER] && m_vertexShader == shader)
+	{
+		m_frame.elided++;
+		return;
+	}
+
+	m_deviceContext->VSSetShader(shader, NULL, 0);
+	m_vertexShader = shader;
+	m_stateKnown[STATE_VERTEX_SHADER] = true;
+	m_frame.issued++;
+
+	return;
+}
+
+void DeviceStateClass::PSSetShader(ID3D11PixelShader* shader)
+{
+	if(m_stateKnown[STATE_PIXEL_SHADER] && m_pixelShader == shader)
+	{
+		m_frame.elided++;
+		return;
+	}
+
+	m_deviceContext->PSSetShader(shader, NULL, 0);
+	m_pixelShader = shader;
+	m_stateKnown[STATE_PIXEL_SHADER] = true;
+	m_frame.issued++;
+
+	return;
+}
+
+void DeviceStateClass::VSSetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer)
+{
+	bool shadowed;
+
+	shadowed = slot < (unsigned int)DEVICE_STATE_CONSTANT_SLOTS;
+	if(shadowed && m_constantBufferKnown[slot] && m_constantBuffers[slot].buffer == buffer && m_constantBuffers[slot].constantCount == 0)
+	{
+		m_frame.elided++;
+		return;
+	}
+
+	m_deviceContext->VSSetConstantBuffers(slot, 1, &buffer);
+	if(shadowed)
+	{
+		m_constantBuffers[slot].buffer = buffer;
+		m_constantBuffers[slot].firstConstant = 0;
+		m_constantBuffers[slot].constantCount = 0;
+		m_constantBufferKnown[slot] = true;
+	}
+	m_frame.issued++;
+
+	return;
+}
+
+bool DeviceStateClass::VSSetConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int constantCount)
+{
+	bool shadowed;
+
+	if(!m_deviceContext1)
+	{
+		return false;
+	}
+
+	shadowed = slot < (unsigned int)DEVICE_STATE_CONSTANT_SLOTS;
+	if(shadowed && m_constantBufferKnown[slot] && m_constantBuffers[slot].buffer == buffer && m_constantBuffers[slot].firstConstant == firstConstant &&
+		m_constantBuffers[slot].constantCount == constantCount)
+	{
+		m_frame.elided++;
+		return true;
+	}
+
+	m_deviceContext1->VSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &constantCount);
+	if(shadowed)
+	{
+		m_constantBuffers[slot].buffer = buffer;
+		m_constantBuffers[slot].firstConstant = firstConstant;
+		m_constantBuffers[slot].constantCount = constantCount;
+		m_constantBufferKnown[slot] = true;
+	}
+	m_frame.issued++;
+
+	return true;
+}
+
+void DeviceStateClass::RSSetState(ID3D11RasterizerState* state)
+{
+	if(m_stateKnown[STATE_RASTERIZER] && m_rasterizerState == state)
+	{
+		m_frame.elided++;
+		return;
+	}
+
+	m_deviceContext->RSSetState(state);
+	m_rasterizerState = state;
+	m_stateKnown[STATE_RASTERIZER] = true;
+	m_frame.issued++;
+
+	return;
+}
+
+void DeviceStateClass::OMSetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef)
+{
+	if(m_stateKnown[STATE_DEPTH_STENCIL] && m_depthStencilState == state && m_stencilRef == stencilRef)
+	{
+		m_frame.elided++;
+		return;
+	}
+
+	m_deviceContext->OMSetDepthStencilState(state, stencilRef);
+	m_depthStencilState = state;
+	m_stencilRef = stencilRef;
+	m_stateKnown[STATE_DEPTH_STENCIL] = true;
+	m_frame.issued++;
+
+	return;
+}
+
+void DeviceStateClass::OMSetBlendState(ID3D11BlendState* state)
+{
+	// no blend factor and every sample, nothing in the renderer uses either.
+	if(m_stateKnown[STATE_BLEND] && m_blendState == state)
+	{
+		m_frame.elided++;
+		return;
+	}
+
+	m_deviceContext->OMSetBlendState(state, NULL, 0xFFFFFFFF);
+	m_blendState = state;
+	m_stateKnown[STATE_BLEND] = true;
+	m_frame.issued++;
+
+	return;
+}
+
+void DeviceStateClass::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	m_deviceContext->DrawIndexed(indexCount, startIndex, baseVertex);
+	m_frame.draws++;
+	return;
+}
+
+void DeviceStateClass::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex,
+	unsigned int startInstance)
+{
+	m_deviceContext->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+	m_frame.draws++;
+	return;
+}
+
+HRESULT DeviceStateClass::Map(ID3D11Resource* resource, D3D11_MAP mapType, D3D11_MAPPED_SUBRESOURCE* mappedResource, unsigned long long size)
+{
+	HRESULT result;
+
+	result = m_deviceContext->Map(resource, 0, mapType, 0, mappedResource);
+	if(FAILED(result))
+	{
+		return result;
+	}
+
+	m_frame.maps++;
+	m_frame.bytesMapped += size;
+
+	return result;
+}
+
+void DeviceStateClass::Unmap(ID3D11Resource* resource)
+{
+	m_deviceContext->Unmap(resource, 0);
+	return;
+}
+
+void DeviceStateClass::CopySubresourceRegion(ID3D11Resource* destination, unsigned int x, ID3D11Resource* source, const D3D11_BOX* box)
+{
+	m_deviceContext->CopySubresourceRegion(destination, 0, x, 0, 0, source, 0, box);
+	m_frame.copies++;
+	return;
+}
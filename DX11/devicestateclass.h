@@ -0,0 +1,128 @@
+#pragma once
+#ifndef _DEVICESTATECLASS_H_
+#define _DEVICESTATECLASS_H_
+
+#include <d3d11_1.h>
+
+// input assembler and vertex shader constant slots that are shadowed, binds past them are always issued.
+const int DEVICE_STATE_VERTEX_SLOTS = 4;
+const int DEVICE_STATE_CONSTANT_SLOTS = 4;
+
+/*
+ * a shadow of what is bound to a device context, every bind of the renderer goes through it.
+ * a call that sets what is already bound is dropped before it reaches the driver, everything else is passed on and remembered.
+ * bound objects are compared by pointer, that is safe because the context keeps a reference to whatever is bound,
+ * so no new object can be created at the address of one the shadow still thinks is there.
+ * it also counts the calls issued and elided, the draws, the maps and the bytes mapped, per frame.
+ */
+class DeviceStateClass
+{
+public:
+	struct StatisticsType
+	{
+		int issued;
+		int elided;
+		int draws;
+		int maps;
+		int copies;
+		unsigned long long bytesMapped;
+	};
+
+public:
+	DeviceStateClass();
+	DeviceStateClass(const DeviceStateClass&);
+	~DeviceStateClass();
+
+	bool Initialize(ID3D11DeviceContext* deviceContext);
+	void Shutdown();
+
+	ID3D11DeviceContext* GetDeviceContext();
+
+	// forget what is bound, for when something outside the shadow may have changed it.
+	void Invalidate();
+
+	// the counters start over at BeginFrame, EndFrame keeps them as the last frame's.
+	void BeginFrame();
+	void EndFrame();
+	void GetStatistics(StatisticsType& statistics);
+	// counts calls made elsewhere as this frame's, the deferred contexts' once their command lists ran here.
+	void AddStatistics(const StatisticsType& statistics);
+
+	void IASetInputLayout(ID3D11InputLayout* inputLayout);
+	void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology);
+	void IASetVertexBuffer(unsigned int slot, ID3D11Buffer* buffer, unsigned int stride, unsigned int offset);
+	void IASetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset);
+	void VSSetShader(ID3D11VertexShader* shader);
+	void PSSetShader(ID3D11PixelShader* shader);
+	void VSSetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer);
+	// binds part of a buffer, needs the direct 3d 11.1 context. false when there is none.
+	bool VSSetConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int constantCount);
+	void RSSetState(ID3D11RasterizerState* state);
+	void OMSetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef);
+	void OMSetBlendState(ID3D11BlendState* state);
+
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+	void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance);
+
+	// size is how many bytes the caller is going to write, it only goes into the counters.
+	HRESULT Map(ID3D11Resource* resource, D3D11_MAP mapType, D3D11_MAPPED_SUBRESOURCE* mappedResource, unsigned long long size);
+	void Unmap(ID3D11Resource* resource);
+	void CopySubresourceRegion(ID3D11Resource* destination, unsigned int x, ID3D11Resource* source, const D3D11_BOX* box);
+
+private:
+	// the shadowed states that are not slots, to index m_stateKnown with.
+	enum StateType
+	{
+		STATE_INPUT_LAYOUT,
+		STATE_TOPOLOGY,
+		STATE_INDEX_BUFFER,
+		STATE_VERTEX_SHADER,
+		STATE_PIXEL_SHADER,
+		STATE_RASTERIZER,
+		STATE_DEPTH_STENCIL,
+		STATE_BLEND,
+		STATE_COUNT
+	};
+
+	struct VertexBufferType
+	{
+		ID3D11Buffer* buffer;
+		unsigned int stride;
+		unsigned int offset;
+	};
+
+	struct ConstantBufferType
+	{
+		ID3D11Buffer* buffer;
+		// 0 and 0 for a whole buffer.
+		unsigned int firstConstant;
+		unsigned int constantCount;
+	};
+
+private:
+	ID3D11DeviceContext* m_deviceContext;
+	ID3D11DeviceContext1* m_deviceContext1;
+
+	// a state that is not known is always set, the value next to it is meaningless until then.
+	bool m_stateKnown[STATE_COUNT];
+	ID3D11InputLayout* m_inputLayout;
+	D3D11_PRIMITIVE_TOPOLOGY m_topology;
+	VertexBufferType m_vertexBuffers[DEVICE_STATE_VERTEX_SLOTS];
+	bool m_vertexBufferKnown[DEVICE_STATE_VERTEX_SLOTS];
+	ID3D11Buffer* m_indexBuffer;
+	DXGI_FORMAT m_indexFormat;
+	unsigned int m_indexOffset;
+	ID3D11VertexShader* m_vertexShader;
+	ID3D11PixelShader* m_pixelShader;
+	ConstantBufferType m_constantBuffers[DEVICE_STATE_CONSTANT_SLOTS];
+	bool m_constantBufferKnown[DEVICE_STATE_CONSTANT_SLOTS];
+	ID3D11RasterizerState* m_rasterizerState;
+	ID3D11DepthStencilState* m_depthStencilState;
+	unsigned int m_stencilRef;
+	ID3D11BlendState* m_blendState;
+
+	StatisticsType m_frame;
+	StatisticsType m_lastFrame;
+};
+
+#endif
@@ -0,0 +1,524 @@
+#include "drawlistclass.h"
+
+#include <cstring>
+
+// keys per range of the parallel sort.
+static const int SORT_RANGE_SIZE = 16384;
+// widest digit of the serial sort. a digit is kept a little narrower than the index so there are fewer counters than keys.
+static const int SORT_MAX_DIGIT_BITS = 16;
+static const int SORT_MIN_DIGIT_BITS = 8;
+// widest digit when there is more than one pass. the single pass only writes indices, the others move the keys as well
+// and scatter them to fewer places at a time.
+static const int SORT_MAX_MOVE_DIGIT_BITS = 13;
+// widest digit of the parallel sort, every range has counters of its own and they are all summed up between the passes.
+static const int SORT_PARALLEL_DIGIT_BITS = 11;
+static const int SORT_PARALLEL_BUCKETS = 1 << SORT_PARALLEL_DIGIT_BITS;
+
+DrawListClass::DrawListClass()
+{
+	m_capacity = 0;
+	m_count = 0;
+	m_runCount = 0;
+	m_narrow = true;
+	m_indexBits = 0;
+	m_digitBits = 0;
+	m_passCount = 0;
+	m_phase = PHASE_COUNT;
+	m_pass = 0;
+	m_jobSystem = nullptr;
+}
+
+DrawListClass::DrawListClass(const DrawListClass&)
+{
+}
+
+DrawListClass::~DrawListClass()
+{
+}
+
+bool DrawListClass::Initialize(int capacity, JobSystemClass* jobSystem)
+{
+	if(capacity <= 0 || !jobSystem)
+	{
+		return false;
+	}
+
+	m_jobSystem = jobSystem;
+	m_capacity = capacity;
+	m_count = 0;
+	m_packets.resize((size_t)capacity);
+	m_keys.resize((size_t)capacity);
+	m_order.resize((size_t)capacity);
+	m_sortKeys[0].resize((size_t)capacity);
+	m_sortKeys[1].resize((size_t)capacity);
+	m_sortPackets[0].resize((size_t)capacity);
+	m_sortPackets[1].resize((size_t)capacity);
+	// the counters of the pass being scattered and of the one after it.
+	m_histograms.resize((size_t)2 << SORT_MAX_DIGIT_BITS);
+
+	return true;
+}
+
+void DrawListClass::Shutdown()
+{
+	m_packets.clear();
+	m_keys.clear();
+	m_order.clear();
+	m_sortKeys[0].clear();
+	m_sortKeys[1].clear();
+	m_sortPackets[0].clear();
+	m_sortPackets[1].clear();
+	m_histograms.clear();
+	m_rangeCounts.clear();
+	m_capacity = 0;
+	m_count = 0;
+	m_jobSystem = nullptr;
+
+	return;
+}
+
+unsigned long long DrawListClass::MakeKey(unsigned int layer, unsigned int pipeline, unsigned int material, float depth, unsigned int geometry)
+{
+	unsigned long long key;
+	unsigned int bucket;
+
+	// depth outside the planes goes to the first or last bucket.
+	depth = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+	bucket = (unsigned int)(depth * (float)((1 << DRAW_KEY_DEPTH_BITS) - 1) + 0.5f);
+
+	key = (unsigned long long)(layer & ((1u << DRAW_KEY_LAYER_BITS) - 1));
+	key = (key << DRAW_KEY_PIPELINE_BITS) | (pipeline & ((1u << DRAW_KEY_PIPELINE_BITS) - 1));
+	key = (key << DRAW_KEY_MATERIAL_BITS) | (material & ((1u << DRAW_KEY_MATERIAL_BITS) - 1));
+	key = (key << DRAW_KEY_DEPTH_BITS) | bucket;
+	key = (key << DRAW_KEY_GEOMETRY_BITS) | (geometry & ((1u << DRAW_KEY_GEOMETRY_BITS) - 1));
+
+	return key;
+}
+
+void DrawListClass::Clear()
+{
+	m_count = 0;
+	return;
+}
+
+bool DrawListClass::Add(unsigned long long key, unsigned int pipeline, unsigned int geometry, int object)
+{
+	PacketType* packet;
+
+	if(m_count >= m_capacity)
+	{
+		return false;
+	}
+
+	packet = &m_packets[m_count];
+	packet->key = key;
+	packet->pipeline = pipeline;
+	packet->geometry = geometry;
+	packet->object = object;
+
+	m_keys[m_count] = key;
+	m_order[m_count] = (unsigned int)m_count;
+	m_count++;
+
+	return true;
+}
+
+void DrawListClass::Sort()
+{
+	unsigned long long varying, first;
+	int i, bit, bits, maxDigitBits;
+	bool parallel;
+
+	if(m_count <= 1)
+	{
+		return;
+	}
+
+	// a bit no two keys differ in can not change the order.
+	first = m_keys[0];
+	varying = 0;
+	for(i = 1; i < m_count; i++)
+	{
+		varying |= m_keys[i] ^ first;
+	}
+
+	// all keys equal, the order they were added in is the sorted one.
+	if(varying == 0)
+	{
+		return;
+	}
+
+	// the runs of differing bits, lowest first, so the shorter key keeps their order.
+	m_runCount = 0;
+	bits = 0;
+	bit = 0;
+	while(bit < 64)
+	{
+		if(!((varying >> bit) & 1))
+		{
+			bit++;
+			continue;
+		}
+
+		m_runShifts[m_runCount] = bit;
+		m_runDestinations[m_runCount] = bits;
+		while(bit < 64 && ((varying >> bit) & 1))
+		{
+			bit++;
+			bits++;
+		}
+		m_runMasks[m_runCount] = ((bits - m_runDestinations[m_runCount]) == 64) ? ~0ull : (1ull << (bits - m_runDestinations[m_runCount])) - 1;
+		m_runCount++;
+	}
+
+	// the index takes as many bits as the count needs, a shorter key that fits above it is sorted along with it as one value.
+	m_indexBits = 1;
+	while(m_indexBits < 32 && (1ull << m_indexBits) < (unsigned long long)m_count)
+	{
+		m_indexBits++;
+	}
+	m_narrow = bits + m_indexBits <= 64;
+
+	parallel = m_count >= DRAW_LIST_PARALLEL_THRESHOLD && m_jobSystem->GetThreadCount() > 1;
+	if(parallel)
+	{
+		maxDigitBits = SORT_PARALLEL_DIGIT_BITS;
+	}
+	else
+	{
+		maxDigitBits = m_indexBits - 1;
+		maxDigitBits = maxDigitBits < SORT_MIN_DIGIT_BITS ? SORT_MIN_DIGIT_BITS : (maxDigitBits > SORT_MAX_DIGIT_BITS ? SORT_MAX_DIGIT_BITS : maxDigitBits);
+		if(bits > maxDigitBits && maxDigitBits > SORT_MAX_MOVE_DIGIT_BITS)
+		{
+			maxDigitBits = SORT_MAX_MOVE_DIGIT_BITS;
+		}
+	}
+
+	// as few passes as the widest digit allows, with the bits spread evenly over them.
+	m_passCount = (bits + maxDigitBits - 1) / maxDigitBits;
+	m_digitBits = (bits + m_passCount - 1) / m_passCount;
+
+	if(parallel)
+	{
+		SortParallel();
+	}
+	else
+	{
+		SortSerial();
+	}
+
+	return;
+}
+
+int DrawListClass::GetCount()
+{
+	return m_count;
+}
+
+const DrawListClass::PacketType& DrawListClass::GetPacket(int index)
+{
+	return m_packets[m_order[index]];
+}
+
+static inline unsigned long long GatherKey(unsigned long long key, int runCount, const int* shifts, const int* destinations, const unsigned long long* masks)
+{
+	unsigned long long gathered;
+	int run;
+
+	if(runCount == 1)
+	{
+		return (key >> shifts[0]) & masks[0];
+	}
+
+	gathered = 0;
+	for(run = 0; run < runCount; run++)
+	{
+		gathered |= ((key >> shifts[run]) & masks[run]) << destinations[run];
+	}
+
+	return gathered;
+}
+
+void DrawListClass::CountRange(int pass, int first, int last, unsigned int* counts)
+{
+	const unsigned long long* keys;
+	unsigned long long masks[64];
+	unsigned int mask;
+	int i, runCount, shift, shifts[64], destinations[64];
+
+	mask = (1u << m_digitBits) - 1;
+	memset(counts, 0, sizeof(unsigned int) << m_digitBits);
+
+	// the first pass reads the keys as they were added and gathers the bits that differ on the way, only the runs the first digit is in.
+	if(pass == 0)
+	{
+		keys = m_keys.data();
+		runCount = 0;
+		while(runCount < m_runCount && m_runDestinations[runCount] < m_digitBits)
+		{
+			shifts[runCount] = m_runShifts[runCount];
+			destinations[runCount] = m_runDestinations[runCount];
+			masks[runCount] = m_runMasks[runCount];
+			runCount++;
+		}
+
+		for(i = first; i < last; i++)
+		{
+			counts[(unsigned int)GatherKey(keys[i], runCount, shifts, destinations, masks) & mask]++;
+		}
+
+		return;
+	}
+
+	keys = m_sortKeys[(pass - 1) & 1].data();
+	shift = (m_narrow ? m_indexBits : 0) + pass * m_digitBits;
+	for(i = first; i < last; i++)
+	{
+		counts[(unsigned int)(keys[i] >> shift) & mask]++;
+	}
+
+	return;
+}
+
+void DrawListClass::ScatterRange(int pass, int first, int last, unsigned int* offsets, unsigned int* nextCounts)
+{
+	const unsigned long long* keys;
+	const unsigned int* packets;
+	unsigned long long* destinationKeys;
+	unsigned int* destinationPackets;
+	unsigned int* order;
+	unsigned long long key, masks[64];
+	unsigned int mask, indexMask, offset;
+	int i, run, runCount, indexBits, shift, nextShift, shifts[64], destinations[64];
+	bool narrow, lastPass;
+
+	// copied out, the stores below could alias the members for all the compiler knows.
+	destinationKeys = m_sortKeys[pass & 1].data();
+	destinationPackets = m_sortPackets[pass & 1].data();
+	order = m_order.data();
+	narrow = m_narrow;
+	indexBits = m_indexBits;
+	mask = (1u << m_digitBits) - 1;
+	indexMask = (unsigned int)((1ull << indexBits) - 1);
+	lastPass = pass == m_passCount - 1;
+
+	// the serial sort counts the next digit on the way, the key is in a register anyway.
+	if(nextCounts && !lastPass)
+	{
+		memset(nextCounts, 0, sizeof(unsigned int) << m_digitBits);
+	}
+	else
+	{
+		nextCounts = nullptr;
+	}
+
+	// the first pass gathers the shorter keys itself, a sort of a single pass never writes them at all.
+	if(pass == 0)
+	{
+		keys = m_keys.data();
+		runCount = m_runCount;
+		for(run = 0; run < runCount; run++)
+		{
+			shifts[run] = m_runShifts[run];
+			destinations[run] = m_runDestinations[run];
+			masks[run] = m_runMasks[run];
+		}
+		nextShift = m_digitBits;
+
+		for(i = first; i < last; i++)
+		{
+			key = GatherKey(keys[i], runCount, shifts, destinations, masks);
+			offset = offsets[(unsigned int)key & mask]++;
+			if(lastPass)
+			{
+				order[offset] = (unsigned int)i;
+				continue;
+			}
+
+			// the shorter key goes above the index, equal keys then stay in the order they were added without anything else to compare.
+			if(narrow)
+			{
+				destinationKeys[offset] = (key << indexBits) | (unsigned int)i;
+			}
+			else
+			{
+				destinationKeys[offset] = key;
+				destinationPackets[offset] = (unsigned int)i;
+			}
+			if(nextCounts)
+			{
+				nextCounts[(unsigned int)(key >> nextShift) & mask]++;
+			}
+		}
+
+		return;
+	}
+
+	keys = m_sortKeys[(pass - 1) & 1].data();
+	packets = m_sortPackets[(pass - 1) & 1].data();
+	shift = (narrow ? indexBits : 0) + pass * m_digitBits;
+	nextShift = shift + m_digitBits;
+
+	// the last pass only needs to say where every packet goes.
+	if(lastPass && narrow)
+	{
+		for(i = first; i < last; i++)
+		{
+			order[offsets[(unsigned int)(keys[i] >> shift) & mask]++] = (unsigned int)keys[i] & indexMask;
+		}
+	}
+	else if(lastPass)
+	{
+		for(i = first; i < last; i++)
+		{
+			order[offsets[(unsigned int)(keys[i] >> shift) & mask]++] = packets[i];
+		}
+	}
+	// one loop each for the rest, so nothing is tested per key.
+	else if(narrow && nextCounts)
+	{
+		for(i = first; i < last; i++)
+		{
+			key = keys[i];
+			destinationKeys[offsets[(unsigned int)(key >> shift) & mask]++] = key;
+			nextCounts[(unsigned int)(key >> nextShift) & mask]++;
+		}
+	}
+	else if(narrow)
+	{
+		for(i = first; i < last; i++)
+		{
+			key = keys[i];
+			destinationKeys[offsets[(unsigned int)(key >> shift) & mask]++] = key;
+		}
+	}
+	else if(nextCounts)
+	{
+		for(i = first; i < last; i++)
+		{
+			key = keys[i];
+			offset = offsets[(unsigned int)(key >> shift) & mask]++;
+			destinationKeys[offset] = key;
+			destinationPackets[offset] = packets[i];
+			nextCounts[(unsigned int)(key >> nextShift) & mask]++;
+		}
+	}
+	else
+	{
+		for(i = first; i < last; i++)
+		{
+			key = keys[i];
+			offset = offsets[(unsigned int)(key >> shift) & mask]++;
+			destinationKeys[offset] = key;
+			destinationPackets[offset] = packets[i];
+		}
+	}
+
+	return;
+}
+
+void DrawListClass::SortSerial()
+{
+	unsigned int* counts;
+	unsigned int* nextCounts;
+	unsigned int* swap;
+	unsigned int total, count;
+	int i, pass, buckets;
+
+	buckets = 1 << m_digitBits;
+	counts = m_histograms.data();
+	nextCounts = counts + ((size_t)1 << SORT_MAX_DIGIT_BITS);
+
+	// the first digit is counted on its own, every other one during the pass before it.
+	CountRange(0, 0, m_count, counts);
+
+	for(pass = 0; pass < m_passCount; pass++)
+	{
+		total = 0;
+		for(i = 0; i < buckets; i++)
+		{
+			count = counts[i];
+			counts[i] = total;
+			total += count;
+		}
+
+		ScatterRange(pass, 0, m_count, counts, nextCounts);
+
+		swap = counts;
+		counts = nextCounts;
+		nextCounts = swap;
+	}
+
+	return;
+}
+
+void DrawListClass::SortParallel()
+{
+	unsigned int total, count;
+	int rangeCount, range, bucket, buckets;
+
+	rangeCount = (m_count + SORT_RANGE_SIZE - 1) / SORT_RANGE_SIZE;
+	buckets = 1 << m_digitBits;
+	m_rangeCounts.resize((size_t)rangeCount * SORT_PARALLEL_BUCKETS);
+
+	for(m_pass = 0; m_pass < m_passCount; m_pass++)
+	{
+		// every range counts its own keys before each pass.
+		m_phase = PHASE_COUNT;
+		RunParallel(rangeCount);
+
+		// a range's keys of one bucket go after the same bucket of every range before it, which keeps the sort stable.
+		total = 0;
+		for(bucket = 0; bucket < buckets; bucket++)
+		{
+			for(range = 0; range < rangeCount; range++)
+			{
+				count = m_rangeCounts[(size_t)range * SORT_PARALLEL_BUCKETS + bucket];
+				m_rangeCounts[(size_t)range * SORT_PARALLEL_BUCKETS + bucket] = total;
+				total += count;
+			}
+		}
+
+		m_phase = PHASE_SCATTER;
+		RunParallel(rangeCount);
+	}
+
+	return;
+}
+
+void DrawListClass::RunRange(int range)
+{
+	unsigned int* counts;
+	int first, last;
+
+	first = range * SORT_RANGE_SIZE;
+	last = first + SORT_RANGE_SIZE < m_count ? first + SORT_RANGE_SIZE : m_count;
+	counts = &m_rangeCounts[(size_t)range * SORT_PARALLEL_BUCKETS];
+
+	switch(m_phase)
+	{
+		case PHASE_COUNT:
+			CountRange(m_pass, first, last, counts);
+			break;
+		case PHASE_SCATTER:
+			ScatterRange(m_pass, first, last, counts, nullptr);
+			break;
+	}
+
+	return;
+}
+
+void DrawListClass::RunParallel(int jobCount)
+{
+	m_jobSystem->ParallelFor(jobCount, 1, [this](int first, int last)
+	{
+		int range;
+
+		for(range = first; range < last; range++)
+		{
+			RunRange(range);
+		}
+	});
+
+	return;
+}
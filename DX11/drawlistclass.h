@@ -0,0 +1,111 @@
+#pragma once
+#ifndef _DRAWLISTCLASS_H_
+#define _DRAWLISTCLASS_H_
+
+#include <vector>
+
+#include "jobsystemclass.h"
+
+// how the 64 bit sort key is laid out, from the most significant field down. packets sort by layer first and by geometry last.
+const int DRAW_KEY_LAYER_BITS = 4;
+const int DRAW_KEY_PIPELINE_BITS = 12;
+const int DRAW_KEY_MATERIAL_BITS = 16;
+const int DRAW_KEY_DEPTH_BITS = 16;
+const int DRAW_KEY_GEOMETRY_BITS = 16;
+// lists shorter than this are sorted on the calling thread alone, the jobs cost more than they save.
+const int DRAW_LIST_PARALLEL_THRESHOLD = 65536;
+
+/*
+ * the draws of a frame as a list of packets that are sorted before any of them is submitted.
+ * every packet carries a 64 bit key made of its layer, pipeline, material, depth bucket and geometry, so after sorting
+ * draws that share state are next to each other and state changes happen in the order of the fields' importance.
+ * the keys are sorted by a least significant digit radix sort. bits every key has the same value in say nothing about the order,
+ * so the first pass gathers the bits that do differ into a shorter key as it reads, and the passes only go over those, 16 bits at
+ * a time when that is all of them and 13 otherwise. when the shorter key fits above the packet's index in 64 bits the two are sorted as one value, otherwise keys and
+ * indices are moved side by side. the last pass only writes the indices. the serial sort counts each digit during the pass before
+ * it, so after the first count every pass is a single scatter. a frame's keys differ in a few dozen bits at most, which is one to
+ * three passes, and keys that only differ in depth take one.
+ * long lists are sorted by jobs, each pass counting and then scattering in ranges, the result is the same either way.
+ */
+class DrawListClass
+{
+public:
+	struct PacketType
+	{
+		unsigned long long key;
+		unsigned int pipeline;
+		unsigned int geometry;
+		// what the caller draws, the scene object for graphics class.
+		int object;
+	};
+
+public:
+	DrawListClass();
+	DrawListClass(const DrawListClass&);
+	~DrawListClass();
+
+	bool Initialize(int capacity, JobSystemClass* jobSystem);
+	void Shutdown();
+
+	// depth is 0 at the near and 1 at the far plane, nearer packets sort first within the same layer, pipeline and material.
+	static unsigned long long MakeKey(unsigned int layer, unsigned int pipeline, unsigned int material, float depth, unsigned int geometry);
+
+	void Clear();
+	// false once the list is full.
+	bool Add(unsigned long long key, unsigned int pipeline, unsigned int geometry, int object);
+
+	// sorts by key, packets with equal keys keep the order they were added in.
+	void Sort();
+
+	int GetCount();
+	// the packets in sorted order once Sort ran, in the order they were added before.
+	const PacketType& GetPacket(int index);
+
+private:
+	enum PhaseType
+	{
+		PHASE_COUNT,
+		PHASE_SCATTER
+	};
+
+	void CountRange(int pass, int first, int last, unsigned int* counts);
+	void ScatterRange(int pass, int first, int last, unsigned int* offsets, unsigned int* nextCounts);
+
+	void SortSerial();
+	void SortParallel();
+	void RunRange(int range);
+
+	void RunParallel(int jobCount);
+
+private:
+	std::vector<PacketType> m_packets;
+	// the keys in the order they were added, and the packet indices in sorted order.
+	std::vector<unsigned long long> m_keys;
+	std::vector<unsigned int> m_order;
+	int m_capacity;
+	int m_count;
+
+	// what the radix sort moves around, double buffered. the indices are only used when the shorter key does not fit above one.
+	std::vector<unsigned long long> m_sortKeys[2];
+	std::vector<unsigned int> m_sortPackets[2];
+	std::vector<unsigned int> m_histograms;
+
+	// the bits that differ between the keys, as runs of neighbouring bits and where each run goes in the shorter key.
+	int m_runCount;
+	int m_runShifts[64];
+	int m_runDestinations[64];
+	unsigned long long m_runMasks[64];
+	bool m_narrow;
+	int m_indexBits;
+	int m_digitBits;
+	int m_passCount;
+
+	// the parallel pass in flight, one histogram or set of offsets per range.
+	PhaseType m_phase;
+	int m_pass;
+	std::vector<unsigned int> m_rangeCounts;
+
+	JobSystemClass* m_jobSystem;
+};
+
+#endif
@@ -0,0 +1,226 @@
+#include "framearenaclass.h"
+
+FrameArenaClass::FrameArenaClass()
+{
+	m_jobSystem = nullptr;
+	m_frameCount = 0;
+	m_threadCount = 0;
+	m_bytesPerThread = 0;
+	m_arenas = nullptr;
+	m_peakUsed = 0;
+	m_overflowCount.store(0);
+}
+
+FrameArenaClass::FrameArenaClass(const FrameArenaClass&)
+{
+}
+
+FrameArenaClass::~FrameArenaClass()
+{
+}
+
+bool FrameArenaClass::Initialize(JobSystemClass* jobSystem, int frameCount, size_t bytesPerThread)
+{
+	int i;
+
+	if(!jobSystem || frameCount <= 0)
+	{
+		return false;
+	}
+
+	m_jobSystem = jobSystem;
+	m_frameCount = frameCount;
+	m_threadCount = jobSystem->GetThreadCount();
+	m_bytesPerThread = bytesPerThread > 0 ? bytesPerThread : 1;
+
+	m_arenas = MemoryClass::AllocateArray<ArenaType>((size_t)m_frameCount * m_threadCount, MEMORY_TAG_FRAME);
+	if(!m_arenas)
+	{
+		return false;
+	}
+
+	for(i = 0; i < m_frameCount * m_threadCount; i++)
+	{
+		m_arenas[i].memory = nullptr;
+		m_arenas[i].capacity = 0;
+		m_arenas[i].used = 0;
+		m_arenas[i].overflow = nullptr;
+		m_arenas[i].total = 0;
+	}
+
+	m_peakUsed = 0;
+	m_overflowCount.store(0);
+
+	return true;
+}
+
+void FrameArenaClass::Shutdown()
+{
+	int i;
+
+	if(m_arenas)
+	{
+		for(i = 0; i < m_frameCount; i++)
+		{
+			Reset(i);
+		}
+
+		for(i = 0; i < m_frameCount * m_threadCount; i++)
+		{
+			MemoryClass::Free(m_arenas[i].memory);
+		}
+
+		MemoryClass::FreeArray(m_arenas);
+		m_arenas = nullptr;
+	}
+
+	m_frameCount = 0;
+	m_threadCount = 0;
+	m_jobSystem = nullptr;
+
+	return;
+}
+
+void FrameArenaClass::Reset(int frame)
+{
+	ArenaType* arena;
+	OverflowType* overflow;
+	size_t used;
+	int i;
+
+	if(frame < 0 || frame >= m_frameCount)
+	{
+		return;
+	}
+
+	used = 0;
+	for(i = 0; i < m_threadCount; i++)
+	{
+		arena = &m_arenas[frame * m_threadCount + i];
+		used += arena->total;
+
+		// the frame did not fit, next time it gets all it needed in one block. the new block is only allocated on first use.
+		if(arena->overflow)
+		{
+			while(arena->overflow)
+			{
+				overflow = arena->overflow;
+				arena->overflow = overflow->next;
+				MemoryClass::Free(overflow);
+			}
+
+			MemoryClass::Free(arena->memory);
+			arena->memory = nullptr;
+			arena->capacity = arena->total;
+		}
+
+		arena->used = 0;
+		arena->total = 0;
+	}
+
+	m_peakUsed = used > m_peakUsed ? used : m_peakUsed;
+
+	return;
+}
+
+void* FrameArenaClass::Allocate(int frame, size_t size, size_t alignment)
+{
+	ArenaType* arena;
+	OverflowType* overflow;
+	size_t overflowSize;
+	void* memory;
+	int threadIndex;
+
+	threadIndex = m_jobSystem ? m_jobSystem->GetThreadIndex() : -1;
+	if(frame < 0 || frame >= m_frameCount || threadIndex < 0)
+	{
+		return nullptr;
+	}
+
+	if(alignment < 1)
+	{
+		alignment = 1;
+	}
+
+	arena = &m_arenas[frame * m_threadCount + threadIndex];
+	arena->total += size + alignment - 1;
+
+	if(!arena->memory)
+	{
+		if(arena->capacity < m_bytesPerThread)
+		{
+			arena->capacity = m_bytesPerThread;
+		}
+
+		arena->memory = (char*)MemoryClass::Allocate(arena->capacity, MEMORY_TAG_FRAME);
+		if(!arena->memory)
+		{
+			arena->capacity = 0;
+			return nullptr;
+		}
+	}
+
+	// overflow blocks are bumped like the arena itself, only the newest one can still have room.
+	if(arena->overflow)
+	{
+		memory = Bump((char*)(arena->overflow + 1), arena->overflow->size, arena->overflow->used, size, alignment);
+	}
+	else
+	{
+		memory = Bump(arena->memory, arena->capacity, arena->used, size, alignment);
+	}
+
+	if(memory)
+	{
+		return memory;
+	}
+
+	// at least as big as the arena, a frame that overflows once tends to keep going.
+	overflowSize = size + alignment - 1 > arena->capacity ? size + alignment - 1 : arena->capacity;
+	overflow = (OverflowType*)MemoryClass::Allocate(sizeof(OverflowType) + overflowSize, MEMORY_TAG_FRAME);
+	if(!overflow)
+	{
+		return nullptr;
+	}
+
+	overflow->next = arena->overflow;
+	overflow->size = overflowSize;
+	overflow->used = 0;
+	arena->overflow = overflow;
+	m_overflowCount.fetch_add(1, std::memory_order_relaxed);
+
+	return Bump((char*)(overflow + 1), overflow->size, overflow->used, size, alignment);
+}
+
+void FrameArenaClass::GetStatistics(StatisticsType& statistics)
+{
+	int i;
+
+	statistics.capacity = 0;
+	for(i = 0; i < m_frameCount * m_threadCount; i++)
+	{
+		statistics.capacity += m_arenas[i].memory ? m_arenas[i].capacity : 0;
+	}
+
+	statistics.peakUsed = m_peakUsed;
+	statistics.overflowCount = m_overflowCount.load(std::memory_order_relaxed);
+
+	return;
+}
+
+void* FrameArenaClass::Bump(char* memory, size_t capacity, size_t& used, size_t size, size_t alignment)
+{
+	size_t address, start;
+
+	// alignments are powers of two, the offset is rounded up on the address and not on used.
+	address = ((size_t)(memory + used) + alignment - 1) & ~(alignment - 1);
+	start = address - (size_t)memory;
+	if(start + size > capacity)
+	{
+		return nullptr;
+	}
+
+	used = start + size;
+
+	return (void*)address;
+}
@@ -0,0 +1,106 @@
+#pragma once
+#ifndef _FRAMEARENACLASS_H_
+#define _FRAMEARENACLASS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+#include "jobsystemclass.h"
+#include "memoryclass.h"
+
+/*
+ * memory that lives for one frame, handed out by bumping a pointer and given back all at once.
+ * there is an arena per frame in flight and per thread of the job system, a thread only ever bumps its own so nothing is locked.
+ * Reset(frame) empties every thread's arena of that frame, once nothing reads what was allocated in it any more.
+ * an arena that runs out chains an overflow block from MemoryClass and carries on. Reset frees those and grows the arena
+ * to what the frame needed, so after a few frames the arenas are big enough and a frame allocates nothing from the heap.
+ * a thread's arena gets its first block on its first allocation, threads that never allocate cost nothing.
+ */
+class FrameArenaClass
+{
+public:
+	struct StatisticsType
+	{
+		// bytes of every arena's block, and the most any one frame slot has had allocated from all its arenas since Initialize.
+		size_t capacity;
+		size_t peakUsed;
+		// overflow blocks chained since Initialize, it stops going up once the arenas have grown.
+		int overflowCount;
+	};
+
+public:
+	FrameArenaClass();
+	FrameArenaClass(const FrameArenaClass&);
+	~FrameArenaClass();
+
+	// frameCount slots with an arena per job system thread each, starting at bytesPerThread.
+	bool Initialize(JobSystemClass* jobSystem, int frameCount, size_t bytesPerThread);
+	void Shutdown();
+
+	// every thread's arena of the frame is empty again. nothing may be allocating from it at the same time.
+	void Reset(int frame);
+
+	// from the calling thread's arena of the frame, valid until its next Reset. null for a thread that is not one of the job system's.
+	void* Allocate(int frame, size_t size, size_t alignment);
+
+	// arrays of types without a destructor, Reset drops them without running one.
+	template<typename T>
+	T* AllocateArray(int frame, size_t count)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "frame arena arrays are reset without running destructors");
+		T* array;
+		size_t i;
+
+		array = (T*)Allocate(frame, sizeof(T) * count, alignof(T));
+		if(!array)
+		{
+			return nullptr;
+		}
+
+		for(i = 0; i < count; i++)
+		{
+			new(&array[i]) T;
+		}
+
+		return array;
+	}
+
+	void GetStatistics(StatisticsType& statistics);
+
+private:
+	struct OverflowType
+	{
+		OverflowType* next;
+		size_t size;
+		size_t used;
+	};
+
+	// a cache line each, neighbouring threads bump their own without fighting over one.
+	struct alignas(64) ArenaType
+	{
+		char* memory;
+		size_t capacity;
+		size_t used;
+		// newest first, the head is the one being bumped.
+		OverflowType* overflow;
+		// everything allocated since the last Reset, what the arena grows to.
+		size_t total;
+	};
+
+	static void* Bump(char* memory, size_t capacity, size_t& used, size_t size, size_t alignment);
+
+private:
+	JobSystemClass* m_jobSystem;
+	int m_frameCount;
+	int m_threadCount;
+	size_t m_bytesPerThread;
+	// frame after frame, the threads' arenas of a frame next to each other.
+	ArenaType* m_arenas;
+
+	size_t m_peakUsed;
+	std::atomic<int> m_overflowCount;
+};
+
+#endif
@@ -0,0 +1,289 @@
+#include "frustumclass.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+
+// objects per job. below this much work waking the workers up costs more than the test itself.
+static const int CULL_RANGE_SIZE = 16384;
+
+#if defined(__AVX2__)
+
+#define SIMD_WIDTH 8
+
+typedef __m256 SimdFloat;
+
+static inline SimdFloat SimdSet(float value) { return _mm256_set1_ps(value); }
+static inline SimdFloat SimdLoad(const float* p) { return _mm256_loadu_ps(p); }
+static inline SimdFloat SimdZero() { return _mm256_setzero_ps(); }
+static inline SimdFloat SimdAdd(SimdFloat a, SimdFloat b) { return _mm256_add_ps(a, b); }
+static inline SimdFloat SimdMul(SimdFloat a, SimdFloat b) { return _mm256_mul_ps(a, b); }
+static inline SimdFloat SimdOr(SimdFloat a, SimdFloat b) { return _mm256_or_ps(a, b); }
+static inline SimdFloat SimdLess(SimdFloat a, SimdFloat b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline int SimdMask(SimdFloat mask) { return _mm256_movemask_ps(mask); }
+
+#else
+
+#define SIMD_WIDTH 4
+
+typedef __m128 SimdFloat;
+
+static inline SimdFloat SimdSet(float value) { return _mm_set1_ps(value); }
+static inline SimdFloat SimdLoad(const float* p) { return _mm_loadu_ps(p); }
+static inline SimdFloat SimdZero() { return _mm_setzero_ps(); }
+static inline SimdFloat SimdAdd(SimdFloat a, SimdFloat b) { return _mm_add_ps(a, b); }
+static inline SimdFloat SimdMul(SimdFloat a, SimdFloat b) { return _mm_mul_ps(a, b); }
+static inline SimdFloat SimdOr(SimdFloat a, SimdFloat b) { return _mm_or_ps(a, b); }
+static inline SimdFloat SimdLess(SimdFloat a, SimdFloat b) { return _mm_cmplt_ps(a, b); }
+static inline int SimdMask(SimdFloat mask) { return _mm_movemask_ps(mask); }
+
+#endif
+
+FrustumClass::FrustumClass()
+{
+	int i;
+
+	for(i = 0; i < 6; i++)
+	{
+		m_planes[i] = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+	}
+
+	m_bounds.count = 0;
+	m_visible = nullptr;
+	m_spheres = false;
+	m_jobSystem = nullptr;
+}
+
+FrustumClass::FrustumClass(const FrustumClass&)
+{
+}
+
+FrustumClass::~FrustumClass()
+{
+}
+
+bool FrustumClass::Initialize(JobSystemClass* jobSystem)
+{
+	if(!jobSystem)
+	{
+		return false;
+	}
+
+	m_jobSystem = jobSystem;
+
+	return true;
+}
+
+void FrustumClass::Shutdown()
+{
+	m_jobSystem = nullptr;
+	return;
+}
+
+void FrustumClass::ConstructFrustum(const XMMATRIX& viewMatrix, const XMMATRIX& projectionMatrix)
+{
+	XMMATRIX matrix;
+	XMVECTOR planes[6];
+	int i;
+
+	/*
+	 * a point is inside when -w <= x <= w, -w <= y <= w and 0 <= z <= w in clip space.
+	 * with row vectors clip = position * matrix, so every plane is a sum or difference of the matrix's columns,
+	 * which are the rows of its transpose.
+	 */
+	matrix = XMMatrixTranspose(XMMatrixMultiply(viewMatrix, projectionMatrix));
+
+	planes[0] = XMVectorAdd(matrix.r[3], matrix.r[0]);
+	planes[1] = XMVectorSubtract(matrix.r[3], matrix.r[0]);
+	planes[2] = XMVectorAdd(matrix.r[3], matrix.r[1]);
+	planes[3] = XMVectorSubtract(matrix.r[3], matrix.r[1]);
+	planes[4] = matrix.r[2];
+	planes[5] = XMVectorSubtract(matrix.r[3], matrix.r[2]);
+
+	for(i = 0; i < 6; i++)
+	{
+		XMStoreFloat4(&m_planes[i], XMPlaneNormalize(planes[i]));
+	}
+
+	return;
+}
+
+int FrustumClass::CullBoxes(SceneClass* scene, int* visible)
+{
+	return Cull(scene, visible, false);
+}
+
+int FrustumClass::CullSpheres(SceneClass* scene, int* visible)
+{
+	return Cull(scene, visible, true);
+}
+
+bool FrustumClass::CheckBox(const XMFLOAT3& center, const XMFLOAT3& extent)
+{
+	float distance, radius;
+	int i;
+
+	// the box is outside once even its corner furthest along the normal is behind one plane.
+	for(i = 0; i < 6; i++)
+	{
+		distance = m_planes[i].x * center.x + m_planes[i].y * center.y + m_planes[i].z * center.z + m_planes[i].w;
+		radius = fabsf(m_planes[i].x) * extent.x + fabsf(m_planes[i].y) * extent.y + fabsf(m_planes[i].z) * extent.z;
+		if(distance + radius < 0.0f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool FrustumClass::CheckSphere(const XMFLOAT3& center, float radius)
+{
+	float distance;
+	int i;
+
+	for(i = 0; i < 6; i++)
+	{
+		distance = m_planes[i].x * center.x + m_planes[i].y * center.y + m_planes[i].z * center.z + m_planes[i].w;
+		if(distance + radius < 0.0f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int FrustumClass::Cull(SceneClass* scene, int* visible, bool spheres)
+{
+	int rangeCount, range, count;
+
+	scene->GetBounds(m_bounds);
+	if(m_bounds.count <= 0)
+	{
+		return 0;
+	}
+
+	m_visible = visible;
+	m_spheres = spheres;
+
+	rangeCount = (m_bounds.count + CULL_RANGE_SIZE - 1) / CULL_RANGE_SIZE;
+	m_rangeCounts.resize((size_t)rangeCount);
+
+	// every range writes its survivors to the start of its own slice of visible, then the slices are packed together in order.
+	m_jobSystem->ParallelFor(rangeCount, 1, [this](int first, int last)
+	{
+		int range;
+
+		for(range = first; range < last; range++)
+		{
+			CullRange(range);
+		}
+	});
+
+	count = m_rangeCounts[0];
+	for(range = 1; range < rangeCount; range++)
+	{
+		memmove(visible + count, visible + (size_t)range * CULL_RANGE_SIZE, sizeof(int) * (size_t)m_rangeCounts[range]);
+		count += m_rangeCounts[range];
+	}
+
+	return count;
+}
+
+void FrustumClass::CullRange(int range)
+{
+	const SceneClass::BoundsType& bounds = m_bounds;
+	SimdFloat planeX[6], planeY[6], planeZ[6], planeW[6], absoluteX[6], absoluteY[6], absoluteZ[6];
+	SimdFloat centerX, centerY, centerZ, extentX, extentY, extentZ, distance, radius, outside, zero;
+	int* visible;
+	int i, first, last, count, mask, k, p;
+	bool spheres;
+
+	first = range * CULL_RANGE_SIZE;
+	last = first + CULL_RANGE_SIZE < bounds.count ? first + CULL_RANGE_SIZE : bounds.count;
+	visible = m_visible + first;
+	spheres = m_spheres;
+	count = 0;
+
+	for(p = 0; p < 6; p++)
+	{
+		planeX[p] = SimdSet(m_planes[p].x);
+		planeY[p] = SimdSet(m_planes[p].y);
+		planeZ[p] = SimdSet(m_planes[p].z);
+		planeW[p] = SimdSet(m_planes[p].w);
+		absoluteX[p] = SimdSet(fabsf(m_planes[p].x));
+		absoluteY[p] = SimdSet(fabsf(m_planes[p].y));
+		absoluteZ[p] = SimdSet(fabsf(m_planes[p].z));
+	}
+	zero = SimdZero();
+
+	for(i = first; i + SIMD_WIDTH <= last; i += SIMD_WIDTH)
+	{
+		centerX = SimdLoad(bounds.centerX + i);
+		centerY = SimdLoad(bounds.centerY + i);
+		centerZ = SimdLoad(bounds.centerZ + i);
+
+		/*
+		 * the box's projected radius along each normal is |n| dot extent, a sphere's is just its radius.
+		 * an object is culled when center distance plus radius is behind any of the planes.
+		 */
+		if(spheres)
+		{
+			extentX = SimdLoad(bounds.radius + i);
+			extentY = zero;
+			extentZ = zero;
+		} else
+		{
+			extentX = SimdLoad(bounds.extentX + i);
+			extentY = SimdLoad(bounds.extentY + i);
+			extentZ = SimdLoad(bounds.extentZ + i);
+		}
+
+		outside = zero;
+		for(p = 0; p < 6; p++)
+		{
+			distance = SimdAdd(SimdAdd(SimdMul(planeX[p], centerX), SimdMul(planeY[p], centerY)), SimdAdd(SimdMul(planeZ[p], centerZ), planeW[p]));
+			if(spheres)
+			{
+				radius = extentX;
+			} else
+			{
+				radius = SimdAdd(SimdAdd(SimdMul(absoluteX[p], extentX), SimdMul(absoluteY[p], extentY)), SimdMul(absoluteZ[p], extentZ));
+			}
+			outside = SimdOr(outside, SimdLess(SimdAdd(distance, radius), zero));
+		}
+
+		// branchless compaction, every lane is written and only the visible ones advance the count.
+		mask = ~SimdMask(outside);
+		for(k = 0; k < SIMD_WIDTH; k++)
+		{
+			visible[count] = i + k;
+			count += (mask >> k) & 1;
+		}
+	}
+
+	// the last few objects that do not fill a register.
+	for(; i < last; i++)
+	{
+		if(spheres)
+		{
+			if(CheckSphere(XMFLOAT3(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]), bounds.radius[i]))
+			{
+				visible[count++] = i;
+			}
+		} else if(CheckBox(XMFLOAT3(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]), XMFLOAT3(bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i])))
+		{
+			visible[count++] = i;
+		}
+	}
+
+	m_rangeCounts[range] = count;
+
+	return;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#ifndef _FRUSTUMCLASS_H_
+#define _FRUSTUMCLASS_H_
+
+#include <vector>
+
+#include <DirectXMath.h>
+using namespace DirectX;
+
+#include "jobsystemclass.h"
+#include "sceneclass.h"
+
+/*
+ * frustum culling for the whole scene at once.
+ * the six planes come out of view times projection and are tested against the scene's structure of arrays bounds,
+ * 8 objects per instruction with AVX2 and 4 with SSE2. big scenes are split in ranges that run as jobs.
+ * the visible list is compacted in object order, so it comes out the same however many threads ran.
+ */
+class FrustumClass
+{
+public:
+	FrustumClass();
+	FrustumClass(const FrustumClass&);
+	~FrustumClass();
+
+	bool Initialize(JobSystemClass* jobSystem);
+	void Shutdown();
+
+	void ConstructFrustum(const XMMATRIX& viewMatrix, const XMMATRIX& projectionMatrix);
+
+	// visible needs room for every object in the scene, returns how many of them are at least partly inside.
+	int CullBoxes(SceneClass* scene, int* visible);
+	int CullSpheres(SceneClass* scene, int* visible);
+
+	bool CheckBox(const XMFLOAT3& center, const XMFLOAT3& extent);
+	bool CheckSphere(const XMFLOAT3& center, float radius);
+
+private:
+	int Cull(SceneClass* scene, int* visible, bool spheres);
+	void CullRange(int range);
+
+
+private:
+	// left, right, bottom, top, near, far. normals point inwards and have unit length.
+	XMFLOAT4 m_planes[6];
+
+	// the cull in flight.
+	SceneClass::BoundsType m_bounds;
+	int* m_visible;
+	bool m_spheres;
+	std::vector<int> m_rangeCounts;
+
+	JobSystemClass* m_jobSystem;
+};
+
+#endif
@@ -0,0 +1,393 @@
+#include "geometryarenaclass.h"
+
+#include <map>
+
+static unsigned int GetIndexSize(DXGI_FORMAT indexFormat)
+{
+	return indexFormat == DXGI_FORMAT_R16_UINT ? 2 : 4;
+}
+
+GeometryArenaClass::GeometryArenaClass()
+{
+	m_device = nullptr;
+	m_deviceContext = nullptr;
+	m_vertexBuffer = nullptr;
+	m_indexBuffer = nullptr;
+	m_VertexAllocator = nullptr;
+	m_IndexAllocator = nullptr;
+	m_defragmentations = 0;
+}
+
+GeometryArenaClass::GeometryArenaClass(const GeometryArenaClass&)
+{
+}
+
+GeometryArenaClass::~GeometryArenaClass()
+{
+}
+
+bool GeometryArenaClass::Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext, unsigned int vertexCapacity, unsigned int indexCapacity)
+{
+	bool result;
+
+	m_device = device;
+	m_deviceContext = deviceContext;
+
+	m_VertexAllocator = new RangeAllocatorClass;
+	if(!m_VertexAllocator)
+	{
+		return false;
+	}
+
+	result = m_VertexAllocator->Initialize(vertexCapacity);
+	if(!result)
+	{
+		return false;
+	}
+
+	m_IndexAllocator = new RangeAllocatorClass;
+	if(!m_IndexAllocator)
+	{
+		return false;
+	}
+
+	result = m_IndexAllocator->Initialize(indexCapacity);
+	if(!result)
+	{
+		return false;
+	}
+
+	result = CreateBuffer(vertexCapacity, D3D11_BIND_VERTEX_BUFFER, &m_vertexBuffer);
+	if(!result)
+	{
+		return false;
+	}
+
+	result = CreateBuffer(indexCapacity, D3D11_BIND_INDEX_BUFFER, &m_indexBuffer);
+	if(!result)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+void GeometryArenaClass::Shutdown()
+{
+	if(m_indexBuffer)
+	{
+		m_indexBuffer->Release();
+		m_indexBuffer = nullptr;
+	}
+
+	if(m_vertexBuffer)
+	{
+		m_vertexBuffer->Release();
+		m_vertexBuffer = nullptr;
+	}
+
+	if(m_IndexAllocator)
+	{
+		m_IndexAllocator->Shutdown();
+		delete m_IndexAllocator;
+		m_IndexAllocator = nullptr;
+	}
+
+	if(m_VertexAllocator)
+	{
+		m_VertexAllocator->Shutdown();
+		delete m_VertexAllocator;
+		m_VertexAllocator = nullptr;
+	}
+
+	m_allocations.clear();
+	m_freeAllocations.clear();
+	m_device = nullptr;
+	m_deviceContext = nullptr;
+
+	return;
+}
+
+bool GeometryArenaClass::Allocate(const void* vertices, unsigned int vertexStride, unsigned int vertexCount,
+	const void* indices, DXGI_FORMAT indexFormat, unsigned int indexCount, int& allocation)
+{
+	AllocationType range;
+	bool result;
+
+	if(vertexCount == 0 || indexCount == 0)
+	{
+		return false;
+	}
+
+	range.vertexStride = vertexStride;
+	range.vertexSize = vertexStride * vertexCount;
+	range.indexFormat = indexFormat;
+	range.indexSize = GetIndexSize(indexFormat) * indexCount;
+	range.used = true;
+
+	// vertex ranges are aligned to the stride and index ranges to the index size so both locations are whole numbers.
+	result = AllocateRange(m_VertexAllocator, &m_vertexBuffer, D3D11_BIND_VERTEX_BUFFER, range.vertexSize, vertexStride, range.vertexOffset);
+	if(!result)
+	{
+		return false;
+	}
+
+	result = AllocateRange(m_IndexAllocator, &m_indexBuffer, D3D11_BIND_INDEX_BUFFER, range.indexSize, GetIndexSize(indexFormat), range.indexOffset);
+	if(!result)
+	{
+		m_VertexAllocator->Free(range.vertexOffset);
+		return false;
+	}
+
+	Upload(m_vertexBuffer, range.vertexOffset, vertices, range.vertexSize);
+	Upload(m_indexBuffer, range.indexOffset, indices, range.indexSize);
+
+	if(!m_freeAllocations.empty())
+	{
+		allocation = m_freeAllocations.back();
+		m_freeAllocations.pop_back();
+		m_allocations[allocation] = range;
+	} else
+	{
+		allocation = (int)m_allocations.size();
+		m_allocations.push_back(range);
+	}
+
+	return true;
+}
+
+void GeometryArenaClass::Free(int allocation)
+{
+	if(allocation < 0 || allocation >= (int)m_allocations.size() || !m_allocations[allocation].used)
+	{
+		return;
+	}
+
+	m_VertexAllocator->Free(m_allocations[allocation].vertexOffset);
+	m_IndexAllocator->Free(m_allocations[allocation].indexOffset);
+
+	m_allocations[allocation].used = false;
+	m_freeAllocations.push_back(allocation);
+
+	return;
+}
+
+void GeometryArenaClass::GetLocation(int allocation, int& baseVertex, int& startIndex)
+{
+	baseVertex = (int)(m_allocations[allocation].vertexOffset / m_allocations[allocation].vertexStride);
+	startIndex = (int)(m_allocations[allocation].indexOffset / GetIndexSize(m_allocations[allocation].indexFormat));
+	return;
+}
+
+void GeometryArenaClass::Bind(DeviceStateClass* deviceState, int allocation)
+{
+	deviceState->IASetVertexBuffer(0, m_vertexBuffer, m_allocations[allocation].vertexStride, 0);
+	deviceState->IASetIndexBuffer(m_indexBuffer, m_allocations[allocation].indexFormat, 0);
+
+	return;
+}
+
+bool GeometryArenaClass::Defragment()
+{
+	std::vector<RangeAllocatorClass::MoveType> moves, copies;
+	std::map<unsigned int, unsigned int> vertexMoves, indexMoves;
+	RangeAllocatorClass::MoveType copy;
+	unsigned int i;
+	bool result;
+
+	/*
+	 * the allocators pack their ranges to the front and report what moved.
+	 * the data is copied into fresh buffers, copying a buffer region onto itself is not allowed when the two overlap.
+	 */
+	m_VertexAllocator->Defragment(moves);
+	for(i = 0; i < moves.size(); i++)
+	{
+		vertexMoves[moves[i].sourceOffset] = moves[i].destinationOffset;
+	}
+
+	m_IndexAllocator->Defragment(moves);
+	for(i = 0; i < moves.size(); i++)
+	{
+		indexMoves[moves[i].sourceOffset] = moves[i].destinationOffset;
+	}
+
+	if(vertexMoves.empty() && indexMoves.empty())
+	{
+		return true;
+	}
+
+	if(!vertexMoves.empty())
+	{
+		for(i = 0; i < m_allocations.size(); i++)
+		{
+			if(!m_allocations[i].used)
+			{
+				continue;
+			}
+
+			copy.sourceOffset = m_allocations[i].vertexOffset;
+			copy.destinationOffset = vertexMoves.count(copy.sourceOffset) ? vertexMoves[copy.sourceOffset] : copy.sourceOffset;
+			copy.size = m_allocations[i].vertexSize;
+			copies.push_back(copy);
+
+			m_allocations[i].vertexOffset = copy.destinationOffset;
+		}
+
+		result = Relocate(&m_vertexBuffer, D3D11_BIND_VERTEX_BUFFER, m_VertexAllocator->GetCapacity(), copies);
+		if(!result)
+		{
+			return false;
+		}
+	}
+
+	if(!indexMoves.empty())
+	{
+		copies.clear();
+		for(i = 0; i < m_allocations.size(); i++)
+		{
+			if(!m_allocations[i].used)
+			{
+				continue;
+			}
+
+			copy.sourceOffset = m_allocations[i].indexOffset;
+			copy.destinationOffset = indexMoves.count(copy.sourceOffset) ? indexMoves[copy.sourceOffset] : copy.sourceOffset;
+			copy.size = m_allocations[i].indexSize;
+			copies.push_back(copy);
+
+			m_allocations[i].indexOffset = copy.destinationOffset;
+		}
+
+		result = Relocate(&m_indexBuffer, D3D11_BIND_INDEX_BUFFER, m_IndexAllocator->GetCapacity(), copies);
+		if(!result)
+		{
+			return false;
+		}
+	}
+
+	m_defragmentations++;
+
+	return true;
+}
+
+void GeometryArenaClass::GetStatistics(StatisticsType& statistics)
+{
+	m_VertexAllocator->GetStatistics(statistics.vertices);
+	m_IndexAllocator->GetStatistics(statistics.indices);
+	statistics.defragmentations = m_defragmentations;
+
+	return;
+}
+
+bool GeometryArenaClass::CreateBuffer(unsigned int byteWidth, unsigned int bindFlags, ID3D11Buffer** buffer)
+{
+	D3D11_BUFFER_DESC bufferDesc;
+	HRESULT result;
+
+	bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+	bufferDesc.ByteWidth = byteWidth;
+	bufferDesc.BindFlags = bindFlags;
+	bufferDesc.CPUAccessFlags = 0;
+	bufferDesc.MiscFlags = 0;
+	bufferDesc.StructureByteStride = 0;
+
+	result = m_device->CreateBuffer(&bufferDesc, NULL, buffer);
+	if(FAILED(result))
+	{
+		return false;
+	}
+
+	return true;
+}
+
+bool GeometryArenaClass::Relocate(ID3D11Buffer** buffer, unsigned int bindFlags, unsigned int capacity, const std::vector<RangeAllocatorClass::MoveType>& copies)
+{
+	ID3D11Buffer* newBuffer;
+	D3D11_BOX sourceBox;
+	unsigned int i;
+	bool result;
+
+	newBuffer = nullptr;
+	result = CreateBuffer(capacity, bindFlags, &newBuffer);
+	if(!result)
+	{
+		return false;
+	}
+
+	sourceBox.top = 0;
+	sourceBox.bottom = 1;
+	sourceBox.front = 0;
+	sourceBox.back = 1;
+
+	for(i = 0; i < copies.size(); i++)
+	{
+		if(copies[i].size == 0)
+		{
+			continue;
+		}
+
+		sourceBox.left = copies[i].sourceOffset;
+		sourceBox.right = copies[i].sourceOffset + copies[i].size;
+		m_deviceContext->CopySubresourceRegion(newBuffer, 0, copies[i].destinationOffset, 0, 0, *buffer, 0, &sourceBox);
+	}
+
+	(*buffer)->Release();
+	*buffer = newBuffer;
+
+	// whatever was bound is the old buffer, the device state sees the new one is a different pointer and binds it next time.
+
+	return true;
+}
+
+bool GeometryArenaClass::AllocateRange(RangeAllocatorClass* allocator, ID3D11Buffer** buffer, unsigned int bindFlags, unsigned int size, unsigned int alignment, unsigned int& offset)
+{
+	std::vector<RangeAllocatorClass::MoveType> copies;
+	RangeAllocatorClass::MoveType copy;
+	unsigned int capacity;
+	bool result;
+
+	if(allocator->Allocate(size, alignment, offset))
+	{
+		return true;
+	}
+
+	// out of room, double the buffer (or more for a huge mesh) and carry the old contents over as they are.
+	capacity = allocator->GetCapacity();
+	copy.sourceOffset = 0;
+	copy.destinationOffset = 0;
+	copy.size = capacity;
+	copies.push_back(copy);
+
+	capacity = capacity * 2 > capacity + size + alignment ? capacity * 2 : capacity + size + alignment;
+
+	result = Relocate(buffer, bindFlags, capacity, copies);
+	if(!result)
+	{
+		return false;
+	}
+
+	allocator->Grow(capacity);
+
+	return allocator->Allocate(size, alignment, offset);
+}
+
+void GeometryArenaClass::Upload(ID3D11Buffer* buffer, unsigned int offset, const void* data, unsigned int size)
+{
+	D3D11_BOX destinationBox;
+
+	if(size == 0)
+	{
+		return;
+	}
+
+	destinationBox.left = offset;
+	destinationBox.right = offset + size;
+	destinationBox.top = 0;
+	destinationBox.bottom = 1;
+	destinationBox.front = 0;
+	destinationBox.back = 1;
+
+	m_deviceContext->UpdateSubresource(buffer, 0, &destinationBox, data, 0, 0);
+
+	return;
+}
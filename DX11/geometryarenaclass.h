@@ -0,0 +1,76 @@
+#pragma once
+#ifndef _GEOMETRYARENACLASS_H_
+#define _GEOMETRYARENACLASS_H_
+
+#include <d3d11.h>
+#include <vector>
+
+#include "devicestateclass.h"
+#include "rangeallocatorclass.h"
+
+/*
+ * one big vertex buffer and one big index buffer shared by every model.
+ * a model gets an allocation id back and draws with the BaseVertexLocation and StartIndexLocation of its ranges,
+ * so models using the same vertex stride and index format can be drawn one after the other without rebinding anything.
+ * ranges are asked for by id every time because growing or defragmenting the arena moves them.
+ * both buffers are default usage, data goes in with UpdateSubresource and moves with CopySubresourceRegion.
+ */
+class GeometryArenaClass
+{
+public:
+	struct StatisticsType
+	{
+		RangeAllocatorClass::StatisticsType vertices;
+		RangeAllocatorClass::StatisticsType indices;
+		unsigned int defragmentations;
+	};
+
+public:
+	GeometryArenaClass();
+	GeometryArenaClass(const GeometryArenaClass&);
+	~GeometryArenaClass();
+
+	bool Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext, unsigned int vertexCapacity, unsigned int indexCapacity);
+	void Shutdown();
+
+	bool Allocate(const void* vertices, unsigned int vertexStride, unsigned int vertexCount,
+		const void* indices, DXGI_FORMAT indexFormat, unsigned int indexCount, int& allocation);
+	void Free(int allocation);
+
+	void GetLocation(int allocation, int& baseVertex, int& startIndex);
+	// binds the shared buffers for the allocation, the device state drops the binds when the last model used the same stride and format.
+	void Bind(DeviceStateClass* deviceState, int allocation);
+
+	bool Defragment();
+	void GetStatistics(StatisticsType& statistics);
+
+private:
+	struct AllocationType
+	{
+		unsigned int vertexOffset;
+		unsigned int vertexSize;
+		unsigned int vertexStride;
+		unsigned int indexOffset;
+		unsigned int indexSize;
+		DXGI_FORMAT indexFormat;
+		bool used;
+	};
+
+	bool CreateBuffer(unsigned int byteWidth, unsigned int bindFlags, ID3D11Buffer** buffer);
+	bool Relocate(ID3D11Buffer** buffer, unsigned int bindFlags, unsigned int capacity, const std::vector<RangeAllocatorClass::MoveType>& copies);
+	bool AllocateRange(RangeAllocatorClass* allocator, ID3D11Buffer** buffer, unsigned int bindFlags, unsigned int size, unsigned int alignment, unsigned int& offset);
+	void Upload(ID3D11Buffer* buffer, unsigned int offset, const void* data, unsigned int size);
+
+private:
+	ID3D11Device* m_device;
+	ID3D11DeviceContext* m_deviceContext;
+	ID3D11Buffer* m_vertexBuffer, * m_indexBuffer;
+	RangeAllocatorClass* m_VertexAllocator, * m_IndexAllocator;
+
+	std::vector<AllocationType> m_allocations;
+	std::vector<int> m_freeAllocations;
+
+	unsigned int m_defragmentations;
+};
+
+#endif
@@ -1,11 +1,59 @@
-#include "GraphicsClass.h"
+#include "graphicsclass.h"
+
+#include <cmath>
+
+#ifdef _WIN32
+#include "d3dclass.h"
+#include "d3dshadercompilerclass.h"
+#include "geometryarenaclass.h"
+#include "constantdataclass.h"
+#include "instancebufferclass.h"
+#endif
 
 GraphicsClass::GraphicsClass()
 {
+	int i;
+
+	m_JobSystem = nullptr;
+	m_FrameArena = nullptr;
+	m_Backend = nullptr;
 	m_Direct3D = nullptr;
+	m_Software = nullptr;
+	m_Geometry = nullptr;
 	m_Camera = nullptr;
-	m_Model = nullptr;
-	m_ColorShader = nullptr;
+	m_modelHandle = HANDLE_NULL;
+	m_MeshLoader = nullptr;
+	m_modelRequest = -1;
+	m_Scene = nullptr;
+	m_sceneModel = nullptr;
+	m_Frustum = nullptr;
+	m_OcclusionCuller = nullptr;
+	for(i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		m_frames[i].model = nullptr;
+		m_frames[i].shader = nullptr;
+		m_frames[i].index = i;
+		m_frames[i].visibleObjects = nullptr;
+		m_frames[i].drawList = nullptr;
+		m_frames[i].drawCount = 0;
+	}
+	m_updateFrame = 0;
+	m_frameQueued = false;
+	m_updateCounter = 0;
+	m_metrics = nullptr;
+	m_frameTimeMetric = -1;
+	m_framesMetric = -1;
+	m_drawCallsMetric = -1;
+	m_visibleObjectsMetric = -1;
+	m_mappedBytesMetric = -1;
+	m_loaderQueueMetric = -1;
+	m_geometryBytesMetric = -1;
+	m_CommandRecorder = nullptr;
+	m_ConstantData = nullptr;
+	m_InstanceBuffer = nullptr;
+	m_ShaderCompiler = nullptr;
+	m_ShaderCache = nullptr;
+	m_colorShaderHandle = HANDLE_NULL;
 }
 
 GraphicsClass::GraphicsClass(const GraphicsClass&)
@@ -16,25 +64,79 @@ GraphicsClass::~GraphicsClass()
 {
 }
 
-bool GraphicsClass::Initialize(int screenWidth, int screenHeight, HWND hwnd)
+void GraphicsClass::GetDefaultSceneDesc(SceneDescType& desc)
 {
+	desc.modelFilename = MODEL_FILENAME;
+	desc.objects = nullptr;
+	desc.objectCount = 0;
+	desc.gridSize = SCENE_GRID_SIZE;
+	desc.gridSpacing = SCENE_GRID_SPACING;
+
+	return;
+}
+
+bool GraphicsClass::Initialize(int screenWidth, int screenHeight, HWND hwnd, MetricsClass* metrics, const SceneDescType* scene)
+{
+	SceneDescType defaultScene;
+	PipelineStateClass* pipelineStates;
 	bool result;
+	int x, z, i;
 
-	// create the direct 3d oject
-	m_Direct3D = new D3DClass;
-	if(!m_Direct3D)
+	if(!scene)
+	{
+		GetDefaultSceneDesc(defaultScene);
+		scene = &defaultScene;
+	}
+
+	m_JobSystem = new JobSystemClass;
+	if(!m_JobSystem)
 	{
 		return false;
 	}
 
-	// initialize the direct 3d object
-	result = m_Direct3D->Initialize(screenWidth, screenHeight, VSYNC_ENABLED, hwnd, FULL_SCREEN, SCREEN_DEPTH, SCREEN_NEAR);
+	result = m_JobSystem->Initialize(JOB_THREADS);
+	if(!result)
+	{
+		return false;
+	}
+
+	m_FrameArena = new FrameArenaClass;
+	if(!m_FrameArena)
+	{
+		return false;
+	}
+
+	result = m_FrameArena->Initialize(m_JobSystem, FRAMES_IN_FLIGHT, FRAME_ARENA_BYTES);
 	if(!result)
 	{
-		MessageBox(hwnd, L"Could not initialize Direct3D", L"Error", MB_OK);
 		return false;
 	}
 
+	// without a window there is nothing to present to, render headless on the cpu instead.
+	if(!hwnd)
+	{
+		m_Software = new SoftwareRasterizerClass;
+		if(!m_Software)
+		{
+			return false;
+		}
+
+		result = m_Software->Initialize(screenWidth, screenHeight, SCREEN_DEPTH, SCREEN_NEAR, m_JobSystem);
+		if(!result)
+		{
+			return false;
+		}
+
+		m_Backend = m_Software;
+	} else
+	{
+		result = InitializeDevice(screenWidth, screenHeight, hwnd);
+		if(!result)
+		{
+			return false;
+		}
+	}
+
 	m_Camera = new CameraClass;
 	if(!m_Camera)
 	{
@@ -43,57 +145,301 @@ bool GraphicsClass::Initialize(int screenWidth, int screenHeight, HWND hwnd)
 
 	m_Camera->SetPosition(0.0f, 0.0f, -5.0f);
 
-	m_Model = new ModelClass;
-	if(!m_Model)
+	result = m_Models.Initialize(MODEL_CAPACITY, MEMORY_TAG_GEOMETRY, DestroyModel, this);
+	if(!result)
+	{
+		return false;
+	}
+
+	m_modelHandle = m_Models.Create();
+	if(!m_modelHandle)
 	{
 		return false;
 	}
 
-	result = m_Model->Initialize(m_Direct3D->GetDevice());
+	// the built in triangle, it also stands in for the streamed model until that is resident.
+	result = m_Models.Get(m_modelHandle)->Initialize(m_Geometry, m_JobSystem, nullptr, MODEL_VERTEX_FORMAT);
 	if(!result)
 	{
 		MessageBox(hwnd, L"Could not initialize the model object", L"Error", MB_OK);
 		return false;
 	}
 
-	m_ColorShader = new ColorShaderClass;
-	if(!m_ColorShader)
+	// the upload queue keeps its two ends on separate cache lines, new would only align the loader to 16 bytes before C++17.
+	m_MeshLoader = (MeshLoaderClass*)MemoryClass::Allocate(sizeof(MeshLoaderClass), alignof(MeshLoaderClass), MEMORY_TAG_LOADER);
+	if(!m_MeshLoader)
+	{
+		return false;
+	}
+	new(m_MeshLoader) MeshLoaderClass;
+
+	result = m_MeshLoader->Initialize(m_Geometry, m_JobSystem, MODEL_VERTEX_FORMAT, MESH_LOADER_THREADS, MESH_UPLOAD_QUEUE_SIZE);
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the mesh loader", L"Error", MB_OK);
+		return false;
+	}
+
+	if(scene->modelFilename)
+	{
+		m_modelRequest = m_MeshLoader->Load(scene->modelFilename, 0);
+	}
+
+	m_Scene = new SceneClass;
+	if(!m_Scene)
+	{
+		return false;
+	}
+
+	result = m_Scene->Initialize(scene->objects ? scene->objectCount : scene->gridSize * scene->gridSize);
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the scene object", L"Error", MB_OK);
+		return false;
+	}
+
+	if(scene->objects)
+	{
+		for(i = 0; i < scene->objectCount; i++)
+		{
+			m_Scene->AddObject(scene->objects[i * 4 + 0], scene->objects[i * 4 + 1], scene->objects[i * 4 + 2], scene->objects[i * 4 + 3]);
+		}
+	} else
+	{
+		// centered on the camera's x, starting at the origin and going away from it.
+		for(z = 0; z < scene->gridSize; z++)
+		{
+			for(x = 0; x < scene->gridSize; x++)
+			{
+				m_Scene->AddObject((x - (scene->gridSize - 1) * 0.5f) * scene->gridSpacing, 0.0f, z * scene->gridSpacing, 1.0f);
+			}
+		}
+	}
+
+	// every snapshot has its own draw list, the next frame is culled and sorted into one while the other is being drawn.
+	for(i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		m_frames[i].drawList = new DrawListClass;
+		if(!m_frames[i].drawList)
+		{
+			return false;
+		}
+
+		result = m_frames[i].drawList->Initialize(m_Scene->GetCapacity(), m_JobSystem);
+		if(!result)
+		{
+			MessageBox(hwnd, L"Could not initialize the draw list object", L"Error", MB_OK);
+			return false;
+		}
+	}
+
+	m_CommandRecorder = new CommandRecorderClass;
+	if(!m_CommandRecorder)
+	{
+		return false;
+	}
+
+	result = m_CommandRecorder->Initialize(m_Backend->GetDevice(), m_Software, m_JobSystem);
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the command recorder object", L"Error", MB_OK);
+		return false;
+	}
+
+	m_Frustum = new FrustumClass;
+	if(!m_Frustum)
+	{
+		return false;
+	}
+
+	result = m_Frustum->Initialize(m_JobSystem);
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the frustum object", L"Error", MB_OK);
+		return false;
+	}
+
+	m_OcclusionCuller = new OcclusionCullerClass;
+	if(!m_OcclusionCuller)
+	{
+		return false;
+	}
+
+	result = m_OcclusionCuller->Initialize(OCCLUSION_WIDTH, OCCLUSION_HEIGHT, m_JobSystem, OCCLUSION_BUDGET);
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the occlusion culler object", L"Error", MB_OK);
+		return false;
+	}
+
+	// hlsl is compiled with d3dcompiler, elsewhere the shader cache has no compiler and the software rasterizer needs none.
+#ifdef _WIN32
+	m_ShaderCompiler = new D3DShaderCompilerClass;
+	if(!m_ShaderCompiler)
+	{
+		return false;
+	}
+#endif
+
+	m_ShaderCache = new ShaderCacheClass;
+	if(!m_ShaderCache)
+	{
+		return false;
+	}
+
+	result = m_ShaderCache->Initialize(SHADER_CACHE_FILENAME, m_ShaderCompiler);
+	if(!result)
 	{
+		MessageBox(hwnd, L"Could not initialize the shader cache object", L"Error", MB_OK);
 		return false;
 	}
 
-	result = m_ColorShader->Initialize(m_Direct3D->GetDevice(), hwnd);
+	result = m_Shaders.Initialize(SHADER_CAPACITY, MEMORY_TAG_GENERAL, DestroyShader, this);
+	if(!result)
+	{
+		return false;
+	}
+
+	m_colorShaderHandle = m_Shaders.Create();
+	if(!m_colorShaderHandle)
+	{
+		return false;
+	}
+
+	pipelineStates = nullptr;
+#ifdef _WIN32
+	if(m_Direct3D)
+	{
+		pipelineStates = m_Direct3D->GetPipelineStates();
+	}
+#endif
+
+	result = m_Shaders.Get(m_colorShaderHandle)->Initialize(m_Backend->GetDevice(), hwnd, m_Models.Get(m_modelHandle)->GetVertexFormat(), m_ShaderCache,
+		m_JobSystem, pipelineStates);
 	if(!result)
 	{
 		MessageBox(hwnd, L"Could not initialize the color shader object", L"Error", MB_OK);
 		return false;
 	}
 
+	// written now rather than at shutdown, so a crash later on does not cost the next start its compiles.
+	m_ShaderCache->Save();
+
+	// what the frame loop publishes, memory use is the geometry arena's and the adapter's.
+	m_metrics = metrics;
+	if(m_metrics)
+	{
+		m_frameTimeMetric = m_metrics->AddHistogram("engine_frame_time_seconds", "Time from the start of one frame to the start of the next.", 0.000001);
+		m_framesMetric = m_metrics->AddCounter("engine_frames_total", "Frames drawn.");
+		m_drawCallsMetric = m_metrics->AddGauge("engine_draw_calls", "Draw calls of the last frame.");
+		m_visibleObjectsMetric = m_metrics->AddGauge("engine_visible_objects", "Objects left after culling in the last frame.");
+		m_mappedBytesMetric = m_metrics->AddCounter("engine_mapped_bytes_total", "Bytes written to the device through Map.");
+		m_loaderQueueMetric = m_metrics->AddGauge("engine_mesh_loader_queue_depth", "Meshes waiting to be loaded or to be uploaded.");
+		m_geometryBytesMetric = m_metrics->AddGauge("engine_geometry_bytes", "Bytes of the shared vertex and index buffers in use.");
+
+#ifdef _WIN32
+		if(m_Direct3D)
+		{
+			m_Direct3D->PublishMetrics(m_metrics);
+		}
+#endif
+	}
+
 	return true;
 }
 
-void GraphicsClass::Shutdown()
+#ifdef _WIN32
+bool GraphicsClass::InitializeDevice(int screenWidth, int screenHeight, HWND hwnd)
 {
-	if(m_ColorShader)
+	bool result;
+
+	// create the direct 3d oject
+	m_Direct3D = new D3DClass;
+	if(!m_Direct3D)
 	{
-		m_ColorShader->Shutdown();
-		delete m_ColorShader;
-		m_ColorShader = nullptr;
+		return false;
 	}
 
-	if (m_Model)
+	// initialize the direct 3d object
+	result = m_Direct3D->Initialize(screenWidth, screenHeight, VSYNC_ENABLED, hwnd, FULL_SCREEN, SCREEN_DEPTH, SCREEN_NEAR);
+	if(!result)
 	{
-		m_Model->Shutdown();
-		delete m_Model;
-		m_Model = nullptr;
+		MessageBox(hwnd, L"Could not initialize Direct3D", L"Error", MB_OK);
+		return false;
 	}
 
-	if (m_Camera)
+	m_Backend = m_Direct3D;
+
+	// every model's vertices and indices live in the same two buffers.
+	m_Geometry = new GeometryArenaClass;
+	if(!m_Geometry)
 	{
-		delete m_Camera;
-		m_Camera = nullptr;
+		return false;
 	}
-	
+
+	result = m_Geometry->Initialize(m_Direct3D->GetDevice(), m_Direct3D->GetDeviceContext(), GEOMETRY_VERTEX_CAPACITY, GEOMETRY_INDEX_CAPACITY);
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the geometry arena", L"Error", MB_OK);
+		return false;
+	}
+
+	// the software rasterizer takes its matrices per draw and needs no constant buffers.
+	m_ConstantData = new ConstantDataClass;
+	if(!m_ConstantData)
+	{
+		return false;
+	}
+
+	result = m_ConstantData->Initialize(m_Direct3D->GetDevice(), m_Direct3D->GetDeviceContext(), CONSTANT_OBJECT_CAPACITY);
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the constant data object", L"Error", MB_OK);
+		return false;
+	}
+
+	if(INSTANCED_RENDERING)
+	{
+		m_InstanceBuffer = new InstanceBufferClass;
+		if(!m_InstanceBuffer)
+		{
+			return false;
+		}
+
+		result = m_InstanceBuffer->Initialize(m_Direct3D->GetDevice(), INSTANCE_CAPACITY);
+		if(!result)
+		{
+			MessageBox(hwnd, L"Could not initialize the instance buffer object", L"Error", MB_OK);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void GraphicsClass::ShutdownDevice()
+{
+	if(m_InstanceBuffer)
+	{
+		m_InstanceBuffer->Shutdown();
+		delete m_InstanceBuffer;
+		m_InstanceBuffer = nullptr;
+	}
+
+	if(m_ConstantData)
+	{
+		m_ConstantData->Shutdown();
+		delete m_ConstantData;
+		m_ConstantData = nullptr;
+	}
+
+	if (m_Geometry)
+	{
+		m_Geometry->Shutdown();
+		delete m_Geometry;
+		m_Geometry = nullptr;
+	}
+
 	// Release the Direct3D object.
 	if (m_Direct3D)
 	{
@@ -101,44 +447,705 @@ void GraphicsClass::Shutdown()
 		delete m_Direct3D;
 		m_Direct3D = 0;
 	}
+
+	return;
+}
+#else
+bool GraphicsClass::InitializeDevice(int, int, HWND hwnd)
+{
+	MessageBox(hwnd, L"Direct3D is only available on windows", L"Error", MB_OK);
+	return false;
+}
+
+void GraphicsClass::ShutdownDevice()
+{
+	return;
+}
+#endif
+
+void GraphicsClass::Shutdown()
+{
+	int i;
+
+	// an update started ahead of its frame still reads most of what is released below.
+	if(m_JobSystem)
+	{
+		m_JobSystem->Wait(&m_updateCounter);
+	}
+	m_frameQueued = false;
+
+	// the released shaders and models still waiting for the gpu go along with the live ones.
+	m_Shaders.Shutdown();
+	m_colorShaderHandle = HANDLE_NULL;
+
+	if(m_ShaderCache)
+	{
+		m_ShaderCache->Shutdown();
+		delete m_ShaderCache;
+		m_ShaderCache = nullptr;
+	}
+
+	if(m_ShaderCompiler)
+	{
+		delete m_ShaderCompiler;
+		m_ShaderCompiler = nullptr;
+	}
+
+	if(m_OcclusionCuller)
+	{
+		m_OcclusionCuller->Shutdown();
+		delete m_OcclusionCuller;
+		m_OcclusionCuller = nullptr;
+	}
+
+	if(m_Frustum)
+	{
+		m_Frustum->Shutdown();
+		delete m_Frustum;
+		m_Frustum = nullptr;
+	}
+
+	if(m_CommandRecorder)
+	{
+		m_CommandRecorder->Shutdown();
+		delete m_CommandRecorder;
+		m_CommandRecorder = nullptr;
+	}
+
+	for(i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		if(m_frames[i].drawList)
+		{
+			m_frames[i].drawList->Shutdown();
+			delete m_frames[i].drawList;
+			m_frames[i].drawList = nullptr;
+		}
+
+		m_frames[i].visibleObjects = nullptr;
+		m_frames[i].model = nullptr;
+		m_frames[i].shader = nullptr;
+	}
+
+	if(m_Scene)
+	{
+		m_Scene->Shutdown();
+		delete m_Scene;
+		m_Scene = nullptr;
+	}
+	m_sceneModel = nullptr;
+
+	// the loader's models live in the geometry arena too, so it goes before the arena.
+	if (m_MeshLoader)
+	{
+		m_MeshLoader->Shutdown();
+		m_MeshLoader->~MeshLoaderClass();
+		MemoryClass::Free(m_MeshLoader);
+		m_MeshLoader = nullptr;
+	}
+
+	m_Models.Shutdown();
+	m_modelHandle = HANDLE_NULL;
+
+	if (m_Camera)
+	{
+		delete m_Camera;
+		m_Camera = nullptr;
+	}
+
+	// the constant data, the instance stream, the geometry arena and the device.
+	ShutdownDevice();
+	
+	if (m_Software)
+	{
+		m_Software->Shutdown();
+		delete m_Software;
+		m_Software = nullptr;
+	}
+
+	m_Backend = nullptr;
+
+	if(m_FrameArena)
+	{
+		m_FrameArena->Shutdown();
+		delete m_FrameArena;
+		m_FrameArena = nullptr;
+	}
+
+	// last, everything above may still be running jobs on it until its own Shutdown.
+	if(m_JobSystem)
+	{
+		m_JobSystem->Shutdown();
+		delete m_JobSystem;
+		m_JobSystem = nullptr;
+	}
 }
 
 bool GraphicsClass::Frame()
 {
+	ProfileScopeClass profileScope("GraphicsClass::Frame");
+#ifdef _WIN32
+	GeometryArenaClass::StatisticsType geometryStatistics;
+#endif
+	std::chrono::steady_clock::time_point frameStart;
+	unsigned long long completedFrame, retireFrame;
+	int renderFrame;
 	bool result;
 
+	frameStart = std::chrono::steady_clock::now();
+	if(m_metrics && m_frameStart.time_since_epoch().count() != 0)
+	{
+		m_metrics->Record(m_frameTimeMetric, std::chrono::duration<double>(frameStart - m_frameStart).count());
+	}
+	m_frameStart = frameStart;
+
+	// the update started during the last frame reads the scene and the models, nothing may change them before it is done.
+	m_JobSystem->Wait(&m_updateCounter);
+
+#ifdef _WIN32
+	// pack the shared buffers between frames once freed models have left too many holes.
+	if(m_Geometry)
+	{
+		m_Geometry->GetStatistics(geometryStatistics);
+		if(geometryStatistics.vertices.fragmentation > GEOMETRY_DEFRAGMENT_THRESHOLD || geometryStatistics.indices.fragmentation > GEOMETRY_DEFRAGMENT_THRESHOLD)
+		{
+			result = m_Geometry->Defragment();
+			if(!result)
+			{
+				return false;
+			}
+		}
+	}
+#endif
+
+	// the update is done with the released objects, they are destroyed once the gpu has drawn the last frame that used them.
+	// whatever is released from here on may still be drawn by the frame queued last time and by the one updated this time.
+	completedFrame = m_Backend->GetCompletedFrame();
+	retireFrame = m_Backend->GetSubmittedFrame() + FRAMES_IN_FLIGHT;
+	m_Models.Update(completedFrame, retireFrame);
+	m_Shaders.Update(completedFrame, retireFrame);
+
+	// make finished loads resident before drawing.
+	m_MeshLoader->Update(MESH_UPLOADS_PER_FRAME, completedFrame, retireFrame);
+
+	// the first frame, and every frame without the pipeline, has nothing updated ahead of it.
+	if(!m_frameQueued)
+	{
+		result = BeginUpdate(m_frames[m_updateFrame]);
+		if(!result)
+		{
+			return false;
+		}
+
+		Update(m_frames[m_updateFrame]);
+	}
+	renderFrame = m_updateFrame;
+	m_frameQueued = false;
+
+	// the next frame is culled and sorted into the other snapshot on a worker while this one is submitted.
+	// on this thread's own queue it would be the first job popped by the next Wait inside Render, the background queue keeps it off this thread.
+	if(PIPELINED_FRAMES)
+	{
+		m_updateFrame = (m_updateFrame + 1) % FRAMES_IN_FLIGHT;
+		result = BeginUpdate(m_frames[m_updateFrame]);
+		if(!result)
+		{
+			return false;
+		}
+
+		m_JobSystem->RunBackground(UpdateJob, this, 0, 1, 1, &m_updateCounter);
+		m_frameQueued = true;
+	}
+
 	// render the graphics scene.
-	result = Render();
+	result = Render(m_frames[renderFrame]);
 	if (!result)
 	{
 		return false;
 	}
 
+	PublishMetrics(m_frames[renderFrame]);
+
 	return true;
 }
 
-bool GraphicsClass::Render()
+RenderBackendClass* GraphicsClass::GetRenderBackend()
 {
-	XMMATRIX worldMatrix, viewMatrix, projectionMatrix;
-	bool result;
+	return m_Backend;
+}
 
-	m_Direct3D->BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+CameraClass* GraphicsClass::GetCamera()
+{
+	return m_Camera;
+}
 
+JobSystemClass* GraphicsClass::GetJobSystem()
+{
+	return m_JobSystem;
+}
+
+bool GraphicsClass::BeginUpdate(FrameType& frame)
+{
+	ProfileScopeClass profileScope("GraphicsClass::BeginUpdate");
+	XMFLOAT3 boundsCenter, boundsExtent;
+	ModelClass* model;
+
+	// the camera, the loader and the scene's bounds are only touched here on the render thread, the update itself works on the snapshot.
 	m_Camera->Render();
-	m_Direct3D->GetWorldMatrix(worldMatrix);
-	m_Camera->GetViewMatrix(viewMatrix);
-	m_Direct3D->GetProjectionMatrix(projectionMatrix);
+	m_Camera->GetViewMatrix(frame.viewMatrix);
+	frame.cameraPosition = m_Camera->GetPosition();
+	m_Backend->GetWorldMatrix(frame.worldMatrix);
+	m_Backend->GetProjectionMatrix(frame.projectionMatrix);
 
-	m_Model->Render(m_Direct3D->GetDeviceContext());
+	// the snapshot was drawn last frame, what was allocated for it then is not needed any more.
+	m_FrameArena->Reset(frame.index);
 
-	result = m_ColorShader->Render(m_Direct3D->GetDeviceContext(), m_Model->GetIndexCount(), worldMatrix, viewMatrix, projectionMatrix);
-	if(!result)
+	frame.visibleObjects = m_FrameArena->AllocateArray<int>(frame.index, m_Scene->GetObjectCount());
+	if(!frame.visibleObjects)
 	{
 		return false;
 	}
 
-	// Present the rendered scene to the screen.
-	m_Direct3D->EndScene();
+	// draw the placeholder while the streamed model is still on its way.
+	model = m_MeshLoader->GetModel(m_modelRequest);
+	if(!model)
+	{
+		model = m_Models.Get(m_modelHandle);
+	}
+
+	// every object draws this model, so the scene's bounds change along with it.
+	if(model != m_sceneModel)
+	{
+		model->GetBounds(boundsCenter, boundsExtent);
+		m_Scene->SetModelBounds(boundsCenter, boundsExtent);
+		m_sceneModel = model;
+	}
+
+	frame.model = model;
+	frame.shader = m_Shaders.Get(m_colorShaderHandle);
+
+	// compact positions are scaled back to model space in front of the world transform, by the shader's quantized variant.
+	model->GetDequantizeMatrix(frame.dequantizeMatrix);
 
 	return true;
 }
+
+void GraphicsClass::Update(FrameType& frame)
+{
+	ProfileScopeClass profileScope("GraphicsClass::Update");
+	int visibleCount;
+
+	// only the objects that are at least partly on screen get drawn.
+	m_Frustum->ConstructFrustum(frame.viewMatrix, frame.projectionMatrix);
+	visibleCount = m_Frustum->CullBoxes(m_Scene, frame.visibleObjects);
+	visibleCount = CullOccluded(frame, visibleCount);
+
+	// draws go out sorted by pipeline and then front to back, not in the order the culling left them.
+	frame.drawCount = BuildDrawList(frame, visibleCount);
+
+	return;
+}
+
+void GraphicsClass::UpdateJob(void* data, int, int)
+{
+	GraphicsClass* graphics;
+
+	graphics = (GraphicsClass*)data;
+	graphics->Update(graphics->m_frames[graphics->m_updateFrame]);
+
+	return;
+}
+
+bool GraphicsClass::Render(FrameType& frame)
+{
+	ProfileScopeClass profileScope("GraphicsClass::Render");
+#ifdef _WIN32
+	DeviceStateClass* deviceState;
+#endif
+	bool result;
+
+	m_Backend->BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+
+	frame.shader->SetDequantizeMatrix(frame.dequantizeMatrix);
+
+	if(m_Software)
+	{
+		// the chunks set their triangles up on every core, adding them in chunk order keeps the frame the same as drawing them here.
+		result = m_CommandRecorder->Record(frame.drawCount, [&](int chunk, int first, int last)
+		{
+			return RecordSoftware(m_CommandRecorder->GetCommandList(chunk), frame, first, last);
+		});
+		if(!result)
+		{
+			return false;
+		}
+
+		m_CommandRecorder->Execute(m_Software);
+	}
+#ifdef _WIN32
+	else
+	{
+		// nothing is known about what was bound before this frame, every bind in it goes through the shadow and is counted.
+		deviceState = m_Direct3D->GetDeviceState();
+		deviceState->BeginFrame();
+		deviceState->Invalidate();
+
+		// view and projection go up once, then the per object data of every visible object in as few maps as the rings allow.
+		result = m_ConstantData->BeginFrame(deviceState, frame.viewMatrix, frame.projectionMatrix, frame.dequantizeMatrix);
+		if(!result)
+		{
+			return false;
+		}
+
+		if(m_InstanceBuffer)
+		{
+			result = RenderInstances(deviceState, frame);
+		}
+		else
+		{
+			result = RenderObjects(deviceState, frame);
+		}
+		if(!result)
+		{
+			return false;
+		}
+
+		deviceState->EndFrame();
+	}
+#endif
+
+	// Present the rendered scene to the screen. with vsync on this is where a frame that is done early waits.
+	{
+		ProfileScopeClass presentScope("GraphicsClass::Present");
+		m_Backend->EndScene();
+	}
+
+	return true;
+}
+
+#ifdef _WIN32
+bool GraphicsClass::RenderObjects(DeviceStateClass* deviceState, FrameType& frame)
+{
+	ProfileScopeClass profileScope("GraphicsClass::RenderObjects");
+	XMMATRIX objectMatrix;
+	XMMATRIX* objectMatrices;
+	int j, first, uploaded;
+	bool result;
+
+	objectMatrices = m_FrameArena->AllocateArray<XMMATRIX>(frame.index, frame.drawCount);
+	if(!objectMatrices)
+	{
+		return false;
+	}
+
+	// the matrices go up in the sorted order, so each batch is a run of consecutive packets.
+	for(j = 0; j < frame.drawCount; j++)
+	{
+		m_Scene->GetWorldMatrix(frame.drawList->GetPacket(j).object, objectMatrix);
+		objectMatrices[j] = XMMatrixMultiply(objectMatrix, frame.worldMatrix);
+	}
+
+	for(first = 0; first < frame.drawCount; first += uploaded)
+	{
+		uploaded = m_ConstantData->UploadObjects(deviceState, objectMatrices + first, frame.drawCount - first);
+		if(uploaded <= 0)
+		{
+			return false;
+		}
+
+		// the batch is recorded on every core and executed before the next upload maps the ring again.
+		result = m_CommandRecorder->Record(uploaded, [&](int chunk, int begin, int end)
+		{
+			return RecordObjects(m_CommandRecorder->GetDeviceState(chunk), frame, begin, end);
+		});
+		if(!result)
+		{
+			return false;
+		}
+
+		m_CommandRecorder->Execute(deviceState);
+	}
+
+	return true;
+}
+
+bool GraphicsClass::RecordObjects(DeviceStateClass* deviceState, FrameType& frame, int first, int last)
+{
+	ProfileScopeClass profileScope("GraphicsClass::RecordObjects");
+	ModelClass* model;
+	ColorShaderClass* shader;
+	int i, j, indexCount, startIndex, baseVertex;
+	bool result;
+
+	model = frame.model;
+	shader = frame.shader;
+
+	// a deferred context starts with nothing bound, every chunk binds the model and the frame block itself.
+	model->Render(deviceState);
+	shader->SetFrameConstants(deviceState, m_ConstantData);
+
+	for(j = first; j < last; j++)
+	{
+		for(i = 0; i < model->GetSubsetCount(); i++)
+		{
+			model->GetSubset(i, indexCount, startIndex, baseVertex);
+
+			result = shader->Render(deviceState, m_ConstantData, j, indexCount, startIndex, baseVertex);
+			if(!result)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+#endif
+
+bool GraphicsClass::RecordSoftware(SoftwareCommandListClass* commandList, FrameType& frame, int first, int last)
+{
+	ProfileScopeClass profileScope("GraphicsClass::RecordSoftware");
+	XMMATRIX objectMatrix;
+	ModelClass* model;
+	int i, j, indexCount, startIndex, baseVertex;
+	bool result;
+
+	model = frame.model;
+	model->Render(commandList);
+
+	for(j = first; j < last; j++)
+	{
+		m_Scene->GetWorldMatrix(frame.drawList->GetPacket(j).object, objectMatrix);
+		objectMatrix = XMMatrixMultiply(objectMatrix, frame.worldMatrix);
+
+		// meshes too big for 16 bit indices are drawn in several subsets.
+		for(i = 0; i < model->GetSubsetCount(); i++)
+		{
+			model->GetSubset(i, indexCount, startIndex, baseVertex);
+
+			result = frame.shader->Render(commandList, indexCount, startIndex, baseVertex, objectMatrix, frame.viewMatrix, frame.projectionMatrix);
+			if(!result)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+#ifdef _WIN32
+bool GraphicsClass::RenderInstances(DeviceStateClass* deviceState, FrameType& frame)
+{
+	ProfileScopeClass profileScope("GraphicsClass::RenderInstances");
+	SceneClass::TransformsType transforms;
+	DrawListClass* drawList;
+	ModelClass* model;
+	unsigned int startInstance;
+	int i, j, indexCount, startIndex, baseVertex, first, last, uploaded;
+	bool result;
+
+	model = frame.model;
+	drawList = frame.drawList;
+
+	// a handful of draws, recorded right here on the immediate context.
+	model->Render(deviceState);
+	frame.shader->SetFrameConstants(deviceState, m_ConstantData);
+
+	// the backend's world matrix is the one object block every instance shares, the scene transforms go into the instance stream.
+	uploaded = m_ConstantData->UploadObjects(deviceState, &frame.worldMatrix, 1);
+	if(uploaded <= 0)
+	{
+		return false;
+	}
+
+	m_InstanceBuffer->Bind(deviceState, COLOR_SHADER_INSTANCE_SLOT);
+	m_Scene->GetTransforms(transforms);
+
+	// the visible list is not needed past the draw list, it is overwritten with the objects in draw order for the uploads to gather from.
+	for(j = 0; j < frame.drawCount; j++)
+	{
+		frame.visibleObjects[j] = drawList->GetPacket(j).object;
+	}
+
+	// a batch is a run of packets with the same pipeline and geometry, drawn with one call per subset however many objects it has.
+	for(first = 0; first < frame.drawCount; first = last)
+	{
+		for(last = first + 1; last < frame.drawCount; last++)
+		{
+			if(drawList->GetPacket(last).pipeline != drawList->GetPacket(first).pipeline ||
+				drawList->GetPacket(last).geometry != drawList->GetPacket(first).geometry)
+			{
+				break;
+			}
+		}
+
+		for(j = first; j < last; j += uploaded)
+		{
+			uploaded = m_InstanceBuffer->Upload(deviceState, transforms, frame.visibleObjects + j, last - j, startInstance);
+			if(uploaded <= 0)
+			{
+				return false;
+			}
+
+			for(i = 0; i < model->GetSubsetCount(); i++)
+			{
+				model->GetSubset(i, indexCount, startIndex, baseVertex);
+
+				result = frame.shader->RenderInstanced(deviceState, m_ConstantData, 0, indexCount, uploaded, startIndex, baseVertex, startInstance);
+				if(!result)
+				{
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+#endif
+
+void GraphicsClass::PublishMetrics(FrameType& frame)
+{
+#ifdef _WIN32
+	DeviceStateClass::StatisticsType deviceStatistics;
+	GeometryArenaClass::StatisticsType geometryStatistics;
+#endif
+	MeshLoaderClass::MetricsType loaderMetrics;
+
+	if(!m_metrics)
+	{
+		return;
+	}
+
+	m_metrics->Add(m_framesMetric, 1);
+	m_metrics->Set(m_visibleObjectsMetric, (double)frame.drawCount);
+
+	// the device counts what reached the driver, the software rasterizer draws every visible object's subsets.
+#ifdef _WIN32
+	if(m_Direct3D)
+	{
+		m_Direct3D->GetDeviceState()->GetStatistics(deviceStatistics);
+		m_metrics->Set(m_drawCallsMetric, (double)deviceStatistics.draws);
+		m_metrics->Add(m_mappedBytesMetric, deviceStatistics.bytesMapped);
+	}
+	else
+#endif
+	{
+		m_metrics->Set(m_drawCallsMetric, (double)frame.drawCount * (double)frame.model->GetSubsetCount());
+	}
+
+	m_MeshLoader->GetMetrics(loaderMetrics);
+	m_metrics->Set(m_loaderQueueMetric, (double)(loaderMetrics.queued + loaderMetrics.waitingForUpload));
+
+#ifdef _WIN32
+	if(m_Geometry)
+	{
+		m_Geometry->GetStatistics(geometryStatistics);
+		m_metrics->Set(m_geometryBytesMetric, (double)geometryStatistics.vertices.usedSize + (double)geometryStatistics.indices.usedSize);
+	}
+#endif
+
+	return;
+}
+
+int GraphicsClass::CullOccluded(FrameType& frame, int visibleCount)
+{
+	ProfileScopeClass profileScope("GraphicsClass::CullOccluded");
+	XMMATRIX objectMatrix;
+	SceneClass::BoundsType bounds;
+	const XMFLOAT3* positions;
+	const unsigned int* indices;
+	float distances[OCCLUDERS_PER_FRAME], distance, x, y, z;
+	int occluders[OCCLUDERS_PER_FRAME], occluderCount, vertexCount, indexCount, i, j, object;
+
+	// a model too detailed to rasterize on the cpu hides nothing.
+	if(!frame.model->GetOccluder(positions, vertexCount, indices, indexCount))
+	{
+		return visibleCount;
+	}
+
+	// the visible objects nearest to the camera cover the most, keep them sorted by distance.
+	m_Scene->GetBounds(bounds);
+	occluderCount = 0;
+	for(i = 0; i < visibleCount; i++)
+	{
+		object = frame.visibleObjects[i];
+		x = bounds.centerX[object] - frame.cameraPosition.x;
+		y = bounds.centerY[object] - frame.cameraPosition.y;
+		z = bounds.centerZ[object] - frame.cameraPosition.z;
+		distance = x * x + y * y + z * z;
+
+		if(occluderCount == OCCLUDERS_PER_FRAME && distance >= distances[occluderCount - 1])
+		{
+			continue;
+		}
+
+		j = occluderCount < OCCLUDERS_PER_FRAME ? occluderCount++ : occluderCount - 1;
+		for(; j > 0 && distances[j - 1] > distance; j--)
+		{
+			distances[j] = distances[j - 1];
+			occluders[j] = occluders[j - 1];
+		}
+		distances[j] = distance;
+		occluders[j] = object;
+	}
+
+	m_OcclusionCuller->BeginFrame(frame.viewMatrix, frame.projectionMatrix);
+
+	// occluders are drawn from the model space positions, the dequantize matrix does not apply.
+	for(i = 0; i < occluderCount; i++)
+	{
+		m_Scene->GetWorldMatrix(occluders[i], objectMatrix);
+		m_OcclusionCuller->AddOccluder(positions, vertexCount, indices, indexCount, objectMatrix);
+	}
+
+	m_OcclusionCuller->RasterizeOccluders();
+
+	return m_OcclusionCuller->CullObjects(m_Scene, frame.visibleObjects, visibleCount);
+}
+
+int GraphicsClass::BuildDrawList(FrameType& frame, int visibleCount)
+{
+	ProfileScopeClass profileScope("GraphicsClass::BuildDrawList");
+	SceneClass::BoundsType bounds;
+	unsigned long long key;
+	unsigned int pipeline;
+	float x, y, z, depth;
+	int i, object;
+
+	m_Scene->GetBounds(bounds);
+
+	// one model and one shader so far, the keys only differ in their depth bucket until there are more.
+	pipeline = frame.shader->GetPipeline(m_InstanceBuffer != nullptr);
+
+	frame.drawList->Clear();
+	for(i = 0; i < visibleCount; i++)
+	{
+		object = frame.visibleObjects[i];
+		x = bounds.centerX[object] - frame.cameraPosition.x;
+		y = bounds.centerY[object] - frame.cameraPosition.y;
+		z = bounds.centerZ[object] - frame.cameraPosition.z;
+		depth = sqrtf(x * x + y * y + z * z) / SCREEN_DEPTH;
+
+		key = DrawListClass::MakeKey(DRAW_LAYER_OPAQUE, pipeline, 0, depth, 0);
+		frame.drawList->Add(key, pipeline, 0, object);
+	}
+
+	frame.drawList->Sort();
+
+	return frame.drawList->GetCount();
+}
+
+void GraphicsClass::DestroyModel(void*, ModelClass& model)
+{
+	model.Shutdown();
+	return;
+}
+
+void GraphicsClass::DestroyShader(void*, ColorShaderClass& shader)
+{
+	shader.Shutdown();
+	return;
+}
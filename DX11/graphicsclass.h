@@ -3,36 +3,199 @@
 #define _GRAPHICSCLASS_H_
 
 // includes
-#include "d3dclass.h"
+#include "DxDefine.h"
+#include "jobsystemclass.h"
+#include "framearenaclass.h"
+#include "handlepoolclass.h"
+#include "softwarerasterizerclass.h"
 #include "cameraclass.h"
 #include "modelclass.h"
+#include "meshloaderclass.h"
+#include "sceneclass.h"
+#include "frustumclass.h"
+#include "occlusioncullerclass.h"
+#include "drawlistclass.h"
+#include "commandrecorderclass.h"
+#include "shadercacheclass.h"
 #include "colorshaderclass.h"
+#include "metricsclass.h"
+#include "profilerclass.h"
+
+// forward declarations, the device and what lives on it are only built on windows.
+class D3DClass;
+class GeometryArenaClass;
+class ConstantDataClass;
+class InstanceBufferClass;
 
 // globals
 const bool FULL_SCREEN = false;
+// threads of the job system every parallel stage runs on, 0 uses every core.
+const int JOB_THREADS = 0;
 const bool VSYNC_ENABLED = true;
 const float SCREEN_DEPTH = 1000.0f;
 const float SCREEN_NEAR = 0.1f;
+// mesh file to stream in, the built in triangle is drawn until it is resident or when this is null.
+const char* const MODEL_FILENAME = nullptr;
+// 0 leaves one core to the render thread and loads on the rest.
+const int MESH_LOADER_THREADS = 0;
+const int MESH_UPLOAD_QUEUE_SIZE = 64;
+// models made resident per frame, uploads are spread out so a burst of loads does not hitch.
+const int MESH_UPLOADS_PER_FRAME = 4;
+// how the model is stored on the gpu, see vertexformatclass.h.
+const unsigned int MODEL_VERTEX_FORMAT = VERTEX_FORMAT_COMPACT;
+// starting size in bytes of the shared vertex and index buffers, they double when full.
+const unsigned int GEOMETRY_VERTEX_CAPACITY = 32 * 1024 * 1024;
+const unsigned int GEOMETRY_INDEX_CAPACITY = 16 * 1024 * 1024;
+// the arena gets packed once this much of its free space is outside the largest free block.
+const float GEOMETRY_DEFRAGMENT_THRESHOLD = 0.5f;
+// the scene is a square grid of copies of the model lying in front of the camera.
+const int SCENE_GRID_SIZE = 64;
+const float SCENE_GRID_SPACING = 4.0f;
+// size of the cpu depth buffer the nearest visible objects are drawn into as occluders, powers of two.
+const int OCCLUSION_WIDTH = 256;
+const int OCCLUSION_HEIGHT = 128;
+const int OCCLUDERS_PER_FRAME = 16;
+// milliseconds per frame occlusion culling may take, whatever is not tested by then is drawn.
+const float OCCLUSION_BUDGET = 1.0f;
+// draw list layers, drawn in this order.
+const unsigned int DRAW_LAYER_OPAQUE = 0;
+// compiled shaders are kept here between runs, deleting it only costs one slower start.
+const char* const SHADER_CACHE_FILENAME = "../DX11/shaders.cache";
+// per object constant blocks written with one map, more visible objects than this are drawn in several batches.
+const int CONSTANT_OBJECT_CAPACITY = 4096;
+// the device draws each batch of objects sharing a model with one instanced call, false goes back to a draw per object.
+const bool INSTANCED_RENDERING = true;
+// instances in the ring of the instance stream, a megabyte of them.
+const int INSTANCE_CAPACITY = 65536;
+// the next frame is culled and sorted on the job system while this one is submitted, false updates and draws every frame in turn.
+const bool PIPELINED_FRAMES = true;
+// frame snapshots the update and render stages hand between them, one being drawn and one being updated.
+const int FRAMES_IN_FLIGHT = 2;
+// starting size of every thread's arena per frame in flight, an arena that needed more grows to it on its next reset.
+const size_t FRAME_ARENA_BYTES = 256 * 1024;
+// models and shaders the graphics class owns at once, counting the released ones the gpu may still be drawing with.
+const unsigned int MODEL_CAPACITY = 16;
+const unsigned int SHADER_CAPACITY = 16;
 
 class GraphicsClass
 {
+public:
+	// what the scene is made of, GetDefaultSceneDesc fills in the constants above.
+	struct SceneDescType
+	{
+		// mesh file every object draws, the built in triangle is drawn until it is resident or when this is null.
+		const char* modelFilename;
+		// objects as position x, y, z and scale, four floats each. null lays out the grid below instead.
+		const float* objects;
+		int objectCount;
+		int gridSize;
+		float gridSpacing;
+	};
+
 public:
 	GraphicsClass();
 	GraphicsClass(const GraphicsClass&);
 	~GraphicsClass();
 
-	bool Initialize(int, int, HWND);
+	static void GetDefaultSceneDesc(SceneDescType& desc);
+
+	// metrics may be null, nothing is published then. a null scene is the default one.
+	bool Initialize(int, int, HWND, MetricsClass* metrics, const SceneDescType* scene);
 	void Shutdown();
 	bool Frame();
 
+	RenderBackendClass* GetRenderBackend();
+	// the camera is read at the start of every frame, it may be moved between Frame calls.
+	CameraClass* GetCamera();
+	// the threads every frame and the mesh loaders' parsing run on.
+	JobSystemClass* GetJobSystem();
+
+private:
+	// what the render stage needs of a frame. the update stage fills a snapshot in, after that only the render stage reads it.
+	struct FrameType
+	{
+		XMMATRIX worldMatrix;
+		XMMATRIX viewMatrix;
+		XMMATRIX projectionMatrix;
+		XMMATRIX dequantizeMatrix;
+		XMFLOAT3 cameraPosition;
+		// resolved from their handles when the update starts, a release in between only destroys them once the frame is drawn.
+		ModelClass* model;
+		ColorShaderClass* shader;
+		// which of m_frames it is, its per frame memory comes from the arena slot of the same index.
+		int index;
+		// the objects left after culling. the instanced path overwrites them with the objects in draw order.
+		int* visibleObjects;
+		// the visible objects' draws, sorted by state and depth before they are submitted.
+		DrawListClass* drawList;
+		int drawCount;
+	};
+
 private:
-	bool Render();
+	// creates the device and the buffers every frame's draws go through, the headless build has no device to create.
+	bool InitializeDevice(int, int, HWND);
+	void ShutdownDevice();
+	bool BeginUpdate(FrameType& frame);
+	void Update(FrameType& frame);
+	static void UpdateJob(void* data, int first, int last);
+	bool Render(FrameType& frame);
+	int CullOccluded(FrameType& frame, int visibleCount);
+	int BuildDrawList(FrameType& frame, int visibleCount);
+	bool RenderObjects(DeviceStateClass* deviceState, FrameType& frame);
+	bool RecordObjects(DeviceStateClass* deviceState, FrameType& frame, int first, int last);
+	bool RecordSoftware(SoftwareCommandListClass* commandList, FrameType& frame, int first, int last);
+	bool RenderInstances(DeviceStateClass* deviceState, FrameType& frame);
+	void PublishMetrics(FrameType& frame);
+	static void DestroyModel(void* context, ModelClass& model);
+	static void DestroyShader(void* context, ColorShaderClass& shader);
 
 private:
+	// culling, sorting, recording and the software rasterizer all run their work as jobs on it.
+	JobSystemClass* m_JobSystem;
+	// whatever a frame needs only until it is drawn, reset when its snapshot is updated again.
+	FrameArenaClass* m_FrameArena;
+	// the backend is whichever of the two below got created.
+	RenderBackendClass* m_Backend;
 	D3DClass* m_Direct3D;
+	SoftwareRasterizerClass* m_Software;
+	GeometryArenaClass* m_Geometry;
 	CameraClass* m_Camera;
-	ModelClass* m_Model;
-	ColorShaderClass* m_ColorShader;
+	// the models and shaders are owned by the pools and named by handle, the built in triangle is m_modelHandle.
+	HandlePoolClass<ModelClass> m_Models;
+	HandleType m_modelHandle;
+	MeshLoaderClass* m_MeshLoader;
+	int m_modelRequest;
+	SceneClass* m_Scene;
+	// the model the scene's bounds were last taken from.
+	ModelClass* m_sceneModel;
+	FrustumClass* m_Frustum;
+	OcclusionCullerClass* m_OcclusionCuller;
+	FrameType m_frames[FRAMES_IN_FLIGHT];
+	// the snapshot the last update went into, and whether that update was started ahead of its frame and is still to be drawn.
+	int m_updateFrame;
+	bool m_frameQueued;
+	JobSystemClass::CounterType m_updateCounter;
+	// records the sorted draws as jobs, into deferred contexts or software command lists.
+	CommandRecorderClass* m_CommandRecorder;
+	ConstantDataClass* m_ConstantData;
+	// null when the device draws an object at a time.
+	InstanceBufferClass* m_InstanceBuffer;
+	ShaderCompilerClass* m_ShaderCompiler;
+	ShaderCacheClass* m_ShaderCache;
+	HandlePoolClass<ColorShaderClass> m_Shaders;
+	HandleType m_colorShaderHandle;
+
+	// the registry the frame loop publishes into and its metrics' handles.
+	MetricsClass* m_metrics;
+	int m_frameTimeMetric;
+	int m_framesMetric;
+	int m_drawCallsMetric;
+	int m_visibleObjectsMetric;
+	int m_mappedBytesMetric;
+	int m_loaderQueueMetric;
+	int m_geometryBytesMetric;
+	// when the last frame started, the frame time is measured from one start to the next.
+	std::chrono::steady_clock::time_point m_frameStart;
 };
 
 #endif
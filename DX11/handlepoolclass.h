@@ -0,0 +1,320 @@
+#pragma once
+#ifndef _HANDLEPOOLCLASS_H_
+#define _HANDLEPOOLCLASS_H_
+
+#include <new>
+
+#include "memoryclass.h"
+
+// a pool object's name, the slot in the low bits and the slot's generation above them. 0 never names anything.
+typedef unsigned int HandleType;
+
+const HandleType HANDLE_NULL = 0;
+const unsigned int HANDLE_INDEX_BITS = 20;
+const unsigned int HANDLE_INDEX_MASK = (1u << HANDLE_INDEX_BITS) - 1;
+// a slot's generation wraps after this many releases, a handle kept that long could name the wrong object again.
+const unsigned int HANDLE_GENERATION_MASK = (1u << (32 - HANDLE_INDEX_BITS)) - 1;
+
+/*
+ * engine objects of one type, owned by the pool and named by 32 bit handles instead of pointers.
+ * the objects sit in one block, a slot each, and never move. a handle is the slot and the slot's generation, Get compares
+ * the generation and returns null for a handle whose object has been released, so holding on to a handle is always safe.
+ * the live objects are also listed densely, GetCount and GetObject walk them without looking at a single free slot.
+ * Release makes the handle stale right away, but the object is only destroyed once the gpu has finished every frame
+ * that may still use it: Update is given the newest frame the gpu has completed and the frame releases from now on have to wait for.
+ * freed slots are handed out newest first so the objects in use stay close together in the block.
+ * a pool is used from one thread, the render thread. pointers from Get stay valid until the object's release has been collected.
+ */
+template<typename T>
+class HandlePoolClass
+{
+public:
+	// run on an object before its destructor, to Shutdown what it holds.
+	typedef void (*DestroyFunction)(void* context, T& object);
+
+public:
+	HandlePoolClass()
+	{
+		m_objects = nullptr;
+		m_slots = nullptr;
+		m_dense = nullptr;
+		m_freeSlots = nullptr;
+		m_retired = nullptr;
+		m_capacity = 0;
+		m_count = 0;
+		m_freeCount = 0;
+		m_retiredFirst = 0;
+		m_retiredCount = 0;
+		m_retireFrame = 0;
+		m_destroy = nullptr;
+		m_context = nullptr;
+	}
+
+	HandlePoolClass(const HandlePoolClass&)
+	{
+	}
+
+	~HandlePoolClass()
+	{
+	}
+
+	// destroy may be null, the destructor is all that runs then.
+	bool Initialize(unsigned int capacity, MemoryTagType tag, DestroyFunction destroy, void* context)
+	{
+		unsigned int i;
+
+		if(capacity == 0 || capacity > HANDLE_INDEX_MASK + 1)
+		{
+			return false;
+		}
+
+		m_objects = (T*)MemoryClass::Allocate(sizeof(T) * capacity, alignof(T) > 16 ? alignof(T) : 16, tag);
+		if(!m_objects)
+		{
+			return false;
+		}
+
+		m_slots = MemoryClass::AllocateArray<SlotType>(capacity, tag);
+		if(!m_slots)
+		{
+			return false;
+		}
+
+		m_dense = MemoryClass::AllocateArray<unsigned int>(capacity, tag);
+		if(!m_dense)
+		{
+			return false;
+		}
+
+		m_freeSlots = MemoryClass::AllocateArray<unsigned int>(capacity, tag);
+		if(!m_freeSlots)
+		{
+			return false;
+		}
+
+		m_retired = MemoryClass::AllocateArray<RetiredType>(capacity, tag);
+		if(!m_retired)
+		{
+			return false;
+		}
+
+		// the first slots are handed out first.
+		for(i = 0; i < capacity; i++)
+		{
+			m_slots[i].generation = 1;
+			m_slots[i].dense = 0;
+			m_freeSlots[i] = capacity - 1 - i;
+		}
+
+		m_capacity = capacity;
+		m_count = 0;
+		m_freeCount = capacity;
+		m_retiredFirst = 0;
+		m_retiredCount = 0;
+		m_retireFrame = 0;
+		m_destroy = destroy;
+		m_context = context;
+
+		return true;
+	}
+
+	// destroys every object right away, live and released alike. nothing may be using any of them any more.
+	void Shutdown()
+	{
+		if(m_objects)
+		{
+			while(m_count > 0)
+			{
+				Release(MakeHandle(m_dense[m_count - 1]));
+			}
+
+			Collect(m_retiredCount);
+		}
+
+		MemoryClass::FreeArray(m_retired);
+		m_retired = nullptr;
+		MemoryClass::FreeArray(m_freeSlots);
+		m_freeSlots = nullptr;
+		MemoryClass::FreeArray(m_dense);
+		m_dense = nullptr;
+		MemoryClass::FreeArray(m_slots);
+		m_slots = nullptr;
+		MemoryClass::Free(m_objects);
+		m_objects = nullptr;
+
+		m_capacity = 0;
+		m_count = 0;
+		m_freeCount = 0;
+
+		return;
+	}
+
+	// a default constructed object, HANDLE_NULL when every slot is in use or waiting for the gpu.
+	HandleType Create()
+	{
+		unsigned int slot;
+
+		if(m_freeCount == 0)
+		{
+			return HANDLE_NULL;
+		}
+
+		slot = m_freeSlots[--m_freeCount];
+		new(&m_objects[slot]) T;
+
+		m_slots[slot].dense = m_count;
+		m_dense[m_count++] = slot;
+
+		return MakeHandle(slot);
+	}
+
+	// null for HANDLE_NULL and for a handle whose object has been released.
+	T* Get(HandleType handle)
+	{
+		unsigned int slot;
+
+		slot = handle & HANDLE_INDEX_MASK;
+		if(slot >= m_capacity || m_slots[slot].generation != handle >> HANDLE_INDEX_BITS)
+		{
+			return nullptr;
+		}
+
+		return &m_objects[slot];
+	}
+
+	// the handle and every copy of it go stale now, the object is destroyed by the first Update the gpu is done with it by.
+	// stale handles are ignored.
+	void Release(HandleType handle)
+	{
+		unsigned int slot, dense, last;
+
+		if(!Get(handle))
+		{
+			return;
+		}
+
+		slot = handle & HANDLE_INDEX_MASK;
+
+		// the next handle of the slot is a different one, generation 0 is skipped so no handle is ever HANDLE_NULL.
+		m_slots[slot].generation = (m_slots[slot].generation + 1) & HANDLE_GENERATION_MASK;
+		if(m_slots[slot].generation == 0)
+		{
+			m_slots[slot].generation = 1;
+		}
+
+		// the last live object takes its place in the dense list.
+		dense = m_slots[slot].dense;
+		last = m_dense[--m_count];
+		m_dense[dense] = last;
+		m_slots[last].dense = dense;
+
+		// frames only go up, so the oldest release is always the first one the gpu is done with.
+		m_retired[(m_retiredFirst + m_retiredCount) % m_capacity].slot = slot;
+		m_retired[(m_retiredFirst + m_retiredCount) % m_capacity].frame = m_retireFrame;
+		m_retiredCount++;
+
+		return;
+	}
+
+	// once per frame. destroys the released objects whose frame the gpu has completed, releases after this wait for retireFrame.
+	void Update(unsigned long long completedFrame, unsigned long long retireFrame)
+	{
+		unsigned int count;
+
+		for(count = 0; count < m_retiredCount; count++)
+		{
+			if(m_retired[(m_retiredFirst + count) % m_capacity].frame > completedFrame)
+			{
+				break;
+			}
+		}
+
+		Collect(count);
+		m_retireFrame = retireFrame;
+
+		return;
+	}
+
+	// live objects, GetObject and GetHandle go through them in no particular order. releasing one moves the last one into its place.
+	unsigned int GetCount()
+	{
+		return m_count;
+	}
+
+	T& GetObject(unsigned int index)
+	{
+		return m_objects[m_dense[index]];
+	}
+
+	HandleType GetHandle(unsigned int index)
+	{
+		return MakeHandle(m_dense[index]);
+	}
+
+	// released objects still waiting for the gpu.
+	unsigned int GetRetiredCount()
+	{
+		return m_retiredCount;
+	}
+
+private:
+	struct SlotType
+	{
+		unsigned int generation;
+		// where the slot is in the dense list while it is live.
+		unsigned int dense;
+	};
+
+	struct RetiredType
+	{
+		unsigned int slot;
+		unsigned long long frame;
+	};
+
+	HandleType MakeHandle(unsigned int slot)
+	{
+		return m_slots[slot].generation << HANDLE_INDEX_BITS | slot;
+	}
+
+	// destroys the oldest count released objects and frees their slots.
+	void Collect(unsigned int count)
+	{
+		unsigned int slot;
+
+		for(; count > 0; count--)
+		{
+			slot = m_retired[m_retiredFirst].slot;
+			m_retiredFirst = (m_retiredFirst + 1) % m_capacity;
+			m_retiredCount--;
+
+			if(m_destroy)
+			{
+				m_destroy(m_context, m_objects[slot]);
+			}
+			m_objects[slot].~T();
+
+			m_freeSlots[m_freeCount++] = slot;
+		}
+
+		return;
+	}
+
+private:
+	T* m_objects;
+	SlotType* m_slots;
+	// the live objects' slots, and the free ones newest first.
+	unsigned int* m_dense;
+	unsigned int* m_freeSlots;
+	// released objects oldest first, a ring starting at m_retiredFirst.
+	RetiredType* m_retired;
+	unsigned int m_capacity;
+	unsigned int m_count;
+	unsigned int m_freeCount;
+	unsigned int m_retiredFirst;
+	unsigned int m_retiredCount;
+	unsigned long long m_retireFrame;
+	DestroyFunction m_destroy;
+	void* m_context;
+};
+
+#endif
@@ -1,4 +1,4 @@
-#include "InputClass.h"
+#include "inputclass.h"
 
 InputClass::InputClass()
 {
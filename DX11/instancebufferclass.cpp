@@ -0,0 +1,134 @@
+#include "instancebufferclass.h"
+
+#include <xmmintrin.h>
+
+InstanceBufferClass::InstanceBufferClass()
+{
+	m_instanceBuffer = nullptr;
+	m_capacity = 0;
+	m_ringHead = 0;
+}
+
+InstanceBufferClass::InstanceBufferClass(const InstanceBufferClass&)
+{
+}
+
+InstanceBufferClass::~InstanceBufferClass()
+{
+}
+
+bool InstanceBufferClass::Initialize(ID3D11Device* device, int capacity)
+{
+	HRESULT result;
+	D3D11_BUFFER_DESC bufferDesc;
+
+	if(!device || capacity <= 0)
+	{
+		return false;
+	}
+
+	bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	bufferDesc.ByteWidth = (UINT)capacity * sizeof(InstanceType);
+	bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	bufferDesc.MiscFlags = 0;
+	bufferDesc.StructureByteStride = 0;
+
+	result = device->CreateBuffer(&bufferDesc, NULL, &m_instanceBuffer);
+	if(FAILED(result))
+	{
+		return false;
+	}
+
+	m_capacity = capacity;
+	// a full ring makes the first upload discard, the buffer is never appended to before it was mapped once.
+	m_ringHead = capacity;
+
+	return true;
+}
+
+void InstanceBufferClass::Shutdown()
+{
+	if(m_instanceBuffer)
+	{
+		m_instanceBuffer->Release();
+		m_instanceBuffer = nullptr;
+	}
+
+	m_capacity = 0;
+	m_ringHead = 0;
+
+	return;
+}
+
+unsigned int InstanceBufferClass::GetInputLayout(unsigned int slot, D3D11_INPUT_ELEMENT_DESC* elements)
+{
+	elements[0].SemanticName = "INSTANCE";
+	elements[0].SemanticIndex = 0;
+	elements[0].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	elements[0].InputSlot = slot;
+	elements[0].AlignedByteOffset = 0;
+	elements[0].InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
+	elements[0].InstanceDataStepRate = 1;
+
+	return 1;
+}
+
+int InstanceBufferClass::Upload(DeviceStateClass* deviceState, const SceneClass::TransformsType& transforms, const int* objects, int count,
+	unsigned int& startInstance)
+{
+	HRESULT result;
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	D3D11_MAP mapType;
+	float* output;
+	int i, object;
+
+	count = count < m_capacity ? count : m_capacity;
+	if(count <= 0)
+	{
+		return 0;
+	}
+
+	// vertex buffers can always be appended to without a discard, only a wrap has to start over.
+	if(m_ringHead + count <= m_capacity)
+	{
+		mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+	}
+	else
+	{
+		mapType = D3D11_MAP_WRITE_DISCARD;
+		m_ringHead = 0;
+	}
+
+	result = deviceState->Map(m_instanceBuffer, mapType, &mappedResource, (unsigned long long)count * sizeof(InstanceType));
+	if(FAILED(result))
+	{
+		return 0;
+	}
+
+	// one register per instance gathered from the four arrays, streamed into the write combined mapping without reading it.
+	output = (float*)mappedResource.pData + (size_t)m_ringHead * 4;
+	for(i = 0; i < count; i++)
+	{
+		object = objects[i];
+		_mm_stream_ps(output + (size_t)i * 4, _mm_setr_ps(transforms.positionX[object], transforms.positionY[object], transforms.positionZ[object],
+			transforms.scale[object]));
+	}
+
+	// streaming stores are weakly ordered, they have to land before the unmap.
+	_mm_sfence();
+
+	deviceState->Unmap(m_instanceBuffer);
+
+	startInstance = (unsigned int)m_ringHead;
+	m_ringHead += count;
+
+	return count;
+}
+
+void InstanceBufferClass::Bind(DeviceStateClass* deviceState, unsigned int slot)
+{
+	// the draws pick their instances with a start instance, the buffer is always bound from its beginning.
+	deviceState->IASetVertexBuffer(slot, m_instanceBuffer, sizeof(InstanceType), 0);
+	return;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#ifndef _INSTANCEBUFFERCLASS_H_
+#define _INSTANCEBUFFERCLASS_H_
+
+#include <d3d11.h>
+#include <DirectXMath.h>
+using namespace DirectX;
+
+#include "devicestateclass.h"
+#include "sceneclass.h"
+
+/*
+ * the per instance vertex stream of the instanced draws, one position and uniform scale per object.
+ * that is all a scene object's transform is, 16 bytes an instance instead of the 64 of a world matrix.
+ * the instances are gathered from the scene's transform arrays in draw order and streamed into a dynamic vertex buffer that is used as a ring:
+ * uploads are appended behind the ones the gpu may still be reading and only a full ring is discarded, so a draw starts at its upload's first instance.
+ */
+class InstanceBufferClass
+{
+public:
+	// what the INSTANCE element of Color.vs reads, xyz position and w scale.
+	struct InstanceType
+	{
+		XMFLOAT3 position;
+		float scale;
+	};
+
+public:
+	InstanceBufferClass();
+	InstanceBufferClass(const InstanceBufferClass&);
+	~InstanceBufferClass();
+
+	// the ring holds capacity instances, more objects than that are uploaded in several parts.
+	bool Initialize(ID3D11Device* device, int capacity);
+	void Shutdown();
+
+	// the one element the stream adds to an input layout, per instance data in the given input slot.
+	static unsigned int GetInputLayout(unsigned int slot, D3D11_INPUT_ELEMENT_DESC* elements);
+
+	// uploads the transforms of as many of the listed objects as fit and returns how many that was.
+	// they are drawn as startInstance onward, the instances of earlier uploads stay valid until the ring wraps.
+	int Upload(DeviceStateClass* deviceState, const SceneClass::TransformsType& transforms, const int* objects, int count, unsigned int& startInstance);
+	void Bind(DeviceStateClass* deviceState, unsigned int slot);
+
+private:
+	ID3D11Buffer* m_instanceBuffer;
+	int m_capacity;
+	// the next free instance in the ring.
+	int m_ringHead;
+};
+
+#endif
@@ -0,0 +1,442 @@
+#include "jobsystemclass.h"
+#include "memoryclass.h"
+
+// which system the current thread belongs to and its index in it, a thread only ever belongs to one.
+static thread_local JobSystemClass* t_jobSystem = nullptr;
+static thread_local int t_threadIndex = -1;
+
+JobSystemClass::JobSystemClass()
+{
+	m_queues = nullptr;
+	m_background = nullptr;
+	m_threadCount = 0;
+	m_queued = 0;
+	m_sleepers = 0;
+	m_quit = false;
+}
+
+JobSystemClass::JobSystemClass(const JobSystemClass&)
+{
+}
+
+JobSystemClass::~JobSystemClass()
+{
+}
+
+bool JobSystemClass::Initialize(int threadCount)
+{
+	int i;
+
+	if(threadCount <= 0)
+	{
+		threadCount = (int)std::thread::hardware_concurrency();
+		if(threadCount <= 0)
+		{
+			threadCount = 1;
+		}
+	}
+
+	// the queues keep their two ends on separate cache lines, new[] would only align them to 16 bytes before C++17.
+	m_queues = (WorkStealingQueueClass<JobType>*)MemoryClass::Allocate(sizeof(WorkStealingQueueClass<JobType>) * threadCount,
+		alignof(WorkStealingQueueClass<JobType>), MEMORY_TAG_GENERAL);
+	if(!m_queues)
+	{
+		return false;
+	}
+
+	m_threadCount = threadCount;
+	for(i = 0; i < threadCount; i++)
+	{
+		new(&m_queues[i]) WorkStealingQueueClass<JobType>;
+	}
+
+	for(i = 0; i < threadCount; i++)
+	{
+		if(!m_queues[i].Initialize(JOB_QUEUE_SIZE))
+		{
+			return false;
+		}
+	}
+
+	m_background = (BoundedQueueClass<JobType>*)MemoryClass::Allocate(sizeof(BoundedQueueClass<JobType>), alignof(BoundedQueueClass<JobType>),
+		MEMORY_TAG_GENERAL);
+	if(!m_background)
+	{
+		return false;
+	}
+	new(m_background) BoundedQueueClass<JobType>;
+
+	if(!m_background->Initialize(JOB_BACKGROUND_QUEUE_SIZE))
+	{
+		return false;
+	}
+
+	t_jobSystem = this;
+	t_threadIndex = 0;
+
+	m_queued = 0;
+	m_sleepers = 0;
+	m_quit = false;
+	for(i = 1; i < threadCount; i++)
+	{
+		m_workers.push_back(std::thread(WorkerThread, this, i));
+	}
+
+	return true;
+}
+
+void JobSystemClass::Shutdown()
+{
+	unsigned int i;
+	int j;
+
+	// wake the workers up and wait for them to leave, whatever they had queued is dropped.
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_quit = true;
+	}
+	m_sleepCondition.notify_all();
+
+	for(i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+	m_workers.clear();
+
+	if(m_queues)
+	{
+		for(j = 0; j < m_threadCount; j++)
+		{
+			m_queues[j].Shutdown();
+			m_queues[j].~WorkStealingQueueClass<JobType>();
+		}
+		MemoryClass::Free(m_queues);
+		m_queues = nullptr;
+	}
+
+	if(m_background)
+	{
+		m_background->Shutdown();
+		m_background->~BoundedQueueClass<JobType>();
+		MemoryClass::Free(m_background);
+		m_background = nullptr;
+	}
+
+	if(t_jobSystem == this)
+	{
+		t_jobSystem = nullptr;
+		t_threadIndex = -1;
+	}
+
+	m_threadCount = 0;
+
+	return;
+}
+
+int JobSystemClass::GetThreadCount()
+{
+	return m_threadCount;
+}
+
+int JobSystemClass::GetThreadIndex()
+{
+	return t_jobSystem == this ? t_threadIndex : -1;
+}
+
+void JobSystemClass::Run(JobFunction function, void* data, int first, int last, int grain, CounterType* counter)
+{
+	JobType job;
+	int threadIndex;
+
+	if(first >= last)
+	{
+		return;
+	}
+
+	threadIndex = GetThreadIndex();
+	if(threadIndex < 0)
+	{
+		function(data, first, last);
+		return;
+	}
+
+	job.function = function;
+	job.data = data;
+	job.first = first;
+	job.last = last;
+	job.grain = grain > 0 ? grain : 1;
+	job.counter = counter;
+
+	counter->fetch_add(1);
+	if(!Push(threadIndex, job))
+	{
+		Execute(threadIndex, job);
+	}
+
+	return;
+}
+
+void JobSystemClass::RunBackground(JobFunction function, void* data, int first, int last, int grain, CounterType* counter)
+{
+	JobType job;
+
+	if(first >= last)
+	{
+		return;
+	}
+
+	if(m_threadCount <= 1)
+	{
+		Run(function, data, first, last, grain, counter);
+		return;
+	}
+
+	job.function = function;
+	job.data = data;
+	job.first = first;
+	job.last = last;
+	job.grain = grain > 0 ? grain : 1;
+	job.counter = counter;
+
+	counter->fetch_add(1);
+	if(!m_background->Push(job))
+	{
+		counter->fetch_sub(1);
+		Run(function, data, first, last, grain, counter);
+		return;
+	}
+
+	// the same handshake with the sleepers as Push.
+	m_queued.fetch_add(1);
+	if(m_sleepers.load() > 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+		}
+		m_sleepCondition.notify_one();
+	}
+
+	return;
+}
+
+void JobSystemClass::Wait(CounterType* counter)
+{
+	JobType job;
+	int threadIndex;
+
+	threadIndex = GetThreadIndex();
+
+	// help instead of blocking, the jobs the counter waits for may well be sitting in this thread's own queue.
+	while(counter->load(std::memory_order_acquire) > 0)
+	{
+		if(threadIndex >= 0 && FindJob(threadIndex, job))
+		{
+			Execute(threadIndex, job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	return;
+}
+
+void JobSystemClass::ParallelFor(int count, int grain, JobFunction function, void* data)
+{
+	CounterType counter(0);
+
+	if(count <= 0)
+	{
+		return;
+	}
+
+	if(grain <= 0)
+	{
+		grain = count / (m_threadCount * JOB_RANGES_PER_THREAD);
+		grain = grain > 0 ? grain : 1;
+	}
+
+	// not worth queuing anything for.
+	if(count <= grain || m_threadCount <= 1)
+	{
+		function(data, 0, count);
+		return;
+	}
+
+	// Run would do all of it right here on a thread that is not ours.
+	if(GetThreadIndex() < 0)
+	{
+		ParallelForForeign(count, grain, function, data);
+		return;
+	}
+
+	Run(function, data, 0, count, grain, &counter);
+	Wait(&counter);
+
+	return;
+}
+
+void JobSystemClass::ParallelForForeign(int count, int grain, JobFunction function, void* data)
+{
+	ForeignCallType call;
+	CounterType counter(0);
+
+	call.function = function;
+	call.data = data;
+	call.remaining.store(count);
+
+	// the worker that takes it splits it up like any other job, the rest of them steal the halves.
+	RunBackground(RunForeign, &call, 0, count, grain, &counter);
+
+	{
+		std::unique_lock<std::mutex> lock(call.mutex);
+		call.condition.wait(lock, [&call] { return call.remaining.load() == 0; });
+	}
+
+	// the last part has run but may not have let go of the counter yet.
+	Wait(&counter);
+
+	return;
+}
+
+void JobSystemClass::RunForeign(void* data, int first, int last)
+{
+	ForeignCallType* call;
+
+	call = (ForeignCallType*)data;
+	call->function(call->data, first, last);
+
+	// notified under the lock, the waiter can not return and take call with it before this is done with it.
+	if(call->remaining.fetch_sub(last - first) == last - first)
+	{
+		std::lock_guard<std::mutex> lock(call->mutex);
+		call->condition.notify_one();
+	}
+
+	return;
+}
+
+bool JobSystemClass::Push(int threadIndex, const JobType& job)
+{
+	if(!m_queues[threadIndex].Push(job))
+	{
+		return false;
+	}
+
+	// a sleeper checks m_queued after counting itself in, so either it sees this job or this sees it.
+	m_queued.fetch_add(1);
+	if(m_sleepers.load() > 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+		}
+		m_sleepCondition.notify_one();
+	}
+
+	return true;
+}
+
+bool JobSystemClass::FindJob(int threadIndex, JobType& job)
+{
+	int i, victim;
+
+	if(m_queues[threadIndex].Pop(job))
+	{
+		m_queued.fetch_sub(1);
+		return true;
+	}
+
+	// the next threads over first, so the thieves do not all go for the same queue.
+	for(i = 1; i < m_threadCount; i++)
+	{
+		victim = (threadIndex + i) % m_threadCount;
+		if(m_queues[victim].Steal(job))
+		{
+			m_queued.fetch_sub(1);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool JobSystemClass::FindBackgroundJob(JobType& job)
+{
+	if(!m_background->Pop(job))
+	{
+		return false;
+	}
+
+	m_queued.fetch_sub(1);
+
+	return true;
+}
+
+void JobSystemClass::Execute(int threadIndex, JobType& job)
+{
+	JobType split;
+	int middle;
+
+	// leave the upper half for whoever is idle, as long as it is worth a job of its own.
+	while(job.last - job.first > job.grain)
+	{
+		middle = job.first + (job.last - job.first) / 2;
+
+		split = job;
+		split.first = middle;
+
+		job.counter->fetch_add(1);
+		if(!Push(threadIndex, split))
+		{
+			job.counter->fetch_sub(1);
+			break;
+		}
+
+		job.last = middle;
+	}
+
+	job.function(job.data, job.first, job.last);
+
+	job.counter->fetch_sub(1, std::memory_order_release);
+
+	return;
+}
+
+void JobSystemClass::WorkerThread(JobSystemClass* jobSystem, int threadIndex)
+{
+	JobType job;
+	int idle;
+
+	t_jobSystem = jobSystem;
+	t_threadIndex = threadIndex;
+
+	idle = 0;
+	while(!jobSystem->m_quit)
+	{
+		// background jobs come last and only here, a worker waiting inside a job does not pick one up either.
+		if(jobSystem->FindJob(threadIndex, job) || jobSystem->FindBackgroundJob(job))
+		{
+			jobSystem->Execute(threadIndex, job);
+			idle = 0;
+			continue;
+		}
+
+		if(++idle < JOB_IDLE_SPINS)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(jobSystem->m_sleepMutex);
+
+			jobSystem->m_sleepers++;
+			jobSystem->m_sleepCondition.wait(lock, [jobSystem] { return jobSystem->m_quit || jobSystem->m_queued.load() > 0; });
+			jobSystem->m_sleepers--;
+		}
+		idle = 0;
+	}
+
+	return;
+}
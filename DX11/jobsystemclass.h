@@ -0,0 +1,126 @@
+#pragma once
+#ifndef _JOBSYSTEMCLASS_H_
+#define _JOBSYSTEMCLASS_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "boundedqueueclass.h"
+#include "workstealingqueueclass.h"
+
+// jobs one thread can have queued, a thread with a full queue runs what it would have queued itself.
+const int JOB_QUEUE_SIZE = 4096;
+// jobs waiting for a worker to pick them up, see RunBackground.
+const int JOB_BACKGROUND_QUEUE_SIZE = 64;
+// times an idle worker looks for work before it goes to sleep.
+const int JOB_IDLE_SPINS = 64;
+// ranges per thread ParallelFor cuts its work into when it is not told a grain, enough to even out threads that start late.
+const int JOB_RANGES_PER_THREAD = 4;
+
+/*
+ * the threads every parallel part of the engine runs its work on, one per core with the thread that initialized it counted as the first.
+ * each thread has a work stealing deque. a thread queues and runs its own jobs newest first, an idle one steals the oldest job of another.
+ * a job is a function over a range of indices. whoever runs it keeps splitting the upper half off as a new job while the range is longer than its grain,
+ * so one big range is spread over every thread without anybody cutting it up in advance.
+ * dependencies are counters: Run adds to one for every part, each part takes one off when it finishes, and Wait runs other jobs until it is zero.
+ * a job can Run more jobs and Wait for them, ParallelFor is Run and Wait with any callable, passed by pointer so nothing is allocated for it.
+ * workers that find nothing to do sleep on a condition variable, queuing a job wakes one of them.
+ * a job that must not hold up the thread queuing it goes on a shared background queue instead, only workers with nothing else to do take from it.
+ * ParallelFor on a thread of its own, a mesh loader say, goes through that queue too and sleeps until the workers are done with it.
+ */
+class JobSystemClass
+{
+public:
+	typedef void (*JobFunction)(void* data, int first, int last);
+	// jobs started with it that have not finished, it has to start at zero.
+	typedef std::atomic<int> CounterType;
+
+public:
+	JobSystemClass();
+	JobSystemClass(const JobSystemClass&);
+	~JobSystemClass();
+
+	// 0 uses every core. Run, Wait and ParallelFor work from the initializing thread and from jobs.
+	bool Initialize(int threadCount);
+	void Shutdown();
+
+	int GetThreadCount();
+	// 0 for the thread that initialized the system, 1 and up for its workers and -1 for any other thread.
+	int GetThreadIndex();
+
+	// queues function over [first, last). a thread that is not one of the system's runs it right away instead.
+	void Run(JobFunction function, void* data, int first, int last, int grain, CounterType* counter);
+	// the same, but never run by the calling thread, not even while it waits on something else, unless there are no workers or the queue is full.
+	// Run puts the job on the caller's own queue and the caller takes its newest job first, a long job would end up in the middle of its next Wait.
+	void RunBackground(JobFunction function, void* data, int first, int last, int grain, CounterType* counter);
+	// runs jobs, the calling thread's own first, until the counter is back at zero.
+	void Wait(CounterType* counter);
+	// function over [0, count) on every thread, returns once all of it ran. grain 0 gives every thread a few ranges.
+	// unlike Run it also spreads the work from a thread that is not one of the system's, that thread blocks instead of helping.
+	void ParallelFor(int count, int grain, JobFunction function, void* data);
+
+	// the same over a lambda or anything else called as function(first, last). it is called through a pointer to it,
+	// unlike a std::function a lambda capturing more than a couple of pointers costs no allocation.
+	template<typename FunctionType>
+	void ParallelFor(int count, int grain, const FunctionType& function)
+	{
+		ParallelFor(count, grain, CallRange<FunctionType>, (void*)&function);
+		return;
+	}
+
+private:
+	struct JobType
+	{
+		JobFunction function;
+		void* data;
+		int first;
+		int last;
+		int grain;
+		CounterType* counter;
+	};
+
+	// a ParallelFor from another thread, the last part to finish wakes it.
+	struct ForeignCallType
+	{
+		JobFunction function;
+		void* data;
+		std::atomic<int> remaining;
+		std::mutex mutex;
+		std::condition_variable condition;
+	};
+
+	bool Push(int threadIndex, const JobType& job);
+	bool FindJob(int threadIndex, JobType& job);
+	bool FindBackgroundJob(JobType& job);
+	void Execute(int threadIndex, JobType& job);
+
+	template<typename FunctionType>
+	static void CallRange(void* data, int first, int last)
+	{
+		(*(const FunctionType*)data)(first, last);
+		return;
+	}
+
+	void ParallelForForeign(int count, int grain, JobFunction function, void* data);
+	static void RunForeign(void* data, int first, int last);
+	static void WorkerThread(JobSystemClass* jobSystem, int threadIndex);
+
+private:
+	// one per thread, the initializing thread's first.
+	WorkStealingQueueClass<JobType>* m_queues;
+	BoundedQueueClass<JobType>* m_background;
+	int m_threadCount;
+	std::vector<std::thread> m_workers;
+
+	// jobs sitting in any queue, the sleeping workers wait for it to be above zero.
+	std::atomic<int> m_queued;
+	std::atomic<int> m_sleepers;
+	std::atomic<bool> m_quit;
+	std::mutex m_sleepMutex;
+	std::condition_variable m_sleepCondition;
+};
+
+#endif
@@ -0,0 +1,115 @@
+#include "mappedfileclass.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFileClass::MappedFileClass()
+{
+	m_data = nullptr;
+	m_size = 0;
+}
+
+MappedFileClass::MappedFileClass(const MappedFileClass&)
+{
+}
+
+MappedFileClass::~MappedFileClass()
+{
+}
+
+bool MappedFileClass::Open(const char* filename)
+{
+#ifdef _WIN32
+	HANDLE file, mapping;
+	LARGE_INTEGER fileSize;
+
+	file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if(file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(!mapping)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	// the view keeps the mapping alive, both handles can go straight away.
+	m_data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	m_size = (unsigned long long)fileSize.QuadPart;
+
+	CloseHandle(mapping);
+	CloseHandle(file);
+#else
+	int file;
+	struct stat fileInfo;
+	void* data;
+
+	file = open(filename, O_RDONLY);
+	if(file < 0)
+	{
+		return false;
+	}
+
+	if(fstat(file, &fileInfo) != 0 || fileInfo.st_size <= 0)
+	{
+		close(file);
+		return false;
+	}
+
+	data = mmap(NULL, (size_t)fileInfo.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+
+	m_data = data == MAP_FAILED ? nullptr : (const unsigned char*)data;
+	m_size = (unsigned long long)fileInfo.st_size;
+#endif
+
+	if(!m_data)
+	{
+		m_size = 0;
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFileClass::Close()
+{
+	if(m_data)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(m_data);
+#else
+		munmap((void*)m_data, (size_t)m_size);
+#endif
+		m_data = nullptr;
+		m_size = 0;
+	}
+
+	return;
+}
+
+const unsigned char* MappedFileClass::GetData()
+{
+	return m_data;
+}
+
+unsigned long long MappedFileClass::GetSize()
+{
+	return m_size;
+}
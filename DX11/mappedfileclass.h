@@ -0,0 +1,25 @@
+#pragma once
+#ifndef _MAPPEDFILECLASS_H_
+#define _MAPPEDFILECLASS_H_
+
+// a whole file mapped read only, the pages are only read from disk when they are touched.
+class MappedFileClass
+{
+public:
+	MappedFileClass();
+	MappedFileClass(const MappedFileClass&);
+	~MappedFileClass();
+
+	// empty files can not be mapped and fail to open.
+	bool Open(const char* filename);
+	void Close();
+
+	const unsigned char* GetData();
+	unsigned long long GetSize();
+
+private:
+	const unsigned char* m_data;
+	unsigned long long m_size;
+};
+
+#endif
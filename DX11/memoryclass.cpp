@@ -0,0 +1,129 @@
+#include "memoryclass.h"
+
+MemoryClass::TagType MemoryClass::s_tags[MEMORY_TAG_COUNT];
+
+static const char* const s_tagNames[MEMORY_TAG_COUNT] =
+{
+	"general",
+	"frame",
+	"scene",
+	"culling",
+	"rasterizer",
+	"geometry",
+	"loader"
+};
+
+MemoryClass::MemoryClass()
+{
+}
+
+MemoryClass::MemoryClass(const MemoryClass&)
+{
+}
+
+MemoryClass::~MemoryClass()
+{
+}
+
+void* MemoryClass::Allocate(size_t size, MemoryTagType tag)
+{
+	return Allocate(size, 16, tag);
+}
+
+void* MemoryClass::Allocate(size_t size, size_t alignment, MemoryTagType tag)
+{
+	TagType* tagStatistics;
+	HeaderType* header;
+	char* allocation;
+	size_t address;
+	long long bytes, peak;
+
+	if(tag < 0 || tag >= MEMORY_TAG_COUNT)
+	{
+		tag = MEMORY_TAG_GENERAL;
+	}
+
+	// the header is aligned to 16 bytes already, only bigger alignments need room to move the block up.
+	if(alignment < 16)
+	{
+		alignment = 16;
+	}
+
+	allocation = (char*)::operator new(sizeof(HeaderType) + size + (alignment > 16 ? alignment : 0), std::nothrow);
+	if(!allocation)
+	{
+		return nullptr;
+	}
+
+	address = ((size_t)allocation + sizeof(HeaderType) + alignment - 1) & ~(alignment - 1);
+	header = (HeaderType*)(address - sizeof(HeaderType));
+	header->allocation = allocation;
+	header->size = size;
+	header->tag = tag;
+
+	tagStatistics = &s_tags[tag];
+	bytes = tagStatistics->bytes.fetch_add((long long)size, std::memory_order_relaxed) + (long long)size;
+	tagStatistics->allocations.fetch_add(1, std::memory_order_relaxed);
+	tagStatistics->totalAllocations.fetch_add(1, std::memory_order_relaxed);
+
+	// the peak only ever goes up, a lost race is retried against the newer peak.
+	peak = tagStatistics->peakBytes.load(std::memory_order_relaxed);
+	while(bytes > peak && !tagStatistics->peakBytes.compare_exchange_weak(peak, bytes, std::memory_order_relaxed))
+	{
+	}
+
+	return (void*)address;
+}
+
+void MemoryClass::Free(void* memory)
+{
+	HeaderType* header;
+	TagType* tagStatistics;
+
+	if(!memory)
+	{
+		return;
+	}
+
+	header = (HeaderType*)((char*)memory - sizeof(HeaderType));
+
+	tagStatistics = &s_tags[header->tag];
+	tagStatistics->bytes.fetch_sub((long long)header->size, std::memory_order_relaxed);
+	tagStatistics->allocations.fetch_sub(1, std::memory_order_relaxed);
+
+	::operator delete(header->allocation);
+
+	return;
+}
+
+const char* MemoryClass::GetTagName(MemoryTagType tag)
+{
+	if(tag < 0 || tag >= MEMORY_TAG_COUNT)
+	{
+		return "unknown";
+	}
+
+	return s_tagNames[tag];
+}
+
+void MemoryClass::GetStatistics(MemoryTagType tag, StatisticsType& statistics)
+{
+	TagType* tagStatistics;
+
+	if(tag < 0 || tag >= MEMORY_TAG_COUNT)
+	{
+		statistics.bytes = 0;
+		statistics.peakBytes = 0;
+		statistics.allocations = 0;
+		statistics.totalAllocations = 0;
+		return;
+	}
+
+	tagStatistics = &s_tags[tag];
+	statistics.bytes = tagStatistics->bytes.load(std::memory_order_relaxed);
+	statistics.peakBytes = tagStatistics->peakBytes.load(std::memory_order_relaxed);
+	statistics.allocations = tagStatistics->allocations.load(std::memory_order_relaxed);
+	statistics.totalAllocations = tagStatistics->totalAllocations.load(std::memory_order_relaxed);
+
+	return;
+}
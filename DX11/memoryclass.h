@@ -0,0 +1,109 @@
+#pragma once
+#ifndef _MEMORYCLASS_H_
+#define _MEMORYCLASS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+// what an allocation is for, the statistics are kept per tag.
+enum MemoryTagType
+{
+	MEMORY_TAG_GENERAL = 0,
+	// the per frame arenas' blocks, see FrameArenaClass.
+	MEMORY_TAG_FRAME = 1,
+	MEMORY_TAG_SCENE = 2,
+	MEMORY_TAG_CULLING = 3,
+	MEMORY_TAG_RASTERIZER = 4,
+	// system memory copies of models, before and after they are uploaded.
+	MEMORY_TAG_GEOMETRY = 5,
+	MEMORY_TAG_LOADER = 6,
+	MEMORY_TAG_COUNT = 7
+};
+
+/*
+ * the engine's heap, every long lived block goes through it with a tag saying which subsystem it belongs to.
+ * each block carries a small header with its size and tag in front of it, so Free needs nothing but the pointer
+ * and the bytes in use, their peak and the number of allocations are counted per tag without a lock.
+ * the blocks come from the global operator new, a counting replacement of it sees them like any other allocation.
+ * nothing here is meant for the frame loop, per frame memory comes from FrameArenaClass and objects that come and go from PoolClass.
+ */
+class MemoryClass
+{
+public:
+	struct StatisticsType
+	{
+		long long bytes;
+		long long peakBytes;
+		// live blocks, and every block ever allocated.
+		long long allocations;
+		long long totalAllocations;
+	};
+
+public:
+	MemoryClass();
+	MemoryClass(const MemoryClass&);
+	~MemoryClass();
+
+	// null when out of memory. blocks are aligned to 16 bytes, or to alignment when that is a bigger power of two.
+	static void* Allocate(size_t size, MemoryTagType tag);
+	static void* Allocate(size_t size, size_t alignment, MemoryTagType tag);
+	// null is ignored.
+	static void Free(void* memory);
+
+	// arrays of types that need no destructor, their elements are constructed the way new[] constructs them.
+	template<typename T>
+	static T* AllocateArray(size_t count, MemoryTagType tag)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "MemoryClass arrays are freed without running destructors");
+		T* array;
+		size_t i;
+
+		array = (T*)Allocate(sizeof(T) * (count > 0 ? count : 1), alignof(T) > 16 ? alignof(T) : 16, tag);
+		if(!array)
+		{
+			return nullptr;
+		}
+
+		for(i = 0; i < count; i++)
+		{
+			new(&array[i]) T;
+		}
+
+		return array;
+	}
+
+	template<typename T>
+	static void FreeArray(T* array)
+	{
+		Free(array);
+		return;
+	}
+
+	static const char* GetTagName(MemoryTagType tag);
+	static void GetStatistics(MemoryTagType tag, StatisticsType& statistics);
+
+private:
+	// right in front of every block, padded so the block behind it stays aligned.
+	struct alignas(16) HeaderType
+	{
+		// where the underlying allocation starts, the block may have been moved up to align it.
+		void* allocation;
+		size_t size;
+		int tag;
+	};
+
+	struct alignas(64) TagType
+	{
+		std::atomic<long long> bytes;
+		std::atomic<long long> peakBytes;
+		std::atomic<long long> allocations;
+		std::atomic<long long> totalAllocations;
+	};
+
+private:
+	static TagType s_tags[MEMORY_TAG_COUNT];
+};
+
+#endif
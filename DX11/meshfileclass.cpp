@@ -0,0 +1,308 @@
+#include "meshfileclass.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+static const char MESH_FILE_MAGIC[4] = { 'D', 'X', 'M', 'S' };
+
+// tells apart the temporary files of threads saving the same mesh at once.
+static std::atomic<unsigned int> s_saveCount(0);
+
+static unsigned long long AlignUp(unsigned long long value)
+{
+	return (value + MESH_FILE_ALIGNMENT - 1) & ~(unsigned long long)(MESH_FILE_ALIGNMENT - 1);
+}
+
+MeshFileClass::MeshFileClass()
+{
+	m_data = nullptr;
+	m_size = 0;
+}
+
+MeshFileClass::MeshFileClass(const MeshFileClass&)
+{
+}
+
+MeshFileClass::~MeshFileClass()
+{
+}
+
+bool MeshFileClass::Open(const char* filename)
+{
+	bool result;
+
+	result = m_file.Open(filename);
+	if(!result)
+	{
+		return false;
+	}
+
+	m_data = m_file.GetData();
+	m_size = m_file.GetSize();
+
+	result = m_size >= sizeof(HeaderType) && Validate();
+	if(!result)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void MeshFileClass::Close()
+{
+	m_file.Close();
+	m_data = nullptr;
+	m_size = 0;
+
+	return;
+}
+
+const MeshFileClass::HeaderType* MeshFileClass::GetHeader()
+{
+	return (const HeaderType*)m_data;
+}
+
+const void* MeshFileClass::GetVertices()
+{
+	return m_data + GetHeader()->vertexOffset;
+}
+
+const void* MeshFileClass::GetIndices()
+{
+	return m_data + GetHeader()->indexOffset;
+}
+
+const MeshFileClass::SubsetType* MeshFileClass::GetSubsets()
+{
+	return (const SubsetType*)(m_data + GetHeader()->subsetOffset);
+}
+
+bool MeshFileClass::Validate()
+{
+	const HeaderType* header;
+	const unsigned char* indices;
+	const SubsetType* subsets;
+	SubsetType wholeSubset;
+	unsigned int i, k, subsetCount, next, index;
+
+	header = GetHeader();
+
+	if(memcmp(header->magic, MESH_FILE_MAGIC, sizeof(MESH_FILE_MAGIC)) != 0 || header->version != MESH_FILE_VERSION)
+	{
+		return false;
+	}
+
+	if(header->vertexStride == 0 || (header->indexStride != 2 && header->indexStride != 4))
+	{
+		return false;
+	}
+
+	if(header->vertexSize != (unsigned long long)header->vertexStride * header->vertexCount ||
+		header->indexSize != (unsigned long long)header->indexStride * header->indexCount ||
+		header->subsetSize != (unsigned long long)sizeof(SubsetType) * header->subsetCount)
+	{
+		return false;
+	}
+
+	// every section has to be page aligned and inside the file.
+	if((header->vertexOffset % MESH_FILE_ALIGNMENT) != 0 || (header->indexOffset % MESH_FILE_ALIGNMENT) != 0 ||
+		(header->subsetOffset % MESH_FILE_ALIGNMENT) != 0)
+	{
+		return false;
+	}
+
+	// compared without adding, a huge offset must not wrap around and pass.
+	if(header->vertexOffset > m_size || header->vertexSize > m_size - header->vertexOffset ||
+		header->indexOffset > m_size || header->indexSize > m_size - header->indexOffset ||
+		header->subsetOffset > m_size || header->subsetSize > m_size - header->subsetOffset)
+	{
+		return false;
+	}
+
+	// optimized files go straight to the buffers and the rasterizer, nothing after this looks at the triangles again.
+	if(header->indexCount % 3 != 0)
+	{
+		return false;
+	}
+
+	// the subsets have to cover the indices in order, and every index has to land on a vertex from its subset's base.
+	subsets = GetSubsets();
+	subsetCount = header->subsetCount;
+	if(subsetCount == 0)
+	{
+		wholeSubset.indexCount = header->indexCount;
+		wholeSubset.startIndex = 0;
+		wholeSubset.baseVertex = 0;
+		subsets = &wholeSubset;
+		subsetCount = 1;
+	}
+
+	indices = m_data + header->indexOffset;
+	next = 0;
+	for(i = 0; i < subsetCount; i++)
+	{
+		if(subsets[i].startIndex != next || subsets[i].indexCount > header->indexCount - next || subsets[i].indexCount % 3 != 0)
+		{
+			return false;
+		}
+		next += subsets[i].indexCount;
+
+		for(k = subsets[i].startIndex; k < next; k++)
+		{
+			if(header->indexStride == 2)
+			{
+				index = ((const unsigned short*)indices)[k];
+			} else
+			{
+				index = ((const unsigned int*)indices)[k];
+			}
+
+			if((unsigned long long)index + subsets[i].baseVertex >= header->vertexCount)
+			{
+				return false;
+			}
+		}
+	}
+
+	if(next != header->indexCount)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+bool MeshFileClass::Save(const char* filename, const void* vertices, unsigned int vertexStride, unsigned int vertexCount,
+	const void* indices, unsigned int indexStride, unsigned int indexCount, unsigned int vertexFormat, unsigned int flags)
+{
+	float boundsMin[3], boundsMax[3], dequantize[16];
+	unsigned int i, k;
+
+	memset(boundsMin, 0, sizeof(boundsMin));
+	memset(boundsMax, 0, sizeof(boundsMax));
+
+	// bounds of the leading XMFLOAT3 position.
+	for(i = 0; i < vertexCount; i++)
+	{
+		const float* position = (const float*)((const unsigned char*)vertices + (unsigned long long)i * vertexStride);
+
+		for(k = 0; k < 3; k++)
+		{
+			if(i == 0 || position[k] < boundsMin[k]) boundsMin[k] = position[k];
+			if(i == 0 || position[k] > boundsMax[k]) boundsMax[k] = position[k];
+		}
+	}
+
+	memset(dequantize, 0, sizeof(dequantize));
+	dequantize[0] = dequantize[5] = dequantize[10] = dequantize[15] = 1.0f;
+
+	return Save(filename, vertices, vertexStride, vertexCount, indices, indexStride, indexCount, vertexFormat, flags,
+		nullptr, 0, boundsMin, boundsMax, dequantize);
+}
+
+bool MeshFileClass::Save(const char* filename, const void* vertices, unsigned int vertexStride, unsigned int vertexCount,
+	const void* indices, unsigned int indexStride, unsigned int indexCount, unsigned int vertexFormat, unsigned int flags,
+	const SubsetType* subsets, unsigned int subsetCount, const float boundsMin[3], const float boundsMax[3], const float dequantize[16])
+{
+	HeaderType header;
+	std::string temporary;
+	FILE* file;
+	unsigned long long written;
+	char padding[MESH_FILE_ALIGNMENT];
+	char suffix[32];
+	bool result;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MESH_FILE_MAGIC, sizeof(MESH_FILE_MAGIC));
+	header.version = MESH_FILE_VERSION;
+	header.vertexStride = vertexStride;
+	header.vertexCount = vertexCount;
+	header.indexStride = indexStride;
+	header.indexCount = indexCount;
+	header.vertexFormat = vertexFormat;
+	header.flags = flags;
+	header.vertexSize = (unsigned long long)vertexStride * vertexCount;
+	header.indexSize = (unsigned long long)indexStride * indexCount;
+	header.vertexOffset = AlignUp(sizeof(HeaderType));
+	header.indexOffset = AlignUp(header.vertexOffset + header.vertexSize);
+	memcpy(header.boundsMin, boundsMin, sizeof(header.boundsMin));
+	memcpy(header.boundsMax, boundsMax, sizeof(header.boundsMax));
+	memcpy(header.dequantize, dequantize, sizeof(header.dequantize));
+
+	// without subsets the table is left out altogether.
+	header.subsetCount = subsetCount;
+	header.subsetSize = (unsigned long long)sizeof(SubsetType) * subsetCount;
+	header.subsetOffset = subsetCount > 0 ? AlignUp(header.indexOffset + header.indexSize) : 0;
+
+	/*
+	 * written next to the file and renamed over it, so a loader mapping the file meanwhile never sees half of it.
+	 * truncating a mapped file in place faults its readers, and windows does not even let it be opened for writing.
+	 */
+	snprintf(suffix, sizeof(suffix), ".%u.tmp", s_saveCount.fetch_add(1));
+	temporary = std::string(filename) + suffix;
+
+#ifdef _WIN32
+	if(fopen_s(&file, temporary.c_str(), "wb") != 0)
+	{
+		file = nullptr;
+	}
+#else
+	file = fopen(temporary.c_str(), "wb");
+#endif
+	if(!file)
+	{
+		return false;
+	}
+
+	memset(padding, 0, sizeof(padding));
+
+	// header, vertices, indices and subsets, each padded out to the next page.
+	result = fwrite(&header, sizeof(header), 1, file) == 1;
+	written = sizeof(header);
+
+	result = result && fwrite(padding, 1, (size_t)(header.vertexOffset - written), file) == header.vertexOffset - written;
+	result = result && (header.vertexSize == 0 || fwrite(vertices, (size_t)header.vertexSize, 1, file) == 1);
+	written = header.vertexOffset + header.vertexSize;
+
+	result = result && fwrite(padding, 1, (size_t)(header.indexOffset - written), file) == header.indexOffset - written;
+	result = result && (header.indexSize == 0 || fwrite(indices, (size_t)header.indexSize, 1, file) == 1);
+	written = header.indexOffset + header.indexSize;
+
+	if(subsetCount > 0)
+	{
+		result = result && fwrite(padding, 1, (size_t)(header.subsetOffset - written), file) == header.subsetOffset - written;
+		result = result && fwrite(subsets, (size_t)header.subsetSize, 1, file) == 1;
+	}
+
+	if(fclose(file) != 0)
+	{
+		result = false;
+	}
+
+	// a file that is still mapped can not be replaced on windows, the caller decides whether the one already there will do.
+	if(result)
+	{
+#ifdef _WIN32
+		result = MoveFileExA(temporary.c_str(), filename, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+		result = rename(temporary.c_str(), filename) == 0;
+#endif
+	}
+
+	if(!result)
+	{
+		remove(temporary.c_str());
+		return false;
+	}
+
+	return true;
+}
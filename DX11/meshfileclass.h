@@ -0,0 +1,87 @@
+#pragma once
+#ifndef _MESHFILECLASS_H_
+#define _MESHFILECLASS_H_
+
+#include "mappedfileclass.h"
+
+// sections are aligned to this so a mapped file can be handed straight to buffer creation.
+const unsigned int MESH_FILE_ALIGNMENT = 4096;
+const unsigned int MESH_FILE_VERSION = 2;
+
+// the triangles and vertices have already been through MeshOptimizerClass and can be used as they are.
+const unsigned int MESH_FILE_FLAG_OPTIMIZED = 1;
+
+/*
+ * binary mesh file.
+ * a fixed size header followed by the vertex section, the index section and the subset table, each starting on a page boundary.
+ * the file is memory mapped read only, nothing gets parsed or copied, the vertex and index pointers point right into the mapping.
+ * the sections are stored in the layout the buffers want, quantized vertices and 16 bit indices included, so a file cooked for one vertex format loads without any conversion.
+ */
+class MeshFileClass
+{
+public:
+	// a run of indices drawn with one DrawIndexed, the indices are relative to baseVertex.
+	struct SubsetType
+	{
+		unsigned int indexCount;
+		unsigned int startIndex;
+		unsigned int baseVertex;
+	};
+
+	struct HeaderType
+	{
+		char magic[4];
+		unsigned int version;
+		unsigned int vertexStride;
+		unsigned int vertexCount;
+		unsigned int indexStride;
+		unsigned int indexCount;
+		unsigned int vertexFormat;
+		unsigned int flags;
+		unsigned long long vertexOffset;
+		unsigned long long vertexSize;
+		unsigned long long indexOffset;
+		unsigned long long indexSize;
+		float boundsMin[3];
+		float boundsMax[3];
+		// row major, takes the stored positions back to model space. the identity for float positions.
+		float dequantize[16];
+		// no subsets means a single one over all indices from vertex 0.
+		unsigned long long subsetOffset;
+		unsigned long long subsetSize;
+		unsigned int subsetCount;
+		unsigned int reserved;
+	};
+
+public:
+	MeshFileClass();
+	MeshFileClass(const MeshFileClass&);
+	~MeshFileClass();
+
+	bool Open(const char* filename);
+	void Close();
+
+	const HeaderType* GetHeader();
+	const void* GetVertices();
+	const void* GetIndices();
+	const SubsetType* GetSubsets();
+
+	// written under a temporary name and renamed over filename, a copy of it that is mapped somewhere stays intact.
+	// every vertex has to start with an XMFLOAT3 position, it is used for the bounds.
+	static bool Save(const char* filename, const void* vertices, unsigned int vertexStride, unsigned int vertexCount,
+		const void* indices, unsigned int indexStride, unsigned int indexCount, unsigned int vertexFormat, unsigned int flags);
+	// any vertex format, the bounds and the dequantize matrix are given since the positions may not be floats.
+	static bool Save(const char* filename, const void* vertices, unsigned int vertexStride, unsigned int vertexCount,
+		const void* indices, unsigned int indexStride, unsigned int indexCount, unsigned int vertexFormat, unsigned int flags,
+		const SubsetType* subsets, unsigned int subsetCount, const float boundsMin[3], const float boundsMax[3], const float dequantize[16]);
+
+private:
+	bool Validate();
+
+private:
+	MappedFileClass m_file;
+	const unsigned char* m_data;
+	unsigned long long m_size;
+};
+
+#endif
@@ -0,0 +1,1688 @@
+#include "meshimporterclass.h"
+#include "jobsystemclass.h"
+#include "meshfileclass.h"
+#include "meshoptimizerclass.h"
+#include "vertexformatclass.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// obj chunks are at least this big, smaller ones cost more in scheduling than they save.
+static const size_t OBJ_MIN_CHUNK_SIZE = 256 * 1024;
+// deepest json nesting accepted, gltf itself never goes past a handful of levels.
+static const int JSON_MAX_DEPTH = 64;
+
+static const unsigned int GLB_MAGIC = 0x46546C67;
+static const unsigned int GLB_CHUNK_JSON = 0x4E4F534A;
+static const unsigned int GLB_CHUNK_BIN = 0x004E4942;
+
+static const int GLTF_FLOAT = 5126;
+static const int GLTF_BYTE = 5120;
+static const int GLTF_UNSIGNED_BYTE = 5121;
+static const int GLTF_SHORT = 5122;
+static const int GLTF_UNSIGNED_SHORT = 5123;
+static const int GLTF_UNSIGNED_INT = 5125;
+static const int GLTF_TRIANGLES = 4;
+
+enum JsonKind
+{
+	JSON_NULL = 0,
+	JSON_BOOL = 1,
+	JSON_NUMBER = 2,
+	JSON_STRING = 3,
+	JSON_ARRAY = 4,
+	JSON_OBJECT = 5
+};
+
+// just enough of a json tree for gltf, object members keep their order in keys and items.
+struct JsonType
+{
+	JsonKind kind;
+	double number;
+	std::string text;
+	std::vector<std::string> keys;
+	std::vector<JsonType> items;
+
+	JsonType()
+	{
+		kind = JSON_NULL;
+		number = 0.0;
+	}
+
+	const JsonType* Get(const char* key) const
+	{
+		size_t i;
+
+		for(i = 0; i < keys.size(); i++)
+		{
+			if(keys[i] == key)
+			{
+				return &items[i];
+			}
+		}
+
+		return nullptr;
+	}
+
+	const JsonType* At(double index) const
+	{
+		if(kind != JSON_ARRAY || index < 0.0 || index >= (double)items.size())
+		{
+			return nullptr;
+		}
+
+		return &items[(size_t)index];
+	}
+
+	double GetNumber(const char* key, double defaultValue) const
+	{
+		const JsonType* value;
+
+		value = Get(key);
+		return value && value->kind == JSON_NUMBER ? value->number : defaultValue;
+	}
+};
+
+struct GltfBufferType
+{
+	const unsigned char* data;
+	size_t size;
+};
+
+struct GltfAccessorType
+{
+	const unsigned char* data;
+	size_t count;
+	size_t stride;
+	int componentType;
+	int componentCount;
+	bool normalized;
+};
+
+struct GltfPrimitiveType
+{
+	const JsonType* primitive;
+	std::vector<MeshImporterClass::VertexType> vertices;
+	std::vector<unsigned int> indices;
+	bool valid;
+};
+
+struct ObjChunkType
+{
+	const char* begin;
+	const char* end;
+	unsigned int positionBase;
+	unsigned int positionCount;
+	std::vector<MeshImporterClass::VertexType> vertices;
+	std::vector<unsigned int> indices;
+	bool valid;
+};
+
+// runs task for every index below count on the job system's threads, or on the calling thread without one.
+template<typename TaskType>
+static void RunParallel(JobSystemClass* jobSystem, int count, const TaskType& task)
+{
+	auto range = [&task](int first, int last)
+	{
+		int index;
+
+		for(index = first; index < last; index++)
+		{
+			task(index);
+		}
+	};
+
+	if(!jobSystem)
+	{
+		range(0, count);
+		return;
+	}
+
+	// one index per job, a chunk or a primitive is already plenty of work.
+	jobSystem->ParallelFor(count, 1, range);
+
+	return;
+}
+
+static bool HasExtension(const char* filename, const char* extension)
+{
+	size_t length, extensionLength, i;
+	char a, b;
+
+	length = strlen(filename);
+	extensionLength = strlen(extension);
+	if(length < extensionLength)
+	{
+		return false;
+	}
+
+	for(i = 0; i < extensionLength; i++)
+	{
+		a = filename[length - extensionLength + i];
+		b = extension[i];
+		a = a >= 'A' && a <= 'Z' ? (char)(a - 'A' + 'a') : a;
+		if(a != b)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool ReadFile(const char* filename, std::vector<char>& data)
+{
+	FILE* file;
+	long size;
+	bool result;
+
+#ifdef _WIN32
+	if(fopen_s(&file, filename, "rb") != 0)
+	{
+		file = nullptr;
+	}
+#else
+	file = fopen(filename, "rb");
+#endif
+	if(!file)
+	{
+		return false;
+	}
+
+	result = fseek(file, 0, SEEK_END) == 0;
+	size = result ? ftell(file) : -1;
+	result = size >= 0 && fseek(file, 0, SEEK_SET) == 0;
+
+	if(result)
+	{
+		data.resize((size_t)size);
+		result = size == 0 || fread(data.data(), (size_t)size, 1, file) == 1;
+	}
+
+	fclose(file);
+
+	return result;
+}
+
+/*
+ * 64 bit hash of the source bytes, used as the cache key.
+ * four independent lanes of multiply and rotate keep it well above disk speed, the final mix is murmur3's.
+ */
+static unsigned long long HashBytes(const char* data, size_t size, unsigned long long seed)
+{
+	const unsigned long long prime1 = 0x9E3779B185EBCA87ULL;
+	const unsigned long long prime2 = 0xC2B2AE3D27D4EB4FULL;
+	unsigned long long lanes[4], word, hash;
+	size_t i;
+	int k;
+
+	lanes[0] = seed + prime1 + prime2;
+	lanes[1] = seed + prime2;
+	lanes[2] = seed;
+	lanes[3] = seed - prime1;
+
+	for(i = 0; i + 32 <= size; i += 32)
+	{
+		for(k = 0; k < 4; k++)
+		{
+			memcpy(&word, data + i + k * 8, 8);
+			lanes[k] += word * prime2;
+			lanes[k] = (lanes[k] << 31) | (lanes[k] >> 33);
+			lanes[k] *= prime1;
+		}
+	}
+
+	hash = lanes[0] ^ ((lanes[1] << 7) | (lanes[1] >> 57)) ^ ((lanes[2] << 12) | (lanes[2] >> 52)) ^ ((lanes[3] << 18) | (lanes[3] >> 46));
+	hash += (unsigned long long)size;
+
+	for(; i < size; i++)
+	{
+		hash = (hash ^ (unsigned char)data[i]) * prime1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDULL;
+	hash ^= hash >> 33;
+	hash *= 0xC4CEB9FE1A85EC53ULL;
+	hash ^= hash >> 33;
+
+	return hash;
+}
+
+static bool IsEightDigits(unsigned long long chunk)
+{
+	return (((chunk & 0xF0F0F0F0F0F0F0F0ULL) | (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL);
+}
+
+// eight ascii digits to their value with three multiplies instead of eight, the bytes are in memory order on little endian.
+static unsigned int ParseEightDigits(unsigned long long chunk)
+{
+	chunk -= 0x3030303030303030ULL;
+	chunk = (chunk * 10) + (chunk >> 8);
+	chunk = (((chunk & 0x000000FF000000FFULL) * 0x000F424000000064ULL) + (((chunk >> 16) & 0x000000FF000000FFULL) * 0x0000271000000001ULL)) >> 32;
+
+	return (unsigned int)chunk;
+}
+
+/*
+ * decimal to double.
+ * digits are gathered into a 64 bit mantissa eight at a time where possible, and when the mantissa and the power of ten are both exact as doubles
+ * one multiply or divide gives the correctly rounded result. anything else, long mantissas, big exponents, inf and nan, goes to strtod.
+ */
+static bool ParseNumber(const char*& p, const char* end, double& value)
+{
+	static const double powers[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	const char* start;
+	const char* q;
+	unsigned long long mantissa, chunk;
+	int digits, exponent, explicitExponent;
+	bool negative, truncated, anyDigits, negativeExponent;
+	char buffer[64];
+	char* stop;
+	size_t length;
+
+	while(p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+	{
+		p++;
+	}
+
+	start = p;
+	q = p;
+	mantissa = 0;
+	digits = 0;
+	exponent = 0;
+	truncated = false;
+	anyDigits = false;
+
+	negative = q < end && *q == '-';
+	if(q < end && (*q == '-' || *q == '+'))
+	{
+		q++;
+	}
+
+	// integer part.
+	while(end - q >= 8 && digits + 8 <= 19)
+	{
+		memcpy(&chunk, q, 8);
+		if(!IsEightDigits(chunk))
+		{
+			break;
+		}
+		mantissa = mantissa * 100000000ULL + ParseEightDigits(chunk);
+		digits += 8;
+		anyDigits = true;
+		q += 8;
+	}
+	while(q < end && *q >= '0' && *q <= '9')
+	{
+		if(digits < 19)
+		{
+			mantissa = mantissa * 10 + (unsigned long long)(*q - '0');
+			digits += mantissa != 0 ? 1 : 0;
+		} else
+		{
+			truncated = true;
+		}
+		anyDigits = true;
+		q++;
+	}
+
+	// fraction, every digit taken into the mantissa moves the exponent down by one.
+	if(q < end && *q == '.')
+	{
+		q++;
+		while(end - q >= 8 && digits + 8 <= 19)
+		{
+			memcpy(&chunk, q, 8);
+			if(!IsEightDigits(chunk))
+			{
+				break;
+			}
+			mantissa = mantissa * 100000000ULL + ParseEightDigits(chunk);
+			digits += 8;
+			exponent -= 8;
+			anyDigits = true;
+			q += 8;
+		}
+		while(q < end && *q >= '0' && *q <= '9')
+		{
+			if(digits < 19)
+			{
+				mantissa = mantissa * 10 + (unsigned long long)(*q - '0');
+				digits += mantissa != 0 ? 1 : 0;
+				exponent--;
+			} else
+			{
+				truncated = true;
+			}
+			anyDigits = true;
+			q++;
+		}
+	}
+
+	if(anyDigits && q < end && (*q == 'e' || *q == 'E'))
+	{
+		const char* e;
+
+		e = q + 1;
+		negativeExponent = e < end && *e == '-';
+		if(e < end && (*e == '-' || *e == '+'))
+		{
+			e++;
+		}
+
+		// an 'e' without digits is not part of the number.
+		if(e < end && *e >= '0' && *e <= '9')
+		{
+			explicitExponent = 0;
+			while(e < end && *e >= '0' && *e <= '9')
+			{
+				explicitExponent = explicitExponent < 100000 ? explicitExponent * 10 + (*e - '0') : explicitExponent;
+				e++;
+			}
+			exponent += negativeExponent ? -explicitExponent : explicitExponent;
+			q = e;
+		}
+	}
+
+	if(anyDigits && !truncated && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22)
+	{
+		value = (double)mantissa;
+		value = exponent < 0 ? value / powers[-exponent] : value * powers[exponent];
+		value = negative ? -value : value;
+		p = q;
+		return true;
+	}
+
+	// the slow path, strtod needs a terminated string.
+	length = (size_t)(end - start) < sizeof(buffer) - 1 ? (size_t)(end - start) : sizeof(buffer) - 1;
+	memcpy(buffer, start, length);
+	buffer[length] = '\0';
+
+	value = strtod(buffer, &stop);
+	if(stop == buffer)
+	{
+		return false;
+	}
+
+	p = start + (stop - buffer);
+
+	return true;
+}
+
+static bool ParseFloat(const char*& p, const char* end, float& value)
+{
+	double number;
+
+	if(!ParseNumber(p, end, number))
+	{
+		return false;
+	}
+
+	value = (float)number;
+
+	return true;
+}
+
+static bool ParseInteger(const char*& p, const char* end, long long& value)
+{
+	bool negative;
+	const char* q;
+
+	q = p;
+	negative = q < end && *q == '-';
+	if(q < end && (*q == '-' || *q == '+'))
+	{
+		q++;
+	}
+
+	if(q >= end || *q < '0' || *q > '9')
+	{
+		return false;
+	}
+
+	value = 0;
+	while(q < end && *q >= '0' && *q <= '9')
+	{
+		value = value < 1000000000000LL ? value * 10 + (*q - '0') : value;
+		q++;
+	}
+
+	value = negative ? -value : value;
+	p = q;
+
+	return true;
+}
+
+static void SkipSpaces(const char*& p, const char* end)
+{
+	while(p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+	{
+		p++;
+	}
+
+	return;
+}
+
+static void SkipJsonSpaces(const char*& p, const char* end)
+{
+	while(p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+	{
+		p++;
+	}
+
+	return;
+}
+
+static int HexDigit(char c)
+{
+	if(c >= '0' && c <= '9') return c - '0';
+	if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+	if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+	return -1;
+}
+
+static bool ParseJsonString(const char*& p, const char* end, std::string& text)
+{
+	unsigned int code;
+	int i;
+	char c;
+
+	if(p >= end || *p != '"')
+	{
+		return false;
+	}
+	p++;
+
+	text.clear();
+	while(p < end && *p != '"')
+	{
+		c = *p++;
+		if(c != '\\')
+		{
+			text += c;
+			continue;
+		}
+
+		if(p >= end)
+		{
+			return false;
+		}
+
+		c = *p++;
+		switch(c)
+		{
+			case 'b': text += '\b'; break;
+			case 'f': text += '\f'; break;
+			case 'n': text += '\n'; break;
+			case 'r': text += '\r'; break;
+			case 't': text += '\t'; break;
+			case 'u':
+				if(end - p < 4)
+				{
+					return false;
+				}
+				code = 0;
+				for(i = 0; i < 4; i++)
+				{
+					if(HexDigit(*p) < 0)
+					{
+						return false;
+					}
+					code = (code << 4) | (unsigned int)HexDigit(*p++);
+				}
+
+				// utf-8, surrogate pairs are kept as two separate code points which is fine for names and uris.
+				if(code < 0x80)
+				{
+					text += (char)code;
+				} else if(code < 0x800)
+				{
+					text += (char)(0xC0 | (code >> 6));
+					text += (char)(0x80 | (code & 0x3F));
+				} else
+				{
+					text += (char)(0xE0 | (code >> 12));
+					text += (char)(0x80 | ((code >> 6) & 0x3F));
+					text += (char)(0x80 | (code & 0x3F));
+				}
+				break;
+			default: text += c; break;
+		}
+	}
+
+	if(p >= end)
+	{
+		return false;
+	}
+	p++;
+
+	return true;
+}
+
+static bool ParseJson(const char*& p, const char* end, JsonType& value, int depth)
+{
+	if(depth > JSON_MAX_DEPTH)
+	{
+		return false;
+	}
+
+	SkipJsonSpaces(p, end);
+	if(p >= end)
+	{
+		return false;
+	}
+
+	switch(*p)
+	{
+		case '{':
+			value.kind = JSON_OBJECT;
+			p++;
+			SkipJsonSpaces(p, end);
+			if(p < end && *p == '}')
+			{
+				p++;
+				return true;
+			}
+			for(;;)
+			{
+				value.keys.push_back(std::string());
+				value.items.push_back(JsonType());
+
+				SkipJsonSpaces(p, end);
+				if(!ParseJsonString(p, end, value.keys.back()))
+				{
+					return false;
+				}
+
+				SkipJsonSpaces(p, end);
+				if(p >= end || *p != ':')
+				{
+					return false;
+				}
+				p++;
+
+				if(!ParseJson(p, end, value.items.back(), depth + 1))
+				{
+					return false;
+				}
+
+				SkipJsonSpaces(p, end);
+				if(p < end && *p == ',')
+				{
+					p++;
+					continue;
+				}
+				if(p < end && *p == '}')
+				{
+					p++;
+					return true;
+				}
+				return false;
+			}
+
+		case '[':
+			value.kind = JSON_ARRAY;
+			p++;
+			SkipJsonSpaces(p, end);
+			if(p < end && *p == ']')
+			{
+				p++;
+				return true;
+			}
+			for(;;)
+			{
+				value.items.push_back(JsonType());
+				if(!ParseJson(p, end, value.items.back(), depth + 1))
+				{
+					return false;
+				}
+
+				SkipJsonSpaces(p, end);
+				if(p < end && *p == ',')
+				{
+					p++;
+					continue;
+				}
+				if(p < end && *p == ']')
+				{
+					p++;
+					return true;
+				}
+				return false;
+			}
+
+		case '"':
+			value.kind = JSON_STRING;
+			return ParseJsonString(p, end, value.text);
+
+		case 't':
+		case 'f':
+		case 'n':
+			if(end - p >= 4 && memcmp(p, "true", 4) == 0)
+			{
+				value.kind = JSON_BOOL;
+				value.number = 1.0;
+				p += 4;
+				return true;
+			}
+			if(end - p >= 5 && memcmp(p, "false", 5) == 0)
+			{
+				value.kind = JSON_BOOL;
+				p += 5;
+				return true;
+			}
+			if(end - p >= 4 && memcmp(p, "null", 4) == 0)
+			{
+				p += 4;
+				return true;
+			}
+			return false;
+
+		default:
+			if(*p != '-' && (*p < '0' || *p > '9'))
+			{
+				return false;
+			}
+			value.kind = JSON_NUMBER;
+			return ParseNumber(p, end, value.number);
+	}
+}
+
+// relative uris may have percent escapes, spaces in file names being the usual one.
+static std::string DecodeUri(const std::string& uri)
+{
+	std::string text;
+	size_t i;
+
+	for(i = 0; i < uri.size(); i++)
+	{
+		if(uri[i] == '%' && i + 2 < uri.size() && HexDigit(uri[i + 1]) >= 0 && HexDigit(uri[i + 2]) >= 0)
+		{
+			text += (char)(HexDigit(uri[i + 1]) * 16 + HexDigit(uri[i + 2]));
+			i += 2;
+		} else
+		{
+			text += uri[i];
+		}
+	}
+
+	return text;
+}
+
+static bool DecodeBase64(const char* text, size_t length, std::vector<char>& data)
+{
+	unsigned int bits;
+	int count, value;
+	size_t i;
+	char c;
+
+	data.clear();
+	data.reserve(length / 4 * 3);
+
+	bits = 0;
+	count = 0;
+	for(i = 0; i < length; i++)
+	{
+		c = text[i];
+		if(c >= 'A' && c <= 'Z') value = c - 'A';
+		else if(c >= 'a' && c <= 'z') value = c - 'a' + 26;
+		else if(c >= '0' && c <= '9') value = c - '0' + 52;
+		else if(c == '+' || c == '-') value = 62;
+		else if(c == '/' || c == '_') value = 63;
+		else if(c == '=') break;
+		else return false;
+
+		bits = (bits << 6) | (unsigned int)value;
+		count += 6;
+		if(count >= 8)
+		{
+			count -= 8;
+			data.push_back((char)((bits >> count) & 0xFF));
+		}
+	}
+
+	return true;
+}
+
+static std::string GetDirectory(const char* filename)
+{
+	const char* slash;
+	const char* backslash;
+
+	slash = strrchr(filename, '/');
+	backslash = strrchr(filename, '\\');
+	slash = backslash > slash ? backslash : slash;
+
+	return slash ? std::string(filename, slash + 1) : std::string();
+}
+
+// splits a .glb into its json and binary chunks, a .gltf is all json.
+static bool GetGltfChunks(const std::vector<char>& file, bool binary, const char*& json, size_t& jsonSize, GltfBufferType& bin)
+{
+	unsigned int header[3], chunk[2];
+	size_t offset;
+
+	bin.data = nullptr;
+	bin.size = 0;
+
+	if(!binary)
+	{
+		json = file.data();
+		jsonSize = file.size();
+		return true;
+	}
+
+	if(file.size() < sizeof(header) + sizeof(chunk))
+	{
+		return false;
+	}
+
+	memcpy(header, file.data(), sizeof(header));
+	if(header[0] != GLB_MAGIC || header[1] != 2 || header[2] > file.size())
+	{
+		return false;
+	}
+
+	json = nullptr;
+	offset = sizeof(header);
+	while(offset + sizeof(chunk) <= header[2])
+	{
+		memcpy(chunk, file.data() + offset, sizeof(chunk));
+		offset += sizeof(chunk);
+		if(chunk[0] > header[2] - offset)
+		{
+			return false;
+		}
+
+		if(chunk[1] == GLB_CHUNK_JSON && !json)
+		{
+			json = file.data() + offset;
+			jsonSize = chunk[0];
+		} else if(chunk[1] == GLB_CHUNK_BIN && !bin.data)
+		{
+			bin.data = (const unsigned char*)file.data() + offset;
+			bin.size = chunk[0];
+		}
+
+		offset += (chunk[0] + 3) & ~3u;
+	}
+
+	return json != nullptr;
+}
+
+static bool GetAccessor(const JsonType& root, const std::vector<GltfBufferType>& buffers, double index, GltfAccessorType& accessor)
+{
+	const JsonType* accessors;
+	const JsonType* source;
+	const JsonType* views;
+	const JsonType* view;
+	const JsonType* type;
+	const JsonType* normalized;
+	double bufferIndex;
+	size_t offset, length, elementSize, componentSize;
+
+	accessors = root.Get("accessors");
+	source = accessors ? accessors->At(index) : nullptr;
+	views = root.Get("bufferViews");
+	view = source && views ? views->At(source->GetNumber("bufferView", -1.0)) : nullptr;
+
+	// sparse accessors and accessors without a view are not supported.
+	if(!view || source->Get("sparse"))
+	{
+		return false;
+	}
+
+	bufferIndex = view->GetNumber("buffer", -1.0);
+	if(bufferIndex < 0.0 || bufferIndex >= (double)buffers.size())
+	{
+		return false;
+	}
+
+	type = source->Get("type");
+	if(!type || type->kind != JSON_STRING)
+	{
+		return false;
+	}
+
+	if(type->text == "SCALAR") accessor.componentCount = 1;
+	else if(type->text == "VEC2") accessor.componentCount = 2;
+	else if(type->text == "VEC3") accessor.componentCount = 3;
+	else if(type->text == "VEC4") accessor.componentCount = 4;
+	else return false;
+
+	accessor.componentType = (int)source->GetNumber("componentType", 0.0);
+	switch(accessor.componentType)
+	{
+		case GLTF_BYTE:
+		case GLTF_UNSIGNED_BYTE: componentSize = 1; break;
+		case GLTF_SHORT:
+		case GLTF_UNSIGNED_SHORT: componentSize = 2; break;
+		case GLTF_UNSIGNED_INT:
+		case GLTF_FLOAT: componentSize = 4; break;
+		default: return false;
+	}
+
+	normalized = source->Get("normalized");
+	accessor.normalized = normalized && normalized->kind == JSON_BOOL && normalized->number != 0.0;
+
+	elementSize = componentSize * (size_t)accessor.componentCount;
+	accessor.count = (size_t)source->GetNumber("count", 0.0);
+	accessor.stride = (size_t)view->GetNumber("byteStride", 0.0);
+	accessor.stride = accessor.stride ? accessor.stride : elementSize;
+
+	offset = (size_t)view->GetNumber("byteOffset", 0.0);
+	length = (size_t)view->GetNumber("byteLength", 0.0);
+	if(offset > buffers[(size_t)bufferIndex].size || length > buffers[(size_t)bufferIndex].size - offset)
+	{
+		return false;
+	}
+
+	// everything the accessor reads has to lie inside its view.
+	accessor.data = buffers[(size_t)bufferIndex].data + offset;
+	offset = (size_t)source->GetNumber("byteOffset", 0.0);
+	if(accessor.count > 0 && (accessor.stride < elementSize || offset > length || (accessor.count - 1) > (length - offset - elementSize) / accessor.stride ||
+		length - offset < elementSize))
+	{
+		return false;
+	}
+
+	accessor.data += offset;
+
+	return true;
+}
+
+static float ReadComponent(const unsigned char* data, int componentType, bool normalized)
+{
+	float f;
+	unsigned int u;
+	unsigned short us;
+	short s;
+	signed char b;
+
+	switch(componentType)
+	{
+		case GLTF_FLOAT:
+			memcpy(&f, data, 4);
+			return f;
+		case GLTF_UNSIGNED_BYTE:
+			return normalized ? data[0] / 255.0f : (float)data[0];
+		case GLTF_BYTE:
+			memcpy(&b, data, 1);
+			return normalized ? (b / 127.0f < -1.0f ? -1.0f : b / 127.0f) : (float)b;
+		case GLTF_UNSIGNED_SHORT:
+			memcpy(&us, data, 2);
+			return normalized ? us / 65535.0f : (float)us;
+		case GLTF_SHORT:
+			memcpy(&s, data, 2);
+			return normalized ? (s / 32767.0f < -1.0f ? -1.0f : s / 32767.0f) : (float)s;
+		case GLTF_UNSIGNED_INT:
+			memcpy(&u, data, 4);
+			return (float)u;
+	}
+
+	return 0.0f;
+}
+
+static bool DecodePrimitive(const JsonType& root, const std::vector<GltfBufferType>& buffers, GltfPrimitiveType& output)
+{
+	const JsonType* attributes;
+	const JsonType* color;
+	const JsonType* indices;
+	GltfAccessorType positions, colors, indexAccessor;
+	const unsigned char* element;
+	unsigned int index;
+	unsigned short shortIndex;
+	size_t i, componentSize;
+
+	attributes = output.primitive->Get("attributes");
+	if(!attributes || !attributes->Get("POSITION"))
+	{
+		return false;
+	}
+
+	if(!GetAccessor(root, buffers, attributes->Get("POSITION")->number, positions) || positions.componentCount != 3 || positions.componentType != GLTF_FLOAT)
+	{
+		return false;
+	}
+
+	// vertex colors are optional and can be rgb or rgba, float or normalized integers.
+	color = attributes->Get("COLOR_0");
+	if(color)
+	{
+		if(!GetAccessor(root, buffers, color->number, colors) || colors.count != positions.count || colors.componentCount < 3)
+		{
+			return false;
+		}
+		colors.normalized = colors.normalized || colors.componentType != GLTF_FLOAT;
+	}
+
+	output.vertices.resize(positions.count);
+	for(i = 0; i < positions.count; i++)
+	{
+		memcpy(&output.vertices[i].position, positions.data + i * positions.stride, sizeof(XMFLOAT3));
+		output.vertices[i].color = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+
+		if(color)
+		{
+			element = colors.data + i * colors.stride;
+			componentSize = colors.componentType == GLTF_FLOAT ? 4 : (colors.componentType == GLTF_UNSIGNED_SHORT ? 2 : 1);
+			output.vertices[i].color.x = ReadComponent(element, colors.componentType, colors.normalized);
+			output.vertices[i].color.y = ReadComponent(element + componentSize, colors.componentType, colors.normalized);
+			output.vertices[i].color.z = ReadComponent(element + componentSize * 2, colors.componentType, colors.normalized);
+			if(colors.componentCount == 4)
+			{
+				output.vertices[i].color.w = ReadComponent(element + componentSize * 3, colors.componentType, colors.normalized);
+			}
+		}
+	}
+
+	// without indices every three vertices make a triangle.
+	indices = output.primitive->Get("indices");
+	if(!indices)
+	{
+		output.indices.resize(positions.count / 3 * 3);
+		for(i = 0; i < output.indices.size(); i++)
+		{
+			output.indices[i] = (unsigned int)i;
+		}
+		return true;
+	}
+
+	if(!GetAccessor(root, buffers, indices->number, indexAccessor) || indexAccessor.componentCount != 1)
+	{
+		return false;
+	}
+
+	output.indices.resize(indexAccessor.count / 3 * 3);
+	for(i = 0; i < output.indices.size(); i++)
+	{
+		element = indexAccessor.data + i * indexAccessor.stride;
+		switch(indexAccessor.componentType)
+		{
+			case GLTF_UNSIGNED_BYTE:
+				index = element[0];
+				break;
+			case GLTF_UNSIGNED_SHORT:
+				memcpy(&shortIndex, element, 2);
+				index = shortIndex;
+				break;
+			case GLTF_UNSIGNED_INT:
+				memcpy(&index, element, 4);
+				break;
+			default:
+				return false;
+		}
+
+		if(index >= positions.count)
+		{
+			return false;
+		}
+		output.indices[i] = index;
+	}
+
+	return true;
+}
+
+MeshImporterClass::MeshImporterClass()
+{
+	m_JobSystem = nullptr;
+	memset(&m_statistics, 0, sizeof(m_statistics));
+}
+
+MeshImporterClass::MeshImporterClass(const MeshImporterClass&)
+{
+}
+
+MeshImporterClass::~MeshImporterClass()
+{
+}
+
+bool MeshImporterClass::Initialize(JobSystemClass* jobSystem)
+{
+	m_JobSystem = jobSystem;
+
+	return true;
+}
+
+void MeshImporterClass::Shutdown()
+{
+	m_JobSystem = nullptr;
+
+	return;
+}
+
+bool MeshImporterClass::IsSupported(const char* filename)
+{
+	return filename && (HasExtension(filename, ".obj") || HasExtension(filename, ".gltf") || HasExtension(filename, ".glb"));
+}
+
+bool MeshImporterClass::Cook(const char* filename, std::string& cookedFilename)
+{
+	std::chrono::steady_clock::time_point start;
+	std::vector<std::vector<char> > files;
+	std::vector<VertexType> vertices;
+	std::vector<unsigned int> indices;
+	unsigned long long hash;
+	char suffix[32];
+	bool result;
+
+	start = std::chrono::steady_clock::now();
+	memset(&m_statistics, 0, sizeof(m_statistics));
+
+	result = ReadSource(filename, files, hash);
+	if(!result)
+	{
+		return false;
+	}
+
+	snprintf(suffix, sizeof(suffix), ".%016llx.mesh", hash);
+	cookedFilename = filename;
+	cookedFilename += suffix;
+
+	// a cooked file that was cut short or is otherwise damaged fails to open and simply gets cooked again.
+	result = OpenCooked(cookedFilename.c_str());
+	if(result)
+	{
+		m_statistics.cacheHit = true;
+		m_statistics.totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return true;
+	}
+
+	result = Parse(filename, files, vertices, indices);
+	if(!result)
+	{
+		return false;
+	}
+
+	// the source is not needed any more, no point holding on to it while optimizing.
+	files.clear();
+	files.shrink_to_fit();
+
+	result = Optimize(vertices, indices);
+	if(!result)
+	{
+		return false;
+	}
+
+	// the name is the content, so when the save fails because another loader cooked the same source and has it mapped, that copy is just as good.
+	result = MeshFileClass::Save(cookedFilename.c_str(), vertices.data(), sizeof(VertexType), (unsigned int)vertices.size(),
+		indices.data(), sizeof(unsigned int), (unsigned int)indices.size(), VERTEX_FORMAT_FLOAT, MESH_FILE_FLAG_OPTIMIZED);
+	if(!result)
+	{
+		result = OpenCooked(cookedFilename.c_str());
+		if(!result)
+		{
+			return false;
+		}
+	}
+
+	m_statistics.totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return true;
+}
+
+bool MeshImporterClass::OpenCooked(const char* cookedFilename)
+{
+	const MeshFileClass::HeaderType* header;
+	MeshFileClass* meshFile;
+	bool result;
+
+	meshFile = new MeshFileClass;
+	if(!meshFile)
+	{
+		return false;
+	}
+
+	result = meshFile->Open(cookedFilename);
+	if(result)
+	{
+		header = meshFile->GetHeader();
+		result = header->vertexFormat == VERTEX_FORMAT_FLOAT && header->vertexStride == sizeof(VertexType) && header->indexStride == sizeof(unsigned int) &&
+			(header->flags & MESH_FILE_FLAG_OPTIMIZED);
+		m_statistics.vertices = header->vertexCount;
+		m_statistics.indices = header->indexCount;
+		meshFile->Close();
+	}
+	delete meshFile;
+
+	return result;
+}
+
+bool MeshImporterClass::Import(const char* filename, std::vector<VertexType>& vertices, std::vector<unsigned int>& indices)
+{
+	std::chrono::steady_clock::time_point start;
+	std::vector<std::vector<char> > files;
+	unsigned long long hash;
+	bool result;
+
+	start = std::chrono::steady_clock::now();
+	memset(&m_statistics, 0, sizeof(m_statistics));
+
+	result = ReadSource(filename, files, hash);
+	if(!result)
+	{
+		return false;
+	}
+
+	result = Parse(filename, files, vertices, indices);
+	if(!result)
+	{
+		return false;
+	}
+
+	m_statistics.totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return true;
+}
+
+bool MeshImporterClass::Optimize(std::vector<VertexType>& vertices, std::vector<unsigned int>& indices)
+{
+	MeshOptimizerClass* optimizer;
+	MeshOptimizerClass::StatisticsType before, after;
+	bool result;
+
+	optimizer = new MeshOptimizerClass;
+	if(!optimizer)
+	{
+		return false;
+	}
+
+	result = optimizer->Optimize(vertices.data(), sizeof(VertexType), (unsigned int)vertices.size(), indices.data(), (unsigned int)indices.size());
+	if(result)
+	{
+		optimizer->GetStatistics(before, after);
+		m_statistics.acmrBefore = before.acmr;
+		m_statistics.acmrAfter = after.acmr;
+		m_statistics.atvrBefore = before.atvr;
+		m_statistics.atvrAfter = after.atvr;
+	}
+
+	delete optimizer;
+
+	return result;
+}
+
+void MeshImporterClass::GetStatistics(StatisticsType& statistics)
+{
+	statistics = m_statistics;
+	return;
+}
+
+bool MeshImporterClass::ReadSource(const char* filename, std::vector<std::vector<char> >& files, unsigned long long& hash)
+{
+	const char* json;
+	size_t jsonSize, i;
+	GltfBufferType bin;
+	JsonType root;
+	const JsonType* buffers;
+	const JsonType* uri;
+	std::string directory;
+	bool result;
+
+	if(!IsSupported(filename))
+	{
+		return false;
+	}
+
+	files.resize(1);
+	result = ReadFile(filename, files[0]);
+	if(!result)
+	{
+		return false;
+	}
+
+	/*
+	 * a .gltf usually keeps its binary data in separate files, those are part of the content too.
+	 * they are read here in the order the buffers list them, ParseGltf picks them up in the same order.
+	 */
+	if(HasExtension(filename, ".gltf"))
+	{
+		result = GetGltfChunks(files[0], false, json, jsonSize, bin) && ParseJson(json, json + jsonSize, root, 0);
+		if(!result)
+		{
+			return false;
+		}
+
+		directory = GetDirectory(filename);
+		buffers = root.Get("buffers");
+		for(i = 0; buffers && buffers->kind == JSON_ARRAY && i < buffers->items.size(); i++)
+		{
+			uri = buffers->items[i].Get("uri");
+			if(!uri || uri->kind != JSON_STRING || uri->text.compare(0, 5, "data:") == 0)
+			{
+				continue;
+			}
+
+			files.push_back(std::vector<char>());
+			result = ReadFile((directory + DecodeUri(uri->text)).c_str(), files.back());
+			if(!result)
+			{
+				return false;
+			}
+		}
+	}
+
+	hash = HashBytes((const char*)&MESH_IMPORTER_VERSION, sizeof(MESH_IMPORTER_VERSION), 0);
+	for(i = 0; i < files.size(); i++)
+	{
+		hash = HashBytes(files[i].data(), files[i].size(), hash);
+		m_statistics.sourceBytes += files[i].size();
+	}
+
+	return true;
+}
+
+bool MeshImporterClass::Parse(const char* filename, std::vector<std::vector<char> >& files, std::vector<VertexType>& vertices, std::vector<unsigned int>& indices)
+{
+	std::chrono::steady_clock::time_point start;
+	bool result;
+
+	start = std::chrono::steady_clock::now();
+
+	if(HasExtension(filename, ".obj"))
+	{
+		result = ParseObj(files[0], vertices, indices);
+	} else
+	{
+		result = ParseGltf(filename, files, vertices, indices);
+	}
+	if(!result || vertices.empty() || indices.empty())
+	{
+		return false;
+	}
+
+	m_statistics.sourceVertices = (unsigned int)vertices.size();
+
+	Weld(vertices, indices);
+
+	m_statistics.vertices = (unsigned int)vertices.size();
+	m_statistics.indices = (unsigned int)indices.size();
+	m_statistics.parseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	m_statistics.megabytesPerSecond = m_statistics.parseSeconds > 0.0 ? m_statistics.sourceBytes / 1000000.0 / m_statistics.parseSeconds : 0.0;
+
+	return !indices.empty();
+}
+
+bool MeshImporterClass::ParseObj(const std::vector<char>& text, std::vector<VertexType>& vertices, std::vector<unsigned int>& indices)
+{
+	std::vector<ObjChunkType> chunks;
+	const char* data;
+	const char* end;
+	const char* p;
+	size_t chunkCount, threadCount, i, vertexTotal, indexTotal;
+	unsigned int positionTotal;
+	bool result;
+
+	data = text.data();
+	end = data + text.size();
+
+	// a few chunks per thread so one dense chunk does not leave the others idle.
+	threadCount = m_JobSystem ? (size_t)m_JobSystem->GetThreadCount() : 1;
+	chunkCount = text.size() / OBJ_MIN_CHUNK_SIZE;
+	chunkCount = chunkCount > threadCount * 4 ? threadCount * 4 : chunkCount;
+	chunkCount = chunkCount < 1 ? 1 : chunkCount;
+
+	// every chunk starts right after a line break, lines never straddle two chunks.
+	chunks.resize(chunkCount);
+	for(i = 0; i < chunkCount; i++)
+	{
+		p = data + text.size() / chunkCount * i;
+		if(i > 0)
+		{
+			p = (const char*)memchr(p, '\n', (size_t)(end - p));
+			p = p ? p + 1 : end;
+		}
+		chunks[i].begin = i > 0 && p < chunks[i - 1].begin ? chunks[i - 1].begin : p;
+		chunks[i].valid = true;
+		chunks[i].positionCount = 0;
+		if(i > 0)
+		{
+			chunks[i - 1].end = chunks[i].begin;
+		}
+	}
+	chunks[chunkCount - 1].end = end;
+
+	/*
+	 * relative face indices need to know how many positions came before, so the chunks first only count their 'v' lines.
+	 * a running sum over the counts gives every chunk its first global position.
+	 */
+	RunParallel(m_JobSystem, (int)chunkCount, [&](int index)
+	{
+		ObjChunkType& chunk = chunks[index];
+		const char* line;
+		const char* lineEnd;
+
+		for(line = chunk.begin; line < chunk.end; line = lineEnd + 1)
+		{
+			lineEnd = (const char*)memchr(line, '\n', (size_t)(chunk.end - line));
+			lineEnd = lineEnd ? lineEnd : chunk.end;
+
+			SkipSpaces(line, lineEnd);
+			if(lineEnd - line >= 2 && line[0] == 'v' && (line[1] == ' ' || line[1] == '\t'))
+			{
+				chunk.positionCount++;
+			}
+		}
+	});
+
+	positionTotal = 0;
+	for(i = 0; i < chunkCount; i++)
+	{
+		chunks[i].positionBase = positionTotal;
+		positionTotal += chunks[i].positionCount;
+	}
+
+	RunParallel(m_JobSystem, (int)chunkCount, [&](int index)
+	{
+		ObjChunkType& chunk = chunks[index];
+		const char* line;
+		const char* lineEnd;
+		float values[7];
+		long long value, first, previous, current;
+		int valueCount, cornerCount;
+		VertexType vertex;
+
+		chunk.vertices.reserve(chunk.positionCount);
+
+		for(line = chunk.begin; line < chunk.end && chunk.valid; line = lineEnd + 1)
+		{
+			lineEnd = (const char*)memchr(line, '\n', (size_t)(chunk.end - line));
+			lineEnd = lineEnd ? lineEnd : chunk.end;
+
+			SkipSpaces(line, lineEnd);
+			if(lineEnd - line < 2 || (line[1] != ' ' && line[1] != '\t'))
+			{
+				continue;
+			}
+
+			// "v x y z" with an optional w or the common "v x y z r g b" vertex color extension.
+			if(line[0] == 'v')
+			{
+				line += 2;
+				for(valueCount = 0; valueCount < 7 && ParseFloat(line, lineEnd, values[valueCount]); valueCount++)
+				{
+				}
+				if(valueCount < 3)
+				{
+					chunk.valid = false;
+					break;
+				}
+
+				vertex.position = XMFLOAT3(values[0], values[1], values[2]);
+				vertex.color = valueCount >= 6 ? XMFLOAT4(values[3], values[4], values[5], 1.0f) : XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+				chunk.vertices.push_back(vertex);
+			}
+
+			// "f v/vt/vn ...", only the position index matters. polygons become a fan of triangles.
+			if(line[0] == 'f')
+			{
+				line += 2;
+				first = previous = 0;
+				for(cornerCount = 0; ; cornerCount++)
+				{
+					SkipSpaces(line, lineEnd);
+					if(!ParseInteger(line, lineEnd, value))
+					{
+						break;
+					}
+					while(line < lineEnd && *line != ' ' && *line != '\t' && *line != '\r')
+					{
+						line++;
+					}
+
+					// 1 based, negative ones count back from the last position so far.
+					current = value > 0 ? value - 1 : (long long)chunk.positionBase + (long long)chunk.vertices.size() + value;
+					if(value == 0 || current < 0 || current >= (long long)positionTotal)
+					{
+						chunk.valid = false;
+						break;
+					}
+
+					if(cornerCount == 0)
+					{
+						first = current;
+					} else if(cornerCount >= 2)
+					{
+						chunk.indices.push_back((unsigned int)first);
+						chunk.indices.push_back((unsigned int)previous);
+						chunk.indices.push_back((unsigned int)current);
+					}
+					previous = current;
+				}
+			}
+		}
+	});
+
+	vertexTotal = 0;
+	indexTotal = 0;
+	result = true;
+	for(i = 0; i < chunkCount; i++)
+	{
+		result = result && chunks[i].valid;
+		vertexTotal += chunks[i].vertices.size();
+		indexTotal += chunks[i].indices.size();
+	}
+	if(!result)
+	{
+		return false;
+	}
+
+	vertices.clear();
+	indices.clear();
+	vertices.reserve(vertexTotal);
+	indices.reserve(indexTotal);
+	for(i = 0; i < chunkCount; i++)
+	{
+		vertices.insert(vertices.end(), chunks[i].vertices.begin(), chunks[i].vertices.end());
+		indices.insert(indices.end(), chunks[i].indices.begin(), chunks[i].indices.end());
+	}
+
+	return true;
+}
+
+bool MeshImporterClass::ParseGltf(const char* filename, std::vector<std::vector<char> >& files, std::vector<VertexType>& vertices, std::vector<unsigned int>& indices)
+{
+	std::vector<GltfPrimitiveType> primitives;
+	std::vector<GltfBufferType> buffers;
+	std::vector<std::vector<char> > embedded;
+	GltfBufferType buffer, bin;
+	const JsonType* meshes;
+	const JsonType* list;
+	const JsonType* uri;
+	const JsonType* mode;
+	const char* json;
+	size_t jsonSize, i, j, externalFile, vertexTotal, indexTotal, comma;
+	unsigned int base;
+	JsonType root;
+	bool result;
+
+	result = GetGltfChunks(files[0], HasExtension(filename, ".glb"), json, jsonSize, bin);
+	result = result && ParseJson(json, json + jsonSize, root, 0);
+	if(!result)
+	{
+		return false;
+	}
+
+	// buffers are the glb binary chunk, a base64 data uri or one of the external files ReadSource loaded, in that order.
+	list = root.Get("buffers");
+	externalFile = 1;
+	for(i = 0; list && list->kind == JSON_ARRAY && i < list->items.size(); i++)
+	{
+		uri = list->items[i].Get("uri");
+		if(!uri || uri->kind != JSON_STRING)
+		{
+			buffer = bin;
+		} else if(uri->text.compare(0, 5, "data:") == 0)
+		{
+			comma = uri->text.find(',');
+			embedded.push_back(std::vector<char>());
+			if(comma == std::string::npos || !DecodeBase64(uri->text.c_str() + comma + 1, uri->text.size() - comma - 1, embedded.back()))
+			{
+				return false;
+			}
+			buffer.data = (const unsigned char*)embedded.back().data();
+			buffer.size = embedded.back().size();
+		} else
+		{
+			if(externalFile >= files.size())
+			{
+				return false;
+			}
+			buffer.data = (const unsigned char*)files[externalFile].data();
+			buffer.size = files[externalFile].size();
+			externalFile++;
+		}
+
+		buffers.push_back(buffer);
+	}
+
+	/*
+	 * every triangle primitive of every mesh, in mesh space. node transforms, materials and other attributes are not imported.
+	 * embedded only grows above, so the pointers into it stay valid while the primitives decode in parallel.
+	 */
+	meshes = root.Get("meshes");
+	for(i = 0; meshes && meshes->kind == JSON_ARRAY && i < meshes->items.size(); i++)
+	{
+		list = meshes->items[i].Get("primitives");
+		for(j = 0; list && list->kind == JSON_ARRAY && j < list->items.size(); j++)
+		{
+			mode = list->items[j].Get("mode");
+			if(mode && mode->number != GLTF_TRIANGLES)
+			{
+				continue;
+			}
+
+			primitives.push_back(GltfPrimitiveType());
+			primitives.back().primitive = &list->items[j];
+			primitives.back().valid = false;
+		}
+	}
+
+	RunParallel(m_JobSystem, (int)primitives.size(), [&](int index)
+	{
+		primitives[index].valid = DecodePrimitive(root, buffers, primitives[index]);
+	});
+
+	vertexTotal = 0;
+	indexTotal = 0;
+	for(i = 0; i < primitives.size(); i++)
+	{
+		if(!primitives[i].valid)
+		{
+			return false;
+		}
+		vertexTotal += primitives[i].vertices.size();
+		indexTotal += primitives[i].indices.size();
+	}
+
+	if(vertexTotal > 0xFFFFFFFFULL)
+	{
+		return false;
+	}
+
+	vertices.clear();
+	indices.clear();
+	vertices.reserve(vertexTotal);
+	indices.reserve(indexTotal);
+	for(i = 0; i < primitives.size(); i++)
+	{
+		base = (unsigned int)vertices.size();
+		vertices.insert(vertices.end(), primitives[i].vertices.begin(), primitives[i].vertices.end());
+		for(j = 0; j < primitives[i].indices.size(); j++)
+		{
+			indices.push_back(primitives[i].indices[j] + base);
+		}
+	}
+
+	return true;
+}
+
+void MeshImporterClass::Weld(std::vector<VertexType>& vertices, std::vector<unsigned int>& indices)
+{
+	const unsigned int empty = 0xFFFFFFFF;
+	std::vector<unsigned int> table, remap;
+	VertexType vertex;
+	unsigned int words[7], mask, slot, unique, hash, i, k;
+	size_t tableSize, count;
+	float* components;
+
+	/*
+	 * open addressing table at most half full, keyed by the vertex bytes.
+	 * unique vertices are compacted to the front as they are found, so the output keeps the order of first use.
+	 */
+	tableSize = 16;
+	while(tableSize < vertices.size() * 2)
+	{
+		tableSize *= 2;
+	}
+
+	table.assign(tableSize, empty);
+	remap.resize(vertices.size());
+	mask = (unsigned int)tableSize - 1;
+	unique = 0;
+
+	for(i = 0; i < (unsigned int)vertices.size(); i++)
+	{
+		vertex = vertices[i];
+
+		// -0 and +0 are the same vertex.
+		components = &vertex.position.x;
+		for(k = 0; k < 7; k++)
+		{
+			components[k] = components[k] == 0.0f ? 0.0f : components[k];
+		}
+
+		memcpy(words, &vertex, sizeof(words));
+		hash = 2166136261u;
+		for(k = 0; k < 7; k++)
+		{
+			hash = (hash ^ words[k]) * 16777619u;
+		}
+		hash ^= hash >> 15;
+
+		for(slot = hash & mask; table[slot] != empty; slot = (slot + 1) & mask)
+		{
+			if(memcmp(&vertices[table[slot]], &vertex, sizeof(VertexType)) == 0)
+			{
+				break;
+			}
+		}
+
+		if(table[slot] == empty)
+		{
+			vertices[unique] = vertex;
+			table[slot] = unique++;
+		}
+		remap[i] = table[slot];
+	}
+
+	vertices.resize(unique);
+
+	// triangles that welding collapsed to a line or a point are dropped.
+	count = 0;
+	for(i = 0; i + 2 < (unsigned int)indices.size(); i += 3)
+	{
+		words[0] = remap[indices[i]];
+		words[1] = remap[indices[i + 1]];
+		words[2] = remap[indices[i + 2]];
+		if(words[0] == words[1] || words[1] == words[2] || words[0] == words[2])
+		{
+			continue;
+		}
+
+		indices[count++] = words[0];
+		indices[count++] = words[1];
+		indices[count++] = words[2];
+	}
+
+	indices.resize(count);
+
+	return;
+}
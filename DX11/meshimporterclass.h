@@ -0,0 +1,83 @@
+#pragma once
+#ifndef _MESHIMPORTERCLASS_H_
+#define _MESHIMPORTERCLASS_H_
+
+#include <DirectXMath.h>
+#include <string>
+#include <vector>
+using namespace DirectX;
+
+class JobSystemClass;
+
+// bumped whenever the cooked output would change, it is part of the cache key.
+const unsigned int MESH_IMPORTER_VERSION = 1;
+
+/*
+ * turns wavefront obj and gltf 2.0 (.gltf with external or embedded buffers, .glb) into mesh files.
+ * obj text is split into chunks at line breaks and parsed on the job system, floats go through a parser that reads eight digits at a time.
+ * gltf json is small and parsed on one thread, the primitives' accessors are decoded in parallel.
+ * only positions and vertex colors are kept, so vertices that differ in anything else are welded together through a hash map.
+ * the cooked mesh file is optimized and named after a hash of the source bytes, importing the same content again just maps the cooked file.
+ */
+class MeshImporterClass
+{
+public:
+	// same layout as ModelClass::VertexType.
+	struct VertexType
+	{
+		XMFLOAT3 position;
+		XMFLOAT4 color;
+	};
+
+	struct StatisticsType
+	{
+		unsigned long long sourceBytes;
+		unsigned int sourceVertices;
+		unsigned int vertices;
+		unsigned int indices;
+		double parseSeconds;
+		double totalSeconds;
+		// source bytes over parse time.
+		double megabytesPerSecond;
+		// the vertex cache miss ratios, see MeshOptimizerClass, before and after optimizing. all 0 when nothing was optimized.
+		float acmrBefore;
+		float acmrAfter;
+		float atvrBefore;
+		float atvrAfter;
+		bool cacheHit;
+	};
+
+public:
+	MeshImporterClass();
+	MeshImporterClass(const MeshImporterClass&);
+	~MeshImporterClass();
+
+	// the parsing is spread over jobSystem's threads, without one it all runs on the calling thread.
+	bool Initialize(JobSystemClass* jobSystem);
+	void Shutdown();
+
+	static bool IsSupported(const char* filename);
+
+	// imports the file unless a cooked copy of the same content exists, either way cookedFilename names the mesh file to load.
+	bool Cook(const char* filename, std::string& cookedFilename);
+	// parses and welds without touching the cache.
+	bool Import(const char* filename, std::vector<VertexType>& vertices, std::vector<unsigned int>& indices);
+	// what Cook does to a mesh before saving it, for one that came from Import.
+	bool Optimize(std::vector<VertexType>& vertices, std::vector<unsigned int>& indices);
+
+	void GetStatistics(StatisticsType& statistics);
+
+private:
+	bool OpenCooked(const char* cookedFilename);
+	bool ReadSource(const char* filename, std::vector<std::vector<char> >& files, unsigned long long& hash);
+	bool Parse(const char* filename, std::vector<std::vector<char> >& files, std::vector<VertexType>& vertices, std::vector<unsigned int>& indices);
+	bool ParseObj(const std::vector<char>& text, std::vector<VertexType>& vertices, std::vector<unsigned int>& indices);
+	bool ParseGltf(const char* filename, std::vector<std::vector<char> >& files, std::vector<VertexType>& vertices, std::vector<unsigned int>& indices);
+	void Weld(std::vector<VertexType>& vertices, std::vector<unsigned int>& indices);
+
+private:
+	JobSystemClass* m_JobSystem;
+	StatisticsType m_statistics;
+};
+
+#endif
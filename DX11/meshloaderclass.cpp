@@ -0,0 +1,443 @@
+#include "meshloaderclass.h"
+
+MeshLoaderClass::MeshLoaderClass()
+{
+	m_Geometry = nullptr;
+	m_JobSystem = nullptr;
+	m_vertexFormat = VERTEX_FORMAT_FLOAT;
+	m_sequence = 0;
+	m_running.store(false);
+	m_loading.store(0);
+	m_residentCount = 0;
+	m_failedCount = 0;
+	m_cancelledCount.store(0);
+	m_timedCount = 0;
+	m_totalTimeToResident = 0.0;
+	m_maxTimeToResident = 0.0;
+}
+
+MeshLoaderClass::MeshLoaderClass(const MeshLoaderClass&)
+{
+}
+
+MeshLoaderClass::~MeshLoaderClass()
+{
+}
+
+bool MeshLoaderClass::Initialize(GeometryArenaClass* geometry, JobSystemClass* jobSystem, unsigned int vertexFormat, int threadCount, int uploadQueueSize)
+{
+	bool result;
+	int i;
+
+	m_Geometry = geometry;
+	m_JobSystem = jobSystem;
+	m_vertexFormat = vertexFormat;
+
+	result = m_models.Initialize(MESH_LOADER_MAX_MODELS, MEMORY_TAG_LOADER);
+	if(!result)
+	{
+		return false;
+	}
+
+	result = m_resident.Initialize(MESH_LOADER_MAX_MODELS, MEMORY_TAG_LOADER, DestroyModel, this);
+	if(!result)
+	{
+		return false;
+	}
+
+	result = m_uploads.Initialize((size_t)uploadQueueSize);
+	if(!result)
+	{
+		return false;
+	}
+
+	// loading is mostly waiting on the disk, leave the render thread its core.
+	if(threadCount <= 0)
+	{
+		threadCount = (int)std::thread::hardware_concurrency() - 1;
+		threadCount = threadCount < 1 ? 1 : threadCount;
+	}
+
+	m_running.store(true);
+	for(i = 0; i < threadCount; i++)
+	{
+		m_workers.push_back(std::thread(&MeshLoaderClass::WorkerThread, this));
+	}
+
+	return true;
+}
+
+void MeshLoaderClass::Shutdown()
+{
+	RequestType* request;
+	unsigned int i;
+
+	{
+		std::lock_guard<std::mutex> lock(m_pendingMutex);
+		m_running.store(false);
+	}
+	m_pendingCondition.notify_all();
+
+	// and the ones waiting for room in the upload queue.
+	{
+		std::lock_guard<std::mutex> lock(m_uploadMutex);
+	}
+	m_uploadCondition.notify_all();
+
+	for(i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+	m_workers.clear();
+
+	// whatever is still waiting for an upload is released along with everything else below.
+	while(m_uploads.Pop(request))
+	{
+	}
+	m_uploads.Shutdown();
+
+	while(!m_pending.empty())
+	{
+		m_pending.pop();
+	}
+	m_skipped.clear();
+
+	for(i = 0; i < m_requests.size(); i++)
+	{
+		ReleaseModel(m_requests[i]);
+		delete m_requests[i];
+	}
+	m_requests.clear();
+	m_freeRequests.clear();
+
+	// the cancelled models still waiting for the gpu are unloaded here too, before their pool goes.
+	m_resident.Shutdown();
+	m_models.Shutdown();
+
+	m_Geometry = nullptr;
+
+	return;
+}
+
+int MeshLoaderClass::Load(const char* filename, int priority)
+{
+	RequestType* request;
+
+	// the slot of a request that is done with if there is one, a new one otherwise.
+	if(!m_freeRequests.empty())
+	{
+		request = m_requests[m_freeRequests.back()];
+		m_freeRequests.pop_back();
+	} else
+	{
+		if(m_requests.size() > HANDLE_INDEX_MASK)
+		{
+			return -1;
+		}
+
+		request = new RequestType;
+		if(!request)
+		{
+			return -1;
+		}
+
+		request->slot = (int)m_requests.size();
+		request->generation = 0;
+		m_requests.push_back(request);
+	}
+
+	request->filename = filename;
+	request->priority = priority;
+	request->sequence = m_sequence++;
+	request->state.store(MESH_LOAD_QUEUED);
+	request->cancelled.store(false);
+	request->model = nullptr;
+	request->handle = HANDLE_NULL;
+	request->startTime = std::chrono::steady_clock::now();
+
+	{
+		std::lock_guard<std::mutex> lock(m_pendingMutex);
+		m_pending.push(request);
+	}
+	m_pendingCondition.notify_one();
+
+	return (int)((request->generation << HANDLE_INDEX_BITS) | (unsigned int)request->slot);
+}
+
+void MeshLoaderClass::Cancel(int request)
+{
+	RequestType* cancelled;
+
+	cancelled = GetRequest(request);
+	if(!cancelled)
+	{
+		return;
+	}
+
+	/*
+	 * a queued request is skipped by the worker that picks it up and one in flight is dropped by Update.
+	 * a resident model is only used on the render thread, so its handle can be released right here.
+	 */
+	cancelled->cancelled.store(true);
+
+	if(cancelled->state.load() == MESH_LOAD_RESIDENT)
+	{
+		ReleaseModel(cancelled);
+		cancelled->state.store(MESH_LOAD_CANCELLED);
+		m_residentCount--;
+		m_cancelledCount++;
+		RecycleRequest(cancelled);
+	}
+
+	return;
+}
+
+MeshLoadState MeshLoaderClass::GetState(int request)
+{
+	RequestType* found;
+
+	found = GetRequest(request);
+	if(!found)
+	{
+		return MESH_LOAD_FAILED;
+	}
+
+	return (MeshLoadState)found->state.load();
+}
+
+ModelClass* MeshLoaderClass::GetModel(int request)
+{
+	ModelClass** model;
+
+	if(GetState(request) != MESH_LOAD_RESIDENT)
+	{
+		return nullptr;
+	}
+
+	model = m_resident.Get(GetRequest(request)->handle);
+	if(!model)
+	{
+		return nullptr;
+	}
+
+	return *model;
+}
+
+void MeshLoaderClass::Update(int maxUploads, unsigned long long completedFrame, unsigned long long retireFrame)
+{
+	RequestType* request;
+	double timeToResident;
+	bool result;
+	int i;
+
+	m_resident.Update(completedFrame, retireFrame);
+
+	// no worker looks at a request again once it has skipped it.
+	{
+		std::lock_guard<std::mutex> lock(m_pendingMutex);
+		for(i = 0; i < (int)m_skipped.size(); i++)
+		{
+			RecycleRequest(m_skipped[i]);
+		}
+		m_skipped.clear();
+	}
+
+	for(i = 0; i < maxUploads && m_uploads.Pop(request); i++)
+	{
+		if(request->cancelled.load())
+		{
+			ReleaseModel(request);
+			request->state.store(MESH_LOAD_CANCELLED);
+			m_cancelledCount++;
+			RecycleRequest(request);
+			continue;
+		}
+
+		result = request->model != nullptr;
+		if(result)
+		{
+			result = request->model->Upload(m_Geometry);
+		}
+		if(!result)
+		{
+			ReleaseModel(request);
+			request->state.store(MESH_LOAD_FAILED);
+			m_failedCount++;
+			RecycleRequest(request);
+			continue;
+		}
+
+		timeToResident = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - request->startTime).count();
+		m_totalTimeToResident += timeToResident;
+		m_timedCount++;
+		m_maxTimeToResident = timeToResident > m_maxTimeToResident ? timeToResident : m_maxTimeToResident;
+
+		// a full pool fails the request like a full model pool does, a handle is needed to hand the model out.
+		request->handle = m_resident.Create();
+		if(!request->handle)
+		{
+			ReleaseModel(request);
+			request->state.store(MESH_LOAD_FAILED);
+			m_failedCount++;
+			RecycleRequest(request);
+			continue;
+		}
+
+		*m_resident.Get(request->handle) = request->model;
+		request->model = nullptr;
+
+		request->state.store(MESH_LOAD_RESIDENT);
+		m_residentCount++;
+	}
+
+	// there is room in the upload queue now for the workers waiting on it.
+	if(i > 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_uploadMutex);
+		}
+		m_uploadCondition.notify_all();
+	}
+
+	return;
+}
+
+void MeshLoaderClass::GetMetrics(MetricsType& metrics)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_pendingMutex);
+		metrics.queued = (int)m_pending.size();
+	}
+
+	metrics.loading = m_loading.load();
+	metrics.waitingForUpload = (int)m_uploads.GetSize();
+	metrics.resident = m_residentCount;
+	metrics.failed = m_failedCount;
+	metrics.cancelled = m_cancelledCount.load();
+
+	// cancelling a resident model takes it out of the count but not out of the timings.
+	metrics.averageTimeToResident = m_timedCount > 0 ? (float)(m_totalTimeToResident / m_timedCount) : 0.0f;
+	metrics.maxTimeToResident = (float)m_maxTimeToResident;
+
+	return;
+}
+
+void MeshLoaderClass::WorkerThread()
+{
+	RequestType* request;
+	ModelClass* model;
+	bool result;
+
+	for(;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_pendingMutex);
+			m_pendingCondition.wait(lock, [this] { return !m_running.load() || !m_pending.empty(); });
+			if(!m_running.load())
+			{
+				return;
+			}
+
+			request = m_pending.top();
+			m_pending.pop();
+
+			// cancelled before it was started, Update recycles it.
+			if(request->cancelled.load())
+			{
+				request->state.store(MESH_LOAD_CANCELLED);
+				m_cancelledCount++;
+				m_skipped.push_back(request);
+				continue;
+			}
+		}
+
+		request->state.store(MESH_LOAD_LOADING);
+		m_loading++;
+
+		// the cpu half of ModelClass::Initialize, a failed load goes through the queue as a null model and so does one the pool has no room for.
+		model = m_models.Allocate();
+		if(model)
+		{
+			result = model->Load(request->filename.c_str(), m_vertexFormat, m_Geometry != nullptr, m_JobSystem);
+			if(!result)
+			{
+				model->Shutdown();
+				m_models.Free(model);
+				model = nullptr;
+			}
+		}
+
+		request->model = model;
+		request->state.store(MESH_LOAD_UPLOADING);
+		m_loading--;
+
+		// back pressure, sleep until the render thread makes room. the push is retried under the lock Update takes before waking
+		// anyone, so room made between a failed push and the wait is not missed.
+		if(!m_uploads.Push(request))
+		{
+			std::unique_lock<std::mutex> lock(m_uploadMutex);
+			m_uploadCondition.wait(lock, [this, request] { return !m_running.load() || m_uploads.Push(request); });
+			if(!m_running.load())
+			{
+				return;
+			}
+		}
+	}
+}
+
+MeshLoaderClass::RequestType* MeshLoaderClass::GetRequest(int request)
+{
+	unsigned int slot;
+
+	if(request < 0)
+	{
+		return nullptr;
+	}
+
+	slot = (unsigned int)request & HANDLE_INDEX_MASK;
+	if(slot >= m_requests.size() || m_requests[slot]->generation != (unsigned int)request >> HANDLE_INDEX_BITS)
+	{
+		return nullptr;
+	}
+
+	return m_requests[slot];
+}
+
+void MeshLoaderClass::RecycleRequest(RequestType* request)
+{
+	// the ids handed out for the slot so far name nothing from here on.
+	request->generation = (request->generation + 1) & MESH_LOADER_GENERATION_MASK;
+	m_freeRequests.push_back(request->slot);
+
+	return;
+}
+
+void MeshLoaderClass::ReleaseModel(RequestType* request)
+{
+	// a resident model is unloaded by the pool, once the gpu is done with it.
+	if(request->handle)
+	{
+		m_resident.Release(request->handle);
+		request->handle = HANDLE_NULL;
+	}
+
+	if(request->model)
+	{
+		request->model->Shutdown();
+		m_models.Free(request->model);
+		request->model = nullptr;
+	}
+
+	return;
+}
+
+void MeshLoaderClass::DestroyModel(void* context, ModelClass*& model)
+{
+	MeshLoaderClass* loader;
+
+	loader = (MeshLoaderClass*)context;
+	model->Shutdown();
+	loader->m_models.Free(model);
+
+	return;
+}
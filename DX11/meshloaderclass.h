@@ -0,0 +1,150 @@
+#pragma once
+#ifndef _MESHLOADERCLASS_H_
+#define _MESHLOADERCLASS_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boundedqueueclass.h"
+#include "handlepoolclass.h"
+#include "modelclass.h"
+#include "poolclass.h"
+
+// models loaded at once, a load past that fails until one is cancelled.
+const int MESH_LOADER_MAX_MODELS = 1024;
+// a request id is a slot and the slot's generation like a handle, with one generation bit less so the id stays a positive int.
+const unsigned int MESH_LOADER_GENERATION_MASK = HANDLE_GENERATION_MASK >> 1;
+
+enum MeshLoadState
+{
+	MESH_LOAD_QUEUED = 0,
+	MESH_LOAD_LOADING = 1,
+	MESH_LOAD_UPLOADING = 2,
+	MESH_LOAD_RESIDENT = 3,
+	MESH_LOAD_FAILED = 4,
+	MESH_LOAD_CANCELLED = 5
+};
+
+/*
+ * streams mesh files in the background.
+ * worker threads take requests highest priority first, map, optimize and encode the mesh with ModelClass::Load,
+ * obj and gltf sources are parsed on the job system, the workers themselves mostly wait on the disk and on that.
+ * and push the finished model onto a bounded lock free queue. Update drains that queue on the render thread and uploads into the geometry arena,
+ * so a model handed out by GetModel is always fully resident and the caller draws a placeholder until then.
+ * a full upload queue holds the workers back instead of piling up system memory copies, they sleep until Update makes room.
+ * the models come from a pool the workers and the render thread share, loading and cancelling never touch the heap for them.
+ * a resident model is named by a handle, cancelling it makes GetModel return null at once but it is only unloaded
+ * once the gpu has drawn the last frame that may use it.
+ * a request that failed or was cancelled is recycled for the next Load, its id then reads as failed and names nothing.
+ */
+class MeshLoaderClass
+{
+public:
+	struct MetricsType
+	{
+		int queued;
+		int loading;
+		int waitingForUpload;
+		int resident;
+		int failed;
+		int cancelled;
+		// milliseconds from Load to the model becoming resident.
+		float averageTimeToResident;
+		float maxTimeToResident;
+	};
+
+public:
+	MeshLoaderClass();
+	MeshLoaderClass(const MeshLoaderClass&);
+	~MeshLoaderClass();
+
+	// geometry is null for the software backend, models then stay in system memory.
+	bool Initialize(GeometryArenaClass* geometry, JobSystemClass* jobSystem, unsigned int vertexFormat, int threadCount, int uploadQueueSize);
+	void Shutdown();
+
+	// returns the request id, or -1 when there is no slot left for it. higher priorities are loaded first.
+	int Load(const char* filename, int priority);
+	// drops a request that is not resident yet, or unloads the model if it is.
+	void Cancel(int request);
+
+	MeshLoadState GetState(int request);
+	ModelClass* GetModel(int request);
+
+	// render thread only. makes at most maxUploads finished loads resident, and unloads the cancelled models the gpu is done with.
+	// completedFrame and retireFrame are as for HandlePoolClass::Update.
+	void Update(int maxUploads, unsigned long long completedFrame, unsigned long long retireFrame);
+	void GetMetrics(MetricsType& metrics);
+
+private:
+	struct RequestType
+	{
+		std::string filename;
+		int priority;
+		unsigned int sequence;
+		int slot;
+		// bumped every time the slot is recycled, so the ids handed out for it before name nothing.
+		unsigned int generation;
+		std::atomic<int> state;
+		std::atomic<bool> cancelled;
+		// the loaded model until it is resident, after that the resident pool owns it and it is found through the handle.
+		ModelClass* model;
+		HandleType handle;
+		std::chrono::steady_clock::time_point startTime;
+	};
+
+	struct PriorityOrderType
+	{
+		// higher priority first, then first come first served.
+		bool operator()(const RequestType* a, const RequestType* b) const
+		{
+			return a->priority != b->priority ? a->priority < b->priority : a->sequence > b->sequence;
+		}
+	};
+
+	RequestType* GetRequest(int request);
+	void RecycleRequest(RequestType* request);
+	void WorkerThread();
+	void ReleaseModel(RequestType* request);
+	static void DestroyModel(void* context, ModelClass*& model);
+
+private:
+	GeometryArenaClass* m_Geometry;
+	JobSystemClass* m_JobSystem;
+	unsigned int m_vertexFormat;
+	PoolClass<ModelClass> m_models;
+	HandlePoolClass<ModelClass*> m_resident;
+
+	// requests are only added, looked up and recycled on the render thread, the workers get pointers through the queues.
+	// a slot's request is reused once it failed or was cancelled, the free slots are listed newest first.
+	std::vector<RequestType*> m_requests;
+	std::vector<int> m_freeRequests;
+	unsigned int m_sequence;
+
+	// the cancelled requests the workers took off the pending queue without loading them, for Update to recycle.
+	std::mutex m_pendingMutex;
+	std::condition_variable m_pendingCondition;
+	std::priority_queue<RequestType*, std::vector<RequestType*>, PriorityOrderType> m_pending;
+	std::vector<RequestType*> m_skipped;
+
+	// a worker that finds the upload queue full sleeps on the condition until Update has taken something off it.
+	BoundedQueueClass<RequestType*> m_uploads;
+	std::mutex m_uploadMutex;
+	std::condition_variable m_uploadCondition;
+
+	std::vector<std::thread> m_workers;
+	std::atomic<bool> m_running;
+	std::atomic<int> m_loading;
+
+	int m_residentCount, m_failedCount, m_timedCount;
+	// workers count the requests they skip as well.
+	std::atomic<int> m_cancelledCount;
+	double m_totalTimeToResident, m_maxTimeToResident;
+};
+
+#endif
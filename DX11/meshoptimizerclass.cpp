@@ -0,0 +1,489 @@
+#include "meshoptimizerclass.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// size of the fifo cache the statistics and the overdraw clusters are measured with.
+static const int FIFO_CACHE_SIZE = 16;
+
+// forsyth's scoring model, a 32 entry lru cache where the last triangle's vertices get a fixed score.
+static const int LRU_CACHE_SIZE = 32;
+static const float CACHE_DECAY_POWER = 1.5f;
+static const float LAST_TRIANGLE_SCORE = 0.75f;
+static const float VALENCE_BOOST_SCALE = 2.0f;
+static const float VALENCE_BOOST_POWER = 0.5f;
+
+// a cluster is split as soon as its running miss ratio gets within this factor of the whole cluster's.
+static const float OVERDRAW_THRESHOLD = 1.05f;
+
+static float VertexScore(int cachePosition, unsigned int remainingTriangles)
+{
+	float score;
+
+	// nothing left to draw with this vertex.
+	if(remainingTriangles == 0)
+	{
+		return -1.0f;
+	}
+
+	score = 0.0f;
+	if(cachePosition >= 0)
+	{
+		if(cachePosition < 3)
+		{
+			// used by the last triangle, deliberately lower so it does not get stuck on one strip.
+			score = LAST_TRIANGLE_SCORE;
+		} else
+		{
+			score = powf(1.0f - (float)(cachePosition - 3) / (float)(LRU_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+		}
+	}
+
+	// boost vertices with few triangles left so they get finished off instead of leaving lone triangles behind.
+	score += VALENCE_BOOST_SCALE * powf((float)remainingTriangles, -VALENCE_BOOST_POWER);
+
+	return score;
+}
+
+// pushes the triangle's vertices into a fifo cache and returns how many of them missed.
+static unsigned int SimulateFifo(const unsigned int* triangle, unsigned int* timestamps, unsigned int& time)
+{
+	unsigned int misses, k;
+
+	misses = 0;
+	for(k = 0; k < 3; k++)
+	{
+		if(time - timestamps[triangle[k]] > (unsigned int)FIFO_CACHE_SIZE)
+		{
+			timestamps[triangle[k]] = time++;
+			misses++;
+		}
+	}
+
+	return misses;
+}
+
+MeshOptimizerClass::MeshOptimizerClass()
+{
+	memset(&m_before, 0, sizeof(m_before));
+	memset(&m_after, 0, sizeof(m_after));
+}
+
+MeshOptimizerClass::MeshOptimizerClass(const MeshOptimizerClass&)
+{
+}
+
+MeshOptimizerClass::~MeshOptimizerClass()
+{
+}
+
+bool MeshOptimizerClass::Optimize(void* vertices, unsigned int vertexStride, unsigned int vertexCount, unsigned int* indices, unsigned int indexCount)
+{
+	unsigned int i;
+
+	if(indexCount % 3 != 0 || vertexStride < 3 * sizeof(float))
+	{
+		return false;
+	}
+
+	for(i = 0; i < indexCount; i++)
+	{
+		if(indices[i] >= vertexCount)
+		{
+			return false;
+		}
+	}
+
+	AnalyzeVertexCache(indices, indexCount, vertexCount, m_before);
+
+	OptimizeVertexCache(indices, indexCount, vertexCount);
+	OptimizeOverdraw(indices, indexCount, (const unsigned char*)vertices, vertexStride);
+
+	if(!OptimizeVertexFetch((unsigned char*)vertices, vertexStride, vertexCount, indices, indexCount))
+	{
+		return false;
+	}
+
+	AnalyzeVertexCache(indices, indexCount, vertexCount, m_after);
+
+	return true;
+}
+
+void MeshOptimizerClass::GetStatistics(StatisticsType& before, StatisticsType& after)
+{
+	before = m_before;
+	after = m_after;
+	return;
+}
+
+void MeshOptimizerClass::AnalyzeVertexCache(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount, StatisticsType& statistics)
+{
+	std::vector<unsigned int> timestamps(vertexCount, 0);
+	std::vector<bool> referenced(vertexCount, false);
+	unsigned int i, time, uniqueVertices;
+
+	// start the clock past the cache size so every first use is a miss.
+	time = FIFO_CACHE_SIZE + 1;
+	statistics.misses = 0;
+	uniqueVertices = 0;
+
+	for(i = 0; i + 2 < indexCount; i += 3)
+	{
+		statistics.misses += SimulateFifo(indices + i, &timestamps[0], time);
+	}
+
+	for(i = 0; i < indexCount; i++)
+	{
+		if(!referenced[indices[i]])
+		{
+			referenced[indices[i]] = true;
+			uniqueVertices++;
+		}
+	}
+
+	statistics.acmr = indexCount ? (float)statistics.misses / (float)(indexCount / 3) : 0.0f;
+	statistics.atvr = uniqueVertices ? (float)statistics.misses / (float)uniqueVertices : 0.0f;
+
+	return;
+}
+
+void MeshOptimizerClass::OptimizeVertexCache(unsigned int* indices, unsigned int indexCount, unsigned int vertexCount)
+{
+	std::vector<unsigned int> triangleOffsets(vertexCount + 1, 0), triangleCounts(vertexCount, 0), adjacency;
+	std::vector<int> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount), triangleScores;
+	std::vector<bool> emitted;
+	unsigned int triangleCount, i, k, v, t, cacheSize, newCacheSize, cursor, output;
+	unsigned int cache[LRU_CACHE_SIZE + 3], newCache[LRU_CACHE_SIZE + 3];
+	int bestTriangle;
+	float bestScore;
+
+	triangleCount = indexCount / 3;
+	if(triangleCount == 0)
+	{
+		return;
+	}
+
+	// the triangles using every vertex, packed back to back.
+	for(i = 0; i < indexCount; i++)
+	{
+		triangleCounts[indices[i]]++;
+	}
+	for(v = 0; v < vertexCount; v++)
+	{
+		triangleOffsets[v + 1] = triangleOffsets[v] + triangleCounts[v];
+	}
+
+	adjacency.resize(indexCount);
+	std::fill(triangleCounts.begin(), triangleCounts.end(), 0);
+	for(t = 0; t < triangleCount; t++)
+	{
+		for(k = 0; k < 3; k++)
+		{
+			v = indices[t * 3 + k];
+			adjacency[triangleOffsets[v] + triangleCounts[v]++] = t;
+		}
+	}
+
+	for(v = 0; v < vertexCount; v++)
+	{
+		vertexScores[v] = VertexScore(-1, triangleCounts[v]);
+	}
+
+	triangleScores.resize(triangleCount);
+	emitted.resize(triangleCount, false);
+	bestTriangle = 0;
+	bestScore = -1.0f;
+	for(t = 0; t < triangleCount; t++)
+	{
+		triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+		if(triangleScores[t] > bestScore)
+		{
+			bestScore = triangleScores[t];
+			bestTriangle = (int)t;
+		}
+	}
+
+	m_scratch.resize(indexCount);
+	cacheSize = 0;
+	cursor = 0;
+
+	for(output = 0; output < triangleCount; output++)
+	{
+		// dead end, nothing in the cache has triangles left. carry on with the next one in input order.
+		if(bestTriangle < 0)
+		{
+			while(emitted[cursor])
+			{
+				cursor++;
+			}
+			bestTriangle = (int)cursor;
+		}
+
+		t = (unsigned int)bestTriangle;
+		emitted[t] = true;
+		triangleScores[t] = -1.0f;
+
+		for(k = 0; k < 3; k++)
+		{
+			unsigned int* begin;
+			unsigned int* end;
+
+			v = indices[t * 3 + k];
+			m_scratch[output * 3 + k] = v;
+
+			// drop the triangle from the vertex's list.
+			begin = &adjacency[triangleOffsets[v]];
+			end = begin + triangleCounts[v];
+			*std::find(begin, end, t) = *(end - 1);
+			triangleCounts[v]--;
+		}
+
+		// the triangle's vertices go to the front of the lru cache.
+		newCacheSize = 0;
+		for(k = 0; k < 3; k++)
+		{
+			newCache[newCacheSize++] = indices[t * 3 + k];
+		}
+		for(i = 0; i < cacheSize; i++)
+		{
+			v = cache[i];
+			if(v != indices[t * 3] && v != indices[t * 3 + 1] && v != indices[t * 3 + 2])
+			{
+				newCache[newCacheSize++] = v;
+			}
+		}
+
+		// rescore everything that moved, including whatever fell out of the end.
+		for(i = 0; i < newCacheSize; i++)
+		{
+			v = newCache[i];
+			cachePositions[v] = i < (unsigned int)LRU_CACHE_SIZE ? (int)i : -1;
+			vertexScores[v] = VertexScore(cachePositions[v], triangleCounts[v]);
+		}
+
+		// the triangles touching the cache are the only ones whose score changed, pick the best of them.
+		bestTriangle = -1;
+		bestScore = -1.0f;
+		for(i = 0; i < newCacheSize; i++)
+		{
+			v = newCache[i];
+			for(k = 0; k < triangleCounts[v]; k++)
+			{
+				unsigned int neighbour = adjacency[triangleOffsets[v] + k];
+				float score = vertexScores[indices[neighbour * 3]] + vertexScores[indices[neighbour * 3 + 1]] + vertexScores[indices[neighbour * 3 + 2]];
+
+				triangleScores[neighbour] = score;
+				if(score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = (int)neighbour;
+				}
+			}
+		}
+
+		cacheSize = newCacheSize < (unsigned int)LRU_CACHE_SIZE ? newCacheSize : (unsigned int)LRU_CACHE_SIZE;
+		memcpy(cache, newCache, cacheSize * sizeof(unsigned int));
+	}
+
+	memcpy(indices, &m_scratch[0], indexCount * sizeof(unsigned int));
+
+	return;
+}
+
+void MeshOptimizerClass::OptimizeOverdraw(unsigned int* indices, unsigned int indexCount, const unsigned char* vertices, unsigned int vertexStride)
+{
+	struct ClusterType
+	{
+		unsigned int start, count;
+		float sortKey;
+	};
+
+	std::vector<ClusterType> clusters;
+	std::vector<unsigned int> hardStarts, timestamps;
+	unsigned int triangleCount, vertexCount, i, t, c, k, time, start, end, misses, clusterMisses;
+	float meshCentroid[3], meshArea;
+
+	triangleCount = indexCount / 3;
+	if(triangleCount == 0)
+	{
+		return;
+	}
+
+	vertexCount = 0;
+	for(i = 0; i < indexCount; i++)
+	{
+		vertexCount = indices[i] + 1 > vertexCount ? indices[i] + 1 : vertexCount;
+	}
+	timestamps.resize(vertexCount);
+
+	// hard boundaries, triangles where the cache starts over with three misses.
+	std::fill(timestamps.begin(), timestamps.end(), 0);
+	time = FIFO_CACHE_SIZE + 1;
+	for(t = 0; t < triangleCount; t++)
+	{
+		if(SimulateFifo(indices + t * 3, &timestamps[0], time) == 3 || t == 0)
+		{
+			hardStarts.push_back(t);
+		}
+	}
+	hardStarts.push_back(triangleCount);
+
+	// soft boundaries, split a cluster once its running miss ratio is nearly as good as the whole cluster's.
+	for(c = 0; c + 1 < hardStarts.size(); c++)
+	{
+		start = hardStarts[c];
+		end = hardStarts[c + 1];
+
+		std::fill(timestamps.begin(), timestamps.end(), 0);
+		time = FIFO_CACHE_SIZE + 1;
+		clusterMisses = 0;
+		for(t = start; t < end; t++)
+		{
+			clusterMisses += SimulateFifo(indices + t * 3, &timestamps[0], time);
+		}
+
+		std::fill(timestamps.begin(), timestamps.end(), 0);
+		time = FIFO_CACHE_SIZE + 1;
+		misses = 0;
+		for(t = start; t < end; t++)
+		{
+			misses += SimulateFifo(indices + t * 3, &timestamps[0], time);
+
+			if(t + 1 == end || (float)misses / (float)(t - start + 1) <= OVERDRAW_THRESHOLD * (float)clusterMisses / (float)(end - hardStarts[c]))
+			{
+				ClusterType cluster;
+
+				cluster.start = start;
+				cluster.count = t - start + 1;
+				cluster.sortKey = 0.0f;
+				clusters.push_back(cluster);
+
+				start = t + 1;
+				misses = 0;
+				std::fill(timestamps.begin(), timestamps.end(), 0);
+				time = FIFO_CACHE_SIZE + 1;
+			}
+		}
+	}
+
+	// area weighted centroid of the whole mesh.
+	meshCentroid[0] = meshCentroid[1] = meshCentroid[2] = 0.0f;
+	meshArea = 0.0f;
+	for(t = 0; t < triangleCount; t++)
+	{
+		const float* a = (const float*)(vertices + (unsigned long long)indices[t * 3] * vertexStride);
+		const float* b = (const float*)(vertices + (unsigned long long)indices[t * 3 + 1] * vertexStride);
+		const float* d = (const float*)(vertices + (unsigned long long)indices[t * 3 + 2] * vertexStride);
+		float ux = b[0] - a[0], uy = b[1] - a[1], uz = b[2] - a[2];
+		float vx = d[0] - a[0], vy = d[1] - a[1], vz = d[2] - a[2];
+		float nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx;
+		float area = sqrtf(nx * nx + ny * ny + nz * nz);
+
+		for(k = 0; k < 3; k++)
+		{
+			meshCentroid[k] += (a[k] + b[k] + d[k]) * area / 3.0f;
+		}
+		meshArea += area;
+	}
+	if(meshArea > 0.0f)
+	{
+		for(k = 0; k < 3; k++)
+		{
+			meshCentroid[k] /= meshArea;
+		}
+	}
+
+	/*
+	 * clusters facing away from the middle of the mesh are the ones most likely to occlude the rest,
+	 * so they are drawn first. the key is how far the cluster's centroid sits along its own average normal.
+	 */
+	for(c = 0; c < clusters.size(); c++)
+	{
+		float centroid[3], normal[3], area, length;
+
+		centroid[0] = centroid[1] = centroid[2] = 0.0f;
+		normal[0] = normal[1] = normal[2] = 0.0f;
+		area = 0.0f;
+
+		for(t = clusters[c].start; t < clusters[c].start + clusters[c].count; t++)
+		{
+			const float* a = (const float*)(vertices + (unsigned long long)indices[t * 3] * vertexStride);
+			const float* b = (const float*)(vertices + (unsigned long long)indices[t * 3 + 1] * vertexStride);
+			const float* d = (const float*)(vertices + (unsigned long long)indices[t * 3 + 2] * vertexStride);
+			float ux = b[0] - a[0], uy = b[1] - a[1], uz = b[2] - a[2];
+			float vx = d[0] - a[0], vy = d[1] - a[1], vz = d[2] - a[2];
+			float nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx;
+			float triangleArea = sqrtf(nx * nx + ny * ny + nz * nz);
+
+			for(k = 0; k < 3; k++)
+			{
+				centroid[k] += (a[k] + b[k] + d[k]) * triangleArea / 3.0f;
+			}
+			normal[0] += nx;
+			normal[1] += ny;
+			normal[2] += nz;
+			area += triangleArea;
+		}
+
+		length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		if(area > 0.0f && length > 0.0f)
+		{
+			clusters[c].sortKey = ((centroid[0] / area - meshCentroid[0]) * normal[0] +
+				(centroid[1] / area - meshCentroid[1]) * normal[1] +
+				(centroid[2] / area - meshCentroid[2]) * normal[2]) / length;
+		}
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](const ClusterType& a, const ClusterType& b) { return a.sortKey > b.sortKey; });
+
+	m_scratch.resize(indexCount);
+	i = 0;
+	for(c = 0; c < clusters.size(); c++)
+	{
+		memcpy(&m_scratch[i], indices + clusters[c].start * 3, clusters[c].count * 3 * sizeof(unsigned int));
+		i += clusters[c].count * 3;
+	}
+
+	memcpy(indices, &m_scratch[0], indexCount * sizeof(unsigned int));
+
+	return;
+}
+
+bool MeshOptimizerClass::OptimizeVertexFetch(unsigned char* vertices, unsigned int vertexStride, unsigned int vertexCount, unsigned int* indices, unsigned int indexCount)
+{
+	std::vector<unsigned int> remap(vertexCount, 0xFFFFFFFF);
+	std::vector<unsigned char> reordered;
+	unsigned int i, next;
+
+	// number the vertices in the order the triangles first use them.
+	next = 0;
+	for(i = 0; i < indexCount; i++)
+	{
+		if(remap[indices[i]] == 0xFFFFFFFF)
+		{
+			remap[indices[i]] = next++;
+		}
+		indices[i] = remap[indices[i]];
+	}
+
+	// unreferenced vertices keep their relative order at the end.
+	for(i = 0; i < vertexCount; i++)
+	{
+		if(remap[i] == 0xFFFFFFFF)
+		{
+			remap[i] = next++;
+		}
+	}
+
+	reordered.resize((size_t)vertexStride * vertexCount);
+	for(i = 0; i < vertexCount; i++)
+	{
+		memcpy(&reordered[(size_t)remap[i] * vertexStride], vertices + (size_t)i * vertexStride, vertexStride);
+	}
+
+	memcpy(vertices, &reordered[0], reordered.size());
+
+	return true;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#ifndef _MESHOPTIMIZERCLASS_H_
+#define _MESHOPTIMIZERCLASS_H_
+
+#include <vector>
+
+/*
+ * reorders an indexed triangle list for the gpu in three passes.
+ * first the triangles are sorted for post transform vertex cache hits (tom forsyth's linear speed algorithm),
+ * then the result is cut into clusters at cache restarts and the clusters are sorted outside in to reduce overdraw (sander et al, tipsify),
+ * last the vertices are renumbered in the order they are first fetched.
+ * the statistics are measured on a 16 entry fifo cache, like the hardware the numbers are usually quoted for.
+ * every vertex has to start with an XMFLOAT3 position, it is used to sort the clusters.
+ */
+class MeshOptimizerClass
+{
+public:
+	struct StatisticsType
+	{
+		// average cache miss ratio, misses per triangle. 0.5 is the best a regular grid can do, 3 the worst.
+		float acmr;
+		// average transform to vertex ratio, misses per referenced vertex. 1 is perfect.
+		float atvr;
+		unsigned int misses;
+	};
+
+public:
+	MeshOptimizerClass();
+	MeshOptimizerClass(const MeshOptimizerClass&);
+	~MeshOptimizerClass();
+
+	bool Optimize(void* vertices, unsigned int vertexStride, unsigned int vertexCount, unsigned int* indices, unsigned int indexCount);
+	void GetStatistics(StatisticsType& before, StatisticsType& after);
+
+	static void AnalyzeVertexCache(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount, StatisticsType& statistics);
+
+private:
+	void OptimizeVertexCache(unsigned int* indices, unsigned int indexCount, unsigned int vertexCount);
+	void OptimizeOverdraw(unsigned int* indices, unsigned int indexCount, const unsigned char* vertices, unsigned int vertexStride);
+	bool OptimizeVertexFetch(unsigned char* vertices, unsigned int vertexStride, unsigned int vertexCount, unsigned int* indices, unsigned int indexCount);
+
+private:
+	StatisticsType m_before, m_after;
+	std::vector<unsigned int> m_scratch;
+};
+
+#endif
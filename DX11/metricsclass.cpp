@@ -0,0 +1,288 @@
+#include "metricsclass.h"
+
+#include <cstdio>
+
+MetricsClass::MetricsClass()
+{
+	int i;
+
+	for(i = 0; i < METRICS_MAX; i++)
+	{
+		m_metrics[i].kind = KIND_COUNTER;
+		m_metrics[i].count = 0;
+		m_metrics[i].value = 0.0;
+		m_metrics[i].resolution = 1.0;
+		m_metrics[i].sum = 0;
+		m_metrics[i].buckets = nullptr;
+	}
+	m_metricCount = 0;
+	m_interval = std::chrono::duration<double>(0.0);
+}
+
+MetricsClass::MetricsClass(const MetricsClass&)
+{
+}
+
+MetricsClass::~MetricsClass()
+{
+}
+
+bool MetricsClass::Initialize(const char* filename, float interval)
+{
+	m_filename = filename ? filename : "";
+	m_interval = std::chrono::duration<double>(interval);
+	m_lastWrite = std::chrono::steady_clock::now();
+	m_metricCount = 0;
+
+	return true;
+}
+
+void MetricsClass::Shutdown()
+{
+	int i;
+
+	for(i = 0; i < m_metricCount; i++)
+	{
+		if(m_metrics[i].buckets)
+		{
+			delete[] m_metrics[i].buckets;
+			m_metrics[i].buckets = nullptr;
+		}
+	}
+	m_metricCount = 0;
+
+	return;
+}
+
+int MetricsClass::AddCounter(const char* name, const char* help)
+{
+	return AddMetric(name, help, KIND_COUNTER, 1.0);
+}
+
+int MetricsClass::AddGauge(const char* name, const char* help)
+{
+	return AddMetric(name, help, KIND_GAUGE, 1.0);
+}
+
+int MetricsClass::AddHistogram(const char* name, const char* help, double resolution)
+{
+	if(resolution <= 0.0)
+	{
+		return -1;
+	}
+
+	return AddMetric(name, help, KIND_HISTOGRAM, resolution);
+}
+
+void MetricsClass::Add(int counter, unsigned long long value)
+{
+	if(counter < 0)
+	{
+		return;
+	}
+
+	m_metrics[counter].count.fetch_add(value, std::memory_order_relaxed);
+
+	return;
+}
+
+void MetricsClass::Set(int gauge, double value)
+{
+	if(gauge < 0)
+	{
+		return;
+	}
+
+	m_metrics[gauge].value.store(value, std::memory_order_relaxed);
+
+	return;
+}
+
+void MetricsClass::Record(int histogram, double value)
+{
+	MetricType* metric;
+	unsigned long long units;
+
+	if(histogram < 0)
+	{
+		return;
+	}
+
+	metric = &m_metrics[histogram];
+
+	// negative values are counted as zero.
+	units = value > 0.0 ? (unsigned long long)(value / metric->resolution) : 0;
+
+	metric->buckets[GetBucket(units)].fetch_add(1, std::memory_order_relaxed);
+	metric->sum.fetch_add(units, std::memory_order_relaxed);
+	metric->count.fetch_add(1, std::memory_order_relaxed);
+
+	return;
+}
+
+bool MetricsClass::Update()
+{
+	std::chrono::steady_clock::time_point now;
+
+	if(m_filename.empty())
+	{
+		return true;
+	}
+
+	now = std::chrono::steady_clock::now();
+	if(now - m_lastWrite < m_interval)
+	{
+		return true;
+	}
+
+	m_lastWrite = now;
+
+	return Write(m_filename.c_str());
+}
+
+bool MetricsClass::Write(const char* filename)
+{
+	std::string temporary;
+	MetricType* metric;
+	unsigned long long cumulative;
+	FILE* file;
+	int i, bucket;
+
+	// written next to the file and renamed over it, so whatever reads it never sees half of a dump.
+	temporary = std::string(filename) + ".tmp";
+	file = fopen(temporary.c_str(), "w");
+	if(!file)
+	{
+		return false;
+	}
+
+	for(i = 0; i < m_metricCount; i++)
+	{
+		metric = &m_metrics[i];
+
+		fprintf(file, "# HELP %s %s\n", metric->name.c_str(), metric->help.c_str());
+
+		switch(metric->kind)
+		{
+			case KIND_COUNTER:
+				fprintf(file, "# TYPE %s counter\n%s %llu\n", metric->name.c_str(), metric->name.c_str(), metric->count.load());
+				break;
+
+			case KIND_GAUGE:
+				fprintf(file, "# TYPE %s gauge\n%s %.17g\n", metric->name.c_str(), metric->name.c_str(), metric->value.load());
+				break;
+
+			case KIND_HISTOGRAM:
+				fprintf(file, "# TYPE %s histogram\n", metric->name.c_str());
+
+				// every bucket every time, prometheus wants the same le labels in each dump. a bucket's bound is the end of the last resolution it holds.
+				// the last bucket also holds everything past it, +Inf stands for it. buckets other threads are adding to are read one at a time,
+				// the total is taken from them so the dump adds up.
+				cumulative = 0;
+				for(bucket = 0; bucket < METRICS_HISTOGRAM_BUCKETS - 1; bucket++)
+				{
+					cumulative += metric->buckets[bucket].load(std::memory_order_relaxed);
+					fprintf(file, "%s_bucket{le=\"%.9g\"} %llu\n", metric->name.c_str(), (double)(GetBucketLimit(bucket) + 1) * metric->resolution, cumulative);
+				}
+				cumulative += metric->buckets[bucket].load(std::memory_order_relaxed);
+
+				fprintf(file, "%s_bucket{le=\"+Inf\"} %llu\n", metric->name.c_str(), cumulative);
+				fprintf(file, "%s_sum %.9g\n", metric->name.c_str(), (double)metric->sum.load(std::memory_order_relaxed) * metric->resolution);
+				fprintf(file, "%s_count %llu\n", metric->name.c_str(), cumulative);
+				break;
+		}
+	}
+
+	if(fclose(file) != 0)
+	{
+		return false;
+	}
+
+	remove(filename);
+	if(rename(temporary.c_str(), filename) != 0)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+int MetricsClass::AddMetric(const char* name, const char* help, KindType kind, double resolution)
+{
+	MetricType* metric;
+	int i;
+
+	if(m_metricCount >= METRICS_MAX)
+	{
+		return -1;
+	}
+
+	metric = &m_metrics[m_metricCount];
+	metric->name = name;
+	metric->help = help;
+	metric->kind = kind;
+	metric->count = 0;
+	metric->value = 0.0;
+	metric->resolution = resolution;
+	metric->sum = 0;
+	metric->buckets = nullptr;
+
+	if(kind == KIND_HISTOGRAM)
+	{
+		metric->buckets = new std::atomic<unsigned long long>[METRICS_HISTOGRAM_BUCKETS];
+		if(!metric->buckets)
+		{
+			return -1;
+		}
+
+		for(i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++)
+		{
+			metric->buckets[i] = 0;
+		}
+	}
+
+	return m_metricCount++;
+}
+
+int MetricsClass::GetBucket(unsigned long long value)
+{
+	int exponent, bucket;
+
+	// below the first power of two with sub buckets every value has its own bucket.
+	if(value < (unsigned long long)METRICS_SUB_BUCKETS)
+	{
+		return (int)value;
+	}
+
+	// otherwise the power of two picks a group of sub buckets and the bits under the leading one pick the sub bucket in it.
+	exponent = 63;
+	while(!(value >> exponent))
+	{
+		exponent--;
+	}
+
+	bucket = (exponent - METRICS_SUB_BUCKET_BITS + 1) * METRICS_SUB_BUCKETS + (int)(value >> (exponent - METRICS_SUB_BUCKET_BITS)) - METRICS_SUB_BUCKETS;
+
+	return bucket < METRICS_HISTOGRAM_BUCKETS ? bucket : METRICS_HISTOGRAM_BUCKETS - 1;
+}
+
+unsigned long long MetricsClass::GetBucketLimit(int bucket)
+{
+	int group, shift;
+
+	if(bucket < METRICS_SUB_BUCKETS)
+	{
+		return (unsigned long long)bucket;
+	}
+
+	// the last bucket also holds everything past it.
+	if(bucket == METRICS_HISTOGRAM_BUCKETS - 1)
+	{
+		return ~0ULL - 1;
+	}
+
+	group = bucket / METRICS_SUB_BUCKETS;
+	shift = group - 1;
+
+	return ((unsigned long long)(METRICS_SUB_BUCKETS + bucket % METRICS_SUB_BUCKETS) << shift) + (1ULL << shift) - 1;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#ifndef _METRICSCLASS_H_
+#define _METRICSCLASS_H_
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+// metrics one registry can hold.
+const int METRICS_MAX = 64;
+// a histogram's buckets are linear within every power of two, 8 of them keep a bucket within 12.5% of the values in it.
+const int METRICS_SUB_BUCKET_BITS = 3;
+const int METRICS_SUB_BUCKETS = 1 << METRICS_SUB_BUCKET_BITS;
+// enough to tell apart every value up to 2^32 resolutions, larger ones go into the last bucket.
+const int METRICS_HISTOGRAM_BUCKETS = (32 - METRICS_SUB_BUCKET_BITS + 1) * METRICS_SUB_BUCKETS;
+
+/*
+ * always on aggregate telemetry, as opposed to the profiler's captures of a few frames.
+ * a metric is a counter that only goes up, a gauge that is set to its latest value or a histogram of values such as latencies.
+ * metrics are registered by name up front and updated through the index registering returned, from any thread and without locks:
+ * counters and histogram buckets are atomic adds, gauges an atomic store.
+ * histograms are HDR style, buckets are linear within each power of two so the relative precision is the same from microseconds to seconds.
+ * Update writes everything to a file in the prometheus text format every so often, for a textfile collector or for reading by hand.
+ */
+class MetricsClass
+{
+public:
+	MetricsClass();
+	MetricsClass(const MetricsClass&);
+	~MetricsClass();
+
+	// filename is where Update writes, every interval seconds. null never writes unless Write is called.
+	bool Initialize(const char* filename, float interval);
+	void Shutdown();
+
+	// not thread safe, metrics are registered before the threads updating them start. names follow prometheus, lowercase with underscores.
+	// -1 when the registry is full, updating -1 does nothing.
+	int AddCounter(const char* name, const char* help);
+	int AddGauge(const char* name, const char* help);
+	// values are counted in whole multiples of resolution, a histogram of seconds with a resolution of 1e-6 counts microseconds.
+	int AddHistogram(const char* name, const char* help, double resolution);
+
+	// any thread.
+	void Add(int counter, unsigned long long value);
+	void Set(int gauge, double value);
+	void Record(int histogram, double value);
+
+	// render thread, once per frame. writes the file once the interval has passed since the last time.
+	bool Update();
+	bool Write(const char* filename);
+
+private:
+	enum KindType
+	{
+		KIND_COUNTER,
+		KIND_GAUGE,
+		KIND_HISTOGRAM
+	};
+
+	struct MetricType
+	{
+		std::string name;
+		std::string help;
+		KindType kind;
+		// a counter's value, or how many values a histogram has.
+		std::atomic<unsigned long long> count;
+		std::atomic<double> value;
+		// histograms only, the sum is in resolutions.
+		double resolution;
+		std::atomic<unsigned long long> sum;
+		std::atomic<unsigned long long>* buckets;
+	};
+
+	int AddMetric(const char* name, const char* help, KindType kind, double resolution);
+	static int GetBucket(unsigned long long value);
+	// the largest value that still goes into the bucket.
+	static unsigned long long GetBucketLimit(int bucket);
+
+private:
+	MetricType m_metrics[METRICS_MAX];
+	int m_metricCount;
+
+	std::string m_filename;
+	std::chrono::duration<double> m_interval;
+	std::chrono::steady_clock::time_point m_lastWrite;
+};
+
+#endif
@@ -1,9 +1,38 @@
 #include "modelclass.h"
 
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include "geometryarenaclass.h"
+#include "devicestateclass.h"
+#endif
+
+// the most vertices a 16 bit index can address from one base vertex.
+static const int MAX_16BIT_VERTICES = 65536;
+
 ModelClass::ModelClass()
 {
-	m_vertexBuffer = nullptr;
-	m_indexBuffer = nullptr;
+	m_Geometry = nullptr;
+	m_allocation = -1;
+	m_MeshFile = nullptr;
+	m_vertices = nullptr;
+	m_indices = nullptr;
+	m_vertexData = nullptr;
+	m_indexData = nullptr;
+	m_encodedVertices = nullptr;
+	m_shortIndices = nullptr;
+	m_bufferVertices = nullptr;
+	m_bufferIndices = nullptr;
+	m_vertexFormat = VERTEX_FORMAT_FLOAT;
+	m_indexStride = sizeof(unsigned int);
+	m_subsets = nullptr;
+	m_subsetCount = 0;
+	m_dequantizeMatrix = XMMatrixIdentity();
+	m_boundsCenter = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	m_boundsExtent = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	m_occluderPositions = nullptr;
+	m_occluderIndices = nullptr;
 }
 
 ModelClass::ModelClass(const ModelClass&)
@@ -14,29 +43,151 @@ ModelClass::~ModelClass()
 {
 }
 
-bool ModelClass::Initialize(ID3D11Device* device)
+bool ModelClass::Initialize(GeometryArenaClass* geometry, JobSystemClass* jobSystem, const char* modelFilename, unsigned int vertexFormat)
 {
 	bool result;
 
-	result = InitializeBuffers(device);
+	result = Load(modelFilename, vertexFormat, geometry != nullptr, jobSystem);
+	if(!result)
+	{
+		return false;
+	}
+
+	result = Upload(geometry);
 	if(!result)
 	{
 		return false;
 	}
-	
+
+	return true;
+}
+
+bool ModelClass::Load(const char* modelFilename, unsigned int vertexFormat, bool deviceBuffers, JobSystemClass* jobSystem)
+{
+	std::string deviceFilename;
+	bool result, deviceReady;
+
+	if(!VertexFormatClass::IsValid(vertexFormat))
+	{
+		return false;
+	}
+
+	// the software rasterizer only reads float vertices, compact formats are for the gpu.
+	m_vertexFormat = deviceBuffers ? vertexFormat : VERTEX_FORMAT_FLOAT;
+
+	// map the mesh file if there is one, otherwise fall back to the built in triangle.
+	deviceReady = false;
+	if(modelFilename)
+	{
+		result = LoadModel(modelFilename, deviceBuffers, jobSystem, deviceFilename, deviceReady);
+	} else
+	{
+		result = CreateTriangle();
+	}
+	if(!result)
+	{
+		return false;
+	}
+
+	// a file cooked for the buffers brings its subsets, bounds and dequantize matrix along, there is nothing left to do.
+	if(deviceReady)
+	{
+		return true;
+	}
+
+	ComputeBounds();
+
+	result = CopyOccluder();
+	if(!result)
+	{
+		return false;
+	}
+
+	// the software rasterizer reads the 32 bit system memory indices, 16 bit ones are only built for the gpu.
+	result = BuildSubsets(deviceBuffers);
+	if(!result)
+	{
+		return false;
+	}
+
+	if(deviceBuffers)
+	{
+		result = PrepareBuffers();
+		if(!result)
+		{
+			return false;
+		}
+	}
+
+	/*
+	 * keep what was just converted next to the cooked source so the next load maps it as it is.
+	 * occluders are left out, they need the float positions and are small enough to convert every time.
+	 * failing to save only costs the next load the same conversion again.
+	 */
+	if(!deviceFilename.empty() && !m_occluderPositions)
+	{
+		SaveDeviceModel(deviceFilename.c_str());
+	}
+
+	return true;
+}
+
+bool ModelClass::Upload(GeometryArenaClass* geometry)
+{
+	bool result;
+
+	result = InitializeBuffers(geometry);
+	if(!result)
+	{
+		return false;
+	}
+
+	// once the arena has the data the system memory copy is only needed by the software rasterizer.
+	if(geometry)
+	{
+		ReleaseModel();
+	}
+
 	return true;
 }
 
 void ModelClass::Shutdown()
 {
 	ShutdownBuffers();
+	ReleaseModel();
+
+	if(m_occluderPositions)
+	{
+		MemoryClass::FreeArray(m_occluderPositions);
+		m_occluderPositions = nullptr;
+	}
+	if(m_occluderIndices)
+	{
+		MemoryClass::FreeArray(m_occluderIndices);
+		m_occluderIndices = nullptr;
+	}
+
+	if(m_subsets)
+	{
+		MemoryClass::FreeArray(m_subsets);
+		m_subsets = nullptr;
+	}
+	m_subsetCount = 0;
 
 	return;
 }
 
-void ModelClass::Render(ID3D11DeviceContext* deviceContext)
+#ifdef _WIN32
+void ModelClass::Render(DeviceStateClass* deviceState)
+{
+	RenderBuffers(deviceState);
+	return;
+}
+#endif
+
+void ModelClass::Render(SoftwareCommandListClass* commandList)
 {
-	RenderBuffers(deviceContext);
+	RenderBuffers(commandList);
 	return;
 }
 
@@ -45,26 +196,317 @@ int ModelClass::GetIndexCount()
 	return m_indexCount;
 }
 
-bool ModelClass::InitializeBuffers(ID3D11Device* device)
+int ModelClass::GetSubsetCount()
 {
-	VertexType* vertices;
-	unsigned long* indices;
+	return m_subsetCount;
+}
+
+void ModelClass::GetSubset(int subset, int& indexCount, int& startIndex, int& baseVertex)
+{
+	int arenaBaseVertex, arenaStartIndex;
+
+	// subsets are relative to the model's own ranges, the arena knows where those are right now.
+	arenaBaseVertex = 0;
+	arenaStartIndex = 0;
+#ifdef _WIN32
+	if(m_Geometry)
+	{
+		m_Geometry->GetLocation(m_allocation, arenaBaseVertex, arenaStartIndex);
+	}
+#endif
+
+	indexCount = m_subsets[subset].indexCount;
+	startIndex = arenaStartIndex + m_subsets[subset].startIndex;
+	baseVertex = arenaBaseVertex + m_subsets[subset].baseVertex;
+	return;
+}
+
+unsigned int ModelClass::GetVertexFormat()
+{
+	return m_vertexFormat;
+}
+
+void ModelClass::GetDequantizeMatrix(XMMATRIX& dequantizeMatrix)
+{
+	dequantizeMatrix = m_dequantizeMatrix;
+	return;
+}
+
+void ModelClass::GetBounds(XMFLOAT3& center, XMFLOAT3& extent)
+{
+	center = m_boundsCenter;
+	extent = m_boundsExtent;
+	return;
+}
+
+bool ModelClass::GetOccluder(const XMFLOAT3*& positions, int& vertexCount, const unsigned int*& indices, int& indexCount)
+{
+	if(!m_occluderPositions)
+	{
+		return false;
+	}
+
+	positions = m_occluderPositions;
+	vertexCount = m_vertexCount;
+	indices = m_occluderIndices;
+	indexCount = m_indexCount;
+	return true;
+}
+
+bool ModelClass::LoadModel(const char* filename, bool deviceBuffers, JobSystemClass* jobSystem, std::string& deviceFilename, bool& deviceReady)
+{
+	const MeshFileClass::HeaderType* header;
+	MeshImporterClass* importer;
+	std::string cookedFilename;
+	char suffix[32];
+	bool result;
+
+	// obj and gltf sources are cooked into a mesh file first, or just point at the one cooked on an earlier run.
+	if(MeshImporterClass::IsSupported(filename))
+	{
+		importer = new MeshImporterClass;
+		if(!importer)
+		{
+			return false;
+		}
+
+		result = importer->Initialize(jobSystem);
+		if(result)
+		{
+			result = importer->Cook(filename, cookedFilename);
+		}
+
+		importer->Shutdown();
+		delete importer;
+
+		if(!result)
+		{
+			return false;
+		}
+
+		filename = cookedFilename.c_str();
+
+		// the importer cooks float vertices and 32 bit indices, the layout for the buffers is cooked next to it once and mapped from then on.
+		if(deviceBuffers)
+		{
+			snprintf(suffix, sizeof(suffix), ".format%u.mesh", m_vertexFormat);
+			deviceFilename = cookedFilename.substr(0, cookedFilename.size() - strlen(".mesh")) + suffix;
+
+			deviceReady = OpenDeviceModel(deviceFilename.c_str());
+			if(deviceReady)
+			{
+				deviceFilename.clear();
+				return true;
+			}
+		}
+	}
+
+	m_MeshFile = new MeshFileClass;
+	if(!m_MeshFile)
+	{
+		return false;
+	}
+
+	result = m_MeshFile->Open(filename);
+	if(!result)
+	{
+		return false;
+	}
 
-	D3D11_BUFFER_DESC vertexBufferDesc, indexBufferDesc;
-	D3D11_SUBRESOURCE_DATA vertexData, indexData;
-	HRESULT result;
+	// a mesh file cooked for exactly these buffers is used as it is.
+	if(deviceBuffers)
+	{
+		deviceReady = MapDeviceModel();
+		if(deviceReady)
+		{
+			return true;
+		}
+	}
+
+	// anything else has to be the float layout the rest of the load converts from.
+	header = m_MeshFile->GetHeader();
+	if(header->vertexFormat != VERTEX_FORMAT_FLOAT || header->vertexStride != sizeof(VertexType) || header->indexStride != sizeof(unsigned int))
+	{
+		return false;
+	}
+
+	m_vertexCount = (int)header->vertexCount;
+	m_indexCount = (int)header->indexCount;
+	m_vertexData = (const VertexType*)m_MeshFile->GetVertices();
+	m_indexData = (const unsigned int*)m_MeshFile->GetIndices();
+
+	// files that were not optimized offline get a copy that is optimized here, the mapping is read only.
+	if(!(header->flags & MESH_FILE_FLAG_OPTIMIZED))
+	{
+		result = OptimizeModel();
+		if(!result)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
 
+bool ModelClass::OpenDeviceModel(const char* filename)
+{
+	bool result;
+
+	m_MeshFile = new MeshFileClass;
+	if(!m_MeshFile)
+	{
+		return false;
+	}
+
+	result = m_MeshFile->Open(filename) && MapDeviceModel();
+	if(!result)
+	{
+		ReleaseModel();
+		return false;
+	}
+
+	return true;
+}
+
+bool ModelClass::MapDeviceModel()
+{
+	const MeshFileClass::HeaderType* header;
+	const MeshFileClass::SubsetType* subsets;
+	XMFLOAT4X4 dequantize;
+	int i;
+
+	// only files with a subset table were cooked for the buffers, and only the ones in the vertex format asked for fit.
+	header = m_MeshFile->GetHeader();
+	if(header->subsetCount == 0 || header->vertexFormat != m_vertexFormat || header->vertexStride != VertexFormatClass::GetStride(m_vertexFormat) ||
+		!(header->flags & MESH_FILE_FLAG_OPTIMIZED))
+	{
+		return false;
+	}
+
+	m_subsets = MemoryClass::AllocateArray<SubsetType>(header->subsetCount, MEMORY_TAG_GEOMETRY);
+	if(!m_subsets)
+	{
+		return false;
+	}
+
+	subsets = m_MeshFile->GetSubsets();
+	for(i = 0; i < (int)header->subsetCount; i++)
+	{
+		m_subsets[i].indexCount = (int)subsets[i].indexCount;
+		m_subsets[i].startIndex = (int)subsets[i].startIndex;
+		m_subsets[i].baseVertex = (int)subsets[i].baseVertex;
+	}
+	m_subsetCount = (int)header->subsetCount;
+
+	m_vertexCount = (int)header->vertexCount;
+	m_indexCount = (int)header->indexCount;
+	m_indexStride = header->indexStride;
+	m_bufferVertices = m_MeshFile->GetVertices();
+	m_bufferIndices = m_MeshFile->GetIndices();
+
+	memcpy(&dequantize, header->dequantize, sizeof(dequantize));
+	m_dequantizeMatrix = XMLoadFloat4x4(&dequantize);
+
+	m_boundsCenter = XMFLOAT3((header->boundsMin[0] + header->boundsMax[0]) * 0.5f, (header->boundsMin[1] + header->boundsMax[1]) * 0.5f,
+		(header->boundsMin[2] + header->boundsMax[2]) * 0.5f);
+	m_boundsExtent = XMFLOAT3((header->boundsMax[0] - header->boundsMin[0]) * 0.5f, (header->boundsMax[1] - header->boundsMin[1]) * 0.5f,
+		(header->boundsMax[2] - header->boundsMin[2]) * 0.5f);
+
+	return true;
+}
+
+bool ModelClass::SaveDeviceModel(const char* filename)
+{
+	MeshFileClass::SubsetType* subsets;
+	XMFLOAT4X4 dequantize;
+	float boundsMin[3], boundsMax[3];
+	int i;
+	bool result;
+
+	subsets = MemoryClass::AllocateArray<MeshFileClass::SubsetType>(m_subsetCount, MEMORY_TAG_GEOMETRY);
+	if(!subsets)
+	{
+		return false;
+	}
+
+	for(i = 0; i < m_subsetCount; i++)
+	{
+		subsets[i].indexCount = (unsigned int)m_subsets[i].indexCount;
+		subsets[i].startIndex = (unsigned int)m_subsets[i].startIndex;
+		subsets[i].baseVertex = (unsigned int)m_subsets[i].baseVertex;
+	}
+
+	boundsMin[0] = m_boundsCenter.x - m_boundsExtent.x;
+	boundsMin[1] = m_boundsCenter.y - m_boundsExtent.y;
+	boundsMin[2] = m_boundsCenter.z - m_boundsExtent.z;
+	boundsMax[0] = m_boundsCenter.x + m_boundsExtent.x;
+	boundsMax[1] = m_boundsCenter.y + m_boundsExtent.y;
+	boundsMax[2] = m_boundsCenter.z + m_boundsExtent.z;
+
+	XMStoreFloat4x4(&dequantize, m_dequantizeMatrix);
+
+	result = MeshFileClass::Save(filename, m_bufferVertices, VertexFormatClass::GetStride(m_vertexFormat), (unsigned int)m_vertexCount,
+		m_bufferIndices, m_indexStride, (unsigned int)m_indexCount, m_vertexFormat, MESH_FILE_FLAG_OPTIMIZED,
+		subsets, (unsigned int)m_subsetCount, boundsMin, boundsMax, &dequantize.m[0][0]);
+
+	MemoryClass::FreeArray(subsets);
+
+	return result;
+}
+
+bool ModelClass::OptimizeModel()
+{
+	MeshOptimizerClass* optimizer;
+	bool result;
+
+	m_vertices = MemoryClass::AllocateArray<VertexType>(m_vertexCount, MEMORY_TAG_GEOMETRY);
+	if(!m_vertices)
+	{
+		return false;
+	}
+
+	m_indices = MemoryClass::AllocateArray<unsigned int>(m_indexCount, MEMORY_TAG_GEOMETRY);
+	if(!m_indices)
+	{
+		return false;
+	}
+
+	memcpy(m_vertices, m_vertexData, sizeof(VertexType) * m_vertexCount);
+	memcpy(m_indices, m_indexData, sizeof(unsigned int) * m_indexCount);
+
+	// the copy is all that is needed from now on.
+	m_MeshFile->Close();
+	delete m_MeshFile;
+	m_MeshFile = nullptr;
+
+	m_vertexData = m_vertices;
+	m_indexData = m_indices;
+
+	optimizer = new MeshOptimizerClass;
+	if(!optimizer)
+	{
+		return false;
+	}
+
+	result = optimizer->Optimize(m_vertices, sizeof(VertexType), m_vertexCount, m_indices, m_indexCount);
+	delete optimizer;
+
+	return result;
+}
+
+bool ModelClass::CreateTriangle()
+{
 	m_vertexCount = 3;
 	m_indexCount = 3;
 
-	vertices = new VertexType[m_vertexCount];
-	if(!vertices)
+	m_vertices = MemoryClass::AllocateArray<VertexType>(m_vertexCount, MEMORY_TAG_GEOMETRY);
+	if(!m_vertices)
 	{
 		return false;
 	}
 
-	indices = new unsigned long[m_indexCount];
-	if(!indices)
+	m_indices = MemoryClass::AllocateArray<unsigned int>(m_indexCount, MEMORY_TAG_GEOMETRY);
+	if(!m_indices)
 	{
 		return false;
 	}
@@ -79,102 +521,321 @@ bool ModelClass::InitializeBuffers(ID3D11Device* device)
 	 */
 
 	// load the vertex array with data.
-	vertices[0].position = XMFLOAT3(-1.0f, -1.0f, 0.0f);
-	vertices[0].color = XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f);
+	m_vertices[0].position = XMFLOAT3(-1.0f, -1.0f, 0.0f);
+	m_vertices[0].color = XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f);
 
-	vertices[1].position = XMFLOAT3(0.0f, 1.0f, 0.0f);
-	vertices[1].color = XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f);
+	m_vertices[1].position = XMFLOAT3(0.0f, 1.0f, 0.0f);
+	m_vertices[1].color = XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f);
 
-	vertices[2].position = XMFLOAT3(-1.0f, -1.0f, 0.0f);
-	vertices[2].color = XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f);
+	m_vertices[2].position = XMFLOAT3(1.0f, -1.0f, 0.0f);
+	m_vertices[2].color = XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f);
 
 	// load the index array with data
-	indices[0] = 0;
-	indices[1] = 1;
-	indices[2] = 2;
+	m_indices[0] = 0;
+	m_indices[1] = 1;
+	m_indices[2] = 2;
+
+	m_vertexData = m_vertices;
+	m_indexData = m_indices;
+
+	return true;
+}
+
+void ModelClass::ReleaseModel()
+{
+	if(m_shortIndices)
+	{
+		MemoryClass::FreeArray(m_shortIndices);
+		m_shortIndices = nullptr;
+	}
+
+	if(m_encodedVertices)
+	{
+		MemoryClass::FreeArray(m_encodedVertices);
+		m_encodedVertices = nullptr;
+	}
+
+	if(m_indices)
+	{
+		MemoryClass::FreeArray(m_indices);
+		m_indices = nullptr;
+	}
+
+	if(m_vertices)
+	{
+		MemoryClass::FreeArray(m_vertices);
+		m_vertices = nullptr;
+	}
+
+	if(m_MeshFile)
+	{
+		m_MeshFile->Close();
+		delete m_MeshFile;
+		m_MeshFile = nullptr;
+	}
+
+	m_vertexData = nullptr;
+	m_indexData = nullptr;
+	m_bufferVertices = nullptr;
+	m_bufferIndices = nullptr;
+
+	return;
+}
+
+bool ModelClass::BuildSubsets(bool use16BitIndices)
+{
+	int i, k, start, minimum, maximum, triangleMinimum, triangleMaximum, maxSubsets;
 
 	/*
-	 * with the vertex array and index array filled out we can now use those to create the vertex buffer and index buffer.
-	 * creating both buffers is done in the same fashion.
-	 * first fill out a description of the buffer.
-	 * in the description the ByteWidth( size of the buffer) and the BindFlags (type of buffer) are what you need to ensure are filled out correctly.
-	 * after the description is filled out you need to also fill out a subresource pointer which will point to either your vertex or index array you previously created.
-	 * with the description and subresource pointer you can call create buffer using the d3d device and it will return a pointer to your new buffer.
+	 * small meshes are a single 16 bit subset.
+	 * bigger ones are cut in triangle order wherever the vertices used so far would no longer fit in 16 bits from the lowest one.
+	 * after MeshOptimizerClass the vertices are numbered in first use order so the windows barely overlap and the cuts are few.
+	 * if the cut still costs more than twice the draws an ideal split would, one 32 bit subset is cheaper.
+	 * so is a triangle that spans too many vertices on its own, no subset can hold it.
 	 */
+	maxSubsets = 2 * ((m_vertexCount + MAX_16BIT_VERTICES - 1) / MAX_16BIT_VERTICES);
 
-	// set up the description of the static vertex buffer.
-	vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	vertexBufferDesc.ByteWidth = sizeof(VertexType) * m_vertexCount;
-	vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	vertexBufferDesc.CPUAccessFlags = 0;
-	vertexBufferDesc.MiscFlags = 0;
-	vertexBufferDesc.StructureByteStride = 0;
+	m_subsets = MemoryClass::AllocateArray<SubsetType>(maxSubsets > 1 ? maxSubsets : 1, MEMORY_TAG_GEOMETRY);
+	if(!m_subsets)
+	{
+		return false;
+	}
 
-	// give the subresource structure a pointer to the vertex data.
-	vertexData.pSysMem = vertices;
-	vertexData.SysMemPitch = 0;
-	vertexData.SysMemSlicePitch = 0;
+	m_subsetCount = 0;
+	m_indexStride = sizeof(unsigned int);
 
-	// now create the vertex buffer.
-	result = device->CreateBuffer(&vertexBufferDesc, &vertexData, &m_vertexBuffer);
-	if(FAILED(result))
+	if(use16BitIndices && m_indexCount > 0)
 	{
-		return false;
+		start = 0;
+		minimum = maximum = (int)m_indexData[0];
+
+		for(i = 0; i <= m_indexCount; i += 3)
+		{
+			if(i < m_indexCount)
+			{
+				triangleMinimum = (int)m_indexData[i];
+				triangleMaximum = (int)m_indexData[i];
+				for(k = 1; k < 3; k++)
+				{
+					triangleMinimum = (int)m_indexData[i + k] < triangleMinimum ? (int)m_indexData[i + k] : triangleMinimum;
+					triangleMaximum = (int)m_indexData[i + k] > triangleMaximum ? (int)m_indexData[i + k] : triangleMaximum;
+				}
+
+				if(triangleMaximum - triangleMinimum >= MAX_16BIT_VERTICES)
+				{
+					m_subsetCount = 0;
+					break;
+				}
+
+				// still fits, grow the current subset.
+				if((triangleMaximum > maximum ? triangleMaximum : maximum) - (triangleMinimum < minimum ? triangleMinimum : minimum) < MAX_16BIT_VERTICES)
+				{
+					minimum = triangleMinimum < minimum ? triangleMinimum : minimum;
+					maximum = triangleMaximum > maximum ? triangleMaximum : maximum;
+					continue;
+				}
+			}
+
+			if(m_subsetCount == maxSubsets)
+			{
+				m_subsetCount = 0;
+				break;
+			}
+
+			m_subsets[m_subsetCount].indexCount = i - start;
+			m_subsets[m_subsetCount].startIndex = start;
+			m_subsets[m_subsetCount].baseVertex = minimum;
+			m_subsetCount++;
+
+			if(i < m_indexCount)
+			{
+				start = i;
+				minimum = triangleMinimum;
+				maximum = triangleMaximum;
+			}
+		}
+
+		if(m_subsetCount > 0)
+		{
+			m_indexStride = sizeof(unsigned short);
+			return true;
+		}
 	}
 
-	// set up the description of the static index buffer.
-	indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	indexBufferDesc.ByteWidth = sizeof(unsigned long) * m_indexCount;
-	indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	indexBufferDesc.CPUAccessFlags = 0;
-	indexBufferDesc.MiscFlags = 0;
-	indexBufferDesc.StructureByteStride = 0;
+	m_subsets[0].indexCount = m_indexCount;
+	m_subsets[0].startIndex = 0;
+	m_subsets[0].baseVertex = 0;
+	m_subsetCount = 1;
 
-	// give the sub resource
-	indexData.pSysMem = indices;
-	indexData.SysMemPitch = 0;
-	indexData.SysMemSlicePitch = 0;
+	return true;
+}
+
+void ModelClass::ComputeBounds()
+{
+	XMVECTOR minimum, maximum, position;
+	int i;
 
-	result = device->CreateBuffer(&indexBufferDesc, &indexData, &m_indexBuffer);
-	if(FAILED(result))
+	if(m_vertexCount <= 0)
+	{
+		return;
+	}
+
+	minimum = XMLoadFloat3(&m_vertexData[0].position);
+	maximum = minimum;
+	for(i = 1; i < m_vertexCount; i++)
+	{
+		position = XMLoadFloat3(&m_vertexData[i].position);
+		minimum = XMVectorMin(minimum, position);
+		maximum = XMVectorMax(maximum, position);
+	}
+
+	XMStoreFloat3(&m_boundsCenter, XMVectorScale(XMVectorAdd(minimum, maximum), 0.5f));
+	XMStoreFloat3(&m_boundsExtent, XMVectorScale(XMVectorSubtract(maximum, minimum), 0.5f));
+
+	return;
+}
+
+bool ModelClass::CopyOccluder()
+{
+	int i;
+
+	// a detailed mesh costs more to rasterize than it could save, those simply are not occluders.
+	if(m_indexCount / 3 > MODEL_OCCLUDER_MAX_TRIANGLES || m_vertexCount > m_indexCount)
+	{
+		return true;
+	}
+
+	m_occluderPositions = MemoryClass::AllocateArray<XMFLOAT3>(m_vertexCount, MEMORY_TAG_GEOMETRY);
+	if(!m_occluderPositions)
 	{
 		return false;
 	}
 
-	delete[] vertices;
-	vertices = nullptr;
+	m_occluderIndices = MemoryClass::AllocateArray<unsigned int>(m_indexCount, MEMORY_TAG_GEOMETRY);
+	if(!m_occluderIndices)
+	{
+		return false;
+	}
 
-	delete[] indices;
-	indices = nullptr;
+	for(i = 0; i < m_vertexCount; i++)
+	{
+		m_occluderPositions[i] = m_vertexData[i].position;
+	}
+	memcpy(m_occluderIndices, m_indexData, sizeof(unsigned int) * m_indexCount);
 
 	return true;
 }
 
-void ModelClass::ShutdownBuffers()
+bool ModelClass::PrepareBuffers()
+{
+	int i, k;
+	bool result;
+
+	/*
+	 * a compact vertex format and 16 bit indices are converted into arrays of their own here, off the render thread when streaming.
+	 * they are gone again with the rest of the system memory copy once the arena has them.
+	 */
+	if(m_vertexFormat != VERTEX_FORMAT_FLOAT)
+	{
+		m_encodedVertices = MemoryClass::AllocateArray<unsigned char>((size_t)VertexFormatClass::GetStride(m_vertexFormat) * m_vertexCount, MEMORY_TAG_GEOMETRY);
+		if(!m_encodedVertices)
+		{
+			return false;
+		}
+
+		result = VertexFormatClass::Encode(m_vertexFormat, m_vertexData, sizeof(VertexType), m_vertexCount, m_encodedVertices, m_dequantizeMatrix);
+		if(!result)
+		{
+			return false;
+		}
+	}
+
+	// 16 bit indices are rebased on their subset's base vertex.
+	if(m_indexStride == sizeof(unsigned short))
+	{
+		m_shortIndices = MemoryClass::AllocateArray<unsigned short>(m_indexCount, MEMORY_TAG_GEOMETRY);
+		if(!m_shortIndices)
+		{
+			return false;
+		}
+
+		for(i = 0; i < m_subsetCount; i++)
+		{
+			for(k = m_subsets[i].startIndex; k < m_subsets[i].startIndex + m_subsets[i].indexCount; k++)
+			{
+				m_shortIndices[k] = (unsigned short)(m_indexData[k] - (unsigned int)m_subsets[i].baseVertex);
+			}
+		}
+	}
+
+	m_bufferVertices = m_encodedVertices ? (const void*)m_encodedVertices : (const void*)m_vertexData;
+	m_bufferIndices = m_shortIndices ? (const void*)m_shortIndices : (const void*)m_indexData;
+
+	return true;
+}
+
+#ifdef _WIN32
+bool ModelClass::InitializeBuffers(GeometryArenaClass* geometry)
 {
-	if(m_indexBuffer)
+	bool result;
+
+	// a headless backend has no device, the software rasterizer reads the system memory copy instead.
+	if(!geometry)
 	{
-		m_indexBuffer->Release();
-		m_indexBuffer = nullptr;
+		return true;
 	}
 
-	if(m_vertexBuffer)
+	// the vertices and indices go into the shared geometry arena instead of buffers of our own, for a mesh file straight out of the mapped file.
+	result = geometry->Allocate(m_bufferVertices, VertexFormatClass::GetStride(m_vertexFormat), m_vertexCount,
+		m_bufferIndices, m_indexStride == sizeof(unsigned short) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT,
+		m_indexCount, m_allocation);
+	if(!result)
 	{
-		m_vertexBuffer->Release();
-		m_vertexBuffer = nullptr;
+		return false;
 	}
+
+	m_Geometry = geometry;
+
+	return true;
 }
 
-void ModelClass::RenderBuffers(ID3D11DeviceContext* deviceContext)
+void ModelClass::ShutdownBuffers()
+{
+	if(m_Geometry)
+	{
+		m_Geometry->Free(m_allocation);
+		m_Geometry = nullptr;
+		m_allocation = -1;
+	}
+
+	return;
+}
+
+void ModelClass::RenderBuffers(DeviceStateClass* deviceState)
+{
+	// nothing reaches the driver when the previous model used the same stride and index format.
+	m_Geometry->Bind(deviceState, m_allocation);
+	deviceState->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	return;
+}
+#else
+// without direct 3d there is never an arena, the software rasterizer reads the system memory copy.
+bool ModelClass::InitializeBuffers(GeometryArenaClass* geometry)
 {
-	unsigned int stride;
-	unsigned int offset;
+	return geometry == nullptr;
+}
 
-	stride = sizeof(VertexType);
-	offset = 0;
+void ModelClass::ShutdownBuffers()
+{
+	return;
+}
+#endif
 
-	deviceContext->IASetVertexBuffers(0, 1, &m_vertexBuffer, &stride, &offset);
-	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+void ModelClass::RenderBuffers(SoftwareCommandListClass* commandList)
+{
+	commandList->IASetVertexBuffer(m_vertexData, sizeof(VertexType), m_vertexCount);
+	commandList->IASetIndexBuffer(m_indexData);
 
 	return;
 }
@@ -2,10 +2,25 @@
 
 #ifndef _MODELCLASS_H_
 #define _MODELCLASS_H_
-#include <d3d11.h>
-#include <directxmath.h>
+#include <DirectXMath.h>
 using namespace DirectX;
 
+#include "meshfileclass.h"
+#include "meshimporterclass.h"
+#include "meshoptimizerclass.h"
+#include "vertexformatclass.h"
+#include "memoryclass.h"
+#include "softwarerasterizerclass.h"
+#include "softwarecommandlistclass.h"
+
+// forward declarations so the model can be loaded and drawn in software without the direct 3d headers.
+class GeometryArenaClass;
+class DeviceStateClass;
+class JobSystemClass;
+
+// models with at most this many triangles keep a copy of their positions to be drawn as occluders.
+const int MODEL_OCCLUDER_MAX_TRIANGLES = 512;
+
 class ModelClass
 {
 private:
@@ -15,25 +30,91 @@ private:
 		XMFLOAT4 color;
 	};
 
+	// a run of indices drawn with one DrawIndexed, 16 bit indices are relative to baseVertex.
+	struct SubsetType
+	{
+		int indexCount;
+		int startIndex;
+		int baseVertex;
+	};
+
 public :
 	ModelClass();
 	ModelClass(const ModelClass&);
 	~ModelClass();
 
-	bool Initialize(ID3D11Device* device);
+	bool Initialize(GeometryArenaClass* geometry, JobSystemClass* jobSystem, const char* modelFilename, unsigned int vertexFormat);
+	// Initialize in two halves. Load only touches system memory and is safe on a worker thread, Upload needs the device's thread.
+	// obj and gltf sources are parsed on jobSystem, or on the calling thread when it is null.
+	bool Load(const char* modelFilename, unsigned int vertexFormat, bool deviceBuffers, JobSystemClass* jobSystem);
+	bool Upload(GeometryArenaClass* geometry);
 	void Shutdown();
-	void Render(ID3D11DeviceContext* deviceContext);
+	void Render(DeviceStateClass* deviceState);
+	void Render(SoftwareCommandListClass* commandList);
 
 	int GetIndexCount();
+	int GetSubsetCount();
+	void GetSubset(int subset, int& indexCount, int& startIndex, int& baseVertex);
+	unsigned int GetVertexFormat();
+	void GetDequantizeMatrix(XMMATRIX& dequantizeMatrix);
+	// axis aligned box around the model space positions.
+	void GetBounds(XMFLOAT3& center, XMFLOAT3& extent);
+	// model space triangles for the occlusion culler, false when the model is too detailed to be one.
+	bool GetOccluder(const XMFLOAT3*& positions, int& vertexCount, const unsigned int*& indices, int& indexCount);
 
 private:
-	bool InitializeBuffers(ID3D11Device* device);
+	bool LoadModel(const char* filename, bool deviceBuffers, JobSystemClass* jobSystem, std::string& deviceFilename, bool& deviceReady);
+	bool OpenDeviceModel(const char* filename);
+	bool MapDeviceModel();
+	bool SaveDeviceModel(const char* filename);
+	bool OptimizeModel();
+	bool CreateTriangle();
+	void ReleaseModel();
+	bool BuildSubsets(bool use16BitIndices);
+	void ComputeBounds();
+	bool CopyOccluder();
+
+	bool PrepareBuffers();
+	bool InitializeBuffers(GeometryArenaClass* geometry);
 	void ShutdownBuffers();
-	void RenderBuffers(ID3D11DeviceContext* deviceContext);
+	void RenderBuffers(DeviceStateClass* deviceState);
+	void RenderBuffers(SoftwareCommandListClass* commandList);
 
 private:
-	ID3D11Buffer* m_vertexBuffer, * m_indexBuffer;
+	// the model's ranges in the shared vertex and index buffers.
+	GeometryArenaClass* m_Geometry;
+	int m_allocation;
 	int m_vertexCount, m_indexCount;
+
+	// 2 byte indices when every subset spans at most 65536 vertices, otherwise a single 4 byte subset.
+	unsigned int m_indexStride;
+	SubsetType* m_subsets;
+	int m_subsetCount;
+
+	// the format the vertex buffer is stored in and the matrix that takes its positions back to model space.
+	unsigned int m_vertexFormat;
+	XMMATRIX m_dequantizeMatrix;
+	XMFLOAT3 m_boundsCenter, m_boundsExtent;
+
+	// outlives the system memory copy, the occlusion culler needs it every frame.
+	XMFLOAT3* m_occluderPositions;
+	unsigned int* m_occluderIndices;
+
+	// the system memory copy, either the mapped mesh file or the built in triangle.
+	// without a device it is kept around for the software rasterizer.
+	MeshFileClass* m_MeshFile;
+	VertexType* m_vertices;
+	unsigned int* m_indices;
+	const VertexType* m_vertexData;
+	const unsigned int* m_indexData;
+
+	// the buffer contents in their gpu formats, when they differ from the system memory copy.
+	unsigned char* m_encodedVertices;
+	unsigned short* m_shortIndices;
+
+	// what goes into the buffers, the mapped sections of a file cooked for them or one of the copies above.
+	const void* m_bufferVertices;
+	const void* m_bufferIndices;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,547 @@
+#include "occlusioncullerclass.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+
+// rows of the depth buffer rasterized by one job.
+static const int BAND_HEIGHT = 8;
+// objects tested by one job.
+static const int TEST_RANGE_SIZE = 1024;
+// the clock is only looked at every this many objects.
+static const int BUDGET_CHECK_INTERVAL = 64;
+// clip space w below this counts as touching the camera.
+static const float NEAR_W = 1e-5f;
+
+#if defined(__AVX2__)
+
+#define SIMD_WIDTH 8
+
+typedef __m256 SimdFloat;
+
+static inline SimdFloat SimdSet(float value) { return _mm256_set1_ps(value); }
+static inline SimdFloat SimdLaneCenters() { return _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f); }
+static inline SimdFloat SimdLoad(const float* p) { return _mm256_loadu_ps(p); }
+static inline void SimdStore(float* p, SimdFloat a) { _mm256_storeu_ps(p, a); }
+static inline SimdFloat SimdAdd(SimdFloat a, SimdFloat b) { return _mm256_add_ps(a, b); }
+static inline SimdFloat SimdMul(SimdFloat a, SimdFloat b) { return _mm256_mul_ps(a, b); }
+static inline SimdFloat SimdMin(SimdFloat a, SimdFloat b) { return _mm256_min_ps(a, b); }
+static inline SimdFloat SimdOr(SimdFloat a, SimdFloat b) { return _mm256_or_ps(a, b); }
+static inline SimdFloat SimdLess(SimdFloat a, SimdFloat b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline SimdFloat SimdSelect(SimdFloat mask, SimdFloat a, SimdFloat b) { return _mm256_blendv_ps(b, a, mask); }
+
+#else
+
+#define SIMD_WIDTH 4
+
+typedef __m128 SimdFloat;
+
+static inline SimdFloat SimdSet(float value) { return _mm_set1_ps(value); }
+static inline SimdFloat SimdLaneCenters() { return _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f); }
+static inline SimdFloat SimdLoad(const float* p) { return _mm_loadu_ps(p); }
+static inline void SimdStore(float* p, SimdFloat a) { _mm_storeu_ps(p, a); }
+static inline SimdFloat SimdAdd(SimdFloat a, SimdFloat b) { return _mm_add_ps(a, b); }
+static inline SimdFloat SimdMul(SimdFloat a, SimdFloat b) { return _mm_mul_ps(a, b); }
+static inline SimdFloat SimdMin(SimdFloat a, SimdFloat b) { return _mm_min_ps(a, b); }
+static inline SimdFloat SimdOr(SimdFloat a, SimdFloat b) { return _mm_or_ps(a, b); }
+static inline SimdFloat SimdLess(SimdFloat a, SimdFloat b) { return _mm_cmplt_ps(a, b); }
+static inline SimdFloat SimdSelect(SimdFloat mask, SimdFloat a, SimdFloat b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+
+#endif
+
+OcclusionCullerClass::OcclusionCullerClass()
+{
+	m_width = 0;
+	m_height = 0;
+	m_depth = nullptr;
+	m_levelCount = 0;
+	m_viewProjectionMatrix = XMMatrixIdentity();
+	m_budget = std::chrono::duration<double, std::milli>(0.0);
+	m_overBudget = false;
+	memset(&m_statistics, 0, sizeof(m_statistics));
+	m_bounds.count = 0;
+	m_objects = nullptr;
+	m_objectCount = 0;
+	m_jobSystem = nullptr;
+}
+
+OcclusionCullerClass::OcclusionCullerClass(const OcclusionCullerClass&)
+{
+}
+
+OcclusionCullerClass::~OcclusionCullerClass()
+{
+}
+
+bool OcclusionCullerClass::Initialize(int width, int height, JobSystemClass* jobSystem, float budget)
+{
+	int size, level, i;
+
+	// powers of two so every pyramid level halves evenly, and rows a whole number of registers wide.
+	if(!jobSystem || width < SIMD_WIDTH || height < 1 || (width & (width - 1)) != 0 || (height & (height - 1)) != 0)
+	{
+		return false;
+	}
+
+	m_jobSystem = jobSystem;
+	m_width = width;
+	m_height = height;
+	m_budget = std::chrono::duration<double, std::milli>(budget);
+
+	size = 0;
+	for(level = 0; level < 16; level++)
+	{
+		m_levelOffsets[level] = size;
+		m_levelWidths[level] = width >> level > 1 ? width >> level : 1;
+		m_levelHeights[level] = height >> level > 1 ? height >> level : 1;
+		size += m_levelWidths[level] * m_levelHeights[level];
+
+		if(m_levelWidths[level] == 1 && m_levelHeights[level] == 1)
+		{
+			break;
+		}
+	}
+	m_levelCount = level + 1;
+
+	m_depth = MemoryClass::AllocateArray<float>(size, MEMORY_TAG_CULLING);
+	if(!m_depth)
+	{
+		return false;
+	}
+
+	for(i = 0; i < size; i++)
+	{
+		m_depth[i] = 1.0f;
+	}
+
+	return true;
+}
+
+void OcclusionCullerClass::Shutdown()
+{
+	if(m_depth)
+	{
+		MemoryClass::FreeArray(m_depth);
+		m_depth = nullptr;
+	}
+
+	m_jobSystem = nullptr;
+
+	return;
+}
+
+void OcclusionCullerClass::BeginFrame(const XMMATRIX& viewMatrix, const XMMATRIX& projectionMatrix)
+{
+	int i;
+
+	m_frameStart = std::chrono::steady_clock::now();
+	m_overBudget = false;
+	memset(&m_statistics, 0, sizeof(m_statistics));
+
+	m_viewProjectionMatrix = XMMatrixMultiply(viewMatrix, projectionMatrix);
+	m_triangles.clear();
+
+	// the far plane, nothing is hidden until an occluder is drawn.
+	for(i = 0; i < m_width * m_height; i++)
+	{
+		m_depth[i] = 1.0f;
+	}
+
+	return;
+}
+
+void OcclusionCullerClass::AddOccluder(const XMFLOAT3* positions, int vertexCount, const unsigned int* indices, int indexCount, const XMMATRIX& worldMatrix)
+{
+	XMMATRIX matrix;
+	TriangleType triangle;
+	const XMFLOAT4* clip[3];
+	float x[3], y[3], z[3], determinant, sign, minX, maxX, minY, maxY;
+	int i, k, a, b;
+	bool skip;
+
+	if(OverBudget())
+	{
+		return;
+	}
+
+	matrix = XMMatrixMultiply(worldMatrix, m_viewProjectionMatrix);
+
+	m_clipVertices.resize((size_t)vertexCount);
+	for(i = 0; i < vertexCount; i++)
+	{
+		XMStoreFloat4(&m_clipVertices[i], XMVector3Transform(XMLoadFloat3(&positions[i]), matrix));
+	}
+
+	for(i = 0; i + 2 < indexCount; i += 3)
+	{
+		skip = false;
+		for(k = 0; k < 3; k++)
+		{
+			if(indices[i + k] >= (unsigned int)vertexCount)
+			{
+				skip = true;
+				break;
+			}
+
+			clip[k] = &m_clipVertices[indices[i + k]];
+
+			// clipping against the near plane is not worth it here, an occluder missing a triangle only hides less.
+			if(clip[k]->w < NEAR_W || clip[k]->z < 0.0f)
+			{
+				skip = true;
+				break;
+			}
+
+			x[k] = (clip[k]->x / clip[k]->w * 0.5f + 0.5f) * m_width;
+			y[k] = (0.5f - clip[k]->y / clip[k]->w * 0.5f) * m_height;
+			z[k] = clip[k]->z / clip[k]->w;
+		}
+		if(skip)
+		{
+			continue;
+		}
+
+		determinant = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+		if(fabsf(determinant) < 1e-8f)
+		{
+			continue;
+		}
+
+		// pixel centers inside the bounding box, clamped to the screen.
+		minX = fminf(x[0], fminf(x[1], x[2]));
+		maxX = fmaxf(x[0], fmaxf(x[1], x[2]));
+		minY = fminf(y[0], fminf(y[1], y[2]));
+		maxY = fmaxf(y[0], fmaxf(y[1], y[2]));
+		if(maxX < 0.5f || maxY < 0.5f || minX > m_width - 0.5f || minY > m_height - 0.5f)
+		{
+			continue;
+		}
+
+		triangle.minX = minX < 0.0f ? 0 : (int)minX;
+		triangle.maxX = maxX >= (float)m_width ? m_width - 1 : (int)maxX;
+		triangle.minY = minY < 0.0f ? 0 : (int)minY;
+		triangle.maxY = maxY >= (float)m_height ? m_height - 1 : (int)maxY;
+
+		// edge k runs between the two other vertices and is positive on the side of vertex k whichever way the triangle winds.
+		sign = determinant > 0.0f ? 1.0f : -1.0f;
+		for(k = 0; k < 3; k++)
+		{
+			a = (k + 1) % 3;
+			b = (k + 2) % 3;
+			triangle.edgeA[k] = (y[a] - y[b]) * sign;
+			triangle.edgeB[k] = (x[b] - x[a]) * sign;
+			triangle.edgeC[k] = ((y[b] - y[a]) * x[a] - (x[b] - x[a]) * y[a]) * sign;
+		}
+
+		// z over w is linear across the screen.
+		triangle.depthA = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / determinant;
+		triangle.depthB = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / determinant;
+		triangle.depthC = z[0] - triangle.depthA * x[0] - triangle.depthB * y[0];
+
+		m_triangles.push_back(triangle);
+	}
+
+	m_statistics.occluders++;
+
+	return;
+}
+
+void OcclusionCullerClass::RasterizeOccluders()
+{
+	RunParallel((m_height + BAND_HEIGHT - 1) / BAND_HEIGHT, &OcclusionCullerClass::RasterizeBand);
+	BuildPyramid();
+
+	m_statistics.triangles = (int)m_triangles.size();
+
+	return;
+}
+
+int OcclusionCullerClass::CullObjects(SceneClass* scene, int* objects, int count)
+{
+	int rangeCount, range, visible;
+
+	scene->GetBounds(m_bounds);
+	m_objects = objects;
+	m_objectCount = count;
+
+	rangeCount = (count + TEST_RANGE_SIZE - 1) / TEST_RANGE_SIZE;
+	m_rangeVisible.resize((size_t)rangeCount);
+	m_rangeOccluded.resize((size_t)rangeCount);
+	m_rangeUntested.resize((size_t)rangeCount);
+
+	RunParallel(rangeCount, &OcclusionCullerClass::TestRange);
+
+	// every range packed its survivors at its own start, now pack the ranges.
+	visible = 0;
+	for(range = 0; range < rangeCount; range++)
+	{
+		memmove(objects + visible, objects + (size_t)range * TEST_RANGE_SIZE, sizeof(int) * (size_t)m_rangeVisible[range]);
+		visible += m_rangeVisible[range];
+
+		m_statistics.occluded += m_rangeOccluded[range];
+		m_statistics.untested += m_rangeUntested[range];
+	}
+
+	m_statistics.tested = count - m_statistics.untested;
+	m_statistics.cullRate = m_statistics.tested > 0 ? (float)m_statistics.occluded / m_statistics.tested : 0.0f;
+	m_statistics.milliseconds = (float)std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_frameStart).count();
+	m_statistics.overBudget = m_overBudget.load();
+
+	return visible;
+}
+
+void OcclusionCullerClass::GetStatistics(StatisticsType& statistics)
+{
+	statistics = m_statistics;
+	return;
+}
+
+bool OcclusionCullerClass::OverBudget()
+{
+	if(m_overBudget.load(std::memory_order_relaxed))
+	{
+		return true;
+	}
+
+	if(std::chrono::steady_clock::now() - m_frameStart > m_budget)
+	{
+		m_overBudget.store(true, std::memory_order_relaxed);
+		return true;
+	}
+
+	return false;
+}
+
+bool OcclusionCullerClass::TestBox(const XMFLOAT3& center, const XMFLOAT3& extent)
+{
+	XMVECTOR middle, axisX, axisY, axisZ, corner;
+	XMFLOAT4 clip;
+	float minX, maxX, minY, maxY, minDepth, screenX, screenY, maxDepth;
+	int i, x0, x1, y0, y1, level, size, x, y;
+	const float* texels;
+
+	// the eight corners are the projected center plus or minus the projected half axes.
+	middle = XMVector3Transform(XMLoadFloat3(&center), m_viewProjectionMatrix);
+	axisX = XMVectorScale(m_viewProjectionMatrix.r[0], extent.x);
+	axisY = XMVectorScale(m_viewProjectionMatrix.r[1], extent.y);
+	axisZ = XMVectorScale(m_viewProjectionMatrix.r[2], extent.z);
+
+	minX = minY = minDepth = 3.0e38f;
+	maxX = maxY = -3.0e38f;
+	for(i = 0; i < 8; i++)
+	{
+		corner = XMVectorAdd(middle, (i & 1) ? axisX : XMVectorNegate(axisX));
+		corner = XMVectorAdd(corner, (i & 2) ? axisY : XMVectorNegate(axisY));
+		corner = XMVectorAdd(corner, (i & 4) ? axisZ : XMVectorNegate(axisZ));
+		XMStoreFloat4(&clip, corner);
+
+		// a box reaching behind the near plane is too close to be hidden.
+		if(clip.w < NEAR_W || clip.z < 0.0f)
+		{
+			return true;
+		}
+
+		screenX = (clip.x / clip.w * 0.5f + 0.5f) * m_width;
+		screenY = (0.5f - clip.y / clip.w * 0.5f) * m_height;
+		minX = fminf(minX, screenX);
+		maxX = fmaxf(maxX, screenX);
+		minY = fminf(minY, screenY);
+		maxY = fmaxf(maxY, screenY);
+		minDepth = fminf(minDepth, clip.z / clip.w);
+	}
+
+	// off the depth buffer, the frustum test let it through so it is kept.
+	if(maxX < 0.0f || maxY < 0.0f || minX >= (float)m_width || minY >= (float)m_height)
+	{
+		return true;
+	}
+
+	x0 = minX < 0.0f ? 0 : (int)minX;
+	x1 = maxX >= (float)m_width ? m_width - 1 : (int)maxX;
+	y0 = minY < 0.0f ? 0 : (int)minY;
+	y1 = maxY >= (float)m_height ? m_height - 1 : (int)maxY;
+
+	// the level where one texel is at least as wide as the rectangle, which then touches at most 2x2 texels.
+	size = (x1 - x0 > y1 - y0 ? x1 - x0 : y1 - y0) + 1;
+	level = 0;
+	while((1 << level) < size && level < m_levelCount - 1)
+	{
+		level++;
+	}
+
+	texels = m_depth + m_levelOffsets[level];
+	maxDepth = 0.0f;
+	for(y = y0 >> level; y <= (y1 >> level) && y < m_levelHeights[level]; y++)
+	{
+		for(x = x0 >> level; x <= (x1 >> level) && x < m_levelWidths[level]; x++)
+		{
+			maxDepth = fmaxf(maxDepth, texels[y * m_levelWidths[level] + x]);
+		}
+	}
+
+	return minDepth <= maxDepth;
+}
+
+void OcclusionCullerClass::BuildPyramid()
+{
+	const float* source;
+	float* destination;
+	int level, x, y, sourceWidth, sourceHeight, width, height, x0, x1, y0, y1;
+
+	for(level = 1; level < m_levelCount; level++)
+	{
+		source = m_depth + m_levelOffsets[level - 1];
+		destination = m_depth + m_levelOffsets[level];
+		sourceWidth = m_levelWidths[level - 1];
+		sourceHeight = m_levelHeights[level - 1];
+		width = m_levelWidths[level];
+		height = m_levelHeights[level];
+
+		for(y = 0; y < height; y++)
+		{
+			y0 = y * 2 < sourceHeight ? y * 2 : sourceHeight - 1;
+			y1 = y * 2 + 1 < sourceHeight ? y * 2 + 1 : sourceHeight - 1;
+			x = 0;
+
+			// four texels out of two rows of eight, the even and odd columns are split apart with a shuffle.
+			if(sourceWidth == width * 2)
+			{
+				for(; x + 4 <= width; x += 4)
+				{
+					__m128 top0, top1, bottom0, bottom1, maximum0, maximum1;
+
+					top0 = _mm_loadu_ps(source + y0 * sourceWidth + x * 2);
+					top1 = _mm_loadu_ps(source + y0 * sourceWidth + x * 2 + 4);
+					bottom0 = _mm_loadu_ps(source + y1 * sourceWidth + x * 2);
+					bottom1 = _mm_loadu_ps(source + y1 * sourceWidth + x * 2 + 4);
+					maximum0 = _mm_max_ps(top0, bottom0);
+					maximum1 = _mm_max_ps(top1, bottom1);
+					_mm_storeu_ps(destination + y * width + x,
+						_mm_max_ps(_mm_shuffle_ps(maximum0, maximum1, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(maximum0, maximum1, _MM_SHUFFLE(3, 1, 3, 1))));
+				}
+			}
+
+			for(; x < width; x++)
+			{
+				x0 = x * 2 < sourceWidth ? x * 2 : sourceWidth - 1;
+				x1 = x * 2 + 1 < sourceWidth ? x * 2 + 1 : sourceWidth - 1;
+				destination[y * width + x] = fmaxf(fmaxf(source[y0 * sourceWidth + x0], source[y0 * sourceWidth + x1]),
+					fmaxf(source[y1 * sourceWidth + x0], source[y1 * sourceWidth + x1]));
+			}
+		}
+	}
+
+	return;
+}
+
+void OcclusionCullerClass::RasterizeBand(int band)
+{
+	SimdFloat laneCenters, pixelX, pixelY, edge0, edge1, edge2, depth, stored, outside, zero;
+	float* row;
+	int bandTop, bandBottom, i, x, y, minY, maxY, minX;
+
+	bandTop = band * BAND_HEIGHT;
+	bandBottom = bandTop + BAND_HEIGHT - 1 < m_height - 1 ? bandTop + BAND_HEIGHT - 1 : m_height - 1;
+	laneCenters = SimdLaneCenters();
+	zero = SimdSet(0.0f);
+
+	for(i = 0; i < (int)m_triangles.size(); i++)
+	{
+		const TriangleType& triangle = m_triangles[i];
+
+		// the band stops drawing once the budget is spent, its part of the buffer is just less covered.
+		if(OverBudget())
+		{
+			break;
+		}
+
+		minY = triangle.minY > bandTop ? triangle.minY : bandTop;
+		maxY = triangle.maxY < bandBottom ? triangle.maxY : bandBottom;
+		minX = triangle.minX & ~(SIMD_WIDTH - 1);
+
+		for(y = minY; y <= maxY; y++)
+		{
+			row = m_depth + y * m_width;
+			pixelY = SimdSet(y + 0.5f);
+
+			// rows are a multiple of the register width, so the aligned start never runs past the end.
+			for(x = minX; x <= triangle.maxX; x += SIMD_WIDTH)
+			{
+				pixelX = SimdAdd(SimdSet((float)x), laneCenters);
+
+				edge0 = SimdAdd(SimdAdd(SimdMul(SimdSet(triangle.edgeA[0]), pixelX), SimdMul(SimdSet(triangle.edgeB[0]), pixelY)), SimdSet(triangle.edgeC[0]));
+				edge1 = SimdAdd(SimdAdd(SimdMul(SimdSet(triangle.edgeA[1]), pixelX), SimdMul(SimdSet(triangle.edgeB[1]), pixelY)), SimdSet(triangle.edgeC[1]));
+				edge2 = SimdAdd(SimdAdd(SimdMul(SimdSet(triangle.edgeA[2]), pixelX), SimdMul(SimdSet(triangle.edgeB[2]), pixelY)), SimdSet(triangle.edgeC[2]));
+				outside = SimdOr(SimdOr(SimdLess(edge0, zero), SimdLess(edge1, zero)), SimdLess(edge2, zero));
+
+				depth = SimdAdd(SimdAdd(SimdMul(SimdSet(triangle.depthA), pixelX), SimdMul(SimdSet(triangle.depthB), pixelY)), SimdSet(triangle.depthC));
+				stored = SimdLoad(row + x);
+				SimdStore(row + x, SimdSelect(outside, stored, SimdMin(stored, depth)));
+			}
+		}
+	}
+
+	return;
+}
+
+void OcclusionCullerClass::TestRange(int range)
+{
+	int first, last, i, object, visible, occluded, untested;
+	bool overBudget;
+
+	first = range * TEST_RANGE_SIZE;
+	last = first + TEST_RANGE_SIZE < m_objectCount ? first + TEST_RANGE_SIZE : m_objectCount;
+	visible = 0;
+	occluded = 0;
+	untested = 0;
+	overBudget = false;
+
+	for(i = first; i < last; i++)
+	{
+		object = m_objects[i];
+
+		if((i - first) % BUDGET_CHECK_INTERVAL == 0)
+		{
+			overBudget = OverBudget();
+		}
+
+		// survivors are written back over the list, never ahead of the object being read.
+		if(overBudget)
+		{
+			untested++;
+		} else if(!TestBox(XMFLOAT3(m_bounds.centerX[object], m_bounds.centerY[object], m_bounds.centerZ[object]),
+			XMFLOAT3(m_bounds.extentX[object], m_bounds.extentY[object], m_bounds.extentZ[object])))
+		{
+			occluded++;
+			continue;
+		}
+
+		m_objects[first + visible++] = object;
+	}
+
+	m_rangeVisible[range] = visible;
+	m_rangeOccluded[range] = occluded;
+	m_rangeUntested[range] = untested;
+
+	return;
+}
+
+void OcclusionCullerClass::RunParallel(int jobCount, void (OcclusionCullerClass::*job)(int))
+{
+	m_jobSystem->ParallelFor(jobCount, 1, [this, job](int first, int last)
+	{
+		int i;
+
+		for(i = first; i < last; i++)
+		{
+			(this->*job)(i);
+		}
+	});
+
+	return;
+}
@@ -0,0 +1,106 @@
+#pragma once
+#ifndef _OCCLUSIONCULLERCLASS_H_
+#define _OCCLUSIONCULLERCLASS_H_
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include <DirectXMath.h>
+using namespace DirectX;
+
+#include "jobsystemclass.h"
+#include "memoryclass.h"
+#include "sceneclass.h"
+
+/*
+ * occlusion culling on the cpu.
+ * a handful of simple occluder meshes are rasterized into a small depth buffer, in horizontal bands that run as jobs and
+ * 8 pixels at a time with AVX2 or 4 with SSE2. a max depth pyramid is built on top of it, so an object's screen rectangle is compared
+ * against at most 2x2 texels of the level where one texel is as big as the rectangle.
+ * everything is conservative: triangles crossing the near plane are not drawn, boxes crossing it are kept,
+ * and whatever the frame's time budget did not cover stays visible.
+ */
+class OcclusionCullerClass
+{
+public:
+	struct StatisticsType
+	{
+		int occluders;
+		int triangles;
+		int tested;
+		int occluded;
+		// kept without a test because the budget ran out.
+		int untested;
+		// occluded over tested.
+		float cullRate;
+		float milliseconds;
+		bool overBudget;
+	};
+
+public:
+	OcclusionCullerClass();
+	OcclusionCullerClass(const OcclusionCullerClass&);
+	~OcclusionCullerClass();
+
+	// width and height are powers of two, the budget is in milliseconds per frame.
+	bool Initialize(int width, int height, JobSystemClass* jobSystem, float budget);
+	void Shutdown();
+
+	void BeginFrame(const XMMATRIX& viewMatrix, const XMMATRIX& projectionMatrix);
+	// occluders are best added nearest first, once the budget is spent the rest are ignored.
+	void AddOccluder(const XMFLOAT3* positions, int vertexCount, const unsigned int* indices, int indexCount, const XMMATRIX& worldMatrix);
+	void RasterizeOccluders();
+	// drops the hidden objects from the list, the rest keep their order. returns how many are left.
+	int CullObjects(SceneClass* scene, int* objects, int count);
+
+	void GetStatistics(StatisticsType& statistics);
+
+private:
+	// edge functions and depth plane in pixel coordinates, inside is where all three edges are positive.
+	struct TriangleType
+	{
+		float edgeA[3], edgeB[3], edgeC[3];
+		float depthA, depthB, depthC;
+		int minX, maxX, minY, maxY;
+	};
+
+	bool OverBudget();
+	bool TestBox(const XMFLOAT3& center, const XMFLOAT3& extent);
+	void BuildPyramid();
+
+	void RasterizeBand(int band);
+	void TestRange(int range);
+
+	void RunParallel(int jobCount, void (OcclusionCullerClass::*job)(int));
+
+private:
+	int m_width, m_height;
+	// level 0 is the depth buffer, every level after it holds the max of 2x2 texels of the one before.
+	float* m_depth;
+	int m_levelCount;
+	int m_levelOffsets[16];
+	int m_levelWidths[16];
+	int m_levelHeights[16];
+
+	XMMATRIX m_viewProjectionMatrix;
+	std::vector<TriangleType> m_triangles;
+	std::vector<XMFLOAT4> m_clipVertices;
+
+	std::chrono::duration<double, std::milli> m_budget;
+	std::chrono::steady_clock::time_point m_frameStart;
+	std::atomic<bool> m_overBudget;
+	StatisticsType m_statistics;
+
+	// the cull in flight, every range keeps its survivors in place and counts for itself.
+	SceneClass::BoundsType m_bounds;
+	int* m_objects;
+	int m_objectCount;
+	std::vector<int> m_rangeVisible;
+	std::vector<int> m_rangeOccluded;
+	std::vector<int> m_rangeUntested;
+
+	JobSystemClass* m_jobSystem;
+};
+
+#endif
@@ -0,0 +1,555 @@
+#include "pipelinestateclass.h"
+
+#include <cstring>
+
+// same hash the shader cache keys with.
+static unsigned long long HashBytes(const char* data, size_t size, unsigned long long seed)
+{
+	const unsigned long long prime1 = 0x9E3779B185EBCA87ULL;
+	const unsigned long long prime2 = 0xC2B2AE3D27D4EB4FULL;
+	unsigned long long lanes[4], word, hash;
+	size_t i;
+	int k;
+
+	lanes[0] = seed + prime1 + prime2;
+	lanes[1] = seed + prime2;
+	lanes[2] = seed;
+	lanes[3] = seed - prime1;
+
+	for(i = 0; i + 32 <= size; i += 32)
+	{
+		for(k = 0; k < 4; k++)
+		{
+			memcpy(&word, data + i + k * 8, 8);
+			lanes[k] += word * prime2;
+			lanes[k] = (lanes[k] << 31) | (lanes[k] >> 33);
+			lanes[k] *= prime1;
+		}
+	}
+
+	hash = lanes[0] ^ ((lanes[1] << 7) | (lanes[1] >> 57)) ^ ((lanes[2] << 12) | (lanes[2] >> 52)) ^ ((lanes[3] << 18) | (lanes[3] >> 46));
+	hash += (unsigned long long)size;
+
+	for(; i < size; i++)
+	{
+		hash = (hash ^ (unsigned char)data[i]) * prime1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDULL;
+	hash ^= hash >> 33;
+	hash *= 0xC4CEB9FE1A85EC53ULL;
+	hash ^= hash >> 33;
+
+	return hash;
+}
+
+static void AppendBytes(std::string& key, const void* data, size_t size)
+{
+	key.append((const char*)data, size);
+	return;
+}
+
+/*
+ * the keys are built a field at a time, the descriptions have padding after their byte sized members
+ * and whatever the caller left in it must not make two equal states look different.
+ */
+static void BuildRasterizerKey(const D3D11_RASTERIZER_DESC& desc, std::string& key)
+{
+	key.clear();
+	AppendBytes(key, &desc.FillMode, sizeof(desc.FillMode));
+	AppendBytes(key, &desc.CullMode, sizeof(desc.CullMode));
+	AppendBytes(key, &desc.FrontCounterClockwise, sizeof(desc.FrontCounterClockwise));
+	AppendBytes(key, &desc.DepthBias, sizeof(desc.DepthBias));
+	AppendBytes(key, &desc.DepthBiasClamp, sizeof(desc.DepthBiasClamp));
+	AppendBytes(key, &desc.SlopeScaledDepthBias, sizeof(desc.SlopeScaledDepthBias));
+	AppendBytes(key, &desc.DepthClipEnable, sizeof(desc.DepthClipEnable));
+	AppendBytes(key, &desc.ScissorEnable, sizeof(desc.ScissorEnable));
+	AppendBytes(key, &desc.MultisampleEnable, sizeof(desc.MultisampleEnable));
+	AppendBytes(key, &desc.AntialiasedLineEnable, sizeof(desc.AntialiasedLineEnable));
+	return;
+}
+
+static void AppendStencilOp(std::string& key, const D3D11_DEPTH_STENCILOP_DESC& desc)
+{
+	AppendBytes(key, &desc.StencilFailOp, sizeof(desc.StencilFailOp));
+	AppendBytes(key, &desc.StencilDepthFailOp, sizeof(desc.StencilDepthFailOp));
+	AppendBytes(key, &desc.StencilPassOp, sizeof(desc.StencilPassOp));
+	AppendBytes(key, &desc.StencilFunc, sizeof(desc.StencilFunc));
+	return;
+}
+
+static void BuildDepthStencilKey(const D3D11_DEPTH_STENCIL_DESC& desc, std::string& key)
+{
+	key.clear();
+	AppendBytes(key, &desc.DepthEnable, sizeof(desc.DepthEnable));
+	AppendBytes(key, &desc.DepthWriteMask, sizeof(desc.DepthWriteMask));
+	AppendBytes(key, &desc.DepthFunc, sizeof(desc.DepthFunc));
+	AppendBytes(key, &desc.StencilEnable, sizeof(desc.StencilEnable));
+	AppendBytes(key, &desc.StencilReadMask, sizeof(desc.StencilReadMask));
+	AppendBytes(key, &desc.StencilWriteMask, sizeof(desc.StencilWriteMask));
+	AppendStencilOp(key, desc.FrontFace);
+	AppendStencilOp(key, desc.BackFace);
+	return;
+}
+
+static void BuildBlendKey(const D3D11_BLEND_DESC& desc, std::string& key)
+{
+	const D3D11_RENDER_TARGET_BLEND_DESC* target;
+	int i, targetCount;
+
+	key.clear();
+	AppendBytes(key, &desc.AlphaToCoverageEnable, sizeof(desc.AlphaToCoverageEnable));
+	AppendBytes(key, &desc.IndependentBlendEnable, sizeof(desc.IndependentBlendEnable));
+
+	// without independent blending only the first target is read, the other seven are whatever the caller left there.
+	targetCount = desc.IndependentBlendEnable ? 8 : 1;
+	for(i = 0; i < targetCount; i++)
+	{
+		target = &desc.RenderTarget[i];
+		AppendBytes(key, &target->BlendEnable, sizeof(target->BlendEnable));
+		AppendBytes(key, &target->SrcBlend, sizeof(target->SrcBlend));
+		AppendBytes(key, &target->DestBlend, sizeof(target->DestBlend));
+		AppendBytes(key, &target->BlendOp, sizeof(target->BlendOp));
+		AppendBytes(key, &target->SrcBlendAlpha, sizeof(target->SrcBlendAlpha));
+		AppendBytes(key, &target->DestBlendAlpha, sizeof(target->DestBlendAlpha));
+		AppendBytes(key, &target->BlendOpAlpha, sizeof(target->BlendOpAlpha));
+		AppendBytes(key, &target->RenderTargetWriteMask, sizeof(target->RenderTargetWriteMask));
+	}
+
+	return;
+}
+
+// shaders are keyed by their bytecode's size and hash rather than the whole blob.
+static void BuildBytecodeKey(const void* bytecode, unsigned long long bytecodeSize, std::string& key)
+{
+	unsigned long long hashes[2];
+
+	hashes[0] = HashBytes((const char*)bytecode, (size_t)bytecodeSize, 0x5049504553544154ULL);
+	hashes[1] = HashBytes((const char*)bytecode, (size_t)bytecodeSize, 0x4458313142595445ULL);
+
+	key.clear();
+	AppendBytes(key, &bytecodeSize, sizeof(bytecodeSize));
+	AppendBytes(key, hashes, sizeof(hashes));
+	return;
+}
+
+// the layout is validated against the vertex shader's input signature, so the shader is part of its key.
+static void BuildInputLayoutKey(const D3D11_INPUT_ELEMENT_DESC* elements, unsigned int elementCount, const void* bytecode,
+	unsigned long long bytecodeSize, std::string& key)
+{
+	std::string shaderKey;
+	unsigned int i, length;
+
+	BuildBytecodeKey(bytecode, bytecodeSize, shaderKey);
+
+	key.clear();
+	AppendBytes(key, shaderKey.data(), shaderKey.size());
+	AppendBytes(key, &elementCount, sizeof(elementCount));
+	for(i = 0; i < elementCount; i++)
+	{
+		length = (unsigned int)strlen(elements[i].SemanticName);
+		AppendBytes(key, &length, sizeof(length));
+		AppendBytes(key, elements[i].SemanticName, length);
+		AppendBytes(key, &elements[i].SemanticIndex, sizeof(elements[i].SemanticIndex));
+		AppendBytes(key, &elements[i].Format, sizeof(elements[i].Format));
+		AppendBytes(key, &elements[i].InputSlot, sizeof(elements[i].InputSlot));
+		AppendBytes(key, &elements[i].AlignedByteOffset, sizeof(elements[i].AlignedByteOffset));
+		AppendBytes(key, &elements[i].InputSlotClass, sizeof(elements[i].InputSlotClass));
+		AppendBytes(key, &elements[i].InstanceDataStepRate, sizeof(elements[i].InstanceDataStepRate));
+	}
+
+	return;
+}
+
+static unsigned long long HashKey(const std::string& key)
+{
+	return HashBytes(key.data(), key.size(), 0x50534F4341434845ULL);
+}
+
+PipelineStateClass::PipelineStateClass()
+{
+	int i;
+
+	m_device = nullptr;
+
+	// the direct 3d defaults until the device sets its own.
+	memset(&m_defaultDesc, 0, sizeof(m_defaultDesc));
+	m_defaultDesc.rasterizer.FillMode = D3D11_FILL_SOLID;
+	m_defaultDesc.rasterizer.CullMode = D3D11_CULL_BACK;
+	m_defaultDesc.rasterizer.DepthClipEnable = true;
+	m_defaultDesc.depthStencil.DepthEnable = true;
+	m_defaultDesc.depthStencil.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+	m_defaultDesc.depthStencil.DepthFunc = D3D11_COMPARISON_LESS;
+	m_defaultDesc.depthStencil.StencilReadMask = 0xFF;
+	m_defaultDesc.depthStencil.StencilWriteMask = 0xFF;
+	m_defaultDesc.depthStencil.FrontFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
+	m_defaultDesc.depthStencil.FrontFace.StencilDepthFailOp = D3D11_STENCIL_OP_KEEP;
+	m_defaultDesc.depthStencil.FrontFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
+	m_defaultDesc.depthStencil.FrontFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
+	m_defaultDesc.depthStencil.BackFace = m_defaultDesc.depthStencil.FrontFace;
+	for(i = 0; i < 8; i++)
+	{
+		m_defaultDesc.blend.RenderTarget[i].SrcBlend = D3D11_BLEND_ONE;
+		m_defaultDesc.blend.RenderTarget[i].DestBlend = D3D11_BLEND_ZERO;
+		m_defaultDesc.blend.RenderTarget[i].BlendOp = D3D11_BLEND_OP_ADD;
+		m_defaultDesc.blend.RenderTarget[i].SrcBlendAlpha = D3D11_BLEND_ONE;
+		m_defaultDesc.blend.RenderTarget[i].DestBlendAlpha = D3D11_BLEND_ZERO;
+		m_defaultDesc.blend.RenderTarget[i].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+		m_defaultDesc.blend.RenderTarget[i].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+	}
+	m_defaultDesc.topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+
+	m_pipelineHits = 0;
+	m_binds = 0;
+}
+
+PipelineStateClass::PipelineStateClass(const PipelineStateClass&)
+{
+}
+
+PipelineStateClass::~PipelineStateClass()
+{
+}
+
+bool PipelineStateClass::Initialize(ID3D11Device* device)
+{
+	if(!device)
+	{
+		return false;
+	}
+
+	m_device = device;
+
+	return true;
+}
+
+void PipelineStateClass::Shutdown()
+{
+	// the pipelines only point at the objects below, they hold no references of their own.
+	m_pipelines.clear();
+	m_pipelineKeys.clear();
+
+	ReleaseObjects(m_pixelShaders);
+	ReleaseObjects(m_vertexShaders);
+	ReleaseObjects(m_inputLayouts);
+	ReleaseObjects(m_blendStates);
+	ReleaseObjects(m_depthStencilStates);
+	ReleaseObjects(m_rasterizerStates);
+
+	m_device = nullptr;
+
+	return;
+}
+
+void PipelineStateClass::SetDefaultStates(const D3D11_RASTERIZER_DESC& rasterizer, const D3D11_DEPTH_STENCIL_DESC& depthStencil,
+	const D3D11_BLEND_DESC& blend, unsigned int stencilRef)
+{
+	m_defaultDesc.rasterizer = rasterizer;
+	m_defaultDesc.depthStencil = depthStencil;
+	m_defaultDesc.blend = blend;
+	m_defaultDesc.stencilRef = stencilRef;
+	return;
+}
+
+void PipelineStateClass::GetDefaultDesc(DescType& desc)
+{
+	desc = m_defaultDesc;
+	return;
+}
+
+unsigned int PipelineStateClass::Create(const DescType& desc)
+{
+	std::string key, stateKey;
+	ObjectType entry;
+	PipelineType pipeline;
+	unsigned long long hash;
+	int index;
+
+	if(!m_device || !desc.vertexShader || !desc.pixelShader || desc.inputElementCount > (unsigned int)PIPELINE_STATE_MAX_ELEMENTS)
+	{
+		return PIPELINE_STATE_INVALID;
+	}
+
+	// the pipeline's key is the keys of its parts, so equal descriptions find each other before any state object is asked for.
+	BuildRasterizerKey(desc.rasterizer, stateKey);
+	key += stateKey;
+	BuildDepthStencilKey(desc.depthStencil, stateKey);
+	key += stateKey;
+	BuildBlendKey(desc.blend, stateKey);
+	key += stateKey;
+	BuildInputLayoutKey(desc.inputElements, desc.inputElementCount, desc.vertexShader, desc.vertexShaderSize, stateKey);
+	key += stateKey;
+	BuildBytecodeKey(desc.pixelShader, desc.pixelShaderSize, stateKey);
+	key += stateKey;
+	AppendBytes(key, &desc.stencilRef, sizeof(desc.stencilRef));
+	AppendBytes(key, &desc.topology, sizeof(desc.topology));
+	hash = HashKey(key);
+
+	index = FindObject(m_pipelineKeys, hash, key);
+	if(index >= 0)
+	{
+		m_pipelineHits++;
+		return (unsigned int)index;
+	}
+
+	pipeline.rasterizerState = GetRasterizerState(desc.rasterizer);
+	pipeline.depthStencilState = GetDepthStencilState(desc.depthStencil);
+	pipeline.blendState = GetBlendState(desc.blend);
+	pipeline.stencilRef = desc.stencilRef;
+	pipeline.inputLayout = GetInputLayout(desc.inputElements, desc.inputElementCount, desc.vertexShader, desc.vertexShaderSize);
+	pipeline.vertexShader = GetVertexShader(desc.vertexShader, desc.vertexShaderSize);
+	pipeline.pixelShader = GetPixelShader(desc.pixelShader, desc.pixelShaderSize);
+	pipeline.topology = desc.topology;
+
+	if(!pipeline.rasterizerState || !pipeline.depthStencilState || !pipeline.blendState || !pipeline.inputLayout || !pipeline.vertexShader ||
+		!pipeline.pixelShader)
+	{
+		return PIPELINE_STATE_INVALID;
+	}
+
+	entry.hash = hash;
+	entry.key = key;
+	entry.object = nullptr;
+
+	m_pipelines.push_back(pipeline);
+	m_pipelineKeys.push_back(entry);
+
+	return (unsigned int)(m_pipelines.size() - 1);
+}
+
+ID3D11RasterizerState* PipelineStateClass::GetRasterizerState(const D3D11_RASTERIZER_DESC& desc)
+{
+	HRESULT result;
+	ObjectType entry;
+	ID3D11RasterizerState* state;
+	int index;
+
+	BuildRasterizerKey(desc, entry.key);
+	entry.hash = HashKey(entry.key);
+
+	index = FindObject(m_rasterizerStates, entry.hash, entry.key);
+	if(index >= 0)
+	{
+		return (ID3D11RasterizerState*)m_rasterizerStates[index].object;
+	}
+
+	result = m_device->CreateRasterizerState(&desc, &state);
+	if(FAILED(result))
+	{
+		return nullptr;
+	}
+
+	entry.object = state;
+	m_rasterizerStates.push_back(entry);
+
+	return state;
+}
+
+ID3D11DepthStencilState* PipelineStateClass::GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc)
+{
+	HRESULT result;
+	ObjectType entry;
+	ID3D11DepthStencilState* state;
+	int index;
+
+	BuildDepthStencilKey(desc, entry.key);
+	entry.hash = HashKey(entry.key);
+
+	index = FindObject(m_depthStencilStates, entry.hash, entry.key);
+	if(index >= 0)
+	{
+		return (ID3D11DepthStencilState*)m_depthStencilStates[index].object;
+	}
+
+	result = m_device->CreateDepthStencilState(&desc, &state);
+	if(FAILED(result))
+	{
+		return nullptr;
+	}
+
+	entry.object = state;
+	m_depthStencilStates.push_back(entry);
+
+	return state;
+}
+
+ID3D11BlendState* PipelineStateClass::GetBlendState(const D3D11_BLEND_DESC& desc)
+{
+	HRESULT result;
+	ObjectType entry;
+	ID3D11BlendState* state;
+	int index;
+
+	BuildBlendKey(desc, entry.key);
+	entry.hash = HashKey(entry.key);
+
+	index = FindObject(m_blendStates, entry.hash, entry.key);
+	if(index >= 0)
+	{
+		return (ID3D11BlendState*)m_blendStates[index].object;
+	}
+
+	result = m_device->CreateBlendState(&desc, &state);
+	if(FAILED(result))
+	{
+		return nullptr;
+	}
+
+	entry.object = state;
+	m_blendStates.push_back(entry);
+
+	return state;
+}
+
+void PipelineStateClass::Bind(DeviceStateClass* deviceState, unsigned int pipeline)
+{
+	const PipelineType* state;
+
+	if(pipeline >= (unsigned int)m_pipelines.size())
+	{
+		return;
+	}
+
+	state = &m_pipelines[pipeline];
+
+	deviceState->IASetInputLayout(state->inputLayout);
+	deviceState->IASetPrimitiveTopology(state->topology);
+	deviceState->VSSetShader(state->vertexShader);
+	deviceState->PSSetShader(state->pixelShader);
+	deviceState->RSSetState(state->rasterizerState);
+	deviceState->OMSetDepthStencilState(state->depthStencilState, state->stencilRef);
+	deviceState->OMSetBlendState(state->blendState);
+
+	m_binds.fetch_add(1, std::memory_order_relaxed);
+
+	return;
+}
+
+void PipelineStateClass::GetStatistics(StatisticsType& statistics)
+{
+	statistics.pipelines = (int)m_pipelines.size();
+	statistics.pipelineHits = m_pipelineHits;
+	statistics.rasterizerStates = (int)m_rasterizerStates.size();
+	statistics.depthStencilStates = (int)m_depthStencilStates.size();
+	statistics.blendStates = (int)m_blendStates.size();
+	statistics.inputLayouts = (int)m_inputLayouts.size();
+	statistics.vertexShaders = (int)m_vertexShaders.size();
+	statistics.pixelShaders = (int)m_pixelShaders.size();
+	statistics.binds = m_binds;
+	return;
+}
+
+// creation is rare and the tables hold tens of entries, a scan comparing hashes first is all the lookup they need.
+int PipelineStateClass::FindObject(const std::vector<ObjectType>& objects, unsigned long long hash, const std::string& key)
+{
+	int i;
+
+	for(i = 0; i < (int)objects.size(); i++)
+	{
+		if(objects[i].hash == hash && objects[i].key == key)
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+ID3D11InputLayout* PipelineStateClass::GetInputLayout(const D3D11_INPUT_ELEMENT_DESC* elements, unsigned int elementCount, const void* bytecode,
+	unsigned long long bytecodeSize)
+{
+	HRESULT result;
+	ObjectType entry;
+	ID3D11InputLayout* layout;
+	int index;
+
+	BuildInputLayoutKey(elements, elementCount, bytecode, bytecodeSize, entry.key);
+	entry.hash = HashKey(entry.key);
+
+	index = FindObject(m_inputLayouts, entry.hash, entry.key);
+	if(index >= 0)
+	{
+		return (ID3D11InputLayout*)m_inputLayouts[index].object;
+	}
+
+	result = m_device->CreateInputLayout(elements, elementCount, bytecode, (SIZE_T)bytecodeSize, &layout);
+	if(FAILED(result))
+	{
+		return nullptr;
+	}
+
+	entry.object = layout;
+	m_inputLayouts.push_back(entry);
+
+	return layout;
+}
+
+ID3D11VertexShader* PipelineStateClass::GetVertexShader(const void* bytecode, unsigned long long bytecodeSize)
+{
+	HRESULT result;
+	ObjectType entry;
+	ID3D11VertexShader* shader;
+	int index;
+
+	BuildBytecodeKey(bytecode, bytecodeSize, entry.key);
+	entry.hash = HashKey(entry.key);
+
+	index = FindObject(m_vertexShaders, entry.hash, entry.key);
+	if(index >= 0)
+	{
+		return (ID3D11VertexShader*)m_vertexShaders[index].object;
+	}
+
+	result = m_device->CreateVertexShader(bytecode, (SIZE_T)bytecodeSize, NULL, &shader);
+	if(FAILED(result))
+	{
+		return nullptr;
+	}
+
+	entry.object = shader;
+	m_vertexShaders.push_back(entry);
+
+	return shader;
+}
+
+ID3D11PixelShader* PipelineStateClass::GetPixelShader(const void* bytecode, unsigned long long bytecodeSize)
+{
+	HRESULT result;
+	ObjectType entry;
+	ID3D11PixelShader* shader;
+	int index;
+
+	BuildBytecodeKey(bytecode, bytecodeSize, entry.key);
+	entry.hash = HashKey(entry.key);
+
+	index = FindObject(m_pixelShaders, entry.hash, entry.key);
+	if(index >= 0)
+	{
+		return (ID3D11PixelShader*)m_pixelShaders[index].object;
+	}
+
+	result = m_device->CreatePixelShader(bytecode, (SIZE_T)bytecodeSize, NULL, &shader);
+	if(FAILED(result))
+	{
+		return nullptr;
+	}
+
+	entry.object = shader;
+	m_pixelShaders.push_back(entry);
+
+	return shader;
+}
+
+void PipelineStateClass::ReleaseObjects(std::vector<ObjectType>& objects)
+{
+	int i;
+
+	for(i = 0; i < (int)objects.size(); i++)
+	{
+		objects[i].object->Release();
+	}
+	objects.clear();
+
+	return;
+}
@@ -0,0 +1,130 @@
+#pragma once
+#ifndef _PIPELINESTATECLASS_H_
+#define _PIPELINESTATECLASS_H_
+
+#include <d3d11.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "devicestateclass.h"
+
+// handle Create returns when the pipeline could not be made, never bound.
+const unsigned int PIPELINE_STATE_INVALID = 0xFFFFFFFF;
+// input elements one pipeline can take, the same as the input assembler has slots for.
+const int PIPELINE_STATE_MAX_ELEMENTS = 32;
+
+/*
+ * every piece of fixed function and shader state a draw needs, created once and shared.
+ * a pipeline is the full description (rasterizer, depth stencil, blend, input layout, shader pair and topology), it is hashed and
+ * looked up before anything is made, and the same description always comes back as the same 32 bit handle.
+ * the state objects underneath are deduplicated on their own too, two pipelines that only differ in their shaders share one rasterizer state.
+ * pipelines are immutable once created and live until Shutdown, so a draw only has to carry its handle.
+ */
+class PipelineStateClass
+{
+public:
+	struct DescType
+	{
+		D3D11_RASTERIZER_DESC rasterizer;
+		D3D11_DEPTH_STENCIL_DESC depthStencil;
+		D3D11_BLEND_DESC blend;
+		unsigned int stencilRef;
+		// the elements are copied, the semantic names only have to live for the call.
+		const D3D11_INPUT_ELEMENT_DESC* inputElements;
+		unsigned int inputElementCount;
+		const void* vertexShader;
+		unsigned long long vertexShaderSize;
+		const void* pixelShader;
+		unsigned long long pixelShaderSize;
+		D3D11_PRIMITIVE_TOPOLOGY topology;
+	};
+
+	struct StatisticsType
+	{
+		int pipelines;
+		// Create calls that found their pipeline already there.
+		int pipelineHits;
+		int rasterizerStates;
+		int depthStencilStates;
+		int blendStates;
+		int inputLayouts;
+		int vertexShaders;
+		int pixelShaders;
+		int binds;
+	};
+
+public:
+	PipelineStateClass();
+	PipelineStateClass(const PipelineStateClass&);
+	~PipelineStateClass();
+
+	bool Initialize(ID3D11Device* device);
+	void Shutdown();
+
+	// the states the device was set up with, pipelines start from these and change what they need.
+	void SetDefaultStates(const D3D11_RASTERIZER_DESC& rasterizer, const D3D11_DEPTH_STENCIL_DESC& depthStencil, const D3D11_BLEND_DESC& blend,
+		unsigned int stencilRef);
+	void GetDefaultDesc(DescType& desc);
+
+	unsigned int Create(const DescType& desc);
+
+	// deduplicated single states, owned by the cache and released by its Shutdown.
+	ID3D11RasterizerState* GetRasterizerState(const D3D11_RASTERIZER_DESC& desc);
+	ID3D11DepthStencilState* GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc);
+	ID3D11BlendState* GetBlendState(const D3D11_BLEND_DESC& desc);
+
+	// binds the whole pipeline, the device state drops whatever parts of it are bound already.
+	void Bind(DeviceStateClass* deviceState, unsigned int pipeline);
+
+	void GetStatistics(StatisticsType& statistics);
+
+private:
+	// one created state object and the bytes its description was keyed with.
+	struct ObjectType
+	{
+		unsigned long long hash;
+		std::string key;
+		ID3D11DeviceChild* object;
+	};
+
+	struct PipelineType
+	{
+		ID3D11RasterizerState* rasterizerState;
+		ID3D11DepthStencilState* depthStencilState;
+		ID3D11BlendState* blendState;
+		unsigned int stencilRef;
+		ID3D11InputLayout* inputLayout;
+		ID3D11VertexShader* vertexShader;
+		ID3D11PixelShader* pixelShader;
+		D3D11_PRIMITIVE_TOPOLOGY topology;
+	};
+
+	int FindObject(const std::vector<ObjectType>& objects, unsigned long long hash, const std::string& key);
+	ID3D11InputLayout* GetInputLayout(const D3D11_INPUT_ELEMENT_DESC* elements, unsigned int elementCount, const void* bytecode,
+		unsigned long long bytecodeSize);
+	ID3D11VertexShader* GetVertexShader(const void* bytecode, unsigned long long bytecodeSize);
+	ID3D11PixelShader* GetPixelShader(const void* bytecode, unsigned long long bytecodeSize);
+	void ReleaseObjects(std::vector<ObjectType>& objects);
+
+private:
+	ID3D11Device* m_device;
+	DescType m_defaultDesc;
+
+	std::vector<ObjectType> m_rasterizerStates;
+	std::vector<ObjectType> m_depthStencilStates;
+	std::vector<ObjectType> m_blendStates;
+	std::vector<ObjectType> m_inputLayouts;
+	std::vector<ObjectType> m_vertexShaders;
+	std::vector<ObjectType> m_pixelShaders;
+
+	// the handle is the index into m_pipelines, m_pipelineKeys holds the hash and key of each.
+	std::vector<PipelineType> m_pipelines;
+	std::vector<ObjectType> m_pipelineKeys;
+
+	int m_pipelineHits;
+	// Bind is called from every thread recording draws.
+	std::atomic<int> m_binds;
+};
+
+#endif
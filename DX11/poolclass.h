@@ -0,0 +1,158 @@
+#pragma once
+#ifndef _POOLCLASS_H_
+#define _POOLCLASS_H_
+
+#include <atomic>
+#include <new>
+
+#include "memoryclass.h"
+
+/*
+ * a fixed number of objects of one type in a single block, handed out and taken back without touching the heap.
+ * free slots form a lock free list threaded through an index array, so any thread can Allocate and Free.
+ * the head of the list carries a tag that goes up with every pop, so a slot that was popped and pushed back
+ * in between cannot make another thread's compare exchange succeed with a stale next index.
+ * Allocate constructs the object and Free destroys it, a full pool makes Allocate return null instead of growing.
+ */
+template<typename T>
+class PoolClass
+{
+public:
+	PoolClass()
+	{
+		m_objects = nullptr;
+		m_next = nullptr;
+		m_capacity = 0;
+		m_head.store(0, std::memory_order_relaxed);
+		m_count.store(0, std::memory_order_relaxed);
+	}
+
+	PoolClass(const PoolClass&)
+	{
+	}
+
+	~PoolClass()
+	{
+	}
+
+	bool Initialize(unsigned int capacity, MemoryTagType tag)
+	{
+		unsigned int i;
+
+		if(capacity == 0 || capacity == POOL_END)
+		{
+			return false;
+		}
+
+		// the slots are raw storage, an object only exists between its Allocate and its Free.
+		m_objects = (T*)MemoryClass::Allocate(sizeof(T) * capacity, alignof(T) > 16 ? alignof(T) : 16, tag);
+		if(!m_objects)
+		{
+			return false;
+		}
+
+		m_next = MemoryClass::AllocateArray<std::atomic<unsigned int> >(capacity, tag);
+		if(!m_next)
+		{
+			return false;
+		}
+
+		for(i = 0; i < capacity; i++)
+		{
+			m_next[i].store(i + 1 < capacity ? i + 1 : POOL_END, std::memory_order_relaxed);
+		}
+
+		m_capacity = capacity;
+		m_head.store(0, std::memory_order_relaxed);
+		m_count.store(0, std::memory_order_relaxed);
+
+		return true;
+	}
+
+	// every object has to be freed by now, the pool does not know which slots are in use.
+	void Shutdown()
+	{
+		MemoryClass::FreeArray(m_next);
+		m_next = nullptr;
+
+		MemoryClass::Free(m_objects);
+		m_objects = nullptr;
+
+		m_capacity = 0;
+
+		return;
+	}
+
+	T* Allocate()
+	{
+		unsigned long long head, next;
+		unsigned int index;
+
+		head = m_head.load(std::memory_order_acquire);
+		do
+		{
+			index = (unsigned int)head;
+			if(index == POOL_END)
+			{
+				return nullptr;
+			}
+
+			next = ((head >> 32) + 1) << 32 | m_next[index].load(std::memory_order_relaxed);
+		} while(!m_head.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire));
+
+		m_count.fetch_add(1, std::memory_order_relaxed);
+
+		return new(&m_objects[index]) T;
+	}
+
+	// null is ignored.
+	void Free(T* object)
+	{
+		unsigned long long head, next;
+		unsigned int index;
+
+		if(!object)
+		{
+			return;
+		}
+
+		object->~T();
+		index = (unsigned int)(object - m_objects);
+
+		head = m_head.load(std::memory_order_relaxed);
+		do
+		{
+			m_next[index].store((unsigned int)head, std::memory_order_relaxed);
+			next = (head & 0xFFFFFFFF00000000ULL) | index;
+		} while(!m_head.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed));
+
+		m_count.fetch_sub(1, std::memory_order_relaxed);
+
+		return;
+	}
+
+	unsigned int GetCapacity()
+	{
+		return m_capacity;
+	}
+
+	// objects allocated and not freed yet.
+	unsigned int GetCount()
+	{
+		return m_count.load(std::memory_order_relaxed);
+	}
+
+private:
+	// the next index of the last free slot.
+	static const unsigned int POOL_END = 0xFFFFFFFF;
+
+private:
+	T* m_objects;
+	std::atomic<unsigned int>* m_next;
+	unsigned int m_capacity;
+	// the first free slot in the low 32 bits and the pop count in the high ones.
+	std::atomic<unsigned long long> m_head;
+	std::atomic<unsigned int> m_count;
+};
+
+#endif
@@ -0,0 +1,407 @@
+#include "profilerclass.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+ProfilerClass* ProfilerClass::s_profiler = nullptr;
+std::atomic<bool> ProfilerClass::s_recording(false);
+std::atomic<int> ProfilerClass::s_frame(0);
+thread_local ProfilerClass::ThreadType* ProfilerClass::s_thread = nullptr;
+thread_local unsigned int ProfilerClass::s_threadGeneration = 0;
+
+// when the current profiler was initialized, every event time is relative to it.
+static std::chrono::steady_clock::time_point s_start;
+// goes up with every Initialize, a thread whose ring belongs to an earlier profiler asks for a new one.
+static std::atomic<unsigned int> s_generation(0);
+
+ProfilerClass::ProfilerClass()
+{
+	int i;
+
+	for(i = 0; i < PROFILER_MAX_THREADS; i++)
+	{
+		m_threads[i] = nullptr;
+	}
+	m_threadCount = 0;
+	m_pendingFrames = 0;
+	m_captureFrames = 0;
+	m_firstFrame = 0;
+	m_captureBegin = 0;
+	m_captureEnd = 0;
+	m_captured = false;
+}
+
+ProfilerClass::ProfilerClass(const ProfilerClass&)
+{
+}
+
+ProfilerClass::~ProfilerClass()
+{
+}
+
+bool ProfilerClass::Initialize()
+{
+	m_threadCount = 0;
+	m_pendingFrames = 0;
+	m_captured = false;
+
+	s_recording = false;
+	s_frame = 0;
+	s_start = std::chrono::steady_clock::now();
+	s_generation++;
+	s_profiler = this;
+
+	return true;
+}
+
+void ProfilerClass::Shutdown()
+{
+	ThreadType* thread;
+	int i;
+
+	s_recording = false;
+	if(s_profiler == this)
+	{
+		s_profiler = nullptr;
+		s_generation++;
+	}
+
+	// a scope that is still open writes its end into its thread's ring, so the threads that record have to be gone by now.
+	for(i = 0; i < PROFILER_MAX_THREADS; i++)
+	{
+		thread = m_threads[i].exchange(nullptr);
+		if(thread)
+		{
+			delete[] thread->events;
+			delete thread;
+		}
+	}
+	m_threadCount = 0;
+
+	return;
+}
+
+void ProfilerClass::BeginCapture(int frameCount)
+{
+	m_pendingFrames = frameCount > 0 ? frameCount : 1;
+	return;
+}
+
+bool ProfilerClass::IsCapturing()
+{
+	return m_pendingFrames > 0 || s_recording;
+}
+
+void ProfilerClass::BeginFrame()
+{
+	int frame;
+
+	frame = s_frame.fetch_add(1) + 1;
+
+	if(m_pendingFrames > 0)
+	{
+		m_captureFrames = m_pendingFrames;
+		m_pendingFrames = 0;
+		m_firstFrame = frame;
+		m_captureBegin = GetTime();
+		m_captured = false;
+		s_recording = true;
+	}
+
+	return;
+}
+
+bool ProfilerClass::EndFrame()
+{
+	if(!s_recording || s_frame - m_firstFrame + 1 < m_captureFrames)
+	{
+		return false;
+	}
+
+	s_recording = false;
+	m_captureEnd = GetTime();
+	m_captured = true;
+
+	return true;
+}
+
+bool ProfilerClass::WriteTrace(const char* filename)
+{
+	std::vector<EventType> events;
+	FILE* file;
+	int thread, count, i;
+	bool first;
+
+	if(!m_captured)
+	{
+		return false;
+	}
+
+	file = fopen(filename, "w");
+	if(!file)
+	{
+		return false;
+	}
+
+	// complete events, times in microseconds. the viewer nests them by time on each thread, the depth is only passed along.
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	first = true;
+	for(thread = 0; thread < m_threadCount; thread++)
+	{
+		events.resize(PROFILER_RING_SIZE);
+		GetEvents(thread, events.data(), count);
+
+		for(i = 0; i < count; i++)
+		{
+			fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%d,\"depth\":%d}}", first ? "" : ",\n",
+				events[i].name, thread, (double)(events[i].begin - m_captureBegin) / 1000.0, (double)(events[i].end - events[i].begin) / 1000.0,
+				events[i].frame - m_firstFrame, events[i].depth);
+			first = false;
+		}
+	}
+	fprintf(file, "\n]}\n");
+
+	if(fclose(file) != 0)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+bool ProfilerClass::WriteSummary(const char* filename)
+{
+	std::vector<ScopeType> scopes;
+	FILE* file;
+	double duration;
+	int frameCount;
+	size_t i;
+
+	if(!GetSummary(scopes, frameCount, duration))
+	{
+		return false;
+	}
+
+	file = fopen(filename, "w");
+	if(!file)
+	{
+		return false;
+	}
+
+	// times are inclusive, a scope's own time contains the scopes opened inside it.
+	fprintf(file, "%d frames, %.3f ms\n", frameCount, duration);
+	fprintf(file, "%-48s %10s %12s %12s %12s %14s\n", "scope", "calls", "calls/frame", "mean ms", "p99 ms", "total ms/frame");
+	for(i = 0; i < scopes.size(); i++)
+	{
+		fprintf(file, "%-48s %10d %12.1f %12.4f %12.4f %14.4f\n", scopes[i].name.c_str(), scopes[i].calls, scopes[i].callsPerFrame,
+			scopes[i].mean, scopes[i].p99, scopes[i].totalPerFrame);
+	}
+
+	if(fclose(file) != 0)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+bool ProfilerClass::GetSummary(std::vector<ScopeType>& scopes, int& frameCount, double& duration)
+{
+	std::map<std::string, std::vector<long long> > durations;
+	std::map<std::string, std::vector<long long> >::iterator scope;
+	std::vector<std::pair<double, std::string> > order;
+	std::vector<EventType> events;
+	std::vector<long long>* scopeDurations;
+	ScopeType line;
+	double total;
+	int thread, count, i;
+	size_t j;
+
+	scopes.clear();
+	if(!m_captured)
+	{
+		return false;
+	}
+
+	// every scope's durations from every thread, a scope name counts as one scope wherever it was recorded.
+	events.resize(PROFILER_RING_SIZE);
+	for(thread = 0; thread < m_threadCount; thread++)
+	{
+		GetEvents(thread, events.data(), count);
+		for(i = 0; i < count; i++)
+		{
+			durations[events[i].name].push_back(events[i].end - events[i].begin);
+		}
+	}
+
+	// most time per frame first.
+	for(scope = durations.begin(); scope != durations.end(); scope++)
+	{
+		total = 0.0;
+		for(j = 0; j < scope->second.size(); j++)
+		{
+			total += (double)scope->second[j];
+		}
+		order.push_back(std::make_pair(-total, scope->first));
+	}
+	std::sort(order.begin(), order.end());
+
+	for(j = 0; j < order.size(); j++)
+	{
+		scopeDurations = &durations[order[j].second];
+		std::sort(scopeDurations->begin(), scopeDurations->end());
+
+		line.name = order[j].second;
+		line.calls = (int)scopeDurations->size();
+		line.callsPerFrame = (double)scopeDurations->size() / (double)m_captureFrames;
+		line.mean = -order[j].first / (double)scopeDurations->size() / 1000000.0;
+		line.p99 = (double)(*scopeDurations)[(scopeDurations->size() * 99 + 99) / 100 - 1] / 1000000.0;
+		line.totalPerFrame = -order[j].first / 1000000.0 / (double)m_captureFrames;
+		scopes.push_back(line);
+	}
+
+	frameCount = m_captureFrames;
+	duration = (double)(m_captureEnd - m_captureBegin) / 1000000.0;
+
+	return true;
+}
+
+void ProfilerClass::BeginScope(const char* name)
+{
+	ThreadType* thread;
+
+	thread = GetThread();
+	if(!thread)
+	{
+		return;
+	}
+
+	if(thread->depth < PROFILER_MAX_DEPTH)
+	{
+		thread->openNames[thread->depth] = name;
+		thread->openBegins[thread->depth] = GetTime();
+	}
+	thread->depth++;
+
+	return;
+}
+
+void ProfilerClass::EndScope()
+{
+	ThreadType* thread;
+	EventType* event;
+	long long head;
+
+	thread = GetThread();
+	if(!thread || thread->depth == 0)
+	{
+		return;
+	}
+
+	thread->depth--;
+	if(thread->depth >= PROFILER_MAX_DEPTH)
+	{
+		return;
+	}
+
+	// the oldest event is overwritten once the ring is full. the head is published after the event is complete.
+	head = thread->head.load(std::memory_order_relaxed);
+	event = &thread->events[head % PROFILER_RING_SIZE];
+	event->name = thread->openNames[thread->depth];
+	event->begin = thread->openBegins[thread->depth];
+	event->end = GetTime();
+	event->frame = s_frame.load(std::memory_order_relaxed);
+	event->depth = thread->depth;
+	thread->head.store(head + 1, std::memory_order_release);
+
+	return;
+}
+
+ProfilerClass::ThreadType* ProfilerClass::GetThread()
+{
+	ProfilerClass* profiler;
+	ThreadType* thread;
+	int index;
+
+	if(s_threadGeneration == s_generation.load(std::memory_order_relaxed))
+	{
+		return s_thread;
+	}
+
+	profiler = s_profiler;
+	s_thread = nullptr;
+	s_threadGeneration = s_generation;
+	if(!profiler)
+	{
+		return nullptr;
+	}
+
+	// the first scope a thread opens under this profiler, it gets its ring for good. threads past the last ring are not recorded.
+	index = profiler->m_threadCount.fetch_add(1);
+	if(index >= PROFILER_MAX_THREADS)
+	{
+		profiler->m_threadCount = PROFILER_MAX_THREADS;
+		return nullptr;
+	}
+
+	thread = new ThreadType;
+	if(!thread)
+	{
+		return nullptr;
+	}
+
+	thread->events = new EventType[PROFILER_RING_SIZE];
+	if(!thread->events)
+	{
+		delete thread;
+		return nullptr;
+	}
+
+	thread->head = 0;
+	thread->depth = 0;
+
+	profiler->m_threads[index] = thread;
+	s_thread = thread;
+
+	return thread;
+}
+
+long long ProfilerClass::GetTime()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_start).count();
+}
+
+void ProfilerClass::GetEvents(int thread, EventType* events, int& count)
+{
+	ThreadType* source;
+	long long head, first, i;
+
+	count = 0;
+
+	// a thread that got its index but has not put its ring in yet has nothing to show.
+	source = thread < PROFILER_MAX_THREADS ? m_threads[thread].load() : nullptr;
+	if(!source)
+	{
+		return;
+	}
+
+	head = source->head.load(std::memory_order_acquire);
+	first = head > PROFILER_RING_SIZE ? head - PROFILER_RING_SIZE : 0;
+
+	// only what began inside the capture. a scope still open when the capture ended is there if it closed before this.
+	for(i = first; i < head; i++)
+	{
+		const EventType& event = source->events[i % PROFILER_RING_SIZE];
+
+		if(event.begin >= m_captureBegin && event.begin < m_captureEnd)
+		{
+			events[count++] = event;
+		}
+	}
+
+	return;
+}
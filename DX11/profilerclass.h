@@ -0,0 +1,151 @@
+#pragma once
+#ifndef _PROFILERCLASS_H_
+#define _PROFILERCLASS_H_
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+// scopes every thread keeps, a capture longer than this only keeps each thread's last ones.
+const int PROFILER_RING_SIZE = 65536;
+// threads that can record, far more than the job system and the mesh loader start.
+const int PROFILER_MAX_THREADS = 64;
+// scopes one thread can have open inside each other, deeper ones are not recorded.
+const int PROFILER_MAX_DEPTH = 32;
+// frames one capture covers.
+const int PROFILER_CAPTURE_FRAMES = 120;
+
+/*
+ * a hierarchical cpu profiler for a few frames at a time.
+ * the code is marked up with ProfileScopeClass objects, each one is a named span from its construction to the end of its scope.
+ * while a capture runs every thread writes the spans it closes into a ring of its own, nothing is shared between threads
+ * but the counter handing out the rings. outside a capture a marker is one branch on a flag that is almost never set.
+ * a capture covers the frames between BeginFrame and EndFrame calls of the main loop, it is written out afterwards
+ * in the chrome trace format (chrome://tracing or perfetto) and as a per scope summary with the mean and 99th percentile.
+ * scope names have to be string literals or live as long as the profiler, only the pointer is kept.
+ */
+class ProfilerClass
+{
+public:
+	// one line of the summary, times are inclusive and in milliseconds.
+	struct ScopeType
+	{
+		std::string name;
+		int calls;
+		double callsPerFrame;
+		double mean;
+		double p99;
+		double totalPerFrame;
+	};
+
+public:
+	ProfilerClass();
+	ProfilerClass(const ProfilerClass&);
+	~ProfilerClass();
+
+	// there is one profiler per process, the markers record into the last one initialized.
+	bool Initialize();
+	void Shutdown();
+
+	// the capture starts with the next BeginFrame.
+	void BeginCapture(int frameCount);
+	bool IsCapturing();
+
+	void BeginFrame();
+	// true once, at the end of the frame a capture finished on.
+	bool EndFrame();
+
+	// the last finished capture. false when there is none or the file could not be written.
+	bool WriteTrace(const char* filename);
+	bool WriteSummary(const char* filename);
+	// the summary WriteSummary writes, most time per frame first. duration is the capture's in milliseconds.
+	bool GetSummary(std::vector<ScopeType>& scopes, int& frameCount, double& duration);
+
+	// the whole cost of a marker while nothing is being captured.
+	static bool IsRecording()
+	{
+		return s_recording.load(std::memory_order_relaxed);
+	}
+
+	// what ProfileScopeClass calls, EndScope closes the innermost scope BeginScope opened on the same thread.
+	static void BeginScope(const char* name);
+	static void EndScope();
+
+private:
+	struct EventType
+	{
+		const char* name;
+		// nanoseconds since Initialize.
+		long long begin;
+		long long end;
+		int frame;
+		int depth;
+	};
+
+	// written only by its own thread. head counts every event ever written, the newest is at head - 1.
+	struct ThreadType
+	{
+		EventType* events;
+		std::atomic<long long> head;
+		const char* openNames[PROFILER_MAX_DEPTH];
+		long long openBegins[PROFILER_MAX_DEPTH];
+		int depth;
+	};
+
+	static ThreadType* GetThread();
+	static long long GetTime();
+	// the finished capture's events of every thread, index is the thread's.
+	void GetEvents(int thread, EventType* events, int& count);
+
+private:
+	static ProfilerClass* s_profiler;
+	static std::atomic<bool> s_recording;
+	static std::atomic<int> s_frame;
+	// the calling thread's ring and the Initialize it was handed out under.
+	static thread_local ThreadType* s_thread;
+	static thread_local unsigned int s_threadGeneration;
+
+	// filled in by the threads themselves as they record their first scope.
+	std::atomic<ThreadType*> m_threads[PROFILER_MAX_THREADS];
+	std::atomic<int> m_threadCount;
+
+	int m_pendingFrames;
+	int m_captureFrames;
+	int m_firstFrame;
+	long long m_captureBegin;
+	long long m_captureEnd;
+	bool m_captured;
+};
+
+/*
+ * a marker, the span from its construction to its destruction is recorded under its name when a capture is running.
+ * inline so that outside a capture it costs the one branch in IsRecording.
+ */
+class ProfileScopeClass
+{
+public:
+	ProfileScopeClass(const char* name)
+	{
+		m_open = ProfilerClass::IsRecording();
+		if(m_open)
+		{
+			ProfilerClass::BeginScope(name);
+		}
+	}
+
+	~ProfileScopeClass()
+	{
+		if(m_open)
+		{
+			ProfilerClass::EndScope();
+		}
+	}
+
+private:
+	ProfileScopeClass(const ProfileScopeClass&);
+
+private:
+	bool m_open;
+};
+
+#endif
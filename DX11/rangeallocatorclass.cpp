@@ -0,0 +1,247 @@
+#include "rangeallocatorclass.h"
+
+static unsigned int AlignUp(unsigned int value, unsigned int alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+RangeAllocatorClass::RangeAllocatorClass()
+{
+	m_capacity = 0;
+	m_usedSize = 0;
+}
+
+RangeAllocatorClass::RangeAllocatorClass(const RangeAllocatorClass&)
+{
+}
+
+RangeAllocatorClass::~RangeAllocatorClass()
+{
+}
+
+bool RangeAllocatorClass::Initialize(unsigned int capacity)
+{
+	if(capacity == 0)
+	{
+		return false;
+	}
+
+	m_capacity = capacity;
+	m_usedSize = 0;
+	InsertFreeBlock(0, capacity);
+
+	return true;
+}
+
+void RangeAllocatorClass::Shutdown()
+{
+	m_freeByOffset.clear();
+	m_freeBySize.clear();
+	m_allocations.clear();
+	m_capacity = 0;
+	m_usedSize = 0;
+
+	return;
+}
+
+bool RangeAllocatorClass::Allocate(unsigned int size, unsigned int alignment, unsigned int& offset)
+{
+	std::set<std::pair<unsigned int, unsigned int> >::iterator candidate;
+	std::map<unsigned int, unsigned int>::iterator block;
+	unsigned int blockOffset, blockSize, alignedOffset;
+	AllocationType allocation;
+
+	if(size == 0 || alignment == 0)
+	{
+		return false;
+	}
+
+	// smallest block first, the padding for the alignment can push it to a bigger one.
+	for(candidate = m_freeBySize.lower_bound(std::make_pair(size, 0u)); candidate != m_freeBySize.end(); ++candidate)
+	{
+		blockSize = candidate->first;
+		blockOffset = candidate->second;
+		alignedOffset = AlignUp(blockOffset, alignment);
+
+		if(alignedOffset - blockOffset <= blockSize - size)
+		{
+			break;
+		}
+	}
+	if(candidate == m_freeBySize.end())
+	{
+		return false;
+	}
+
+	block = m_freeByOffset.find(blockOffset);
+	RemoveFreeBlock(block);
+
+	// whatever is left in front of and behind the allocation goes back on the free list.
+	if(alignedOffset > blockOffset)
+	{
+		InsertFreeBlock(blockOffset, alignedOffset - blockOffset);
+	}
+	if(alignedOffset + size < blockOffset + blockSize)
+	{
+		InsertFreeBlock(alignedOffset + size, blockOffset + blockSize - alignedOffset - size);
+	}
+
+	allocation.size = size;
+	allocation.alignment = alignment;
+	m_allocations[alignedOffset] = allocation;
+	m_usedSize += size;
+
+	offset = alignedOffset;
+
+	return true;
+}
+
+void RangeAllocatorClass::Free(unsigned int offset)
+{
+	std::map<unsigned int, AllocationType>::iterator allocation;
+	std::map<unsigned int, unsigned int>::iterator next, previous;
+	unsigned int blockOffset, blockSize;
+
+	allocation = m_allocations.find(offset);
+	if(allocation == m_allocations.end())
+	{
+		return;
+	}
+
+	blockOffset = offset;
+	blockSize = allocation->second.size;
+	m_usedSize -= blockSize;
+	m_allocations.erase(allocation);
+
+	// merge with the free blocks right after and right before.
+	next = m_freeByOffset.lower_bound(blockOffset);
+	if(next != m_freeByOffset.end() && next->first == blockOffset + blockSize)
+	{
+		blockSize += next->second;
+		RemoveFreeBlock(next);
+	}
+
+	next = m_freeByOffset.lower_bound(blockOffset);
+	if(next != m_freeByOffset.begin())
+	{
+		previous = next;
+		--previous;
+		if(previous->first + previous->second == blockOffset)
+		{
+			blockOffset = previous->first;
+			blockSize += previous->second;
+			RemoveFreeBlock(previous);
+		}
+	}
+
+	InsertFreeBlock(blockOffset, blockSize);
+
+	return;
+}
+
+void RangeAllocatorClass::Grow(unsigned int capacity)
+{
+	std::map<unsigned int, unsigned int>::iterator last;
+	unsigned int blockOffset;
+
+	if(capacity <= m_capacity)
+	{
+		return;
+	}
+
+	// extend the last free block if it runs up to the old end.
+	blockOffset = m_capacity;
+	if(!m_freeByOffset.empty())
+	{
+		last = m_freeByOffset.end();
+		--last;
+		if(last->first + last->second == m_capacity)
+		{
+			blockOffset = last->first;
+			RemoveFreeBlock(last);
+		}
+	}
+
+	InsertFreeBlock(blockOffset, capacity - blockOffset);
+	m_capacity = capacity;
+
+	return;
+}
+
+void RangeAllocatorClass::Defragment(std::vector<MoveType>& moves)
+{
+	std::map<unsigned int, AllocationType> packed;
+	std::map<unsigned int, AllocationType>::iterator allocation;
+	unsigned int next, destination;
+	MoveType move;
+
+	moves.clear();
+	m_freeByOffset.clear();
+	m_freeBySize.clear();
+
+	next = 0;
+	for(allocation = m_allocations.begin(); allocation != m_allocations.end(); ++allocation)
+	{
+		destination = AlignUp(next, allocation->second.alignment);
+
+		// alignment padding between two allocations can not be packed away.
+		if(destination > next)
+		{
+			InsertFreeBlock(next, destination - next);
+		}
+
+		if(destination != allocation->first)
+		{
+			move.sourceOffset = allocation->first;
+			move.destinationOffset = destination;
+			move.size = allocation->second.size;
+			moves.push_back(move);
+		}
+
+		packed[destination] = allocation->second;
+		next = destination + allocation->second.size;
+	}
+
+	if(next < m_capacity)
+	{
+		InsertFreeBlock(next, m_capacity - next);
+	}
+
+	m_allocations.swap(packed);
+
+	return;
+}
+
+void RangeAllocatorClass::GetStatistics(StatisticsType& statistics)
+{
+	statistics.capacity = m_capacity;
+	statistics.usedSize = m_usedSize;
+	statistics.freeSize = m_capacity - m_usedSize;
+	statistics.largestFreeBlock = m_freeBySize.empty() ? 0 : m_freeBySize.rbegin()->first;
+	statistics.freeBlockCount = (unsigned int)m_freeByOffset.size();
+	statistics.allocationCount = (unsigned int)m_allocations.size();
+	statistics.fragmentation = statistics.freeSize ? 1.0f - (float)statistics.largestFreeBlock / (float)statistics.freeSize : 0.0f;
+
+	return;
+}
+
+unsigned int RangeAllocatorClass::GetCapacity()
+{
+	return m_capacity;
+}
+
+void RangeAllocatorClass::InsertFreeBlock(unsigned int offset, unsigned int size)
+{
+	m_freeByOffset[offset] = size;
+	m_freeBySize.insert(std::make_pair(size, offset));
+
+	return;
+}
+
+void RangeAllocatorClass::RemoveFreeBlock(std::map<unsigned int, unsigned int>::iterator block)
+{
+	m_freeBySize.erase(std::make_pair(block->second, block->first));
+	m_freeByOffset.erase(block);
+
+	return;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#ifndef _RANGEALLOCATORCLASS_H_
+#define _RANGEALLOCATORCLASS_H_
+
+#include <map>
+#include <set>
+#include <vector>
+
+/*
+ * hands out ranges of a fixed size address space, the bytes of a big gpu buffer for GeometryArenaClass.
+ * free blocks are kept twice, by offset so neighbours merge on free and by size for a best fit search.
+ * alignment does not have to be a power of two, vertex ranges are aligned to their stride so BaseVertexLocation comes out whole.
+ * it never touches the memory it manages, the caller moves the data when the allocator says so.
+ */
+class RangeAllocatorClass
+{
+public:
+	struct StatisticsType
+	{
+		unsigned int capacity;
+		unsigned int usedSize;
+		unsigned int freeSize;
+		unsigned int largestFreeBlock;
+		unsigned int freeBlockCount;
+		unsigned int allocationCount;
+		// 0 when all free space is one block, close to 1 when it is scattered in small pieces.
+		float fragmentation;
+	};
+
+	struct MoveType
+	{
+		unsigned int sourceOffset;
+		unsigned int destinationOffset;
+		unsigned int size;
+	};
+
+public:
+	RangeAllocatorClass();
+	RangeAllocatorClass(const RangeAllocatorClass&);
+	~RangeAllocatorClass();
+
+	bool Initialize(unsigned int capacity);
+	void Shutdown();
+
+	bool Allocate(unsigned int size, unsigned int alignment, unsigned int& offset);
+	void Free(unsigned int offset);
+	// makes the address space bigger, existing allocations stay where they are.
+	void Grow(unsigned int capacity);
+
+	// packs every allocation towards offset 0 keeping their order, the moves say where each one went.
+	void Defragment(std::vector<MoveType>& moves);
+
+	void GetStatistics(StatisticsType& statistics);
+	unsigned int GetCapacity();
+
+private:
+	struct AllocationType
+	{
+		unsigned int size;
+		unsigned int alignment;
+	};
+
+	void InsertFreeBlock(unsigned int offset, unsigned int size);
+	void RemoveFreeBlock(std::map<unsigned int, unsigned int>::iterator block);
+
+private:
+	unsigned int m_capacity, m_usedSize;
+	std::map<unsigned int, unsigned int> m_freeByOffset;
+	std::set<std::pair<unsigned int, unsigned int> > m_freeBySize;
+	std::map<unsigned int, AllocationType> m_allocations;
+};
+
+#endif
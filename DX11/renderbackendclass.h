@@ -0,0 +1,42 @@
+#pragma once
+#ifndef _RENDERBACKENDCLASS_H_
+#define _RENDERBACKENDCLASS_H_
+
+#include <DirectXMath.h>
+using namespace DirectX;
+
+// forward declarations so headless backends do not need the direct 3d headers.
+struct ID3D11Device;
+struct ID3D11DeviceContext;
+
+/*
+ * the render backend is everything graphics class needs from the thing it draws with.
+ * D3DClass implements it on top of a hardware direct 3d 11 device, SoftwareRasterizerClass implements it on the cpu so the same render path can run on machines without a gpu.
+ * headless backends return null from GetDevice and GetDeviceContext.
+ */
+class RenderBackendClass
+{
+public:
+	virtual ~RenderBackendClass() {}
+
+	virtual void Shutdown() = 0;
+
+	virtual void BeginScene(float, float, float, float) = 0;
+	virtual void EndScene() = 0;
+
+	virtual ID3D11Device* GetDevice() = 0;
+	virtual ID3D11DeviceContext* GetDeviceContext() = 0;
+
+	virtual void GetProjectionMatrix(XMMATRIX& projectionMatrix) = 0;
+	virtual void GetWorldMatrix(XMMATRIX& worldMatrix) = 0;
+	virtual void GetOrthoMatrix(XMMATRIX& orthoMatrix) = 0;
+
+	virtual void GetVideoCardInfo(char*, int&) = 0;
+
+	// frames EndScene has handed to the gpu, and how many of those it has finished, counting from 1.
+	// whatever a frame uses may only be destroyed once it is completed. headless backends finish a frame in EndScene.
+	virtual unsigned long long GetSubmittedFrame() = 0;
+	virtual unsigned long long GetCompletedFrame() = 0;
+};
+
+#endif
@@ -0,0 +1,172 @@
+#include "sceneclass.h"
+
+#include <cmath>
+
+SceneClass::SceneClass()
+{
+	m_capacity = 0;
+	m_count = 0;
+	m_modelCenter = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	m_modelExtent = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	m_data = nullptr;
+	m_positionX = nullptr;
+	m_positionY = nullptr;
+	m_positionZ = nullptr;
+	m_scale = nullptr;
+	m_centerX = nullptr;
+	m_centerY = nullptr;
+	m_centerZ = nullptr;
+	m_extentX = nullptr;
+	m_extentY = nullptr;
+	m_extentZ = nullptr;
+	m_radius = nullptr;
+}
+
+SceneClass::SceneClass(const SceneClass&)
+{
+}
+
+SceneClass::~SceneClass()
+{
+}
+
+bool SceneClass::Initialize(int capacity)
+{
+	float* arrays[11];
+	int i;
+
+	if(capacity <= 0)
+	{
+		return false;
+	}
+
+	m_data = MemoryClass::AllocateArray<float>((size_t)capacity * 11, MEMORY_TAG_SCENE);
+	if(!m_data)
+	{
+		return false;
+	}
+
+	for(i = 0; i < 11; i++)
+	{
+		arrays[i] = m_data + (size_t)capacity * i;
+	}
+
+	m_positionX = arrays[0];
+	m_positionY = arrays[1];
+	m_positionZ = arrays[2];
+	m_scale = arrays[3];
+	m_centerX = arrays[4];
+	m_centerY = arrays[5];
+	m_centerZ = arrays[6];
+	m_extentX = arrays[7];
+	m_extentY = arrays[8];
+	m_extentZ = arrays[9];
+	m_radius = arrays[10];
+
+	m_capacity = capacity;
+	m_count = 0;
+
+	return true;
+}
+
+void SceneClass::Shutdown()
+{
+	if(m_data)
+	{
+		MemoryClass::FreeArray(m_data);
+		m_data = nullptr;
+	}
+
+	m_capacity = 0;
+	m_count = 0;
+
+	return;
+}
+
+int SceneClass::AddObject(float positionX, float positionY, float positionZ, float scale)
+{
+	if(m_count >= m_capacity)
+	{
+		return -1;
+	}
+
+	m_positionX[m_count] = positionX;
+	m_positionY[m_count] = positionY;
+	m_positionZ[m_count] = positionZ;
+	m_scale[m_count] = scale;
+	UpdateBounds(m_count);
+
+	return m_count++;
+}
+
+void SceneClass::SetModelBounds(const XMFLOAT3& center, const XMFLOAT3& extent)
+{
+	int i;
+
+	m_modelCenter = center;
+	m_modelExtent = extent;
+
+	for(i = 0; i < m_count; i++)
+	{
+		UpdateBounds(i);
+	}
+
+	return;
+}
+
+int SceneClass::GetObjectCount()
+{
+	return m_count;
+}
+
+int SceneClass::GetCapacity()
+{
+	return m_capacity;
+}
+
+void SceneClass::GetWorldMatrix(int object, XMMATRIX& worldMatrix)
+{
+	worldMatrix = XMMatrixMultiply(XMMatrixScaling(m_scale[object], m_scale[object], m_scale[object]),
+		XMMatrixTranslation(m_positionX[object], m_positionY[object], m_positionZ[object]));
+	return;
+}
+
+void SceneClass::GetBounds(BoundsType& bounds)
+{
+	bounds.centerX = m_centerX;
+	bounds.centerY = m_centerY;
+	bounds.centerZ = m_centerZ;
+	bounds.extentX = m_extentX;
+	bounds.extentY = m_extentY;
+	bounds.extentZ = m_extentZ;
+	bounds.radius = m_radius;
+	bounds.count = m_count;
+	return;
+}
+
+void SceneClass::GetTransforms(TransformsType& transforms)
+{
+	transforms.positionX = m_positionX;
+	transforms.positionY = m_positionY;
+	transforms.positionZ = m_positionZ;
+	transforms.scale = m_scale;
+	transforms.count = m_count;
+	return;
+}
+
+void SceneClass::UpdateBounds(int object)
+{
+	float scale;
+
+	// a uniform scale keeps the box axis aligned, the sphere is the one around the box.
+	scale = fabsf(m_scale[object]);
+	m_centerX[object] = m_positionX[object] + m_modelCenter.x * m_scale[object];
+	m_centerY[object] = m_positionY[object] + m_modelCenter.y * m_scale[object];
+	m_centerZ[object] = m_positionZ[object] + m_modelCenter.z * m_scale[object];
+	m_extentX[object] = m_modelExtent.x * scale;
+	m_extentY[object] = m_modelExtent.y * scale;
+	m_extentZ[object] = m_modelExtent.z * scale;
+	m_radius[object] = sqrtf(m_extentX[object] * m_extentX[object] + m_extentY[object] * m_extentY[object] + m_extentZ[object] * m_extentZ[object]);
+
+	return;
+}
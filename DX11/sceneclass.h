@@ -0,0 +1,80 @@
+#pragma once
+#ifndef _SCENECLASS_H_
+#define _SCENECLASS_H_
+
+#include <DirectXMath.h>
+using namespace DirectX;
+
+#include "memoryclass.h"
+
+/*
+ * the objects drawn every frame, kept as structure of arrays so the culling stages can load eight of each value at once.
+ * an object is a position and a uniform scale, all of them draw the same model whose bounds SetModelBounds turns into world space boxes and spheres.
+ */
+class SceneClass
+{
+public:
+	// world space bounds, one array per component.
+	struct BoundsType
+	{
+		const float* centerX;
+		const float* centerY;
+		const float* centerZ;
+		const float* extentX;
+		const float* extentY;
+		const float* extentZ;
+		const float* radius;
+		int count;
+	};
+
+	// the transforms themselves, what the instanced draws upload.
+	struct TransformsType
+	{
+		const float* positionX;
+		const float* positionY;
+		const float* positionZ;
+		const float* scale;
+		int count;
+	};
+
+public:
+	SceneClass();
+	SceneClass(const SceneClass&);
+	~SceneClass();
+
+	bool Initialize(int capacity);
+	void Shutdown();
+
+	// returns the object's index, or -1 once the scene is full.
+	int AddObject(float positionX, float positionY, float positionZ, float scale);
+	void SetModelBounds(const XMFLOAT3& center, const XMFLOAT3& extent);
+
+	int GetObjectCount();
+	int GetCapacity();
+	void GetWorldMatrix(int object, XMMATRIX& worldMatrix);
+	void GetBounds(BoundsType& bounds);
+	void GetTransforms(TransformsType& transforms);
+
+private:
+	void UpdateBounds(int object);
+
+private:
+	int m_capacity, m_count;
+	XMFLOAT3 m_modelCenter, m_modelExtent;
+
+	// every array below lives in m_data.
+	float* m_data;
+	float* m_positionX;
+	float* m_positionY;
+	float* m_positionZ;
+	float* m_scale;
+	float* m_centerX;
+	float* m_centerY;
+	float* m_centerZ;
+	float* m_extentX;
+	float* m_extentY;
+	float* m_extentZ;
+	float* m_radius;
+};
+
+#endif
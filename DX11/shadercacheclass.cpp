@@ -0,0 +1,744 @@
+#include "shadercacheclass.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+static const char SHADER_CACHE_MAGIC[4] = { 'D', 'X', 'S', 'C' };
+// an include chain deeper than this is a cycle the visited list did not catch, or not worth following.
+static const int SHADER_INCLUDE_DEPTH = 16;
+
+static bool ReadFile(const char* filename, std::string& data)
+{
+	FILE* file;
+	long size;
+	bool result;
+
+#ifdef _WIN32
+	if(fopen_s(&file, filename, "rb") != 0)
+	{
+		file = nullptr;
+	}
+#else
+	file = fopen(filename, "rb");
+#endif
+	if(!file)
+	{
+		return false;
+	}
+
+	result = fseek(file, 0, SEEK_END) == 0;
+	size = result ? ftell(file) : -1;
+	result = size >= 0 && fseek(file, 0, SEEK_SET) == 0;
+
+	if(result)
+	{
+		data.resize((size_t)size);
+		result = size == 0 || fread(&data[0], (size_t)size, 1, file) == 1;
+	}
+
+	fclose(file);
+
+	return result;
+}
+
+// same hash the mesh importer keys its cooked files with, run twice with different seeds for 128 bits.
+static unsigned long long HashBytes(const char* data, size_t size, unsigned long long seed)
+{
+	const unsigned long long prime1 = 0x9E3779B185EBCA87ULL;
+	const unsigned long long prime2 = 0xC2B2AE3D27D4EB4FULL;
+	unsigned long long lanes[4], word, hash;
+	size_t i;
+	int k;
+
+	lanes[0] = seed + prime1 + prime2;
+	lanes[1] = seed + prime2;
+	lanes[2] = seed;
+	lanes[3] = seed - prime1;
+
+	for(i = 0; i + 32 <= size; i += 32)
+	{
+		for(k = 0; k < 4; k++)
+		{
+			memcpy(&word, data + i + k * 8, 8);
+			lanes[k] += word * prime2;
+			lanes[k] = (lanes[k] << 31) | (lanes[k] >> 33);
+			lanes[k] *= prime1;
+		}
+	}
+
+	hash = lanes[0] ^ ((lanes[1] << 7) | (lanes[1] >> 57)) ^ ((lanes[2] << 12) | (lanes[2] >> 52)) ^ ((lanes[3] << 18) | (lanes[3] >> 46));
+	hash += (unsigned long long)size;
+
+	for(; i < size; i++)
+	{
+		hash = (hash ^ (unsigned char)data[i]) * prime1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDULL;
+	hash ^= hash >> 33;
+	hash *= 0xC4CEB9FE1A85EC53ULL;
+	hash ^= hash >> 33;
+
+	return hash;
+}
+
+// every field goes in with its length in front, so moving bytes from one field to the next changes the key.
+static void AppendField(std::string& keyData, const char* data, size_t size)
+{
+	unsigned long long length;
+
+	length = (unsigned long long)size;
+	keyData.append((const char*)&length, sizeof(length));
+	keyData.append(data, size);
+
+	return;
+}
+
+static std::string GetDirectory(const char* filename)
+{
+	const char* end;
+	const char* c;
+
+	end = filename;
+	for(c = filename; *c; c++)
+	{
+		if(*c == '/' || *c == '\\')
+		{
+			end = c + 1;
+		}
+	}
+
+	return std::string(filename, end);
+}
+
+/*
+ * appends the name and contents of every file the source includes, and of everything those include.
+ * names are resolved relative to the including file like the standard include handler does. the scan is purely textual,
+ * an include inside a comment or a disabled #if still counts, which can only cause an extra miss, never a stale hit.
+ */
+static void AppendIncludes(std::string& keyData, const char* filename, const std::string& source, std::vector<std::string>& visited, int depth)
+{
+	std::string directory, path, contents;
+	size_t i, start;
+	char close;
+	bool lineStart, found;
+
+	if(depth >= SHADER_INCLUDE_DEPTH)
+	{
+		return;
+	}
+
+	directory = GetDirectory(filename);
+	lineStart = true;
+
+	for(i = 0; i < source.size(); i++)
+	{
+		if(source[i] == '\n')
+		{
+			lineStart = true;
+			continue;
+		}
+
+		if(source[i] == ' ' || source[i] == '\t' || source[i] == '\r')
+		{
+			continue;
+		}
+
+		if(!lineStart || source[i] != '#')
+		{
+			lineStart = false;
+			continue;
+		}
+
+		lineStart = false;
+		for(i++; i < source.size() && (source[i] == ' ' || source[i] == '\t'); i++)
+		{
+		}
+
+		if(source.compare(i, 7, "include") != 0)
+		{
+			continue;
+		}
+
+		for(i += 7; i < source.size() && (source[i] == ' ' || source[i] == '\t'); i++)
+		{
+		}
+
+		if(i >= source.size() || (source[i] != '"' && source[i] != '<'))
+		{
+			continue;
+		}
+
+		close = source[i] == '"' ? '"' : '>';
+		start = i + 1;
+		for(i = start; i < source.size() && source[i] != close && source[i] != '\n'; i++)
+		{
+		}
+
+		if(i >= source.size() || source[i] != close)
+		{
+			continue;
+		}
+
+		path = directory + source.substr(start, i - start);
+		AppendField(keyData, path.data(), path.size());
+
+		found = std::find(visited.begin(), visited.end(), path) != visited.end();
+		if(found)
+		{
+			continue;
+		}
+		visited.push_back(path);
+
+		// a missing include is keyed by its name alone, the compile will fail and report it.
+		if(!ReadFile(path.c_str(), contents))
+		{
+			continue;
+		}
+
+		AppendField(keyData, contents.data(), contents.size());
+		AppendIncludes(keyData, path.c_str(), contents, visited, depth + 1);
+	}
+
+	return;
+}
+
+// the reflection blob is three counts followed by the records of each kind.
+static void SerializeReflection(const ShaderReflectionType& reflection, std::vector<unsigned char>& data)
+{
+	unsigned int counts[3];
+	size_t size, offset;
+
+	counts[0] = (unsigned int)reflection.constantBuffers.size();
+	counts[1] = (unsigned int)reflection.inputs.size();
+	counts[2] = (unsigned int)reflection.resources.size();
+
+	size = sizeof(counts) + counts[0] * sizeof(ShaderConstantBufferType) + counts[1] * sizeof(ShaderInputType) + counts[2] * sizeof(ShaderResourceType);
+	data.assign(size, 0);
+
+	offset = 0;
+	memcpy(&data[offset], counts, sizeof(counts));
+	offset += sizeof(counts);
+	if(counts[0])
+	{
+		memcpy(&data[offset], reflection.constantBuffers.data(), counts[0] * sizeof(ShaderConstantBufferType));
+		offset += counts[0] * sizeof(ShaderConstantBufferType);
+	}
+	if(counts[1])
+	{
+		memcpy(&data[offset], reflection.inputs.data(), counts[1] * sizeof(ShaderInputType));
+		offset += counts[1] * sizeof(ShaderInputType);
+	}
+	if(counts[2])
+	{
+		memcpy(&data[offset], reflection.resources.data(), counts[2] * sizeof(ShaderResourceType));
+	}
+
+	return;
+}
+
+static bool DeserializeReflection(const unsigned char* data, unsigned long long size, ShaderReflectionType& reflection)
+{
+	unsigned int counts[3];
+	unsigned long long expected;
+
+	if(size < sizeof(counts))
+	{
+		return false;
+	}
+
+	memcpy(counts, data, sizeof(counts));
+	expected = sizeof(counts) + (unsigned long long)counts[0] * sizeof(ShaderConstantBufferType) +
+		(unsigned long long)counts[1] * sizeof(ShaderInputType) + (unsigned long long)counts[2] * sizeof(ShaderResourceType);
+	if(expected != size)
+	{
+		return false;
+	}
+
+	data += sizeof(counts);
+	reflection.constantBuffers.resize(counts[0]);
+	reflection.inputs.resize(counts[1]);
+	reflection.resources.resize(counts[2]);
+	if(counts[0])
+	{
+		memcpy(reflection.constantBuffers.data(), data, counts[0] * sizeof(ShaderConstantBufferType));
+		data += counts[0] * sizeof(ShaderConstantBufferType);
+	}
+	if(counts[1])
+	{
+		memcpy(reflection.inputs.data(), data, counts[1] * sizeof(ShaderInputType));
+		data += counts[1] * sizeof(ShaderInputType);
+	}
+	if(counts[2])
+	{
+		memcpy(reflection.resources.data(), data, counts[2] * sizeof(ShaderResourceType));
+	}
+
+	return true;
+}
+
+static bool KeyLess(const unsigned long long* a, const unsigned long long* b)
+{
+	return a[0] < b[0] || (a[0] == b[0] && a[1] < b[1]);
+}
+
+static bool WritePadding(FILE* file, unsigned long long& offset)
+{
+	static const unsigned char zeros[SHADER_CACHE_ALIGNMENT] = { 0 };
+	unsigned long long padding;
+
+	padding = (SHADER_CACHE_ALIGNMENT - offset % SHADER_CACHE_ALIGNMENT) % SHADER_CACHE_ALIGNMENT;
+	offset += padding;
+
+	return padding == 0 || fwrite(zeros, (size_t)padding, 1, file) == 1;
+}
+
+ShaderCacheClass::ShaderCacheClass()
+{
+	m_compiler = nullptr;
+	m_entries = nullptr;
+	m_entryCount = 0;
+	memset(&m_statistics, 0, sizeof(m_statistics));
+}
+
+ShaderCacheClass::ShaderCacheClass(const ShaderCacheClass&)
+{
+}
+
+ShaderCacheClass::~ShaderCacheClass()
+{
+}
+
+bool ShaderCacheClass::Initialize(const char* cacheFilename, ShaderCompilerClass* compiler)
+{
+	if(!cacheFilename || !cacheFilename[0])
+	{
+		return false;
+	}
+
+	m_filename = cacheFilename;
+	m_compiler = compiler;
+	memset(&m_statistics, 0, sizeof(m_statistics));
+
+	// no cache yet is not an error, everything misses and the first Save creates it.
+	Open();
+
+	return true;
+}
+
+void ShaderCacheClass::Shutdown()
+{
+	size_t i;
+
+	if(!m_pending.empty())
+	{
+		Save();
+	}
+
+	for(i = 0; i < m_pending.size(); i++)
+	{
+		delete m_pending[i];
+	}
+	m_pending.clear();
+
+	m_file.Close();
+	m_entries = nullptr;
+	m_entryCount = 0;
+	m_compiler = nullptr;
+
+	return;
+}
+
+bool ShaderCacheClass::GetShader(const char* sourceFilename, const char* const* defines, int defineCount, const char* entryPoint, const char* profile,
+	unsigned int flags, ShaderType& shader, std::string& errors)
+{
+	std::string source;
+	std::vector<unsigned char> bytecode;
+	ShaderReflectionType reflection;
+	std::chrono::steady_clock::time_point start;
+	unsigned long long key[2];
+	const EntryType* entry;
+	PendingType* pending;
+	float milliseconds;
+	size_t i;
+	bool result;
+
+	errors.clear();
+	shader.bytecode = nullptr;
+	shader.bytecodeSize = 0;
+	shader.cacheHit = false;
+
+	if(!ReadFile(sourceFilename, source))
+	{
+		errors = std::string("can not read ") + sourceFilename;
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_statistics.failures++;
+		return false;
+	}
+
+	result = ComputeKey(sourceFilename, source, defines, defineCount, entryPoint, profile, flags, key);
+	if(!result)
+	{
+		errors = "no shader compiler";
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_statistics.failures++;
+		return false;
+	}
+
+	// the mapping does not change outside of Save, so it is searched without the lock.
+	entry = FindEntry(key);
+	if(entry && DeserializeReflection(m_file.GetData() + entry->reflectionOffset, entry->reflectionSize, shader.reflection))
+	{
+		shader.bytecode = m_file.GetData() + entry->bytecodeOffset;
+		shader.bytecodeSize = entry->bytecodeSize;
+		shader.cacheHit = true;
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_statistics.hits++;
+		return true;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for(i = 0; i < m_pending.size(); i++)
+		{
+			if(m_pending[i]->key[0] == key[0] && m_pending[i]->key[1] == key[1])
+			{
+				DeserializeReflection(m_pending[i]->reflection.data(), m_pending[i]->reflection.size(), shader.reflection);
+				shader.bytecode = m_pending[i]->bytecode.data();
+				shader.bytecodeSize = m_pending[i]->bytecode.size();
+				shader.cacheHit = true;
+				m_statistics.hits++;
+				return true;
+			}
+		}
+	}
+
+	// compile outside the lock so other threads keep hitting the cache meanwhile.
+	start = std::chrono::steady_clock::now();
+	result = m_compiler->Compile(source.data(), source.size(), sourceFilename, defines, defineCount, entryPoint, profile, flags, bytecode, reflection, errors);
+	milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_statistics.compileMilliseconds += milliseconds;
+	if(!result || bytecode.empty())
+	{
+		m_statistics.failures++;
+		return false;
+	}
+
+	m_statistics.misses++;
+
+	// another thread may have compiled the same shader in the meantime, its copy is kept.
+	for(i = 0; i < m_pending.size(); i++)
+	{
+		if(m_pending[i]->key[0] == key[0] && m_pending[i]->key[1] == key[1])
+		{
+			break;
+		}
+	}
+
+	if(i == m_pending.size())
+	{
+		pending = new PendingType;
+		if(!pending)
+		{
+			return false;
+		}
+
+		pending->key[0] = key[0];
+		pending->key[1] = key[1];
+		pending->bytecode.swap(bytecode);
+		SerializeReflection(reflection, pending->reflection);
+		m_pending.push_back(pending);
+	}
+
+	pending = m_pending[i];
+	shader.bytecode = pending->bytecode.data();
+	shader.bytecodeSize = pending->bytecode.size();
+	shader.reflection = reflection;
+
+	return true;
+}
+
+bool ShaderCacheClass::Save()
+{
+	struct RecordType
+	{
+		EntryType entry;
+		const unsigned char* bytecode;
+		const unsigned char* reflection;
+	};
+
+	std::vector<RecordType> records;
+	std::string temporaryFilename;
+	HeaderType header;
+	RecordType record;
+	FILE* file;
+	unsigned long long offset;
+	unsigned int i;
+	bool result;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if(m_pending.empty())
+	{
+		return true;
+	}
+
+	// pending shaders all missed the mapped index, so the two never share a key.
+	for(i = 0; i < m_entryCount; i++)
+	{
+		record.entry = m_entries[i];
+		record.bytecode = m_file.GetData() + m_entries[i].bytecodeOffset;
+		record.reflection = m_file.GetData() + m_entries[i].reflectionOffset;
+		records.push_back(record);
+	}
+
+	for(i = 0; i < (unsigned int)m_pending.size(); i++)
+	{
+		memset(&record.entry, 0, sizeof(record.entry));
+		record.entry.key[0] = m_pending[i]->key[0];
+		record.entry.key[1] = m_pending[i]->key[1];
+		record.entry.bytecodeSize = m_pending[i]->bytecode.size();
+		record.entry.reflectionSize = m_pending[i]->reflection.size();
+		record.bytecode = m_pending[i]->bytecode.data();
+		record.reflection = m_pending[i]->reflection.data();
+		records.push_back(record);
+	}
+
+	std::sort(records.begin(), records.end(), [](const RecordType& a, const RecordType& b) { return KeyLess(a.entry.key, b.entry.key); });
+
+	temporaryFilename = m_filename + ".tmp";
+#ifdef _WIN32
+	if(fopen_s(&file, temporaryFilename.c_str(), "wb") != 0)
+	{
+		file = nullptr;
+	}
+#else
+	file = fopen(temporaryFilename.c_str(), "wb");
+#endif
+	if(!file)
+	{
+		return false;
+	}
+
+	// the header goes in last, once the index offset is known.
+	memset(&header, 0, sizeof(header));
+	result = fwrite(&header, sizeof(header), 1, file) == 1;
+	offset = sizeof(header);
+
+	for(i = 0; result && i < (unsigned int)records.size(); i++)
+	{
+		result = WritePadding(file, offset);
+		records[i].entry.bytecodeOffset = offset;
+		result = result && fwrite(records[i].bytecode, (size_t)records[i].entry.bytecodeSize, 1, file) == 1;
+		offset += records[i].entry.bytecodeSize;
+
+		result = result && WritePadding(file, offset);
+		records[i].entry.reflectionOffset = offset;
+		result = result && fwrite(records[i].reflection, (size_t)records[i].entry.reflectionSize, 1, file) == 1;
+		offset += records[i].entry.reflectionSize;
+	}
+
+	result = result && WritePadding(file, offset);
+	memcpy(header.magic, SHADER_CACHE_MAGIC, sizeof(header.magic));
+	header.version = SHADER_CACHE_VERSION;
+	header.entryCount = (unsigned int)records.size();
+	header.indexOffset = offset;
+
+	for(i = 0; result && i < (unsigned int)records.size(); i++)
+	{
+		result = fwrite(&records[i].entry, sizeof(EntryType), 1, file) == 1;
+	}
+
+	result = result && fseek(file, 0, SEEK_SET) == 0;
+	result = result && fwrite(&header, sizeof(header), 1, file) == 1;
+	result = fclose(file) == 0 && result;
+
+	if(!result)
+	{
+		remove(temporaryFilename.c_str());
+		return false;
+	}
+
+	// the old file has to be unmapped before it can be replaced.
+	records.clear();
+	m_file.Close();
+	m_entries = nullptr;
+	m_entryCount = 0;
+
+#ifdef _WIN32
+	result = MoveFileExA(temporaryFilename.c_str(), m_filename.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	result = rename(temporaryFilename.c_str(), m_filename.c_str()) == 0;
+#endif
+
+	// when the move failed this maps the old file again and the pending shaders are kept for the next try.
+	Open();
+	if(!result)
+	{
+		remove(temporaryFilename.c_str());
+		return false;
+	}
+
+	for(i = 0; i < (unsigned int)m_pending.size(); i++)
+	{
+		delete m_pending[i];
+	}
+	m_pending.clear();
+
+	return true;
+}
+
+void ShaderCacheClass::GetStatistics(StatisticsType& statistics)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	statistics = m_statistics;
+	statistics.entries = (int)(m_entryCount + m_pending.size());
+
+	return;
+}
+
+bool ShaderCacheClass::Open()
+{
+	bool result;
+
+	result = m_file.Open(m_filename.c_str());
+	if(!result)
+	{
+		return false;
+	}
+
+	result = Validate();
+	if(!result)
+	{
+		// a broken or older cache is ignored, the next Save writes over it.
+		m_file.Close();
+		return false;
+	}
+
+	m_entries = (const EntryType*)(m_file.GetData() + ((const HeaderType*)m_file.GetData())->indexOffset);
+	m_entryCount = ((const HeaderType*)m_file.GetData())->entryCount;
+
+	return true;
+}
+
+bool ShaderCacheClass::Validate()
+{
+	const HeaderType* header;
+	const EntryType* entries;
+	unsigned long long size;
+	unsigned int i;
+
+	size = m_file.GetSize();
+	if(size < sizeof(HeaderType))
+	{
+		return false;
+	}
+
+	header = (const HeaderType*)m_file.GetData();
+	if(memcmp(header->magic, SHADER_CACHE_MAGIC, sizeof(header->magic)) != 0 || header->version != SHADER_CACHE_VERSION)
+	{
+		return false;
+	}
+
+	if(header->indexOffset % SHADER_CACHE_ALIGNMENT != 0 || header->indexOffset > size ||
+		header->entryCount > (size - header->indexOffset) / sizeof(EntryType))
+	{
+		return false;
+	}
+
+	// every blob has to lie between the header and the index, and the keys have to be sorted for the binary search.
+	entries = (const EntryType*)(m_file.GetData() + header->indexOffset);
+	for(i = 0; i < header->entryCount; i++)
+	{
+		if(entries[i].bytecodeOffset < sizeof(HeaderType) || entries[i].bytecodeOffset > header->indexOffset ||
+			entries[i].bytecodeSize > header->indexOffset - entries[i].bytecodeOffset)
+		{
+			return false;
+		}
+
+		if(entries[i].reflectionOffset < sizeof(HeaderType) || entries[i].reflectionOffset > header->indexOffset ||
+			entries[i].reflectionSize > header->indexOffset - entries[i].reflectionOffset)
+		{
+			return false;
+		}
+
+		if(i > 0 && !KeyLess(entries[i - 1].key, entries[i].key))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+const ShaderCacheClass::EntryType* ShaderCacheClass::FindEntry(const unsigned long long* key)
+{
+	unsigned int low, high, middle;
+
+	low = 0;
+	high = m_entryCount;
+	while(low < high)
+	{
+		middle = low + (high - low) / 2;
+		if(KeyLess(m_entries[middle].key, key))
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	if(low < m_entryCount && m_entries[low].key[0] == key[0] && m_entries[low].key[1] == key[1])
+	{
+		return &m_entries[low];
+	}
+
+	return nullptr;
+}
+
+bool ShaderCacheClass::ComputeKey(const char* sourceFilename, const std::string& source, const char* const* defines, int defineCount,
+	const char* entryPoint, const char* profile, unsigned int flags, unsigned long long* key)
+{
+	std::vector<std::string> visited;
+	std::string keyData;
+	unsigned int version;
+	int i;
+
+	if(!m_compiler)
+	{
+		return false;
+	}
+
+	version = SHADER_CACHE_VERSION;
+	AppendField(keyData, (const char*)&version, sizeof(version));
+	AppendField(keyData, m_compiler->GetName(), strlen(m_compiler->GetName()));
+	AppendField(keyData, source.data(), source.size());
+	AppendField(keyData, (const char*)&defineCount, sizeof(defineCount));
+	for(i = 0; i < defineCount; i++)
+	{
+		AppendField(keyData, defines[i], strlen(defines[i]));
+	}
+	AppendField(keyData, entryPoint, strlen(entryPoint));
+	AppendField(keyData, profile, strlen(profile));
+	AppendField(keyData, (const char*)&flags, sizeof(flags));
+	AppendIncludes(keyData, sourceFilename, source, visited, 0);
+
+	key[0] = HashBytes(keyData.data(), keyData.size(), 0x5348414445524341ULL);
+	key[1] = HashBytes(keyData.data(), keyData.size(), 0x4458313143414348ULL);
+
+	return true;
+}
@@ -0,0 +1,111 @@
+#pragma once
+#ifndef _SHADERCACHECLASS_H_
+#define _SHADERCACHECLASS_H_
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "mappedfileclass.h"
+#include "shadercompilerclass.h"
+
+const unsigned int SHADER_CACHE_VERSION = 2;
+// bytecode and reflection blobs start on this boundary inside the file.
+const unsigned int SHADER_CACHE_ALIGNMENT = 16;
+
+/*
+ * content addressed cache of compiled shaders in one file.
+ * the key is a 128 bit hash of the compiler name, the source, every file it includes (followed recursively), the defines, the entry point,
+ * the profile and the flags, so editing a shader or anything it includes simply misses and the stale entry is never looked at again.
+ * the file is a header, the bytecode and reflection blobs, then an index sorted by key. it is memory mapped and searched in place,
+ * a hit hands out a pointer into the mapping without copying or compiling anything.
+ * misses are compiled, kept in memory and written out together by Save.
+ */
+class ShaderCacheClass
+{
+public:
+	struct ShaderType
+	{
+		// valid until the next Save or Shutdown.
+		const void* bytecode;
+		unsigned long long bytecodeSize;
+		ShaderReflectionType reflection;
+		bool cacheHit;
+	};
+
+	struct StatisticsType
+	{
+		int hits;
+		int misses;
+		int failures;
+		// spent inside the compiler on misses.
+		float compileMilliseconds;
+		int entries;
+	};
+
+public:
+	ShaderCacheClass();
+	ShaderCacheClass(const ShaderCacheClass&);
+	~ShaderCacheClass();
+
+	// a missing or unreadable cache file starts out empty. the compiler is only used on a miss.
+	bool Initialize(const char* cacheFilename, ShaderCompilerClass* compiler);
+	// saves first when anything was compiled.
+	void Shutdown();
+
+	// safe to call from several threads at once, but not while Save runs.
+	// the defines are all set to 1, their order is part of the key.
+	bool GetShader(const char* sourceFilename, const char* const* defines, int defineCount, const char* entryPoint, const char* profile, unsigned int flags,
+		ShaderType& shader, std::string& errors);
+	// merges what was compiled into the file, it is written next to it and then moved over it.
+	bool Save();
+
+	void GetStatistics(StatisticsType& statistics);
+
+private:
+	struct HeaderType
+	{
+		char magic[4];
+		unsigned int version;
+		unsigned int entryCount;
+		unsigned int reserved;
+		unsigned long long indexOffset;
+	};
+
+	struct EntryType
+	{
+		unsigned long long key[2];
+		unsigned long long bytecodeOffset;
+		unsigned long long bytecodeSize;
+		unsigned long long reflectionOffset;
+		unsigned long long reflectionSize;
+	};
+
+	struct PendingType
+	{
+		unsigned long long key[2];
+		std::vector<unsigned char> bytecode;
+		std::vector<unsigned char> reflection;
+	};
+
+	bool Open();
+	bool Validate();
+	const EntryType* FindEntry(const unsigned long long* key);
+
+	bool ComputeKey(const char* sourceFilename, const std::string& source, const char* const* defines, int defineCount, const char* entryPoint,
+		const char* profile, unsigned int flags, unsigned long long* key);
+
+private:
+	std::string m_filename;
+	ShaderCompilerClass* m_compiler;
+
+	MappedFileClass m_file;
+	const EntryType* m_entries;
+	unsigned int m_entryCount;
+
+	std::mutex m_mutex;
+	std::vector<PendingType*> m_pending;
+	StatisticsType m_statistics;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#pragma once
+#ifndef _SHADERCOMPILERCLASS_H_
+#define _SHADERCOMPILERCLASS_H_
+
+#include <string>
+#include <vector>
+
+// names longer than this are cut short in the reflection data.
+const unsigned int SHADER_NAME_LENGTH = 32;
+
+// what the shader cache keeps about a shader besides its bytecode, every record is plain old data so it can be stored as it is.
+struct ShaderConstantBufferType
+{
+	char name[SHADER_NAME_LENGTH];
+	unsigned int slot;
+	unsigned int size;
+};
+
+struct ShaderInputType
+{
+	char semanticName[SHADER_NAME_LENGTH];
+	unsigned int semanticIndex;
+	// D3D_REGISTER_COMPONENT_TYPE and the xyzw bit mask.
+	unsigned int componentType;
+	unsigned int mask;
+};
+
+struct ShaderResourceType
+{
+	char name[SHADER_NAME_LENGTH];
+	// D3D_SHADER_INPUT_TYPE.
+	unsigned int type;
+	unsigned int slot;
+	unsigned int count;
+};
+
+struct ShaderReflectionType
+{
+	std::vector<ShaderConstantBufferType> constantBuffers;
+	std::vector<ShaderInputType> inputs;
+	std::vector<ShaderResourceType> resources;
+};
+
+/*
+ * turns hlsl source into bytecode for the shader cache.
+ * D3DShaderCompilerClass uses d3dcompiler, anything else (a stub on machines without it) only has to fill the same outputs.
+ * the cache only calls the compiler when it misses, and may call it from several threads at once.
+ */
+class ShaderCompilerClass
+{
+public:
+	virtual ~ShaderCompilerClass() {}
+
+	// goes into every cache key, a different compiler or compiler version never sees another one's bytecode.
+	virtual const char* GetName() = 0;
+
+	// includes are resolved relative to the source name and every define is set to 1. on failure errors holds the compiler output.
+	virtual bool Compile(const char* source, unsigned long long sourceSize, const char* sourceName, const char* const* defines, int defineCount,
+		const char* entryPoint, const char* profile, unsigned int flags, std::vector<unsigned char>& bytecode, ShaderReflectionType& reflection,
+		std::string& errors) = 0;
+};
+
+#endif
@@ -0,0 +1,242 @@
+#include "shaderpermutationclass.h"
+
+#include "jobsystemclass.h"
+
+ShaderPermutationClass::ShaderPermutationClass()
+{
+	int i;
+
+	m_shaderCache = nullptr;
+	m_jobSystem = nullptr;
+	m_keywordCount = 0;
+	m_vertexStage = StageType();
+	m_pixelStage = StageType();
+
+	for(i = 0; i < SHADER_PERMUTATION_MAX_KEYWORDS; i++)
+	{
+		m_keywords[i] = nullptr;
+	}
+
+	for(i = 0; i < SHADER_PERMUTATION_MAX_VARIANTS; i++)
+	{
+		m_vertexShaders[i] = nullptr;
+		m_pixelShaders[i] = nullptr;
+		m_variants[i].vertexShader = nullptr;
+		m_variants[i].pixelShader = nullptr;
+	}
+}
+
+ShaderPermutationClass::ShaderPermutationClass(const ShaderPermutationClass&)
+{
+}
+
+ShaderPermutationClass::~ShaderPermutationClass()
+{
+}
+
+bool ShaderPermutationClass::Initialize(ShaderCacheClass* shaderCache, JobSystemClass* jobSystem, const char* const* keywords, int keywordCount,
+	const StageType& vertexStage, const StageType& pixelStage)
+{
+	int i;
+
+	if(!shaderCache || keywordCount < 0 || keywordCount > SHADER_PERMUTATION_MAX_KEYWORDS)
+	{
+		return false;
+	}
+
+	m_shaderCache = shaderCache;
+	m_jobSystem = jobSystem;
+	m_keywordCount = keywordCount;
+	for(i = 0; i < keywordCount; i++)
+	{
+		m_keywords[i] = keywords[i];
+	}
+
+	m_vertexStage = vertexStage;
+	m_pixelStage = pixelStage;
+
+	// keywords past the declared ones would index outside the tables.
+	m_vertexStage.keywords &= (1u << keywordCount) - 1;
+	m_pixelStage.keywords &= (1u << keywordCount) - 1;
+
+	return true;
+}
+
+void ShaderPermutationClass::Shutdown()
+{
+	int i;
+
+	for(i = 0; i < SHADER_PERMUTATION_MAX_VARIANTS; i++)
+	{
+		if(m_vertexShaders[i])
+		{
+			delete m_vertexShaders[i];
+			m_vertexShaders[i] = nullptr;
+		}
+
+		if(m_pixelShaders[i])
+		{
+			delete m_pixelShaders[i];
+			m_pixelShaders[i] = nullptr;
+		}
+
+		m_variants[i].vertexShader = nullptr;
+		m_variants[i].pixelShader = nullptr;
+	}
+
+	m_shaderCache = nullptr;
+	m_jobSystem = nullptr;
+	m_keywordCount = 0;
+
+	return;
+}
+
+bool ShaderPermutationClass::Compile(const unsigned int* variants, int variantCount, std::string& errors)
+{
+	std::vector<JobType> jobs;
+	bool vertexQueued[SHADER_PERMUTATION_MAX_VARIANTS];
+	bool pixelQueued[SHADER_PERMUTATION_MAX_VARIANTS];
+	JobType job;
+	unsigned int variant, keywords;
+	int i;
+	bool result;
+
+	errors.clear();
+
+	for(i = 0; i < SHADER_PERMUTATION_MAX_VARIANTS; i++)
+	{
+		vertexQueued[i] = m_vertexShaders[i] != nullptr;
+		pixelQueued[i] = m_pixelShaders[i] != nullptr;
+	}
+
+	// one job per stage shader that is needed and not there yet, variants sharing a stage share its job.
+	job.result = false;
+	for(i = 0; i < variantCount; i++)
+	{
+		variant = variants[i];
+		if(variant >= (1u << m_keywordCount))
+		{
+			errors += "variant out of range\n";
+			return false;
+		}
+
+		keywords = variant & m_vertexStage.keywords;
+		if(!vertexQueued[keywords])
+		{
+			vertexQueued[keywords] = true;
+			job.stage = &m_vertexStage;
+			job.keywords = keywords;
+			jobs.push_back(job);
+		}
+
+		keywords = variant & m_pixelStage.keywords;
+		if(!pixelQueued[keywords])
+		{
+			pixelQueued[keywords] = true;
+			job.stage = &m_pixelStage;
+			job.keywords = keywords;
+			jobs.push_back(job);
+		}
+	}
+
+	for(i = 0; i < (int)jobs.size(); i++)
+	{
+		jobs[i].shader = new ShaderCacheClass::ShaderType;
+		if(!jobs[i].shader)
+		{
+			return false;
+		}
+	}
+
+	// one stage per job, compiling even a small shader is plenty of work.
+	auto compileRange = [this, &jobs](int first, int last)
+	{
+		int index;
+
+		for(index = first; index < last; index++)
+		{
+			CompileJob(jobs[index]);
+		}
+	};
+
+	if(m_jobSystem)
+	{
+		m_jobSystem->ParallelFor((int)jobs.size(), 1, compileRange);
+	}
+	else
+	{
+		compileRange(0, (int)jobs.size());
+	}
+
+	result = true;
+	for(i = 0; i < (int)jobs.size(); i++)
+	{
+		if(!jobs[i].result)
+		{
+			errors += std::string(jobs[i].stage->filename) + " " + jobs[i].stage->entryPoint + ":\n" + jobs[i].errors + "\n";
+			delete jobs[i].shader;
+			result = false;
+			continue;
+		}
+
+		if(jobs[i].stage == &m_vertexStage)
+		{
+			m_vertexShaders[jobs[i].keywords] = jobs[i].shader;
+		}
+		else
+		{
+			m_pixelShaders[jobs[i].keywords] = jobs[i].shader;
+		}
+	}
+
+	// a variant only becomes selectable once both of its stages compiled.
+	for(i = 0; i < variantCount; i++)
+	{
+		variant = variants[i];
+		m_variants[variant].vertexShader = m_vertexShaders[variant & m_vertexStage.keywords];
+		m_variants[variant].pixelShader = m_pixelShaders[variant & m_pixelStage.keywords];
+		if(!m_variants[variant].vertexShader || !m_variants[variant].pixelShader)
+		{
+			m_variants[variant].vertexShader = nullptr;
+			m_variants[variant].pixelShader = nullptr;
+		}
+	}
+
+	return result;
+}
+
+const ShaderPermutationClass::VariantType* ShaderPermutationClass::GetVariant(unsigned int variant)
+{
+	if(variant >= (unsigned int)SHADER_PERMUTATION_MAX_VARIANTS || !m_variants[variant].vertexShader)
+	{
+		return nullptr;
+	}
+
+	return &m_variants[variant];
+}
+
+int ShaderPermutationClass::GetKeywordCount()
+{
+	return m_keywordCount;
+}
+
+void ShaderPermutationClass::CompileJob(JobType& job)
+{
+	const char* defines[SHADER_PERMUTATION_MAX_KEYWORDS];
+	int i, defineCount;
+
+	// the defines go in keyword order, so a variant always has the same cache key.
+	defineCount = 0;
+	for(i = 0; i < m_keywordCount; i++)
+	{
+		if(job.keywords & (1u << i))
+		{
+			defines[defineCount++] = m_keywords[i];
+		}
+	}
+
+	job.result = m_shaderCache->GetShader(job.stage->filename, defines, defineCount, job.stage->entryPoint, job.stage->profile, job.stage->flags,
+		*job.shader, job.errors);
+
+	return;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#ifndef _SHADERPERMUTATIONCLASS_H_
+#define _SHADERPERMUTATIONCLASS_H_
+
+#include <string>
+#include <vector>
+
+#include "shadercacheclass.h"
+
+class JobSystemClass;
+
+// a variant is a bitmask of keywords, so this many keywords give a table of 256 variants.
+const int SHADER_PERMUTATION_MAX_KEYWORDS = 8;
+const int SHADER_PERMUTATION_MAX_VARIANTS = 1 << SHADER_PERMUTATION_MAX_KEYWORDS;
+
+/*
+ * the variants of one vertex and pixel shader pair.
+ * every keyword is a define the hlsl tests with #if, a variant compiles the pair with the defines of its bits set.
+ * only the variants asked for are compiled, together on the job system's threads and through the shader cache, so a warm start compiles nothing at all.
+ * each stage lists the keywords it reads, variants that only differ in keywords a stage ignores share that stage's bytecode.
+ * at draw time a variant is found by indexing a table with its mask.
+ */
+class ShaderPermutationClass
+{
+public:
+	struct StageType
+	{
+		const char* filename;
+		const char* entryPoint;
+		const char* profile;
+		unsigned int flags;
+		// the keywords this stage's source tests.
+		unsigned int keywords;
+	};
+
+	struct VariantType
+	{
+		// point into the shader cache, valid until its next Save or Shutdown.
+		const ShaderCacheClass::ShaderType* vertexShader;
+		const ShaderCacheClass::ShaderType* pixelShader;
+	};
+
+public:
+	ShaderPermutationClass();
+	ShaderPermutationClass(const ShaderPermutationClass&);
+	~ShaderPermutationClass();
+
+	// without a job system the variants compile one after the other on the calling thread.
+	bool Initialize(ShaderCacheClass* shaderCache, JobSystemClass* jobSystem, const char* const* keywords, int keywordCount, const StageType& vertexStage,
+		const StageType& pixelStage);
+	void Shutdown();
+
+	// compiles whatever of the given variants is still missing.
+	bool Compile(const unsigned int* variants, int variantCount, std::string& errors);
+
+	// null when the variant was never compiled.
+	const VariantType* GetVariant(unsigned int variant);
+
+	int GetKeywordCount();
+
+private:
+	struct JobType
+	{
+		const StageType* stage;
+		unsigned int keywords;
+		ShaderCacheClass::ShaderType* shader;
+		std::string errors;
+		bool result;
+	};
+
+	void CompileJob(JobType& job);
+
+private:
+	ShaderCacheClass* m_shaderCache;
+	JobSystemClass* m_jobSystem;
+	const char* m_keywords[SHADER_PERMUTATION_MAX_KEYWORDS];
+	int m_keywordCount;
+	StageType m_vertexStage;
+	StageType m_pixelStage;
+
+	// one shader per stage and distinct mask of the keywords it reads, indexed by that mask.
+	ShaderCacheClass::ShaderType* m_vertexShaders[SHADER_PERMUTATION_MAX_VARIANTS];
+	ShaderCacheClass::ShaderType* m_pixelShaders[SHADER_PERMUTATION_MAX_VARIANTS];
+	VariantType m_variants[SHADER_PERMUTATION_MAX_VARIANTS];
+};
+
+#endif
@@ -0,0 +1,140 @@
+#include "softwarecommandlistclass.h"
+
+SoftwareCommandListClass::SoftwareCommandListClass()
+{
+	m_rasterizer = nullptr;
+	m_rasterDesc.CullMode = SOFTWARE_CULL_BACK;
+	m_rasterDesc.FrontCounterClockwise = false;
+	m_rasterDesc.DepthClipEnable = true;
+	m_vertices = nullptr;
+	m_vertexStride = 0;
+	m_vertexCount = 0;
+	m_indices = nullptr;
+	m_matrices[0] = XMMatrixIdentity();
+	m_matrices[1] = XMMatrixIdentity();
+	m_matrices[2] = XMMatrixIdentity();
+}
+
+SoftwareCommandListClass::SoftwareCommandListClass(const SoftwareCommandListClass&)
+{
+}
+
+SoftwareCommandListClass::~SoftwareCommandListClass()
+{
+}
+
+bool SoftwareCommandListClass::Initialize(SoftwareRasterizerClass* rasterizer)
+{
+	if(!rasterizer)
+	{
+		return false;
+	}
+
+	m_rasterizer = rasterizer;
+	Reset();
+
+	return true;
+}
+
+void SoftwareCommandListClass::Shutdown()
+{
+	m_clipVertices.clear();
+	m_clipVertices.shrink_to_fit();
+	m_triangles.clear();
+	m_triangles.shrink_to_fit();
+	m_rasterizer = nullptr;
+
+	return;
+}
+
+void SoftwareCommandListClass::Reset()
+{
+	// nothing but the rasterizer state carries over, buffers and matrices have to be set again as on a deferred context.
+	m_rasterDesc = m_rasterizer->m_rasterDesc;
+	m_vertices = nullptr;
+	m_vertexStride = 0;
+	m_vertexCount = 0;
+	m_indices = nullptr;
+	m_matrices[0] = XMMatrixIdentity();
+	m_matrices[1] = XMMatrixIdentity();
+	m_matrices[2] = XMMatrixIdentity();
+	m_triangles.clear();
+
+	return;
+}
+
+void SoftwareCommandListClass::RSSetState(const SoftwareRasterizerClass::RasterizerDescType& rasterDesc)
+{
+	m_rasterDesc = rasterDesc;
+	return;
+}
+
+void SoftwareCommandListClass::IASetVertexBuffer(const void* vertices, unsigned int stride, int vertexCount)
+{
+	m_vertices = (const unsigned char*)vertices;
+	m_vertexStride = stride;
+	m_vertexCount = vertexCount;
+	return;
+}
+
+void SoftwareCommandListClass::IASetIndexBuffer(const unsigned int* indices)
+{
+	m_indices = indices;
+	return;
+}
+
+void SoftwareCommandListClass::VSSetMatrices(XMMATRIX worldMatrix, XMMATRIX viewMatrix, XMMATRIX projectionMatrix)
+{
+	m_matrices[0] = worldMatrix;
+	m_matrices[1] = viewMatrix;
+	m_matrices[2] = projectionMatrix;
+	return;
+}
+
+void SoftwareCommandListClass::DrawIndexed(int indexCount, int startIndexLocation, int baseVertexLocation)
+{
+	SoftwareRasterizerClass::ClipVertexType triangle[3];
+	const unsigned int* indices;
+	int i, k, triangleCount, firstVertex, drawVertexCount;
+
+	if(!m_vertices || !m_indices || indexCount < 3)
+	{
+		return;
+	}
+
+	if(!SoftwareRasterizerClass::GetDrawVertices(m_indices, m_vertexCount, indexCount, startIndexLocation, baseVertexLocation, firstVertex,
+		drawVertexCount))
+	{
+		return;
+	}
+
+	// transform every vertex the draw uses once, then clip, cull and set up its triangles in order.
+	if((int)m_clipVertices.size() < drawVertexCount)
+	{
+		m_clipVertices.resize(drawVertexCount);
+	}
+
+	for(i = 0; i < drawVertexCount; i++)
+	{
+		SoftwareRasterizerClass::TransformVertex(m_vertices + (firstVertex + i) * m_vertexStride, m_matrices, m_clipVertices[i]);
+	}
+
+	triangleCount = indexCount / 3;
+	for(i = 0; i < triangleCount; i++)
+	{
+		indices = m_indices + startIndexLocation + i * 3;
+		for(k = 0; k < 3; k++)
+		{
+			triangle[k] = m_clipVertices[baseVertexLocation + (int)indices[k] - firstVertex];
+		}
+
+		m_rasterizer->ClipTriangle(m_rasterDesc, triangle, m_triangles);
+	}
+
+	return;
+}
+
+int SoftwareCommandListClass::GetTriangleCount()
+{
+	return (int)m_triangles.size();
+}
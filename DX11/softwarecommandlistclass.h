@@ -0,0 +1,58 @@
+#pragma once
+#ifndef _SOFTWARECOMMANDLISTCLASS_H_
+#define _SOFTWARECOMMANDLISTCLASS_H_
+
+#include <DirectXMath.h>
+#include <vector>
+
+#include "softwarerasterizerclass.h"
+
+using namespace DirectX;
+
+/*
+ * draws for the software rasterizer recorded away from the render thread, what a deferred context's command list is on the device.
+ * recording runs the vertex transform, clipping and triangle setup of every draw right away on the recording thread, into the list's own triangles.
+ * SoftwareRasterizerClass::ExecuteCommandList then only has to bin them, so setup scales with the threads recording,
+ * and lists executed in a fixed order give exactly the same frame however the draws were spread over them.
+ * one list is only ever recorded by one thread at a time, and not while it is being executed.
+ */
+class SoftwareCommandListClass
+{
+	friend class SoftwareRasterizerClass;
+
+public:
+	SoftwareCommandListClass();
+	SoftwareCommandListClass(const SoftwareCommandListClass&);
+	~SoftwareCommandListClass();
+
+	bool Initialize(SoftwareRasterizerClass* rasterizer);
+	void Shutdown();
+
+	// empties the list and starts over from the rasterizer's current state, like a fresh deferred context.
+	void Reset();
+
+	// the same calls as on the rasterizer.
+	void RSSetState(const SoftwareRasterizerClass::RasterizerDescType& rasterDesc);
+	void IASetVertexBuffer(const void* vertices, unsigned int stride, int vertexCount);
+	void IASetIndexBuffer(const unsigned int* indices);
+	void VSSetMatrices(XMMATRIX worldMatrix, XMMATRIX viewMatrix, XMMATRIX projectionMatrix);
+	void DrawIndexed(int indexCount, int startIndexLocation, int baseVertexLocation);
+
+	int GetTriangleCount();
+
+private:
+	SoftwareRasterizerClass* m_rasterizer;
+
+	SoftwareRasterizerClass::RasterizerDescType m_rasterDesc;
+	const unsigned char* m_vertices;
+	unsigned int m_vertexStride;
+	int m_vertexCount;
+	const unsigned int* m_indices;
+	XMMATRIX m_matrices[3];
+
+	// per draw scratch, and everything the list's draws set up in their order. both keep their memory across Reset.
+	std::vector<SoftwareRasterizerClass::ClipVertexType> m_clipVertices;
+	std::vector<SoftwareRasterizerClass::TriangleType> m_triangles;
+};
+
+#endif
@@ -0,0 +1,857 @@
+#include "softwarerasterizerclass.h"
+#include "softwarecommandlistclass.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+
+// the framebuffer is split in square tiles, each tile is rasterized by one thread.
+static const int TILE_SIZE = 64;
+
+// triangles reaching further than this many times w outside the viewport are clipped so the edge equations stay precise.
+static const float GUARD_BAND = 4.0f;
+
+// 24 bit unorm depth, same as the DXGI_FORMAT_D24_UNORM_S8_UINT buffer D3DClass creates.
+static const float DEPTH_SCALE = 16777215.0f;
+static const unsigned int DEPTH_CLEAR = 0x00FFFFFF;
+
+/*
+ * the pixel loops are written once against these wrappers.
+ * AVX2 builds (the x64 configurations, DX11_AVX2 with cmake) shade 8 pixels at a time, everything else 4 pixels with SSE2.
+ * both paths use the exact same sequence of multiplies and adds (no fma) so they write the same bits.
+ */
+#if defined(__AVX2__)
+
+#define SIMD_WIDTH 8
+
+typedef __m256 SimdFloat;
+typedef __m256i SimdInt;
+
+static inline SimdFloat SimdSet(float value) { return _mm256_set1_ps(value); }
+static inline SimdFloat SimdLaneCenters() { return _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f); }
+static inline SimdFloat SimdAdd(SimdFloat a, SimdFloat b) { return _mm256_add_ps(a, b); }
+static inline SimdFloat SimdMul(SimdFloat a, SimdFloat b) { return _mm256_mul_ps(a, b); }
+static inline SimdFloat SimdDiv(SimdFloat a, SimdFloat b) { return _mm256_div_ps(a, b); }
+static inline SimdFloat SimdMin(SimdFloat a, SimdFloat b) { return _mm256_min_ps(a, b); }
+static inline SimdFloat SimdMax(SimdFloat a, SimdFloat b) { return _mm256_max_ps(a, b); }
+static inline SimdFloat SimdAnd(SimdFloat a, SimdFloat b) { return _mm256_and_ps(a, b); }
+static inline SimdFloat SimdOr(SimdFloat a, SimdFloat b) { return _mm256_or_ps(a, b); }
+static inline SimdFloat SimdGreater(SimdFloat a, SimdFloat b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+static inline SimdFloat SimdEqual(SimdFloat a, SimdFloat b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+static inline SimdFloat SimdLess(SimdFloat a, SimdFloat b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline int SimdAny(SimdFloat mask) { return _mm256_movemask_ps(mask); }
+static inline SimdInt SimdToInt(SimdFloat a) { return _mm256_cvtps_epi32(a); }
+static inline SimdInt SimdLoad(const unsigned int* p) { return _mm256_loadu_si256((const __m256i*)p); }
+static inline void SimdStore(unsigned int* p, SimdInt a) { _mm256_storeu_si256((__m256i*)p, a); }
+static inline SimdFloat SimdLessInt(SimdInt a, SimdInt b) { return _mm256_castsi256_ps(_mm256_cmpgt_epi32(b, a)); }
+static inline SimdInt SimdSelect(SimdFloat mask, SimdInt a, SimdInt b) { return _mm256_blendv_epi8(b, a, _mm256_castps_si256(mask)); }
+static inline SimdInt SimdPackColor(SimdInt r, SimdInt g, SimdInt b, SimdInt a)
+{
+	return _mm256_or_si256(_mm256_or_si256(r, _mm256_slli_epi32(g, 8)), _mm256_or_si256(_mm256_slli_epi32(b, 16), _mm256_slli_epi32(a, 24)));
+}
+
+#else
+
+#define SIMD_WIDTH 4
+
+typedef __m128 SimdFloat;
+typedef __m128i SimdInt;
+
+static inline SimdFloat SimdSet(float value) { return _mm_set1_ps(value); }
+static inline SimdFloat SimdLaneCenters() { return _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f); }
+static inline SimdFloat SimdAdd(SimdFloat a, SimdFloat b) { return _mm_add_ps(a, b); }
+static inline SimdFloat SimdMul(SimdFloat a, SimdFloat b) { return _mm_mul_ps(a, b); }
+static inline SimdFloat SimdDiv(SimdFloat a, SimdFloat b) { return _mm_div_ps(a, b); }
+static inline SimdFloat SimdMin(SimdFloat a, SimdFloat b) { return _mm_min_ps(a, b); }
+static inline SimdFloat SimdMax(SimdFloat a, SimdFloat b) { return _mm_max_ps(a, b); }
+static inline SimdFloat SimdAnd(SimdFloat a, SimdFloat b) { return _mm_and_ps(a, b); }
+static inline SimdFloat SimdOr(SimdFloat a, SimdFloat b) { return _mm_or_ps(a, b); }
+static inline SimdFloat SimdGreater(SimdFloat a, SimdFloat b) { return _mm_cmpgt_ps(a, b); }
+static inline SimdFloat SimdEqual(SimdFloat a, SimdFloat b) { return _mm_cmpeq_ps(a, b); }
+static inline SimdFloat SimdLess(SimdFloat a, SimdFloat b) { return _mm_cmplt_ps(a, b); }
+static inline int SimdAny(SimdFloat mask) { return _mm_movemask_ps(mask); }
+static inline SimdInt SimdToInt(SimdFloat a) { return _mm_cvtps_epi32(a); }
+static inline SimdInt SimdLoad(const unsigned int* p) { return _mm_loadu_si128((const __m128i*)p); }
+static inline void SimdStore(unsigned int* p, SimdInt a) { _mm_storeu_si128((__m128i*)p, a); }
+static inline SimdFloat SimdLessInt(SimdInt a, SimdInt b) { return _mm_castsi128_ps(_mm_cmpgt_epi32(b, a)); }
+static inline SimdInt SimdSelect(SimdFloat mask, SimdInt a, SimdInt b)
+{
+	__m128i m = _mm_castps_si128(mask);
+	return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+}
+static inline SimdInt SimdPackColor(SimdInt r, SimdInt g, SimdInt b, SimdInt a)
+{
+	return _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(b, 16), _mm_slli_epi32(a, 24)));
+}
+
+#endif
+
+static inline float SnapToSubpixel(float value)
+{
+	// snap to 1/16th of a pixel like the hardware does so edges shared by two triangles line up exactly.
+	return floorf(value * 16.0f + 0.5f) * (1.0f / 16.0f);
+}
+
+static inline unsigned int PackColor(float red, float green, float blue, float alpha)
+{
+	unsigned int r, g, b, a;
+
+	r = (unsigned int)(fminf(fmaxf(red, 0.0f), 1.0f) * 255.0f + 0.5f);
+	g = (unsigned int)(fminf(fmaxf(green, 0.0f), 1.0f) * 255.0f + 0.5f);
+	b = (unsigned int)(fminf(fmaxf(blue, 0.0f), 1.0f) * 255.0f + 0.5f);
+	a = (unsigned int)(fminf(fmaxf(alpha, 0.0f), 1.0f) * 255.0f + 0.5f);
+
+	return r | (g << 8) | (b << 16) | (a << 24);
+}
+
+SoftwareRasterizerClass::SoftwareRasterizerClass()
+{
+	m_colorBuffer = nullptr;
+	m_depthBuffer = nullptr;
+	m_tileStarts = nullptr;
+	m_jobSystem = nullptr;
+	m_submittedFrame = 0;
+}
+
+SoftwareRasterizerClass::SoftwareRasterizerClass(const SoftwareRasterizerClass&)
+{
+}
+
+SoftwareRasterizerClass::~SoftwareRasterizerClass()
+{
+}
+
+bool SoftwareRasterizerClass::Initialize(int screenWidth, int screenHeight, float screenDepth, float screenNear, JobSystemClass* jobSystem)
+{
+	float fieldOfView, screenAspect;
+
+	if(screenWidth <= 0 || screenHeight <= 0 || !jobSystem)
+	{
+		return false;
+	}
+
+	m_jobSystem = jobSystem;
+
+	// pad the framebuffer out to whole tiles so the pixel loops never need a tail.
+	m_width = screenWidth;
+	m_height = screenHeight;
+	m_tilesX = (screenWidth + TILE_SIZE - 1) / TILE_SIZE;
+	m_tilesY = (screenHeight + TILE_SIZE - 1) / TILE_SIZE;
+	m_pitch = m_tilesX * TILE_SIZE;
+
+	m_colorBuffer = MemoryClass::AllocateArray<unsigned int>(m_pitch * m_tilesY * TILE_SIZE, MEMORY_TAG_RASTERIZER);
+	if(!m_colorBuffer)
+	{
+		return false;
+	}
+
+	m_depthBuffer = MemoryClass::AllocateArray<unsigned int>(m_pitch * m_tilesY * TILE_SIZE, MEMORY_TAG_RASTERIZER);
+	if(!m_depthBuffer)
+	{
+		return false;
+	}
+
+	// one more than there are tiles, the last one is where the last tile's indices end.
+	m_tileStarts = MemoryClass::AllocateArray<int>(m_tilesX * m_tilesY + 1, MEMORY_TAG_RASTERIZER);
+	if(!m_tileStarts)
+	{
+		return false;
+	}
+
+	// same default rasterizer state D3DClass sets up.
+	m_rasterDesc.CullMode = SOFTWARE_CULL_BACK;
+	m_rasterDesc.FrontCounterClockwise = false;
+	m_rasterDesc.DepthClipEnable = true;
+
+	// same matrices D3DClass creates so both backends see the same scene.
+	fieldOfView = 3.141592654f / 4.0f;
+	screenAspect = (float)screenWidth / (float)screenHeight;
+
+	m_projectionMatrix = XMMatrixPerspectiveFovLH(fieldOfView, screenAspect, screenNear, screenDepth);
+	m_worldMatrix = XMMatrixIdentity();
+	m_orthoMatrix = XMMatrixOrthographicLH((float)screenWidth, (float)screenHeight, screenNear, screenDepth);
+
+	BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+
+	return true;
+}
+
+void SoftwareRasterizerClass::Shutdown()
+{
+	if(m_tileStarts)
+	{
+		MemoryClass::FreeArray(m_tileStarts);
+		m_tileStarts = nullptr;
+	}
+
+	if(m_depthBuffer)
+	{
+		MemoryClass::FreeArray(m_depthBuffer);
+		m_depthBuffer = nullptr;
+	}
+
+	if(m_colorBuffer)
+	{
+		MemoryClass::FreeArray(m_colorBuffer);
+		m_colorBuffer = nullptr;
+	}
+
+	m_jobSystem = nullptr;
+
+	return;
+}
+
+void SoftwareRasterizerClass::BeginScene(float red, float green, float blue, float alpha)
+{
+	unsigned int color;
+	int i, pixelCount;
+
+	// clear the back buffer and the depth buffer.
+	color = PackColor(red, green, blue, alpha);
+	pixelCount = m_pitch * m_tilesY * TILE_SIZE;
+
+	for(i = 0; i < pixelCount; i++)
+	{
+		m_colorBuffer[i] = color;
+		m_depthBuffer[i] = DEPTH_CLEAR;
+	}
+
+	// forget last frame's triangles but keep the memory.
+	m_triangles.clear();
+
+	return;
+}
+
+void SoftwareRasterizerClass::EndScene()
+{
+	// rasterize every tile, there is nothing to present.
+	BinTriangles();
+	RunParallel(m_tilesX * m_tilesY, &SoftwareRasterizerClass::RasterizeTile);
+
+	m_triangles.clear();
+	m_submittedFrame++;
+
+	return;
+}
+
+ID3D11Device* SoftwareRasterizerClass::GetDevice()
+{
+	return nullptr;
+}
+
+ID3D11DeviceContext* SoftwareRasterizerClass::GetDeviceContext()
+{
+	return nullptr;
+}
+
+void SoftwareRasterizerClass::GetProjectionMatrix(XMMATRIX& projectionMatrix)
+{
+	projectionMatrix = m_projectionMatrix;
+	return;
+}
+
+void SoftwareRasterizerClass::GetWorldMatrix(XMMATRIX& worldMatrix)
+{
+	worldMatrix = m_worldMatrix;
+	return;
+}
+
+void SoftwareRasterizerClass::GetOrthoMatrix(XMMATRIX& orthoMatrix)
+{
+	orthoMatrix = m_orthoMatrix;
+	return;
+}
+
+void SoftwareRasterizerClass::GetVideoCardInfo(char* cardName, int& memory)
+{
+#if defined(__AVX2__)
+	snprintf(cardName, 128, "Software Rasterizer (AVX2, %d threads)", GetThreadCount());
+#else
+	snprintf(cardName, 128, "Software Rasterizer (SSE2, %d threads)", GetThreadCount());
+#endif
+	memory = 0;
+	return;
+}
+
+unsigned long long SoftwareRasterizerClass::GetSubmittedFrame()
+{
+	return m_submittedFrame;
+}
+
+// the frame is rasterized by the time EndScene returns.
+unsigned long long SoftwareRasterizerClass::GetCompletedFrame()
+{
+	return m_submittedFrame;
+}
+
+void SoftwareRasterizerClass::RSSetState(const RasterizerDescType& rasterDesc)
+{
+	m_rasterDesc = rasterDesc;
+	return;
+}
+
+void SoftwareRasterizerClass::ExecuteCommandList(SoftwareCommandListClass* commandList)
+{
+	// the list's triangles are set up already and in its draw order, adding them to the frame is all that is left.
+	if(!commandList->m_triangles.empty())
+	{
+		AddTriangles(&commandList->m_triangles[0], (int)commandList->m_triangles.size());
+	}
+
+	return;
+}
+
+const unsigned int* SoftwareRasterizerClass::GetColorBuffer()
+{
+	return m_colorBuffer;
+}
+
+const unsigned int* SoftwareRasterizerClass::GetDepthBuffer()
+{
+	return m_depthBuffer;
+}
+
+int SoftwareRasterizerClass::GetWidth()
+{
+	return m_width;
+}
+
+int SoftwareRasterizerClass::GetHeight()
+{
+	return m_height;
+}
+
+int SoftwareRasterizerClass::GetPitch()
+{
+	return m_pitch;
+}
+
+int SoftwareRasterizerClass::GetThreadCount()
+{
+	return m_jobSystem ? m_jobSystem->GetThreadCount() : 1;
+}
+
+unsigned long long SoftwareRasterizerClass::GetFrameChecksum()
+{
+	unsigned long long hash;
+	int x, y;
+
+	// 64 bit FNV-1a over the visible color and depth, handy for regression tests.
+	hash = 14695981039346656037ULL;
+	for(y = 0; y < m_height; y++)
+	{
+		for(x = 0; x < m_width; x++)
+		{
+			hash = (hash ^ m_colorBuffer[y * m_pitch + x]) * 1099511628211ULL;
+			hash = (hash ^ m_depthBuffer[y * m_pitch + x]) * 1099511628211ULL;
+		}
+	}
+
+	return hash;
+}
+
+bool SoftwareRasterizerClass::GetDrawVertices(const unsigned int* indices, int vertexCount, int indexCount, int startIndexLocation,
+	int baseVertexLocation, int& firstVertex, int& drawVertexCount)
+{
+	int i, minIndex, maxIndex, index;
+
+	// only transform the vertices this draw actually references.
+	minIndex = (int)indices[startIndexLocation];
+	maxIndex = minIndex;
+	for(i = 1; i < indexCount / 3 * 3; i++)
+	{
+		index = (int)indices[startIndexLocation + i];
+		minIndex = index < minIndex ? index : minIndex;
+		maxIndex = index > maxIndex ? index : maxIndex;
+	}
+
+	firstVertex = baseVertexLocation + minIndex;
+	drawVertexCount = maxIndex - minIndex + 1;
+	if(firstVertex < 0 || firstVertex + drawVertexCount > vertexCount)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+void SoftwareRasterizerClass::TransformVertex(const unsigned char* vertex, const XMMATRIX* matrices, ClipVertexType& output)
+{
+	const float* source;
+	XMVECTOR position;
+
+	source = (const float*)vertex;
+
+	// this is ColorVertexShader: w is forced to one and the position goes through world, view and projection in turn.
+	position = XMVectorSet(source[0], source[1], source[2], 1.0f);
+	position = XMVector4Transform(position, matrices[0]);
+	position = XMVector4Transform(position, matrices[1]);
+	position = XMVector4Transform(position, matrices[2]);
+
+	XMStoreFloat4(&output.position, position);
+	output.color = XMFLOAT4(source[3], source[4], source[5], source[6]);
+
+	return;
+}
+
+void SoftwareRasterizerClass::ClipTriangle(const RasterizerDescType& rasterDesc, const ClipVertexType* input, std::vector<TriangleType>& output)
+{
+	ClipVertexType polygon[2][16];
+	float distance[16];
+	int planeCount, plane, i, k, count, next, source, outsideAll[6], outsideAny;
+
+	/*
+	 * the clip planes as distances that are negative outside.
+	 * with depth clip on we clip against 0 <= z <= w like the hardware, with it off we only keep w positive and clamp depth later.
+	 * the last four planes are the guard band, triangles only get clipped against them when they reach very far off screen.
+	 */
+	planeCount = 6;
+	outsideAny = 0;
+	for(plane = 0; plane < planeCount; plane++)
+	{
+		outsideAll[plane] = 1;
+	}
+
+	for(k = 0; k < 3; k++)
+	{
+		const XMFLOAT4& p = input[k].position;
+		float distances[6];
+
+		distances[0] = rasterDesc.DepthClipEnable ? p.z : p.w - 1.0e-5f;
+		distances[1] = rasterDesc.DepthClipEnable ? p.w - p.z : 1.0f;
+		distances[2] = GUARD_BAND * p.w - p.x;
+		distances[3] = GUARD_BAND * p.w + p.x;
+		distances[4] = GUARD_BAND * p.w - p.y;
+		distances[5] = GUARD_BAND * p.w + p.y;
+
+		for(plane = 0; plane < planeCount; plane++)
+		{
+			if(distances[plane] < 0.0f)
+			{
+				outsideAny = 1;
+			} else
+			{
+				outsideAll[plane] = 0;
+			}
+		}
+
+		// outside the actual view frustum on one side means it can never be seen.
+		if(p.x <= p.w) outsideAll[2] = 0;
+		if(p.x >= -p.w) outsideAll[3] = 0;
+		if(p.y <= p.w) outsideAll[4] = 0;
+		if(p.y >= -p.w) outsideAll[5] = 0;
+	}
+
+	for(plane = 0; plane < planeCount; plane++)
+	{
+		if(outsideAll[plane])
+		{
+			return;
+		}
+	}
+
+	if(!outsideAny)
+	{
+		EmitTriangle(rasterDesc, input[0], input[1], input[2], output);
+		return;
+	}
+
+	// sutherland hodgman against every plane, the polygon ping pongs between the two arrays.
+	count = 3;
+	source = 0;
+	for(k = 0; k < 3; k++)
+	{
+		polygon[0][k] = input[k];
+	}
+
+	for(plane = 0; plane < planeCount && count >= 3; plane++)
+	{
+		int written = 0;
+
+		for(i = 0; i < count; i++)
+		{
+			const XMFLOAT4& p = polygon[source][i].position;
+
+			switch(plane)
+			{
+			case 0: distance[i] = rasterDesc.DepthClipEnable ? p.z : p.w - 1.0e-5f; break;
+			case 1: distance[i] = rasterDesc.DepthClipEnable ? p.w - p.z : 1.0f; break;
+			case 2: distance[i] = GUARD_BAND * p.w - p.x; break;
+			case 3: distance[i] = GUARD_BAND * p.w + p.x; break;
+			case 4: distance[i] = GUARD_BAND * p.w - p.y; break;
+			default: distance[i] = GUARD_BAND * p.w + p.y; break;
+			}
+		}
+
+		for(i = 0; i < count; i++)
+		{
+			const ClipVertexType& a = polygon[source][i];
+			next = (i + 1) % count;
+
+			if(distance[i] >= 0.0f)
+			{
+				polygon[1 - source][written++] = a;
+			}
+
+			// the edge crosses the plane, add the intersection.
+			if((distance[i] >= 0.0f) != (distance[next] >= 0.0f))
+			{
+				const ClipVertexType& b = polygon[source][next];
+				float t = distance[i] / (distance[i] - distance[next]);
+				ClipVertexType& v = polygon[1 - source][written++];
+
+				v.position.x = a.position.x + (b.position.x - a.position.x) * t;
+				v.position.y = a.position.y + (b.position.y - a.position.y) * t;
+				v.position.z = a.position.z + (b.position.z - a.position.z) * t;
+				v.position.w = a.position.w + (b.position.w - a.position.w) * t;
+				v.color.x = a.color.x + (b.color.x - a.color.x) * t;
+				v.color.y = a.color.y + (b.color.y - a.color.y) * t;
+				v.color.z = a.color.z + (b.color.z - a.color.z) * t;
+				v.color.w = a.color.w + (b.color.w - a.color.w) * t;
+			}
+		}
+
+		count = written;
+		source = 1 - source;
+	}
+
+	// the clipped polygon is convex, send it on as a fan.
+	for(i = 1; i + 1 < count; i++)
+	{
+		EmitTriangle(rasterDesc, polygon[source][0], polygon[source][i], polygon[source][i + 1], output);
+	}
+
+	return;
+}
+
+void SoftwareRasterizerClass::EmitTriangle(const RasterizerDescType& rasterDesc, const ClipVertexType& v0, const ClipVertexType& v1,
+	const ClipVertexType& v2, std::vector<TriangleType>& output)
+{
+	const ClipVertexType* vertex[3];
+	TriangleType triangle;
+	float attributes[3][6], invW, area, dx1, dy1, dx2, dy2, minX, minY, maxX, maxY;
+	bool frontFacing;
+	int k, a;
+
+	vertex[0] = &v0;
+	vertex[1] = &v1;
+	vertex[2] = &v2;
+
+	// perspective divide and viewport transform, y goes down the screen.
+	for(k = 0; k < 3; k++)
+	{
+		const XMFLOAT4& p = vertex[k]->position;
+		const XMFLOAT4& c = vertex[k]->color;
+
+		invW = 1.0f / p.w;
+		triangle.x[k] = SnapToSubpixel((p.x * invW * 0.5f + 0.5f) * (float)m_width);
+		triangle.y[k] = SnapToSubpixel((0.5f - p.y * invW * 0.5f) * (float)m_height);
+
+		attributes[k][0] = p.z * invW;
+		attributes[k][1] = invW;
+		attributes[k][2] = c.x * invW;
+		attributes[k][3] = c.y * invW;
+		attributes[k][4] = c.z * invW;
+		attributes[k][5] = c.w * invW;
+	}
+
+	// positive area means clockwise on screen, which is front facing unless FrontCounterClockwise is set.
+	dx1 = triangle.x[1] - triangle.x[0];
+	dy1 = triangle.y[1] - triangle.y[0];
+	dx2 = triangle.x[2] - triangle.x[0];
+	dy2 = triangle.y[2] - triangle.y[0];
+	area = dx1 * dy2 - dx2 * dy1;
+	if(area == 0.0f)
+	{
+		return;
+	}
+
+	frontFacing = rasterDesc.FrontCounterClockwise ? area < 0.0f : area > 0.0f;
+	if((rasterDesc.CullMode == SOFTWARE_CULL_BACK && !frontFacing) || (rasterDesc.CullMode == SOFTWARE_CULL_FRONT && frontFacing))
+	{
+		return;
+	}
+
+	// rewind counter clockwise triangles so the inside of every edge is positive.
+	if(area < 0.0f)
+	{
+		float swap;
+
+		swap = triangle.x[1]; triangle.x[1] = triangle.x[2]; triangle.x[2] = swap;
+		swap = triangle.y[1]; triangle.y[1] = triangle.y[2]; triangle.y[2] = swap;
+		for(a = 0; a < 6; a++)
+		{
+			swap = attributes[1][a]; attributes[1][a] = attributes[2][a]; attributes[2][a] = swap;
+		}
+
+		dx1 = triangle.x[1] - triangle.x[0];
+		dy1 = triangle.y[1] - triangle.y[0];
+		dx2 = triangle.x[2] - triangle.x[0];
+		dy2 = triangle.y[2] - triangle.y[0];
+		area = -area;
+	}
+
+	// pixel bounds clamped to the viewport.
+	minX = fminf(triangle.x[0], fminf(triangle.x[1], triangle.x[2]));
+	minY = fminf(triangle.y[0], fminf(triangle.y[1], triangle.y[2]));
+	maxX = fmaxf(triangle.x[0], fmaxf(triangle.x[1], triangle.x[2]));
+	maxY = fmaxf(triangle.y[0], fmaxf(triangle.y[1], triangle.y[2]));
+
+	triangle.minX = minX < 0.0f ? 0 : (int)minX;
+	triangle.minY = minY < 0.0f ? 0 : (int)minY;
+	triangle.maxX = maxX >= (float)m_width ? m_width - 1 : (int)maxX;
+	triangle.maxY = maxY >= (float)m_height ? m_height - 1 : (int)maxY;
+	if(triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+	{
+		return;
+	}
+
+	// attribute planes relative to the first vertex.
+	for(a = 0; a < 6; a++)
+	{
+		float value, d1, d2, ddx, ddy;
+
+		value = attributes[0][a];
+		d1 = attributes[1][a] - value;
+		d2 = attributes[2][a] - value;
+		ddx = (d1 * dy2 - d2 * dy1) / area;
+		ddy = (d2 * dx1 - d1 * dx2) / area;
+
+		if(a == 0)
+		{
+			triangle.z = value; triangle.zdx = ddx; triangle.zdy = ddy;
+		} else if(a == 1)
+		{
+			triangle.invW = value; triangle.invWdx = ddx; triangle.invWdy = ddy;
+		} else
+		{
+			triangle.color[a - 2] = value; triangle.colordx[a - 2] = ddx; triangle.colordy[a - 2] = ddy;
+		}
+	}
+
+	output.push_back(triangle);
+
+	return;
+}
+
+void SoftwareRasterizerClass::AddTriangles(const TriangleType* triangles, int triangleCount)
+{
+	m_triangles.insert(m_triangles.end(), triangles, triangles + triangleCount);
+	return;
+}
+
+void SoftwareRasterizerClass::BinTriangles()
+{
+	int i, tile, tileX, tileY, tileCount, count, start;
+
+	tileCount = m_tilesX * m_tilesY;
+	for(tile = 0; tile <= tileCount; tile++)
+	{
+		m_tileStarts[tile] = 0;
+	}
+
+	// count every tile's triangles, then turn the counts into where each tile's indices start.
+	for(i = 0; i < (int)m_triangles.size(); i++)
+	{
+		const TriangleType& triangle = m_triangles[i];
+
+		for(tileY = triangle.minY / TILE_SIZE; tileY <= triangle.maxY / TILE_SIZE; tileY++)
+		{
+			for(tileX = triangle.minX / TILE_SIZE; tileX <= triangle.maxX / TILE_SIZE; tileX++)
+			{
+				m_tileStarts[tileY * m_tilesX + tileX]++;
+			}
+		}
+	}
+
+	start = 0;
+	for(tile = 0; tile < tileCount; tile++)
+	{
+		count = m_tileStarts[tile];
+		m_tileStarts[tile] = start;
+		start += count;
+	}
+	m_tileStarts[tileCount] = start;
+
+	if((int)m_tileIndices.size() < start)
+	{
+		m_tileIndices.resize(start);
+	}
+
+	// fill them in triangle order, every tile gets its triangles in submission order. the starts are moved along
+	// as they are filled, each ends up where the next tile's was.
+	for(i = 0; i < (int)m_triangles.size(); i++)
+	{
+		const TriangleType& triangle = m_triangles[i];
+
+		for(tileY = triangle.minY / TILE_SIZE; tileY <= triangle.maxY / TILE_SIZE; tileY++)
+		{
+			for(tileX = triangle.minX / TILE_SIZE; tileX <= triangle.maxX / TILE_SIZE; tileX++)
+			{
+				m_tileIndices[m_tileStarts[tileY * m_tilesX + tileX]++] = i;
+			}
+		}
+	}
+
+	// and shift them back.
+	for(tile = tileCount; tile > 0; tile--)
+	{
+		m_tileStarts[tile] = m_tileStarts[tile - 1];
+	}
+	m_tileStarts[0] = 0;
+
+	return;
+}
+
+void SoftwareRasterizerClass::RasterizeTile(int tile)
+{
+	int tileX, tileY, x, y, x0, y0, x1, y1, e, c, i;
+	SimdFloat edgeA[3], edgeRow[3], topLeft[3], zero, lanes, xLimit, depthScale, one, colorScale;
+	SimdFloat zdx, zRow, invWdx, invWRow, colordx[4], colorRow[4];
+	float edgeB[3], edgeC[3];
+
+	tileX = (tile % m_tilesX) * TILE_SIZE;
+	tileY = (tile / m_tilesX) * TILE_SIZE;
+
+	zero = SimdSet(0.0f);
+	one = SimdSet(1.0f);
+	lanes = SimdLaneCenters();
+	xLimit = SimdSet((float)(m_width - tileX));
+	depthScale = SimdSet(DEPTH_SCALE);
+	colorScale = SimdSet(255.0f);
+
+	for(i = m_tileStarts[tile]; i < m_tileStarts[tile + 1]; i++)
+	{
+		const TriangleType& triangle = m_triangles[m_tileIndices[i]];
+		float originX, originY, z, invW, color[4];
+
+		// the part of the triangle's bounds inside this tile, in tile space.
+		x0 = (triangle.minX > tileX ? triangle.minX : tileX) - tileX;
+		y0 = (triangle.minY > tileY ? triangle.minY : tileY) - tileY;
+		x1 = (triangle.maxX < tileX + TILE_SIZE - 1 ? triangle.maxX : tileX + TILE_SIZE - 1) - tileX;
+		y1 = (triangle.maxY < tileY + TILE_SIZE - 1 ? triangle.maxY : tileY + TILE_SIZE - 1) - tileY;
+		x0 &= ~(SIMD_WIDTH - 1);
+
+		/*
+		 * edge equations in tile space.
+		 * the edge from a to b of one triangle is exactly the negation of the edge from b to a of its neighbour,
+		 * so with the top left rule every pixel on a shared edge is drawn exactly once.
+		 */
+		for(e = 0; e < 3; e++)
+		{
+			float xa, ya, xb, yb, a;
+
+			xa = triangle.x[(e + 1) % 3] - (float)tileX;
+			ya = triangle.y[(e + 1) % 3] - (float)tileY;
+			xb = triangle.x[(e + 2) % 3] - (float)tileX;
+			yb = triangle.y[(e + 2) % 3] - (float)tileY;
+
+			a = ya - yb;
+			edgeB[e] = xb - xa;
+			edgeC[e] = xa * yb - xb * ya;
+
+			edgeA[e] = SimdSet(a);
+			topLeft[e] = (a > 0.0f || (a == 0.0f && edgeB[e] > 0.0f)) ? SimdEqual(zero, zero) : zero;
+		}
+
+		// move the attribute planes to the tile origin.
+		originX = (float)tileX - triangle.x[0];
+		originY = (float)tileY - triangle.y[0];
+		z = triangle.z + triangle.zdx * originX + triangle.zdy * originY;
+		invW = triangle.invW + triangle.invWdx * originX + triangle.invWdy * originY;
+		for(c = 0; c < 4; c++)
+		{
+			color[c] = triangle.color[c] + triangle.colordx[c] * originX + triangle.colordy[c] * originY;
+			colordx[c] = SimdSet(triangle.colordx[c]);
+		}
+		zdx = SimdSet(triangle.zdx);
+		invWdx = SimdSet(triangle.invWdx);
+
+		for(y = y0; y <= y1; y++)
+		{
+			float py = (float)y + 0.5f;
+			unsigned int* colorLine = m_colorBuffer + (tileY + y) * m_pitch + tileX;
+			unsigned int* depthLine = m_depthBuffer + (tileY + y) * m_pitch + tileX;
+
+			for(e = 0; e < 3; e++)
+			{
+				edgeRow[e] = SimdSet(edgeB[e] * py + edgeC[e]);
+			}
+			zRow = SimdSet(triangle.zdy * py + z);
+			invWRow = SimdSet(triangle.invWdy * py + invW);
+			for(c = 0; c < 4; c++)
+			{
+				colorRow[c] = SimdSet(triangle.colordy[c] * py + color[c]);
+			}
+
+			for(x = x0; x <= x1; x += SIMD_WIDTH)
+			{
+				SimdFloat px, inside, pass, depth, w, edge;
+				SimdInt depthValue, oldDepth, channel[4];
+
+				px = SimdAdd(SimdSet((float)x), lanes);
+
+				// coverage.
+				inside = SimdLess(px, xLimit);
+				for(e = 0; e < 3; e++)
+				{
+					edge = SimdAdd(SimdMul(edgeA[e], px), edgeRow[e]);
+					inside = SimdAnd(inside, SimdOr(SimdGreater(edge, zero), SimdAnd(SimdEqual(edge, zero), topLeft[e])));
+				}
+
+				if(!SimdAny(inside))
+				{
+					continue;
+				}
+
+				// depth test LESS against the 24 bit depth buffer.
+				depth = SimdAdd(SimdMul(zdx, px), zRow);
+				depth = SimdMin(SimdMax(depth, zero), one);
+				depthValue = SimdToInt(SimdMul(depth, depthScale));
+				oldDepth = SimdLoad(depthLine + x);
+
+				pass = SimdAnd(inside, SimdLessInt(depthValue, oldDepth));
+				if(!SimdAny(pass))
+				{
+					continue;
+				}
+
+				SimdStore(depthLine + x, SimdSelect(pass, depthValue, oldDepth));
+
+				// this is ColorPixelShader: the perspective correct vertex color.
+				w = SimdDiv(one, SimdAdd(SimdMul(invWdx, px), invWRow));
+				for(c = 0; c < 4; c++)
+				{
+					SimdFloat value = SimdMul(SimdAdd(SimdMul(colordx[c], px), colorRow[c]), w);
+					value = SimdMin(SimdMax(value, zero), one);
+					channel[c] = SimdToInt(SimdMul(value, colorScale));
+				}
+
+				SimdStore(colorLine + x, SimdSelect(pass, SimdPackColor(channel[0], channel[1], channel[2], channel[3]), SimdLoad(colorLine + x)));
+			}
+		}
+	}
+
+	return;
+}
+
+void SoftwareRasterizerClass::RunParallel(int jobCount, void (SoftwareRasterizerClass::*job)(int))
+{
+	m_jobSystem->ParallelFor(jobCount, 1, [this, job](int first, int last)
+	{
+		int i;
+
+		for(i = first; i < last; i++)
+		{
+			(this->*job)(i);
+		}
+	});
+
+	return;
+}
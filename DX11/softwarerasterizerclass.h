@@ -0,0 +1,136 @@
+#pragma once
+#ifndef _SOFTWARERASTERIZERCLASS_H_
+#define _SOFTWARERASTERIZERCLASS_H_
+
+#include <DirectXMath.h>
+#include <vector>
+
+#include "jobsystemclass.h"
+#include "memoryclass.h"
+#include "renderbackendclass.h"
+
+using namespace DirectX;
+
+class SoftwareCommandListClass;
+
+// same values as D3D11_CULL_MODE so a D3D11_RASTERIZER_DESC can be copied across directly.
+enum SoftwareCullMode
+{
+	SOFTWARE_CULL_NONE = 1,
+	SOFTWARE_CULL_FRONT = 2,
+	SOFTWARE_CULL_BACK = 3
+};
+
+/*
+ * headless tiled rasterizer.
+ * it runs the same pipeline as the color shader on the gpu: position * world * view * projection, clipping, back face culling, D24 depth test with LESS and a R8G8B8A8 color write.
+ * draws are recorded into SoftwareCommandListClass, which transforms and sets them up on the recording thread. executing the lists adds
+ * their triangles to the frame, EndScene bins them into 64x64 tiles and rasterizes every tile as a job.
+ * a tile only ever sees its triangles in submission order so the framebuffer is identical no matter how many threads run.
+ * it is not identical across instruction sets: an AVX2 build's DirectXMath fuses the vertex transform's multiply adds, which moves some edges
+ * by a rounding step, so frame checksums are only comparable between builds for the same instruction set.
+ */
+class SoftwareRasterizerClass : public RenderBackendClass
+{
+	friend class SoftwareCommandListClass;
+
+public:
+	struct RasterizerDescType
+	{
+		SoftwareCullMode CullMode;
+		bool FrontCounterClockwise;
+		bool DepthClipEnable;
+	};
+
+private:
+	struct ClipVertexType
+	{
+		XMFLOAT4 position;
+		XMFLOAT4 color;
+	};
+
+	struct TriangleType
+	{
+		// snapped screen space positions, wound so the inside of every edge is positive.
+		float x[3], y[3];
+		// depth, 1/w and color/w as planes relative to the first vertex.
+		float z, zdx, zdy;
+		float invW, invWdx, invWdy;
+		float color[4], colordx[4], colordy[4];
+		int minX, minY, maxX, maxY;
+	};
+
+public:
+	SoftwareRasterizerClass();
+	SoftwareRasterizerClass(const SoftwareRasterizerClass&);
+	~SoftwareRasterizerClass();
+
+	bool Initialize(int screenWidth, int screenHeight, float screenDepth, float screenNear, JobSystemClass* jobSystem);
+	void Shutdown();
+
+	void BeginScene(float, float, float, float);
+	void EndScene();
+
+	ID3D11Device* GetDevice();
+	ID3D11DeviceContext* GetDeviceContext();
+
+	void GetProjectionMatrix(XMMATRIX& projectionMatrix);
+	void GetWorldMatrix(XMMATRIX& worldMatrix);
+	void GetOrthoMatrix(XMMATRIX& orthoMatrix);
+
+	void GetVideoCardInfo(char*, int&);
+	unsigned long long GetSubmittedFrame();
+	unsigned long long GetCompletedFrame();
+
+	// the rasterizer state command lists start recording with, named after the device context call it stands in for.
+	void RSSetState(const RasterizerDescType& rasterDesc);
+	// adds the triangles the list recorded to the frame. lists executed in the same order give the same frame.
+	void ExecuteCommandList(SoftwareCommandListClass* commandList);
+
+	// the framebuffer is only complete after EndScene. rows are GetPitch() pixels apart.
+	const unsigned int* GetColorBuffer();
+	const unsigned int* GetDepthBuffer();
+	int GetWidth();
+	int GetHeight();
+	int GetPitch();
+	int GetThreadCount();
+	// hash of the color and depth buffers, see above for which builds it can be compared between.
+	unsigned long long GetFrameChecksum();
+
+private:
+	void RasterizeTile(int tile);
+
+	// shared with the command lists, which call them on their own threads with their own state.
+	static bool GetDrawVertices(const unsigned int* indices, int vertexCount, int indexCount, int startIndexLocation, int baseVertexLocation,
+		int& firstVertex, int& drawVertexCount);
+	static void TransformVertex(const unsigned char* vertex, const XMMATRIX* matrices, ClipVertexType& output);
+	void ClipTriangle(const RasterizerDescType& rasterDesc, const ClipVertexType* input, std::vector<TriangleType>& output);
+	void EmitTriangle(const RasterizerDescType& rasterDesc, const ClipVertexType& v0, const ClipVertexType& v1, const ClipVertexType& v2,
+		std::vector<TriangleType>& output);
+	void AddTriangles(const TriangleType* triangles, int triangleCount);
+	void BinTriangles();
+
+	void RunParallel(int jobCount, void (SoftwareRasterizerClass::*job)(int));
+
+private:
+	int m_width, m_height, m_pitch;
+	int m_tilesX, m_tilesY;
+	unsigned int* m_colorBuffer;
+	unsigned int* m_depthBuffer;
+	XMMATRIX m_projectionMatrix;
+	XMMATRIX m_worldMatrix;
+	XMMATRIX m_orthoMatrix;
+
+	RasterizerDescType m_rasterDesc;
+
+	// per frame triangles in submission order, and their indices sorted by tile. a tile's indices start at m_tileStarts[tile]
+	// and end where the next tile's start. the vectors are only ever cleared, after a few frames they stop allocating.
+	std::vector<TriangleType> m_triangles;
+	std::vector<int> m_tileIndices;
+	int* m_tileStarts;
+
+	JobSystemClass* m_jobSystem;
+	unsigned long long m_submittedFrame;
+};
+
+#endif
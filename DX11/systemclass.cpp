@@ -4,6 +4,8 @@ SystemClass::SystemClass()
 {
 	m_Input = 0;
 	m_Graphics = 0;
+	m_Profiler = 0;
+	m_Metrics = 0;
 }
 
 SystemClass::SystemClass(const SystemClass& other)
@@ -37,6 +39,30 @@ bool SystemClass::Initialize()
 	// initialized the input obj
 	m_Input->Initialize();
 
+	// create the profiler before anything that has markers in it
+	m_Profiler = new ProfilerClass;
+	if(!m_Profiler)
+	{
+		return false;
+	}
+
+	if(!m_Profiler->Initialize())
+	{
+		return false;
+	}
+
+	// create the metrics registry, the graphics obj registers its metrics with it
+	m_Metrics = new MetricsClass;
+	if(!m_Metrics)
+	{
+		return false;
+	}
+
+	if(!m_Metrics->Initialize(METRICS_FILENAME, METRICS_INTERVAL))
+	{
+		return false;
+	}
+
 	// create the graphics object
 	m_Graphics = new GraphicsClass;
 	if(!m_Graphics)
@@ -45,7 +71,7 @@ bool SystemClass::Initialize()
 		return false;
 	}
 
-	return m_Graphics->Initialize(screenWidth, screenHeight, m_hwnd);
+	return m_Graphics->Initialize(screenWidth, screenHeight, m_hwnd, m_Metrics, nullptr);
 }
 
 void SystemClass::Shutdown()
@@ -58,6 +84,22 @@ void SystemClass::Shutdown()
 		m_Graphics = 0;
 	}
 
+	// release the metrics registry once nothing publishes into it any more
+	if(m_Metrics)
+	{
+		m_Metrics->Shutdown();
+		delete m_Metrics;
+		m_Metrics = 0;
+	}
+
+	// release the profiler after the graphics obj, whose threads were the last ones recording
+	if(m_Profiler)
+	{
+		m_Profiler->Shutdown();
+		delete m_Profiler;
+		m_Profiler = 0;
+	}
+
 	// release the input obj
 	if(m_Input)
 	{
@@ -97,11 +139,22 @@ void SystemClass::Run()
 		} else
 		{
 			// otherwise do the frame processing
+			m_Profiler->BeginFrame();
 			result = Frame();
 			if(!result)
 			{
 				done = true;
 			}
+
+			// dump the metrics when it is time to
+			m_Metrics->Update();
+
+			// write a capture out as soon as its last frame is done
+			if(m_Profiler->EndFrame())
+			{
+				m_Profiler->WriteTrace(PROFILE_TRACE_FILENAME);
+				m_Profiler->WriteSummary(PROFILE_SUMMARY_FILENAME);
+			}
 		}
 	}
 
@@ -137,6 +190,7 @@ LRESULT SystemClass::MessageHandler(HWND hwnd, UINT umsg, WPARAM wparam, LPARAM
 
 bool SystemClass::Frame()
 {
+	ProfileScopeClass profileScope("SystemClass::Frame");
 	bool result;
 
 	// check if the user pressed escape and wants to exit the applicaion
@@ -145,6 +199,12 @@ bool SystemClass::Frame()
 		return false;
 	}
 
+	// start a capture unless one is still going
+	if(m_Input->IsKeyDown(PROFILE_CAPTURE_KEY) && !m_Profiler->IsCapturing())
+	{
+		m_Profiler->BeginCapture(PROFILER_CAPTURE_FRAMES);
+	}
+
 	// do ther frame processing for the graphics obj
 	result = m_Graphics->Frame();
 	if(!result)
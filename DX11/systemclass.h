@@ -8,8 +8,18 @@
 #include <windows.h>
 
 // my classes
-#include "InputClass.h"
-#include "GraphicsClass.h"
+#include "inputclass.h"
+#include "graphicsclass.h"
+#include "metricsclass.h"
+#include "profilerclass.h"
+
+// captures the next PROFILER_CAPTURE_FRAMES frames, they are written to the two files below once the capture is done.
+const unsigned int PROFILE_CAPTURE_KEY = VK_F11;
+const char* const PROFILE_TRACE_FILENAME = "../DX11/profile.json";
+const char* const PROFILE_SUMMARY_FILENAME = "../DX11/profile.txt";
+// the metrics are written here in the prometheus text format, every so many seconds.
+const char* const METRICS_FILENAME = "../DX11/metrics.prom";
+const float METRICS_INTERVAL = 10.0f;
 
 class SystemClass
 {
@@ -36,6 +46,8 @@ private:
 
 	InputClass* m_Input;
 	GraphicsClass* m_Graphics;
+	ProfilerClass* m_Profiler;
+	MetricsClass* m_Metrics;
 };
 
 // function prototypes
@@ -0,0 +1,295 @@
+#include "vertexformatclass.h"
+
+#include <cstring>
+#ifdef _WIN32
+#include <d3d11.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+
+/*
+ * the kernels below work on one vertex per iteration with the four components in one register.
+ * positions are loaded 16 bytes at a time, the fourth float is the first color channel and gets masked off.
+ * float to half rounds to nearest even, with F16C on AVX2 builds and the same rounding done with integer math on SSE2.
+ */
+
+static const unsigned int POSITION_SIZE = 3 * sizeof(float);
+static const unsigned int COLOR_SIZE = 4 * sizeof(float);
+
+static __m128 LoadPosition(const unsigned char* vertex)
+{
+	const __m128 xyzMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+
+	return _mm_and_ps(_mm_loadu_ps((const float*)vertex), xyzMask);
+}
+
+static __m128i FloatToHalf(__m128 value)
+{
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+	return _mm_cvtps_ph(value, _MM_FROUND_TO_NEAREST_INT);
+#else
+	const __m128i signMask = _mm_set1_epi32((int)0x80000000);
+	const __m128i halfOverflow = _mm_set1_epi32((127 + 16) << 23);
+	const __m128i floatInfinity = _mm_set1_epi32(255 << 23);
+	const __m128i denormalLimit = _mm_set1_epi32(113 << 23);
+	const __m128i denormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+	const __m128i rebias = _mm_set1_epi32(-((127 - 15) << 23) + 0xFFF);
+	__m128i bits, sign, inRange, nan, special, denormal, denormalResult, normalResult, mantissaOdd, result;
+
+	bits = _mm_castps_si128(value);
+	sign = _mm_and_si128(bits, signMask);
+	bits = _mm_xor_si128(bits, sign);
+
+	// too big for a half becomes infinity, nan stays a quiet nan.
+	inRange = _mm_cmpgt_epi32(halfOverflow, bits);
+	nan = _mm_cmpgt_epi32(bits, floatInfinity);
+	special = _mm_or_si128(_mm_and_si128(nan, _mm_set1_epi32(0x7E00)), _mm_andnot_si128(nan, _mm_set1_epi32(0x7C00)));
+
+	// adding 0.5 lets the fpu do the rounding of the denormals.
+	denormal = _mm_cmpgt_epi32(denormalLimit, bits);
+	denormalResult = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(bits), _mm_castsi128_ps(denormalMagic))), denormalMagic);
+
+	// normal numbers, rebias the exponent and round the mantissa to nearest even.
+	mantissaOdd = _mm_and_si128(_mm_srli_epi32(bits, 13), _mm_set1_epi32(1));
+	normalResult = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(bits, rebias), mantissaOdd), 13);
+
+	result = _mm_or_si128(_mm_and_si128(denormal, denormalResult), _mm_andnot_si128(denormal, normalResult));
+	result = _mm_or_si128(_mm_and_si128(inRange, result), _mm_andnot_si128(inRange, special));
+	result = _mm_or_si128(result, _mm_srli_epi32(sign, 16));
+
+	// there is no unsigned 32 to 16 bit pack before SSE4.1, shift into the signed range and back.
+	result = _mm_packs_epi32(_mm_sub_epi32(result, _mm_set1_epi32(0x8000)), _mm_setzero_si128());
+	return _mm_xor_si128(result, _mm_setr_epi16((short)0x8000, (short)0x8000, (short)0x8000, (short)0x8000, 0, 0, 0, 0));
+#endif
+}
+
+static void EncodePositions(unsigned int format, const unsigned char* vertices, unsigned int vertexStride, unsigned int vertexCount,
+	unsigned char* output, unsigned int outputStride, __m128 center, __m128 scale)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 snormMax = _mm_set1_ps(32767.0f);
+	__m128 position;
+	unsigned int i;
+
+	if(format & VERTEX_FORMAT_POSITION_SNORM16)
+	{
+		for(i = 0; i < vertexCount; i++)
+		{
+			position = _mm_mul_ps(_mm_sub_ps(LoadPosition(vertices), center), scale);
+			position = _mm_min_ps(_mm_max_ps(position, _mm_sub_ps(_mm_setzero_ps(), one)), one);
+			_mm_storel_epi64((__m128i*)output, _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(position, snormMax)), _mm_setzero_si128()));
+
+			vertices += vertexStride;
+			output += outputStride;
+		}
+	} else if(format & VERTEX_FORMAT_POSITION_HALF)
+	{
+		for(i = 0; i < vertexCount; i++)
+		{
+			_mm_storel_epi64((__m128i*)output, FloatToHalf(LoadPosition(vertices)));
+
+			vertices += vertexStride;
+			output += outputStride;
+		}
+	} else
+	{
+		for(i = 0; i < vertexCount; i++)
+		{
+			memcpy(output, vertices, POSITION_SIZE);
+
+			vertices += vertexStride;
+			output += outputStride;
+		}
+	}
+
+	return;
+}
+
+static void EncodeColors(unsigned int format, const unsigned char* vertices, unsigned int vertexStride, unsigned int vertexCount,
+	unsigned char* output, unsigned int outputStride)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 unormMax = _mm_set1_ps(255.0f);
+	__m128 color;
+	__m128i packed;
+	unsigned int i;
+
+	if(format & VERTEX_FORMAT_COLOR_UNORM8)
+	{
+		for(i = 0; i < vertexCount; i++)
+		{
+			color = _mm_min_ps(_mm_max_ps(_mm_loadu_ps((const float*)vertices), _mm_setzero_ps()), one);
+			packed = _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(color, unormMax)), _mm_setzero_si128());
+			packed = _mm_packus_epi16(packed, packed);
+			*(int*)output = _mm_cvtsi128_si32(packed);
+
+			vertices += vertexStride;
+			output += outputStride;
+		}
+	} else if(format & VERTEX_FORMAT_COLOR_HALF)
+	{
+		for(i = 0; i < vertexCount; i++)
+		{
+			_mm_storel_epi64((__m128i*)output, FloatToHalf(_mm_loadu_ps((const float*)vertices)));
+
+			vertices += vertexStride;
+			output += outputStride;
+		}
+	} else
+	{
+		for(i = 0; i < vertexCount; i++)
+		{
+			memcpy(output, vertices, COLOR_SIZE);
+
+			vertices += vertexStride;
+			output += outputStride;
+		}
+	}
+
+	return;
+}
+
+static unsigned int GetPositionSize(unsigned int format)
+{
+	return (format & (VERTEX_FORMAT_POSITION_SNORM16 | VERTEX_FORMAT_POSITION_HALF)) ? 4 * sizeof(unsigned short) : POSITION_SIZE;
+}
+
+static unsigned int GetColorSize(unsigned int format)
+{
+	if(format & VERTEX_FORMAT_COLOR_UNORM8)
+	{
+		return 4 * sizeof(unsigned char);
+	}
+
+	return (format & VERTEX_FORMAT_COLOR_HALF) ? 4 * sizeof(unsigned short) : COLOR_SIZE;
+}
+
+VertexFormatClass::VertexFormatClass()
+{
+}
+
+VertexFormatClass::VertexFormatClass(const VertexFormatClass&)
+{
+}
+
+VertexFormatClass::~VertexFormatClass()
+{
+}
+
+bool VertexFormatClass::IsValid(unsigned int format)
+{
+	const unsigned int positionBits = VERTEX_FORMAT_POSITION_SNORM16 | VERTEX_FORMAT_POSITION_HALF;
+	const unsigned int colorBits = VERTEX_FORMAT_COLOR_UNORM8 | VERTEX_FORMAT_COLOR_HALF;
+
+	// one encoding per attribute at most.
+	if(format & ~(positionBits | colorBits))
+	{
+		return false;
+	}
+
+	return (format & positionBits) != positionBits && (format & colorBits) != colorBits;
+}
+
+unsigned int VertexFormatClass::GetStride(unsigned int format)
+{
+	return GetPositionSize(format) + GetColorSize(format);
+}
+
+#ifdef _WIN32
+unsigned int VertexFormatClass::GetInputLayout(unsigned int format, D3D11_INPUT_ELEMENT_DESC* elements)
+{
+	elements[0].SemanticName = "POSITION";
+	elements[0].SemanticIndex = 0;
+	elements[0].InputSlot = 0;
+	elements[0].AlignedByteOffset = 0;
+	elements[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+	elements[0].InstanceDataStepRate = 0;
+
+	if(format & VERTEX_FORMAT_POSITION_SNORM16)
+	{
+		elements[0].Format = DXGI_FORMAT_R16G16B16A16_SNORM;
+	} else if(format & VERTEX_FORMAT_POSITION_HALF)
+	{
+		elements[0].Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+	} else
+	{
+		elements[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+	}
+
+	elements[1].SemanticName = "COLOR";
+	elements[1].SemanticIndex = 0;
+	elements[1].InputSlot = 0;
+	elements[1].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
+	elements[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+	elements[1].InstanceDataStepRate = 0;
+
+	if(format & VERTEX_FORMAT_COLOR_UNORM8)
+	{
+		elements[1].Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	} else if(format & VERTEX_FORMAT_COLOR_HALF)
+	{
+		elements[1].Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+	} else
+	{
+		elements[1].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	}
+
+	return 2;
+}
+#endif
+
+bool VertexFormatClass::Encode(unsigned int format, const void* vertices, unsigned int vertexStride, unsigned int vertexCount,
+	void* output, XMMATRIX& dequantizeMatrix)
+{
+	const unsigned char* source;
+	unsigned char* destination;
+	__m128 minimum, maximum, center, extent, scale;
+	float centerValues[4], extentValues[4];
+	unsigned int outputStride, i;
+
+	if(!IsValid(format) || vertexStride < POSITION_SIZE + COLOR_SIZE)
+	{
+		return false;
+	}
+
+	source = (const unsigned char*)vertices;
+	destination = (unsigned char*)output;
+	outputStride = GetStride(format);
+
+	dequantizeMatrix = XMMatrixIdentity();
+	center = _mm_setzero_ps();
+	scale = _mm_set1_ps(1.0f);
+
+	// normalized positions are relative to the center of the bounds and scaled by the half extents.
+	if((format & VERTEX_FORMAT_POSITION_SNORM16) && vertexCount > 0)
+	{
+		minimum = maximum = LoadPosition(source);
+		for(i = 1; i < vertexCount; i++)
+		{
+			minimum = _mm_min_ps(minimum, LoadPosition(source + (size_t)i * vertexStride));
+			maximum = _mm_max_ps(maximum, LoadPosition(source + (size_t)i * vertexStride));
+		}
+
+		center = _mm_mul_ps(_mm_add_ps(minimum, maximum), _mm_set1_ps(0.5f));
+		extent = _mm_mul_ps(_mm_sub_ps(maximum, minimum), _mm_set1_ps(0.5f));
+
+		// a flat axis keeps a scale of 1 so nothing divides by zero.
+		extent = _mm_or_ps(_mm_and_ps(_mm_cmpgt_ps(extent, _mm_setzero_ps()), extent),
+			_mm_andnot_ps(_mm_cmpgt_ps(extent, _mm_setzero_ps()), _mm_set1_ps(1.0f)));
+		scale = _mm_div_ps(_mm_set1_ps(1.0f), extent);
+
+		_mm_storeu_ps(centerValues, center);
+		_mm_storeu_ps(extentValues, extent);
+		dequantizeMatrix = XMMatrixMultiply(XMMatrixScaling(extentValues[0], extentValues[1], extentValues[2]),
+			XMMatrixTranslation(centerValues[0], centerValues[1], centerValues[2]));
+	}
+
+	EncodePositions(format, source, vertexStride, vertexCount, destination, outputStride, center, scale);
+	EncodeColors(format, source + POSITION_SIZE, vertexStride, vertexCount, destination + GetPositionSize(format), outputStride);
+
+	return true;
+}
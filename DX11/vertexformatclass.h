@@ -0,0 +1,45 @@
+#pragma once
+#ifndef _VERTEXFORMATCLASS_H_
+#define _VERTEXFORMATCLASS_H_
+
+#include <DirectXMath.h>
+using namespace DirectX;
+
+// forward declaration so the formats can be used without the direct 3d headers.
+struct D3D11_INPUT_ELEMENT_DESC;
+
+// vertex formats are a position encoding or'd with a color encoding, plain floats when neither is set.
+const unsigned int VERTEX_FORMAT_FLOAT = 0;
+// 16 bit signed normalized xyz inside the mesh bounds, the dequantize matrix scales them back.
+const unsigned int VERTEX_FORMAT_POSITION_SNORM16 = 1;
+const unsigned int VERTEX_FORMAT_POSITION_HALF = 2;
+const unsigned int VERTEX_FORMAT_COLOR_UNORM8 = 4;
+const unsigned int VERTEX_FORMAT_COLOR_HALF = 8;
+// 12 bytes per vertex instead of 28.
+const unsigned int VERTEX_FORMAT_COMPACT = VERTEX_FORMAT_POSITION_SNORM16 | VERTEX_FORMAT_COLOR_UNORM8;
+
+const unsigned int VERTEX_FORMAT_MAX_ELEMENTS = 2;
+
+/*
+ * converts the float vertices the model is authored in to the compact gpu formats and describes them to the input assembler.
+ * the source is always an XMFLOAT3 position followed by an XMFLOAT4 color, the layout of ModelClass::VertexType.
+ * positions are stored as 4 components, w is padding and the color shader sets it to 1 anyway.
+ */
+class VertexFormatClass
+{
+public:
+	VertexFormatClass();
+	VertexFormatClass(const VertexFormatClass&);
+	~VertexFormatClass();
+
+	static bool IsValid(unsigned int format);
+	static unsigned int GetStride(unsigned int format);
+	// fills up to VERTEX_FORMAT_MAX_ELEMENTS elements for input slot 0 and returns how many. windows only.
+	static unsigned int GetInputLayout(unsigned int format, D3D11_INPUT_ELEMENT_DESC* elements);
+
+	// the dequantize matrix goes in front of the world matrix, it is the identity unless the positions are normalized.
+	static bool Encode(unsigned int format, const void* vertices, unsigned int vertexStride, unsigned int vertexCount,
+		void* output, XMMATRIX& dequantizeMatrix);
+};
+
+#endif
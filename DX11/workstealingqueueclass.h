@@ -0,0 +1,158 @@
+#pragma once
+#ifndef _WORKSTEALINGQUEUECLASS_H_
+#define _WORKSTEALINGQUEUECLASS_H_
+
+#include <atomic>
+#include <cstddef>
+
+/*
+ * fixed size lock free deque of one owner thread and any number of thieves (chase and lev's work stealing deque).
+ * the owner pushes and pops at the bottom, so it works on what it queued last while that is still in its cache,
+ * thieves take from the top, the oldest and usually biggest pieces of work. only the last item left needs a compare exchange to settle who gets it.
+ * values are copied in and out, T has to be trivially copyable: a thief reads its slot before it knows whether it won it
+ * and throws the copy away when it did not.
+ * a full deque makes Push fail instead of growing. the capacity is rounded up to a power of two.
+ */
+template<typename T>
+class WorkStealingQueueClass
+{
+public:
+	WorkStealingQueueClass()
+	{
+		m_slots = nullptr;
+		m_mask = 0;
+		m_top.store(0, std::memory_order_relaxed);
+		m_bottom.store(0, std::memory_order_relaxed);
+	}
+
+	WorkStealingQueueClass(const WorkStealingQueueClass&)
+	{
+	}
+
+	~WorkStealingQueueClass()
+	{
+	}
+
+	bool Initialize(size_t capacity)
+	{
+		size_t size;
+
+		size = 2;
+		while(size < capacity)
+		{
+			size *= 2;
+		}
+
+		m_slots = new T[size];
+		if(!m_slots)
+		{
+			return false;
+		}
+
+		m_mask = size - 1;
+		m_top.store(0, std::memory_order_relaxed);
+		m_bottom.store(0, std::memory_order_relaxed);
+
+		return true;
+	}
+
+	void Shutdown()
+	{
+		if(m_slots)
+		{
+			delete[] m_slots;
+			m_slots = nullptr;
+		}
+
+		return;
+	}
+
+	// owner only.
+	bool Push(const T& value)
+	{
+		ptrdiff_t bottom, top;
+
+		bottom = m_bottom.load(std::memory_order_relaxed);
+		top = m_top.load(std::memory_order_acquire);
+		if(bottom - top > (ptrdiff_t)m_mask)
+		{
+			return false;
+		}
+
+		m_slots[bottom & m_mask] = value;
+		m_bottom.store(bottom + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	// owner only, takes the newest value.
+	bool Pop(T& value)
+	{
+		ptrdiff_t bottom, top;
+		bool taken;
+
+		// claim the bottom slot first, a thief that reads bottom after this can not take it any more.
+		bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+		m_bottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		top = m_top.load(std::memory_order_relaxed);
+
+		if(top > bottom)
+		{
+			// it was empty already.
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return false;
+		}
+
+		value = m_slots[bottom & m_mask];
+		if(top < bottom)
+		{
+			return true;
+		}
+
+		// the last value, race the thieves for it through top.
+		taken = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+
+		return taken;
+	}
+
+	// any thread, takes the oldest value. false when empty or another thread got there first.
+	bool Steal(T& value)
+	{
+		ptrdiff_t bottom, top;
+
+		top = m_top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		bottom = m_bottom.load(std::memory_order_acquire);
+
+		if(top >= bottom)
+		{
+			return false;
+		}
+
+		value = m_slots[top & m_mask];
+
+		return m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+	}
+
+	// only a snapshot, other threads may push or steal right after.
+	size_t GetSize()
+	{
+		ptrdiff_t bottom, top;
+
+		top = m_top.load(std::memory_order_relaxed);
+		bottom = m_bottom.load(std::memory_order_relaxed);
+
+		return bottom > top ? (size_t)(bottom - top) : 0;
+	}
+
+private:
+	T* m_slots;
+	size_t m_mask;
+	// top is written by the thieves and bottom by the owner, each gets its own cache line.
+	alignas(64) std::atomic<ptrdiff_t> m_top;
+	alignas(64) std::atomic<ptrdiff_t> m_bottom;
+};
+
+#endif
@@ -0,0 +1,20 @@
+#pragma once
+#ifndef _CHECK_H_
+#define _CHECK_H_
+
+#include <cstdio>
+
+// the tests are plain programs. a failed check prints where it is and the test keeps going, it fails once it is done.
+static int s_failedChecks = 0;
+
+#define CHECK(condition) \
+	do \
+	{ \
+		if(!(condition)) \
+		{ \
+			fprintf(stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition); \
+			s_failedChecks++; \
+		} \
+	} while(0)
+
+#endif
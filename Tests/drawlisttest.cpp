@@ -0,0 +1,173 @@
+#include "drawlistclass.h"
+#include "check.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+enum KeySetType
+{
+	KEYS_DEPTH,
+	KEYS_TYPICAL,
+	KEYS_RANDOM,
+	KEYS_FEW,
+	KEYS_EQUAL
+};
+
+static void MakeKeys(KeySetType keySet, int count, std::vector<unsigned long long>& keys)
+{
+	std::mt19937_64 random(12345);
+	int i;
+
+	keys.resize((size_t)count);
+	for(i = 0; i < count; i++)
+	{
+		switch(keySet)
+		{
+			// what graphics class sorts so far, one pipeline and a depth.
+			case KEYS_DEPTH:
+				keys[i] = DrawListClass::MakeKey(0, 3, 0, (float)(random() % 100000) / 100000.0f, 0);
+				break;
+			// every field in use, a few dozen bits that differ in four runs.
+			case KEYS_TYPICAL:
+				keys[i] = DrawListClass::MakeKey((unsigned int)(random() % 2), (unsigned int)(random() % 16), (unsigned int)(random() % 256),
+					(float)(random() % 100000) / 100000.0f, (unsigned int)(random() % 256));
+				break;
+			// all 64 bits differ, too many to go above the index.
+			case KEYS_RANDOM:
+				keys[i] = random();
+				break;
+			// lots of equal keys, so the order they were added in is most of what is checked.
+			case KEYS_FEW:
+				keys[i] = (random() % 3) << 40;
+				break;
+			case KEYS_EQUAL:
+				keys[i] = 0x123456789abcdefull;
+				break;
+		}
+	}
+
+	return;
+}
+
+// the draw list against a stable sort of the same keys, the objects are the indices the packets were added at.
+static void CheckSort(JobSystemClass* jobSystem, KeySetType keySet, int count)
+{
+	DrawListClass drawList;
+	std::vector<unsigned long long> keys;
+	std::vector<int> expected;
+	int i, mismatches;
+
+	MakeKeys(keySet, count, keys);
+	expected.resize((size_t)count);
+	for(i = 0; i < count; i++)
+	{
+		expected[i] = i;
+	}
+	std::stable_sort(expected.begin(), expected.end(), [&keys](int a, int b) { return keys[a] < keys[b]; });
+
+	CHECK(drawList.Initialize(count, jobSystem));
+	for(i = 0; i < count; i++)
+	{
+		CHECK(drawList.Add(keys[i], (unsigned int)(keys[i] >> 44), 0, i));
+	}
+	CHECK(!drawList.Add(0, 0, 0, count));
+
+	// twice, a second sort of the same list starts from the keys again and gives the same order.
+	drawList.Sort();
+	drawList.Sort();
+	CHECK(drawList.GetCount() == count);
+
+	mismatches = 0;
+	for(i = 0; i < count; i++)
+	{
+		if(drawList.GetPacket(i).object != expected[i] || drawList.GetPacket(i).key != keys[expected[i]])
+		{
+			mismatches++;
+		}
+	}
+	CHECK(mismatches == 0);
+
+	drawList.Shutdown();
+
+	return;
+}
+
+// short lists and a job system of one thread both sort on the calling thread.
+static void TestSerial()
+{
+	JobSystemClass jobSystem;
+	int keySet;
+
+	CHECK(jobSystem.Initialize(1));
+	for(keySet = KEYS_DEPTH; keySet <= KEYS_EQUAL; keySet++)
+	{
+		CheckSort(&jobSystem, (KeySetType)keySet, 2);
+		CheckSort(&jobSystem, (KeySetType)keySet, 1000);
+		CheckSort(&jobSystem, (KeySetType)keySet, 100000);
+	}
+	jobSystem.Shutdown();
+
+	return;
+}
+
+// long lists are sorted by jobs in ranges, the last range a short one.
+static void TestParallel()
+{
+	JobSystemClass jobSystem;
+	int keySet;
+
+	CHECK(jobSystem.Initialize(4));
+	for(keySet = KEYS_DEPTH; keySet <= KEYS_EQUAL; keySet++)
+	{
+		CheckSort(&jobSystem, (KeySetType)keySet, 100000);
+	}
+	CheckSort(&jobSystem, KEYS_TYPICAL, DRAW_LIST_PARALLEL_THRESHOLD);
+	CheckSort(&jobSystem, KEYS_TYPICAL, 1000);
+	jobSystem.Shutdown();
+
+	return;
+}
+
+// a list is sorted once more after it was cleared and filled again.
+static void TestReuse()
+{
+	JobSystemClass jobSystem;
+	DrawListClass drawList;
+	int i;
+
+	CHECK(jobSystem.Initialize(1));
+	CHECK(drawList.Initialize(16, &jobSystem));
+	for(i = 0; i < 16; i++)
+	{
+		CHECK(drawList.Add((unsigned long long)(i % 4), 0, 0, i));
+	}
+	drawList.Sort();
+	CHECK(drawList.GetPacket(0).object == 0 && drawList.GetPacket(1).object == 4 && drawList.GetPacket(15).object == 15);
+
+	drawList.Clear();
+	for(i = 0; i < 8; i++)
+	{
+		CHECK(drawList.Add((unsigned long long)(8 - i), 0, 0, i));
+	}
+	drawList.Sort();
+	CHECK(drawList.GetCount() == 8);
+	for(i = 0; i < 8; i++)
+	{
+		CHECK(drawList.GetPacket(i).object == 7 - i);
+	}
+
+	drawList.Shutdown();
+	jobSystem.Shutdown();
+
+	return;
+}
+
+int main()
+{
+	TestSerial();
+	TestParallel();
+	TestReuse();
+
+	return s_failedChecks == 0 ? 0 : 1;
+}
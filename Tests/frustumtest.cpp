@@ -0,0 +1,141 @@
+#include "frustumclass.h"
+#include "check.h"
+
+#include <algorithm>
+#include <vector>
+
+// more than two of the culler's ranges, and not a multiple of any register width so the scalar tail runs too.
+static const int OBJECT_COUNT = 40005;
+// objects this close to a plane, relative to their size, may land either side of it depending on the order of the adds.
+static const float PLANE_TOLERANCE = 0.01f;
+
+static unsigned int s_random = 12345;
+
+static float RandomFloat(float minimum, float maximum)
+{
+	s_random ^= s_random << 13;
+	s_random ^= s_random >> 17;
+	s_random ^= s_random << 5;
+	return minimum + (maximum - minimum) * (float)(s_random & 0xFFFFFF) / (float)0xFFFFFF;
+}
+
+// the scalar CheckBox and CheckSphere are the reference, -1 is an object too close to a plane to say.
+static int ReferenceVisible(FrustumClass* frustum, const SceneClass::BoundsType& bounds, int object, bool spheres)
+{
+	XMFLOAT3 center, extent, smaller, larger;
+	bool inner, outer;
+
+	center = XMFLOAT3(bounds.centerX[object], bounds.centerY[object], bounds.centerZ[object]);
+	if(spheres)
+	{
+		inner = frustum->CheckSphere(center, bounds.radius[object] * (1.0f - PLANE_TOLERANCE));
+		outer = frustum->CheckSphere(center, bounds.radius[object] * (1.0f + PLANE_TOLERANCE));
+	} else
+	{
+		extent = XMFLOAT3(bounds.extentX[object], bounds.extentY[object], bounds.extentZ[object]);
+		smaller = XMFLOAT3(extent.x * (1.0f - PLANE_TOLERANCE), extent.y * (1.0f - PLANE_TOLERANCE), extent.z * (1.0f - PLANE_TOLERANCE));
+		larger = XMFLOAT3(extent.x * (1.0f + PLANE_TOLERANCE), extent.y * (1.0f + PLANE_TOLERANCE), extent.z * (1.0f + PLANE_TOLERANCE));
+		inner = frustum->CheckBox(center, smaller);
+		outer = frustum->CheckBox(center, larger);
+	}
+
+	if(inner != outer)
+	{
+		return -1;
+	}
+
+	return inner ? 1 : 0;
+}
+
+static void TestCull(JobSystemClass* jobSystem, SceneClass* scene, const XMMATRIX& viewMatrix, bool spheres, std::vector<int>& visible, int& visibleCount)
+{
+	FrustumClass frustum;
+	SceneClass::BoundsType bounds;
+	XMMATRIX projectionMatrix;
+	int i, next, reference, ambiguous;
+
+	projectionMatrix = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 150.0f);
+
+	CHECK(frustum.Initialize(jobSystem));
+	frustum.ConstructFrustum(viewMatrix, projectionMatrix);
+
+	visible.assign(OBJECT_COUNT, -1);
+	visibleCount = spheres ? frustum.CullSpheres(scene, visible.data()) : frustum.CullBoxes(scene, visible.data());
+	CHECK(visibleCount > 0 && visibleCount < OBJECT_COUNT);
+
+	// the list is in object order and holds exactly the objects the scalar test keeps.
+	scene->GetBounds(bounds);
+	next = 0;
+	ambiguous = 0;
+	for(i = 0; i < OBJECT_COUNT; i++)
+	{
+		reference = ReferenceVisible(&frustum, bounds, i, spheres);
+		if(next < visibleCount && visible[next] == i)
+		{
+			CHECK(reference != 0);
+			next++;
+		} else
+		{
+			CHECK(reference != 1);
+		}
+
+		ambiguous += reference == -1 ? 1 : 0;
+	}
+	CHECK(next == visibleCount);
+	CHECK(ambiguous < OBJECT_COUNT / 100);
+
+	frustum.Shutdown();
+
+	return;
+}
+
+int main()
+{
+	JobSystemClass jobSystem[2];
+	SceneClass scene;
+	std::vector<int> visible[2];
+	XMMATRIX viewMatrices[2];
+	int threads[2] = { 1, 4 };
+	int visibleCount[2];
+	int i, k, view;
+	bool spheres;
+
+	CHECK(scene.Initialize(OBJECT_COUNT));
+	for(i = 0; i < OBJECT_COUNT; i++)
+	{
+		scene.AddObject(RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f), RandomFloat(0.5f, 2.0f));
+	}
+	scene.SetModelBounds(XMFLOAT3(0.0f, 0.5f, 0.0f), XMFLOAT3(1.0f, 0.5f, 2.0f));
+
+	viewMatrices[0] = XMMatrixIdentity();
+	viewMatrices[1] = XMMatrixLookAtLH(XMVectorSet(10.0f, 20.0f, -30.0f, 1.0f), XMVectorSet(-5.0f, 0.0f, 40.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+
+	for(k = 0; k < 2; k++)
+	{
+		CHECK(jobSystem[k].Initialize(threads[k]));
+	}
+
+	// one thread and several give the same list, and both agree with the scalar test.
+	for(view = 0; view < 2; view++)
+	{
+		for(i = 0; i < 2; i++)
+		{
+			spheres = i == 1;
+			for(k = 0; k < 2; k++)
+			{
+				TestCull(&jobSystem[k], &scene, viewMatrices[view], spheres, visible[k], visibleCount[k]);
+			}
+
+			CHECK(visibleCount[0] == visibleCount[1]);
+			CHECK(std::equal(visible[0].begin(), visible[0].begin() + visibleCount[0], visible[1].begin()));
+		}
+	}
+
+	for(k = 0; k < 2; k++)
+	{
+		jobSystem[k].Shutdown();
+	}
+	scene.Shutdown();
+
+	return s_failedChecks == 0 ? 0 : 1;
+}
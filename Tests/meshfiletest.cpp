@@ -0,0 +1,242 @@
+#include "meshfileclass.h"
+#include "vertexformatclass.h"
+#include "check.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static const char* MESH_FILENAME = "meshfiletest.mesh";
+
+struct VertexType
+{
+	float position[3];
+	float color[4];
+};
+
+static std::string ReadText(const char* filename)
+{
+	std::string text;
+	FILE* file;
+	char buffer[4096];
+	size_t count;
+
+	file = fopen(filename, "rb");
+	if(!file)
+	{
+		return text;
+	}
+
+	while((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		text.append(buffer, count);
+	}
+	fclose(file);
+
+	return text;
+}
+
+static void WriteText(const char* filename, const std::string& text)
+{
+	FILE* file;
+
+	file = fopen(filename, "wb");
+	if(!file)
+	{
+		return;
+	}
+
+	fwrite(text.data(), text.size(), 1, file);
+	fclose(file);
+
+	return;
+}
+
+static bool Opens(const std::string& contents)
+{
+	MeshFileClass meshFile;
+	bool result;
+
+	WriteText(MESH_FILENAME, contents);
+	result = meshFile.Open(MESH_FILENAME);
+	meshFile.Close();
+
+	return result;
+}
+
+// a copy of a valid file with one header field overwritten.
+template<typename T>
+static std::string Patch(const std::string& contents, size_t offset, T value)
+{
+	std::string patched;
+
+	patched = contents;
+	memcpy(&patched[offset], &value, sizeof(value));
+
+	return patched;
+}
+
+static std::string SaveMesh(const std::vector<unsigned int>& indices, unsigned int indexStride)
+{
+	VertexType vertices[4];
+	std::vector<unsigned short> shortIndices;
+	size_t i;
+
+	memset(vertices, 0, sizeof(vertices));
+	for(i = 0; i < 4; i++)
+	{
+		vertices[i].position[0] = (float)i;
+	}
+
+	if(indexStride == sizeof(unsigned short))
+	{
+		shortIndices.assign(indices.begin(), indices.end());
+		MeshFileClass::Save(MESH_FILENAME, vertices, sizeof(VertexType), 4, shortIndices.data(), indexStride, (unsigned int)indices.size(),
+			VERTEX_FORMAT_FLOAT, MESH_FILE_FLAG_OPTIMIZED);
+	} else
+	{
+		MeshFileClass::Save(MESH_FILENAME, vertices, sizeof(VertexType), 4, indices.data(), indexStride, (unsigned int)indices.size(),
+			VERTEX_FORMAT_FLOAT, MESH_FILE_FLAG_OPTIMIZED);
+	}
+
+	return ReadText(MESH_FILENAME);
+}
+
+static void TestHeader()
+{
+	std::string valid, wrapped;
+	std::vector<unsigned int> indices = { 0, 1, 2, 2, 1, 3 };
+
+	valid = SaveMesh(indices, sizeof(unsigned int));
+	CHECK(Opens(valid));
+
+	CHECK(!Opens(Patch(valid, 0, 'X')));
+	CHECK(!Opens(Patch(valid, offsetof(MeshFileClass::HeaderType, version), MESH_FILE_VERSION + 1)));
+	CHECK(!Opens(Patch(valid, offsetof(MeshFileClass::HeaderType, indexStride), 3u)));
+	CHECK(!Opens(Patch(valid, offsetof(MeshFileClass::HeaderType, vertexStride), 0u)));
+	CHECK(!Opens(valid.substr(0, sizeof(MeshFileClass::HeaderType) - 1)));
+
+	// the sizes have to match the counts, and the sections have to be page aligned and inside the file.
+	CHECK(!Opens(Patch(valid, offsetof(MeshFileClass::HeaderType, vertexCount), 5u)));
+	CHECK(!Opens(Patch(valid, offsetof(MeshFileClass::HeaderType, indexOffset), 4097ull)));
+	CHECK(!Opens(valid.substr(0, valid.size() - 4)));
+
+	// an offset that adds up with its size to exactly 2^64 wraps around to 0, which is inside any file.
+	wrapped = Patch(valid, offsetof(MeshFileClass::HeaderType, vertexCount), 4096u);
+	wrapped = Patch(wrapped, offsetof(MeshFileClass::HeaderType, vertexSize), 4096ull * sizeof(VertexType));
+	wrapped = Patch(wrapped, offsetof(MeshFileClass::HeaderType, vertexOffset), 0ull - 4096ull * sizeof(VertexType));
+	CHECK(!Opens(wrapped));
+
+	wrapped = Patch(valid, offsetof(MeshFileClass::HeaderType, indexOffset), 0ull - 4096ull);
+	wrapped = Patch(wrapped, offsetof(MeshFileClass::HeaderType, indexCount), 1024u * 3u);
+	wrapped = Patch(wrapped, offsetof(MeshFileClass::HeaderType, indexSize), 1024ull * 3ull * sizeof(unsigned int));
+	CHECK(!Opens(wrapped));
+
+	return;
+}
+
+static void TestIndices()
+{
+	std::string valid, shorter;
+	std::vector<unsigned int> indices = { 0, 1, 2, 2, 1, 3 };
+
+	// an index count that is not whole triangles, with the size fixed up to match it.
+	valid = SaveMesh(indices, sizeof(unsigned int));
+	shorter = Patch(valid, offsetof(MeshFileClass::HeaderType, indexCount), 5u);
+	shorter = Patch(shorter, offsetof(MeshFileClass::HeaderType, indexSize), 20ull);
+	CHECK(!Opens(shorter));
+
+	// an index past the last vertex, in either index size.
+	indices[4] = 4;
+	CHECK(!Opens(SaveMesh(indices, sizeof(unsigned int))));
+	CHECK(!Opens(SaveMesh(indices, sizeof(unsigned short))));
+
+	indices[4] = 3;
+	CHECK(Opens(SaveMesh(indices, sizeof(unsigned short))));
+
+	indices[5] = 0xFFFFFFFF;
+	CHECK(!Opens(SaveMesh(indices, sizeof(unsigned int))));
+
+	return;
+}
+
+static bool OpensWithSubsets(const std::vector<unsigned short>& indices, const std::vector<MeshFileClass::SubsetType>& subsets)
+{
+	VertexType vertices[4];
+	float boundsMin[3] = { 0.0f, 0.0f, 0.0f }, boundsMax[3] = { 3.0f, 0.0f, 0.0f };
+	float dequantize[16] = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+
+	memset(vertices, 0, sizeof(vertices));
+	MeshFileClass::Save(MESH_FILENAME, vertices, sizeof(VertexType), 4, indices.data(), sizeof(unsigned short), (unsigned int)indices.size(),
+		VERTEX_FORMAT_FLOAT, MESH_FILE_FLAG_OPTIMIZED, subsets.data(), (unsigned int)subsets.size(), boundsMin, boundsMax, dequantize);
+
+	return Opens(ReadText(MESH_FILENAME));
+}
+
+static void TestSubsets()
+{
+	std::string valid;
+	std::vector<unsigned short> indices = { 0, 1, 2, 1, 0, 2 };
+	MeshFileClass meshFile;
+
+	// the second subset is rebased on vertex 1, its indices reach vertex 3.
+	CHECK(OpensWithSubsets(indices, { { 3, 0, 0 }, { 3, 3, 1 } }));
+
+	CHECK(meshFile.Open(MESH_FILENAME));
+	CHECK(meshFile.GetHeader()->subsetCount == 2);
+	CHECK(meshFile.GetSubsets()[1].baseVertex == 1);
+	meshFile.Close();
+
+	// a base vertex that pushes an index past the last vertex.
+	CHECK(!OpensWithSubsets(indices, { { 3, 0, 0 }, { 3, 3, 2 } }));
+
+	// subsets that leave indices out, overlap, or cut a triangle.
+	CHECK(!OpensWithSubsets(indices, { { 3, 0, 0 } }));
+	CHECK(!OpensWithSubsets(indices, { { 3, 0, 0 }, { 6, 0, 0 } }));
+	CHECK(!OpensWithSubsets(indices, { { 2, 0, 0 }, { 4, 2, 0 } }));
+
+	// a table that claims more subsets than the file holds.
+	OpensWithSubsets(indices, { { 3, 0, 0 }, { 3, 3, 1 } });
+	valid = ReadText(MESH_FILENAME);
+	CHECK(!Opens(Patch(valid, offsetof(MeshFileClass::HeaderType, subsetCount), 3u)));
+	CHECK(!Opens(Patch(Patch(valid, offsetof(MeshFileClass::HeaderType, subsetCount), 1024u),
+		offsetof(MeshFileClass::HeaderType, subsetSize), 1024ull * sizeof(MeshFileClass::SubsetType))));
+
+	return;
+}
+
+static void TestReplace()
+{
+	MeshFileClass mapped, replaced;
+	std::vector<unsigned int> indices = { 0, 1, 2, 2, 1, 3 };
+
+	// a loader still has the old file mapped while another one saves over it, it keeps reading the old file whole.
+	SaveMesh(indices, sizeof(unsigned int));
+	CHECK(mapped.Open(MESH_FILENAME));
+
+	indices.resize(3);
+	SaveMesh(indices, sizeof(unsigned short));
+	CHECK(mapped.GetHeader()->indexCount == 6 && mapped.GetHeader()->indexStride == sizeof(unsigned int));
+	CHECK(((const unsigned int*)mapped.GetIndices())[5] == 3);
+
+	CHECK(replaced.Open(MESH_FILENAME));
+	CHECK(replaced.GetHeader()->indexCount == 3 && replaced.GetHeader()->indexStride == sizeof(unsigned short));
+	replaced.Close();
+	mapped.Close();
+
+	return;
+}
+
+int main()
+{
+	TestHeader();
+	TestIndices();
+	TestSubsets();
+	TestReplace();
+
+	remove(MESH_FILENAME);
+
+	return s_failedChecks == 0 ? 0 : 1;
+}
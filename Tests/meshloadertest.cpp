@@ -0,0 +1,202 @@
+#include "meshloaderclass.h"
+#include "check.h"
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+static const char* MESH_FILENAME = "meshloadertest.mesh";
+static const char* MISSING_FILENAME = "meshloadertest.missing.mesh";
+static const int WORKER_COUNT = 2;
+static const int UPLOAD_QUEUE_SIZE = 2;
+
+static bool SaveMesh()
+{
+	std::vector<MeshImporterClass::VertexType> vertices;
+	std::vector<unsigned int> indices;
+	int i;
+
+	for(i = 0; i < 300; i++)
+	{
+		vertices.push_back({ XMFLOAT3((float)(i % 10), (float)(i / 10), 0.0f), XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f) });
+	}
+	for(i = 0; i + 2 < 300; i++)
+	{
+		indices.push_back(i);
+		indices.push_back(i + 1);
+		indices.push_back(i + 2);
+	}
+
+	return MeshFileClass::Save(MESH_FILENAME, vertices.data(), sizeof(MeshImporterClass::VertexType), (unsigned int)vertices.size(), indices.data(),
+		sizeof(unsigned int), (unsigned int)indices.size(), VERTEX_FORMAT_FLOAT, MESH_FILE_FLAG_OPTIMIZED);
+}
+
+// polls the loader's metrics until the workers have nothing left to do but wait for uploads.
+static bool WaitForUploads(MeshLoaderClass* loader, int waitingForUpload)
+{
+	MeshLoaderClass::MetricsType metrics;
+	int i;
+
+	for(i = 0; i < 5000; i++)
+	{
+		loader->GetMetrics(metrics);
+		if(metrics.queued == 0 && metrics.loading == 0 && metrics.waitingForUpload == waitingForUpload)
+		{
+			return true;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	return false;
+}
+
+// runs Update until the request is done one way or another.
+static MeshLoadState WaitForRequest(MeshLoaderClass* loader, int request)
+{
+	MeshLoadState state;
+	int i;
+
+	for(i = 0; i < 5000; i++)
+	{
+		loader->Update(16, 0, 0);
+		state = loader->GetState(request);
+		if(state == MESH_LOAD_RESIDENT || state == MESH_LOAD_FAILED || state == MESH_LOAD_CANCELLED)
+		{
+			return state;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	return state;
+}
+
+// workers held back by a full upload queue sleep, they do not spin until there is room.
+static void TestBackPressure()
+{
+	MeshLoaderClass loader;
+	std::vector<int> requests;
+	std::clock_t start;
+	double seconds;
+	int i, queued;
+
+	CHECK(loader.Initialize(nullptr, nullptr, VERTEX_FORMAT_FLOAT, WORKER_COUNT, UPLOAD_QUEUE_SIZE));
+
+	// the queue's worth and one more per worker, which the workers hold on to.
+	for(i = 0; i < UPLOAD_QUEUE_SIZE + WORKER_COUNT; i++)
+	{
+		requests.push_back(loader.Load(MESH_FILENAME, 0));
+	}
+	CHECK(WaitForUploads(&loader, UPLOAD_QUEUE_SIZE));
+
+	// one more stays queued behind them.
+	queued = loader.Load(MESH_FILENAME, 0);
+	requests.push_back(queued);
+
+	// the whole process barely uses the processor while they wait.
+	start = std::clock();
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	seconds = (double)(std::clock() - start) / CLOCKS_PER_SEC;
+	CHECK(seconds < 0.05);
+	CHECK(loader.GetState(queued) == MESH_LOAD_QUEUED);
+
+	// room in the queue wakes them up again, every load gets through.
+	for(i = 0; i < (int)requests.size(); i++)
+	{
+		CHECK(WaitForRequest(&loader, requests[i]) == MESH_LOAD_RESIDENT);
+		CHECK(loader.GetModel(requests[i]) != nullptr);
+	}
+
+	// shutting down with workers still waiting on a full queue does not hang.
+	for(i = 0; i < UPLOAD_QUEUE_SIZE + WORKER_COUNT; i++)
+	{
+		loader.Load(MESH_FILENAME, 0);
+	}
+	CHECK(WaitForUploads(&loader, UPLOAD_QUEUE_SIZE));
+	loader.Shutdown();
+
+	return;
+}
+
+// requests that are done with hand their slot to the next Load, and their ids stop naming anything.
+static void TestRecycle()
+{
+	MeshLoaderClass loader;
+	ModelClass* model;
+	int request, next, blocked[UPLOAD_QUEUE_SIZE + WORKER_COUNT], queued, i, largestSlot;
+
+	CHECK(loader.Initialize(nullptr, nullptr, VERTEX_FORMAT_FLOAT, WORKER_COUNT, UPLOAD_QUEUE_SIZE));
+
+	// a cancelled resident model.
+	request = loader.Load(MESH_FILENAME, 0);
+	CHECK(WaitForRequest(&loader, request) == MESH_LOAD_RESIDENT);
+	loader.Cancel(request);
+	CHECK(loader.GetState(request) == MESH_LOAD_FAILED);
+	CHECK(loader.GetModel(request) == nullptr);
+
+	next = loader.Load(MESH_FILENAME, 0);
+	CHECK(next != request && (next & HANDLE_INDEX_MASK) == (request & HANDLE_INDEX_MASK));
+	CHECK(WaitForRequest(&loader, next) == MESH_LOAD_RESIDENT);
+
+	// the stale id neither reads nor cancels the new request.
+	loader.Cancel(request);
+	model = loader.GetModel(next);
+	CHECK(model != nullptr && loader.GetModel(request) == nullptr);
+	loader.Cancel(next);
+
+	// a failed load.
+	request = loader.Load(MISSING_FILENAME, 0);
+	CHECK(WaitForRequest(&loader, request) == MESH_LOAD_FAILED);
+	next = loader.Load(MESH_FILENAME, 0);
+	CHECK((next & HANDLE_INDEX_MASK) == (request & HANDLE_INDEX_MASK));
+	CHECK(WaitForRequest(&loader, next) == MESH_LOAD_RESIDENT);
+	loader.Cancel(next);
+
+	// a request cancelled while still queued, the worker skips it and Update recycles it.
+	for(i = 0; i < UPLOAD_QUEUE_SIZE + WORKER_COUNT; i++)
+	{
+		blocked[i] = loader.Load(MESH_FILENAME, 0);
+	}
+	CHECK(WaitForUploads(&loader, UPLOAD_QUEUE_SIZE));
+	queued = loader.Load(MESH_FILENAME, 0);
+	CHECK(loader.GetState(queued) == MESH_LOAD_QUEUED);
+	loader.Cancel(queued);
+	for(i = 0; i < UPLOAD_QUEUE_SIZE + WORKER_COUNT; i++)
+	{
+		CHECK(WaitForRequest(&loader, blocked[i]) == MESH_LOAD_RESIDENT);
+	}
+	CHECK(WaitForRequest(&loader, queued) == MESH_LOAD_FAILED);
+	for(i = 0; i < UPLOAD_QUEUE_SIZE + WORKER_COUNT; i++)
+	{
+		loader.Cancel(blocked[i]);
+	}
+
+	// loading and cancelling over and over keeps to the few slots already there.
+	largestSlot = 0;
+	for(i = 0; i < 200; i++)
+	{
+		request = loader.Load(i % 4 == 0 ? MISSING_FILENAME : MESH_FILENAME, 0);
+		largestSlot = (int)(request & HANDLE_INDEX_MASK) > largestSlot ? (int)(request & HANDLE_INDEX_MASK) : largestSlot;
+		WaitForRequest(&loader, request);
+		loader.Cancel(request);
+	}
+	CHECK(largestSlot < UPLOAD_QUEUE_SIZE + WORKER_COUNT + 1);
+
+	loader.Shutdown();
+
+	return;
+}
+
+int main()
+{
+	CHECK(SaveMesh());
+	remove(MISSING_FILENAME);
+
+	TestBackPressure();
+	TestRecycle();
+
+	remove(MESH_FILENAME);
+
+	return s_failedChecks == 0 ? 0 : 1;
+}
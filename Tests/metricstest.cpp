@@ -0,0 +1,122 @@
+#include "metricsclass.h"
+#include "check.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static const char* METRICS_FILENAME = "metricstest.prom";
+
+struct BucketType
+{
+	std::string bound;
+	unsigned long long count;
+};
+
+// the histogram's bucket lines of a dump, in order, and its count.
+static bool ReadHistogram(const char* name, std::vector<BucketType>& buckets, unsigned long long& count)
+{
+	std::string prefix, countPrefix;
+	char line[256], bound[64];
+	BucketType bucket;
+	FILE* file;
+
+	buckets.clear();
+	count = ~0ULL;
+	prefix = std::string(name) + "_bucket{le=\"%63[^\"]\"} %llu";
+	countPrefix = std::string(name) + "_count %llu";
+
+	file = fopen(METRICS_FILENAME, "r");
+	if(!file)
+	{
+		return false;
+	}
+
+	while(fgets(line, sizeof(line), file))
+	{
+		if(sscanf(line, prefix.c_str(), bound, &bucket.count) == 2)
+		{
+			bucket.bound = bound;
+			buckets.push_back(bucket);
+		}
+		else
+		{
+			sscanf(line, countPrefix.c_str(), &count);
+		}
+	}
+
+	fclose(file);
+
+	return true;
+}
+
+// every dump has the same buckets whatever was recorded, prometheus takes a changing set of le labels for a different series.
+static void TestFixedBuckets()
+{
+	MetricsClass metrics;
+	std::vector<BucketType> empty, few, many;
+	unsigned long long count;
+	int histogram, i;
+
+	CHECK(metrics.Initialize(nullptr, 0.0f));
+	histogram = metrics.AddHistogram("metricstest_seconds", "latencies", 1e-6);
+	CHECK(histogram >= 0);
+
+	// nothing recorded yet, every bucket is there and empty.
+	CHECK(metrics.Write(METRICS_FILENAME));
+	CHECK(ReadHistogram("metricstest_seconds", empty, count));
+	CHECK(empty.size() == (size_t)METRICS_HISTOGRAM_BUCKETS);
+	CHECK(!empty.empty() && empty.back().bound == "+Inf");
+	CHECK(count == 0);
+	for(i = 0; i < (int)empty.size(); i++)
+	{
+		CHECK(empty[i].count == 0);
+	}
+
+	// a couple of values, the first one in a bucket of its own far from the others.
+	metrics.Record(histogram, 3e-6);
+	metrics.Record(histogram, 0.002);
+	metrics.Record(histogram, 0.0021);
+	CHECK(metrics.Write(METRICS_FILENAME));
+	CHECK(ReadHistogram("metricstest_seconds", few, count));
+	CHECK(count == 3);
+
+	// values everywhere, past the last bucket as well.
+	for(i = 0; i < 40; i++)
+	{
+		metrics.Record(histogram, (double)(1ULL << i) * 1e-6);
+	}
+	CHECK(metrics.Write(METRICS_FILENAME));
+	CHECK(ReadHistogram("metricstest_seconds", many, count));
+	CHECK(count == 43);
+
+	CHECK(few.size() == empty.size() && many.size() == empty.size());
+	for(i = 0; i < (int)empty.size() && i < (int)few.size() && i < (int)many.size(); i++)
+	{
+		CHECK(few[i].bound == empty[i].bound && many[i].bound == empty[i].bound);
+
+		// cumulative, never going down, and all of it in +Inf.
+		if(i > 0)
+		{
+			CHECK(few[i].count >= few[i - 1].count && many[i].count >= many[i - 1].count);
+		}
+	}
+	CHECK(!few.empty() && few.back().count == 3 && !many.empty() && many.back().count == 43);
+
+	// the 3 microseconds are counted from the bucket ending at 4 on, and the values past 2^32 microseconds only in +Inf.
+	CHECK(few.size() > 4 && few[2].count == 0 && few[3].count == 1 && few[4].count == 1);
+	CHECK(many.size() > 1 && many[many.size() - 2].count < many.back().count);
+
+	metrics.Shutdown();
+
+	remove(METRICS_FILENAME);
+
+	return;
+}
+
+int main()
+{
+	TestFixedBuckets();
+
+	return s_failedChecks == 0 ? 0 : 1;
+}
@@ -0,0 +1,289 @@
+#include "modelclass.h"
+#include "jobsystemclass.h"
+#include "check.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const char* MESH_FILENAME = "modeltest.mesh";
+static const char* OBJ_FILENAME = "modeltest.obj";
+// more than a 16 bit index can address.
+static const unsigned int VERTEX_COUNT = 70000;
+
+static bool SaveMesh(const std::vector<unsigned int>& indices)
+{
+	std::vector<MeshImporterClass::VertexType> vertices;
+	unsigned int i;
+
+	vertices.resize(VERTEX_COUNT);
+	for(i = 0; i < VERTEX_COUNT; i++)
+	{
+		vertices[i].position = XMFLOAT3((float)(i % 256), (float)(i / 256), 0.0f);
+		vertices[i].color = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+	}
+
+	// flagged as optimized so the triangles stay in the order given here.
+	return MeshFileClass::Save(MESH_FILENAME, vertices.data(), sizeof(MeshImporterClass::VertexType), VERTEX_COUNT, indices.data(), sizeof(unsigned int),
+		(unsigned int)indices.size(), VERTEX_FORMAT_FLOAT, MESH_FILE_FLAG_OPTIMIZED);
+}
+
+// a strip of triangles in first use order, every vertex used.
+static void MakeStrip(std::vector<unsigned int>& indices)
+{
+	unsigned int i;
+
+	indices.clear();
+	for(i = 0; i + 2 < VERTEX_COUNT; i++)
+	{
+		indices.push_back(i);
+		indices.push_back(i + 1);
+		indices.push_back(i + 2);
+	}
+
+	return;
+}
+
+// the subsets cover the indices in order without gaps, and every index of a 16 bit one fits from its base vertex.
+static void CheckSubsets(ModelClass* model, const std::vector<unsigned int>& indices, bool& wide)
+{
+	int subset, indexCount, startIndex, baseVertex, next, i;
+	bool covered, fits;
+
+	next = 0;
+	covered = true;
+	fits = true;
+	for(subset = 0; subset < model->GetSubsetCount(); subset++)
+	{
+		model->GetSubset(subset, indexCount, startIndex, baseVertex);
+		covered = covered && startIndex == next && indexCount > 0 && indexCount % 3 == 0;
+		next = startIndex + indexCount;
+
+		for(i = startIndex; i < startIndex + indexCount && i < (int)indices.size(); i++)
+		{
+			fits = fits && indices[i] >= (unsigned int)baseVertex && indices[i] - (unsigned int)baseVertex < 65536;
+		}
+	}
+	CHECK(covered);
+	CHECK(next == (int)indices.size());
+
+	// a single subset over everything from vertex 0 is the 32 bit fallback, anything else has to fit in 16 bits.
+	model->GetSubset(0, indexCount, startIndex, baseVertex);
+	wide = model->GetSubsetCount() == 1 && indexCount == (int)indices.size() && baseVertex == 0 && !fits;
+	CHECK(wide || fits);
+
+	return;
+}
+
+static void TestSubsets()
+{
+	ModelClass model;
+	std::vector<unsigned int> indices;
+	bool wide;
+
+	// a strip is cut where the window runs out and stays 16 bit.
+	MakeStrip(indices);
+	CHECK(SaveMesh(indices));
+	CHECK(model.Load(MESH_FILENAME, VERTEX_FORMAT_FLOAT, true, nullptr));
+	CHECK(model.GetSubsetCount() == 2);
+	CheckSubsets(&model, indices, wide);
+	CHECK(!wide);
+	model.Shutdown();
+
+	// the last triangle spans the whole mesh by itself, it can not be in any 16 bit subset.
+	indices.push_back(0);
+	indices.push_back(VERTEX_COUNT - 2);
+	indices.push_back(VERTEX_COUNT - 1);
+	CHECK(SaveMesh(indices));
+	CHECK(model.Load(MESH_FILENAME, VERTEX_FORMAT_FLOAT, true, nullptr));
+	CheckSubsets(&model, indices, wide);
+	CHECK(wide);
+	model.Shutdown();
+
+	// the same at the very start, which must not leave an empty subset in front of it.
+	indices.insert(indices.begin(), { 0, VERTEX_COUNT - 1, 1 });
+	indices.resize(indices.size() - 3);
+	CHECK(SaveMesh(indices));
+	CHECK(model.Load(MESH_FILENAME, VERTEX_FORMAT_FLOAT, true, nullptr));
+	CheckSubsets(&model, indices, wide);
+	CHECK(wide);
+	model.Shutdown();
+
+	// the software rasterizer always reads 32 bit indices, there is a single subset without a device.
+	MakeStrip(indices);
+	CHECK(SaveMesh(indices));
+	CHECK(model.Load(MESH_FILENAME, VERTEX_FORMAT_FLOAT, false, nullptr));
+	CHECK(model.GetSubsetCount() == 1);
+	model.Shutdown();
+
+	return;
+}
+
+// a flat grid, too many triangles to be an occluder.
+static bool SaveGrid(int size)
+{
+	FILE* file;
+	int x, y;
+
+	file = fopen(OBJ_FILENAME, "w");
+	if(!file)
+	{
+		return false;
+	}
+
+	for(y = 0; y <= size; y++)
+	{
+		for(x = 0; x <= size; x++)
+		{
+			fprintf(file, "v %d %d 0\n", x, y);
+		}
+	}
+
+	for(y = 0; y < size; y++)
+	{
+		for(x = 0; x < size; x++)
+		{
+			fprintf(file, "f %d %d %d\n", y * (size + 1) + x + 1, (y + 1) * (size + 1) + x + 1, y * (size + 1) + x + 2);
+			fprintf(file, "f %d %d %d\n", y * (size + 1) + x + 2, (y + 1) * (size + 1) + x + 1, (y + 1) * (size + 1) + x + 2);
+		}
+	}
+
+	return fclose(file) == 0;
+}
+
+static long long GeometryBytes()
+{
+	MemoryClass::StatisticsType statistics;
+
+	MemoryClass::GetStatistics(MEMORY_TAG_GEOMETRY, statistics);
+	return statistics.bytes;
+}
+
+static void TestCookedFormat()
+{
+	ModelClass model;
+	MeshImporterClass importer;
+	std::string cookedFilename, deviceFilename;
+	XMMATRIX converted, mapped;
+	XMFLOAT4X4 convertedMatrix, mappedMatrix;
+	long long convertedBytes, mappedBytes;
+	int indexCount, startIndex, baseVertex, subsetCount, expected[3];
+	FILE* file;
+
+	CHECK(SaveGrid(40));
+
+	// the first load converts from the importer's float file and keeps the result.
+	convertedBytes = GeometryBytes();
+	CHECK(model.Load(OBJ_FILENAME, VERTEX_FORMAT_COMPACT, true, nullptr));
+	convertedBytes = GeometryBytes() - convertedBytes;
+	CHECK(model.GetVertexFormat() == VERTEX_FORMAT_COMPACT);
+	subsetCount = model.GetSubsetCount();
+	model.GetSubset(0, expected[0], expected[1], expected[2]);
+	model.GetDequantizeMatrix(converted);
+	model.Shutdown();
+
+	CHECK(importer.Initialize(nullptr));
+	CHECK(importer.Cook(OBJ_FILENAME, cookedFilename));
+	importer.Shutdown();
+	deviceFilename = cookedFilename.substr(0, cookedFilename.size() - 5) + ".format" + std::to_string(VERTEX_FORMAT_COMPACT) + ".mesh";
+
+	file = fopen(deviceFilename.c_str(), "rb");
+	CHECK(file != nullptr);
+	if(file)
+	{
+		fclose(file);
+	}
+
+	// the second one maps that file, the subset table is the only thing copied.
+	mappedBytes = GeometryBytes();
+	CHECK(model.Load(OBJ_FILENAME, VERTEX_FORMAT_COMPACT, true, nullptr));
+	mappedBytes = GeometryBytes() - mappedBytes;
+	CHECK(model.GetVertexFormat() == VERTEX_FORMAT_COMPACT);
+	CHECK(model.GetSubsetCount() == subsetCount);
+	model.GetSubset(0, indexCount, startIndex, baseVertex);
+	CHECK(indexCount == expected[0] && startIndex == expected[1] && baseVertex == expected[2]);
+	model.GetDequantizeMatrix(mapped);
+	XMStoreFloat4x4(&mappedMatrix, mapped);
+	XMStoreFloat4x4(&convertedMatrix, converted);
+	CHECK(memcmp(&mappedMatrix, &convertedMatrix, sizeof(XMFLOAT4X4)) == 0);
+	CHECK(mappedBytes < 1024 && convertedBytes > 41 * 41 * 12);
+	model.Shutdown();
+
+	// a mesh file in the compact format is accepted directly, but only for the format it was cooked for, and not without a device.
+	CHECK(model.Load(deviceFilename.c_str(), VERTEX_FORMAT_COMPACT, true, nullptr));
+	model.Shutdown();
+	CHECK(!model.Load(deviceFilename.c_str(), VERTEX_FORMAT_FLOAT, true, nullptr));
+	model.Shutdown();
+	CHECK(!model.Load(deviceFilename.c_str(), VERTEX_FORMAT_COMPACT, false, nullptr));
+	model.Shutdown();
+
+	remove(deviceFilename.c_str());
+	remove(cookedFilename.c_str());
+	remove(OBJ_FILENAME);
+
+	return;
+}
+
+// a mesh loader thread is not one of the job system's, its parse has to be spread over the workers all the same.
+static void TestParallelImport()
+{
+	JobSystemClass jobSystem;
+	MeshImporterClass importer;
+	std::vector<MeshImporterClass::VertexType> vertices, parallelVertices;
+	std::vector<unsigned int> indices, parallelIndices;
+	std::thread loader;
+	std::atomic<int> ranOnLoader;
+	bool result;
+
+	// big enough for several chunks.
+	CHECK(SaveGrid(200));
+
+	CHECK(importer.Initialize(nullptr));
+	CHECK(importer.Import(OBJ_FILENAME, vertices, indices));
+	importer.Shutdown();
+
+	CHECK(jobSystem.Initialize(4));
+	result = false;
+	ranOnLoader = 0;
+	loader = std::thread([&]()
+	{
+		result = importer.Initialize(&jobSystem) && importer.Import(OBJ_FILENAME, parallelVertices, parallelIndices);
+		importer.Shutdown();
+
+		// none of it runs on the loader thread itself, that one only waits.
+		jobSystem.ParallelFor(64, 1, [&](int first, int last)
+		{
+			if(jobSystem.GetThreadIndex() < 0)
+			{
+				ranOnLoader += last - first;
+			}
+		});
+	});
+	loader.join();
+	jobSystem.Shutdown();
+
+	CHECK(result);
+	CHECK(ranOnLoader == 0);
+	CHECK(indices == parallelIndices);
+	CHECK(vertices.size() == parallelVertices.size() &&
+		memcmp(vertices.data(), parallelVertices.data(), vertices.size() * sizeof(MeshImporterClass::VertexType)) == 0);
+	CHECK(indices.size() == 200 * 200 * 6);
+
+	remove(OBJ_FILENAME);
+
+	return;
+}
+
+int main()
+{
+	TestSubsets();
+	TestCookedFormat();
+	TestParallelImport();
+
+	remove(MESH_FILENAME);
+
+	return s_failedChecks == 0 ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+#include "occlusioncullerclass.h"
+#include "check.h"
+
+#include <vector>
+
+// the same depth buffer the graphics class culls with.
+static const int DEPTH_WIDTH = 256;
+static const int DEPTH_HEIGHT = 128;
+
+// what the test expects of every object it adds.
+static const int EXPECT_HIDDEN = 0;
+static const int EXPECT_VISIBLE = 1;
+
+static void AddObject(SceneClass* scene, std::vector<int>& expected, float x, float y, float z, int expect)
+{
+	scene->AddObject(x, y, z, 1.0f);
+	expected.push_back(expect);
+	return;
+}
+
+/*
+ * a diamond shaped wall at z = 10 in the middle of the screen, where |x| + |y| < 7, and boxes of size 2 around it.
+ * the ones well behind the wall are hidden. the ones in front of it, beside it, in the corners of its bounding box,
+ * reaching past its edge or crossing the near plane are not.
+ */
+static void BuildScene(SceneClass* scene, std::vector<int>& expected)
+{
+	int x, y, z;
+
+	// several test ranges of hidden boxes, at least 3 units inside the wall's edge once projected onto it.
+	for(z = 40; z <= 90; z += 5)
+	{
+		for(y = -4; y <= 4; y++)
+		{
+			for(x = -10; x <= 10; x++)
+			{
+				AddObject(scene, expected, (float)x, (float)y, (float)z, EXPECT_HIDDEN);
+			}
+		}
+	}
+
+	for(x = -10; x <= 10; x += 2)
+	{
+		AddObject(scene, expected, (float)x, 0.0f, 5.0f, EXPECT_VISIBLE);
+		AddObject(scene, expected, (float)x, 0.0f, 0.0f, EXPECT_VISIBLE);
+	}
+
+	for(y = -10; y <= 10; y += 5)
+	{
+		AddObject(scene, expected, 40.0f, (float)y, 50.0f, EXPECT_VISIBLE);
+		AddObject(scene, expected, -40.0f, (float)y, 50.0f, EXPECT_VISIBLE);
+	}
+
+	for(y = -1; y <= 1; y += 2)
+	{
+		for(x = -1; x <= 1; x += 2)
+		{
+			AddObject(scene, expected, 30.0f * x, 12.0f * y, 50.0f, EXPECT_VISIBLE);
+			AddObject(scene, expected, 17.5f * x, 17.5f * y, 50.0f, EXPECT_VISIBLE);
+		}
+	}
+
+	scene->SetModelBounds(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+
+	return;
+}
+
+static int Cull(JobSystemClass* jobSystem, SceneClass* scene, float budget, std::vector<int>& objects, OcclusionCullerClass::StatisticsType& statistics)
+{
+	const XMFLOAT3 positions[4] = { XMFLOAT3(0.0f, -1.0f, 0.0f), XMFLOAT3(-1.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(1.0f, 0.0f, 0.0f) };
+	const unsigned int indices[6] = { 0, 1, 2, 0, 2, 3 };
+	OcclusionCullerClass culler;
+	XMMATRIX projectionMatrix, wallMatrix;
+	int i, count;
+
+	projectionMatrix = XMMatrixPerspectiveFovLH(XM_PIDIV4, 2.0f, 0.1f, 1000.0f);
+	wallMatrix = XMMatrixMultiply(XMMatrixScaling(7.0f, 7.0f, 1.0f), XMMatrixTranslation(0.0f, 0.0f, 10.0f));
+
+	CHECK(culler.Initialize(DEPTH_WIDTH, DEPTH_HEIGHT, jobSystem, budget));
+
+	objects.resize((size_t)scene->GetObjectCount());
+	for(i = 0; i < scene->GetObjectCount(); i++)
+	{
+		objects[i] = i;
+	}
+
+	culler.BeginFrame(XMMatrixIdentity(), projectionMatrix);
+	culler.AddOccluder(positions, 4, indices, 6, wallMatrix);
+	culler.RasterizeOccluders();
+	count = culler.CullObjects(scene, objects.data(), (int)objects.size());
+	culler.GetStatistics(statistics);
+
+	culler.Shutdown();
+
+	objects.resize((size_t)count);
+
+	return count;
+}
+
+int main()
+{
+	JobSystemClass jobSystem[2];
+	OcclusionCullerClass::StatisticsType statistics;
+	SceneClass scene;
+	std::vector<int> expected, objects[2];
+	int threads[2] = { 1, 4 };
+	int i, k, next, visible, hidden;
+
+	CHECK(scene.Initialize(4096));
+	BuildScene(&scene, expected);
+
+	visible = 0;
+	for(i = 0; i < (int)expected.size(); i++)
+	{
+		visible += expected[i] == EXPECT_VISIBLE ? 1 : 0;
+	}
+	hidden = (int)expected.size() - visible;
+
+	// every hidden box goes and every other one stays, in the order they came in, however many threads test them.
+	for(k = 0; k < 2; k++)
+	{
+		CHECK(jobSystem[k].Initialize(threads[k]));
+
+		CHECK(Cull(&jobSystem[k], &scene, 1000.0f, objects[k], statistics) == visible);
+		CHECK(statistics.triangles == 2);
+		CHECK(statistics.tested == (int)expected.size());
+		CHECK(statistics.occluded == hidden);
+		CHECK(statistics.untested == 0);
+
+		next = 0;
+		for(i = 0; i < (int)expected.size(); i++)
+		{
+			if(next < (int)objects[k].size() && objects[k][next] == i)
+			{
+				CHECK(expected[i] == EXPECT_VISIBLE);
+				next++;
+			} else
+			{
+				CHECK(expected[i] == EXPECT_HIDDEN);
+			}
+		}
+		CHECK(next == (int)objects[k].size());
+	}
+	CHECK(objects[0] == objects[1]);
+
+	// without any time to spend nothing is drawn and nothing is culled.
+	CHECK(Cull(&jobSystem[1], &scene, 0.0f, objects[1], statistics) == (int)expected.size());
+	CHECK(statistics.overBudget);
+	CHECK(statistics.occluded == 0);
+
+	for(k = 0; k < 2; k++)
+	{
+		jobSystem[k].Shutdown();
+	}
+	scene.Shutdown();
+
+	return s_failedChecks == 0 ? 0 : 1;
+}
@@ -0,0 +1,274 @@
+#include "rangeallocatorclass.h"
+#include "check.h"
+
+#include <cstring>
+#include <map>
+#include <vector>
+
+static void CheckStatistics(RangeAllocatorClass* allocator, unsigned int usedSize, unsigned int freeBlockCount, unsigned int largestFreeBlock)
+{
+	RangeAllocatorClass::StatisticsType statistics;
+
+	allocator->GetStatistics(statistics);
+	CHECK(statistics.usedSize == usedSize);
+	CHECK(statistics.freeSize == statistics.capacity - usedSize);
+	CHECK(statistics.freeBlockCount == freeBlockCount);
+	CHECK(statistics.largestFreeBlock == largestFreeBlock);
+
+	return;
+}
+
+static void TestBestFit()
+{
+	RangeAllocatorClass allocator;
+	unsigned int offsets[7], offset;
+	const unsigned int sizes[7] = { 5, 40, 10, 60, 10, 200, 675 };
+	int i;
+
+	// holes of 40 at 5, 60 at 55 and 200 at 125 between allocations that stay.
+	CHECK(allocator.Initialize(1000));
+	for(i = 0; i < 7; i++)
+	{
+		CHECK(allocator.Allocate(sizes[i], 1, offsets[i]));
+	}
+	CHECK(offsets[1] == 5 && offsets[3] == 55 && offsets[5] == 125);
+	CHECK(!allocator.Allocate(1, 1, offset));
+	allocator.Free(offsets[1]);
+	allocator.Free(offsets[3]);
+	allocator.Free(offsets[5]);
+	CheckStatistics(&allocator, 700, 3, 200);
+
+	// 36 bytes at a multiple of 12 would fit the 40 byte hole without its padding, with it the 60 byte one is the smallest that fits.
+	CHECK(allocator.Allocate(36, 12, offset));
+	CHECK(offset == 60);
+	CheckStatistics(&allocator, 736, 4, 200);
+
+	// an exact fit takes the whole hole and leaves nothing behind.
+	CHECK(allocator.Allocate(40, 1, offset));
+	CHECK(offset == 5);
+	CheckStatistics(&allocator, 776, 3, 200);
+
+	// a vertex stride, neither a power of two nor a divisor of the hole's offset.
+	CHECK(allocator.Allocate(56, 28, offset));
+	CHECK(offset == 140);
+	CHECK(offset % 28 == 0);
+	CheckStatistics(&allocator, 832, 4, 129);
+
+	// more than the largest hole fails and changes nothing.
+	CHECK(!allocator.Allocate(130, 1, offset));
+	CHECK(!allocator.Allocate(0, 1, offset));
+	CHECK(!allocator.Allocate(1, 0, offset));
+	CheckStatistics(&allocator, 832, 4, 129);
+
+	allocator.Shutdown();
+
+	return;
+}
+
+static void TestCoalesce()
+{
+	RangeAllocatorClass allocator;
+	unsigned int a, b, c, d;
+
+	CHECK(allocator.Initialize(400));
+	CHECK(allocator.Allocate(100, 1, a));
+	CHECK(allocator.Allocate(100, 1, b));
+	CHECK(allocator.Allocate(100, 1, c));
+	CHECK(allocator.Allocate(100, 1, d));
+
+	// freeing the middle one last merges it with the blocks on both sides, the one behind them is untouched.
+	allocator.Free(a);
+	allocator.Free(c);
+	CheckStatistics(&allocator, 200, 2, 100);
+	allocator.Free(b);
+	CheckStatistics(&allocator, 100, 1, 300);
+
+	// freeing twice or something never allocated does nothing.
+	allocator.Free(b);
+	allocator.Free(7);
+	CheckStatistics(&allocator, 100, 1, 300);
+
+	// the merged block is whole again.
+	CHECK(allocator.Allocate(300, 1, a));
+	CHECK(a == 0);
+	allocator.Free(d);
+	CheckStatistics(&allocator, 300, 1, 100);
+
+	// a block freed after the one in front of it merges backwards.
+	allocator.Free(a);
+	CheckStatistics(&allocator, 0, 1, 400);
+
+	allocator.Shutdown();
+
+	return;
+}
+
+static void TestGrow()
+{
+	RangeAllocatorClass allocator;
+	unsigned int a, b;
+
+	// the free tail is extended instead of a second block being added after it.
+	CHECK(allocator.Initialize(100));
+	CHECK(allocator.Allocate(60, 1, a));
+	allocator.Grow(200);
+	CHECK(allocator.GetCapacity() == 200);
+	CheckStatistics(&allocator, 60, 1, 140);
+	CHECK(allocator.Allocate(140, 1, b));
+	CHECK(b == 60);
+
+	// with the end allocated the new space is a block of its own.
+	allocator.Grow(250);
+	CheckStatistics(&allocator, 200, 1, 50);
+
+	// smaller is ignored.
+	allocator.Grow(150);
+	CHECK(allocator.GetCapacity() == 250);
+
+	// a hole in front of the allocated end stays separate.
+	allocator.Free(a);
+	allocator.Grow(300);
+	CheckStatistics(&allocator, 140, 2, 100);
+
+	allocator.Shutdown();
+
+	return;
+}
+
+static void TestDefragment()
+{
+	RangeAllocatorClass allocator;
+	RangeAllocatorClass::StatisticsType statistics;
+	std::vector<RangeAllocatorClass::MoveType> moves;
+	std::vector<unsigned char> memory;
+	std::map<unsigned int, unsigned int> owners;
+	std::map<unsigned int, unsigned int>::iterator owner;
+	unsigned int x, y, z, w, offset, i, k;
+	bool intact;
+
+	CHECK(allocator.Initialize(1000));
+	CHECK(allocator.Allocate(10, 1, x));
+	CHECK(allocator.Allocate(20, 1, y));
+	CHECK(allocator.Allocate(28, 28, z));
+	CHECK(allocator.Allocate(12, 4, w));
+	CHECK(x == 0 && y == 10 && z == 56 && w == 32);
+
+	// every byte of an allocation holds its offset's low byte, the moves have to carry that along.
+	memory.assign(1000, 0);
+	owners[x] = 10;
+	owners[z] = 28;
+	owners[w] = 12;
+	for(owner = owners.begin(); owner != owners.end(); ++owner)
+	{
+		memset(&memory[owner->first], (int)(owner->first & 0xFF) + 1, owner->second);
+	}
+
+	allocator.Free(y);
+	allocator.Defragment(moves);
+
+	// w packs to the next multiple of 4 behind x, z to the next multiple of 28 behind w, the padding in front of both stays free.
+	CHECK(moves.size() == 2);
+	if(moves.size() == 2)
+	{
+		CHECK(moves[0].sourceOffset == w && moves[0].destinationOffset == 12 && moves[0].size == 12);
+		CHECK(moves[1].sourceOffset == z && moves[1].destinationOffset == 28 && moves[1].size == 28);
+	}
+
+	for(i = 0; i < moves.size(); i++)
+	{
+		CHECK(moves[i].destinationOffset <= moves[i].sourceOffset);
+		memmove(&memory[moves[i].destinationOffset], &memory[moves[i].sourceOffset], moves[i].size);
+	}
+
+	intact = memory[0] == 1;
+	for(k = 0; k < 12; k++)
+	{
+		intact = intact && memory[12 + k] == (unsigned char)((w & 0xFF) + 1);
+	}
+	for(k = 0; k < 28; k++)
+	{
+		intact = intact && memory[28 + k] == (unsigned char)((z & 0xFF) + 1);
+	}
+	CHECK(intact);
+
+	// the padding at 10 and 24 and everything after 56.
+	allocator.GetStatistics(statistics);
+	CHECK(statistics.usedSize == 50);
+	CHECK(statistics.allocationCount == 3);
+	CHECK(statistics.freeBlockCount == 3);
+	CHECK(statistics.largestFreeBlock == 944);
+
+	// the allocations are known at their new offsets.
+	allocator.Free(12);
+	allocator.Free(28);
+	allocator.Free(0);
+	CheckStatistics(&allocator, 0, 1, 1000);
+
+	// packed already, nothing moves.
+	CHECK(allocator.Allocate(100, 1, offset));
+	allocator.Defragment(moves);
+	CHECK(moves.empty());
+
+	allocator.Shutdown();
+
+	return;
+}
+
+static void TestFragmentation()
+{
+	RangeAllocatorClass allocator;
+	RangeAllocatorClass::StatisticsType statistics;
+	unsigned int offsets[10];
+	int i;
+
+	CHECK(allocator.Initialize(100));
+	allocator.GetStatistics(statistics);
+	CHECK(statistics.fragmentation == 0.0f);
+
+	// full, there is no free space to be fragmented.
+	for(i = 0; i < 10; i++)
+	{
+		CHECK(allocator.Allocate(10, 1, offsets[i]));
+	}
+	allocator.GetStatistics(statistics);
+	CHECK(statistics.freeSize == 0);
+	CHECK(statistics.fragmentation == 0.0f);
+
+	// every other block free, the largest is a fifth of the free space.
+	for(i = 0; i < 10; i += 2)
+	{
+		allocator.Free(offsets[i]);
+	}
+	allocator.GetStatistics(statistics);
+	CHECK(statistics.freeBlockCount == 5);
+	CHECK(statistics.fragmentation > 0.79f && statistics.fragmentation < 0.81f);
+
+	// the first three merge, 30 out of 60.
+	allocator.Free(offsets[1]);
+	allocator.GetStatistics(statistics);
+	CHECK(statistics.freeBlockCount == 4);
+	CHECK(statistics.fragmentation > 0.49f && statistics.fragmentation < 0.51f);
+
+	for(i = 3; i < 10; i += 2)
+	{
+		allocator.Free(offsets[i]);
+	}
+	allocator.GetStatistics(statistics);
+	CHECK(statistics.freeBlockCount == 1);
+	CHECK(statistics.fragmentation == 0.0f);
+
+	allocator.Shutdown();
+
+	return;
+}
+
+int main()
+{
+	TestBestFit();
+	TestCoalesce();
+	TestGrow();
+	TestDefragment();
+	TestFragmentation();
+
+	return s_failedChecks == 0 ? 0 : 1;
+}
@@ -0,0 +1,409 @@
+#include "shadercacheclass.h"
+#include "check.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// the files live next to the test, in whatever directory it runs in.
+static const char* SOURCE_FILENAME = "shadercachetest.hlsl";
+static const char* INCLUDE_FILENAME = "shadercachetest.hlsli";
+static const char* NESTED_FILENAME = "shadercachetest_nested.hlsli";
+static const char* CACHE_FILENAME = "shadercachetest.cache";
+static const char* TEMPORARY_FILENAME = "shadercachetest.cache.tmp";
+
+static const char* SOURCE = "#include \"shadercachetest.hlsli\"\nfloat4 main(float4 position : POSITION) : SV_POSITION { return position * scale; }\n";
+
+/*
+ * stands in for d3dcompiler. the bytecode is the source and the options it was compiled with, so a hit handing out the wrong shader
+ * shows up as different bytes, and every call is counted so a hit that still compiled shows up too.
+ */
+class StubCompilerClass : public ShaderCompilerClass
+{
+public:
+	StubCompilerClass()
+	{
+		m_compileCount = 0;
+	}
+
+	const char* GetName()
+	{
+		return "stub 1";
+	}
+
+	bool Compile(const char* source, unsigned long long sourceSize, const char*, const char* const* defines, int defineCount, const char* entryPoint,
+		const char* profile, unsigned int flags, std::vector<unsigned char>& bytecode, ShaderReflectionType& reflection, std::string& errors)
+	{
+		ShaderConstantBufferType constantBuffer;
+		std::string output;
+		int i;
+
+		m_compileCount++;
+
+		if(strcmp(entryPoint, "broken") == 0)
+		{
+			errors = "error X3501: 'broken': entrypoint not found";
+			return false;
+		}
+
+		output.assign(source, (size_t)sourceSize);
+		for(i = 0; i < defineCount; i++)
+		{
+			output += std::string(" ") + defines[i];
+		}
+		output += std::string(" ") + entryPoint + " " + profile + " " + std::to_string(flags);
+		bytecode.assign(output.begin(), output.end());
+
+		memset(&constantBuffer, 0, sizeof(constantBuffer));
+		strcpy(constantBuffer.name, "MatrixBuffer");
+		constantBuffer.slot = 0;
+		constantBuffer.size = 64 + flags;
+		reflection.constantBuffers.assign(1, constantBuffer);
+		reflection.inputs.clear();
+		reflection.resources.clear();
+
+		return true;
+	}
+
+	int m_compileCount;
+};
+
+static void WriteText(const char* filename, const std::string& text)
+{
+	FILE* file;
+
+	file = fopen(filename, "wb");
+	if(!file)
+	{
+		return;
+	}
+
+	fwrite(text.data(), text.size(), 1, file);
+	fclose(file);
+
+	return;
+}
+
+static std::string ReadText(const char* filename)
+{
+	std::string text;
+	FILE* file;
+	char buffer[4096];
+	size_t count;
+
+	file = fopen(filename, "rb");
+	if(!file)
+	{
+		return text;
+	}
+
+	while((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		text.append(buffer, count);
+	}
+	fclose(file);
+
+	return text;
+}
+
+static bool FileExists(const char* filename)
+{
+	FILE* file;
+
+	file = fopen(filename, "rb");
+	if(!file)
+	{
+		return false;
+	}
+
+	fclose(file);
+
+	return true;
+}
+
+static void WriteSources()
+{
+	WriteText(SOURCE_FILENAME, SOURCE);
+	WriteText(INCLUDE_FILENAME, "#include \"shadercachetest_nested.hlsli\"\ncbuffer MatrixBuffer { float4 scale; };\n");
+	WriteText(NESTED_FILENAME, "#define ONE 1\n");
+
+	return;
+}
+
+static bool GetShader(ShaderCacheClass* cache, const char* entryPoint, const char* profile, unsigned int flags, ShaderCacheClass::ShaderType& shader)
+{
+	std::string errors;
+
+	return cache->GetShader(SOURCE_FILENAME, nullptr, 0, entryPoint, profile, flags, shader, errors);
+}
+
+static std::string Bytecode(const ShaderCacheClass::ShaderType& shader)
+{
+	return std::string((const char*)shader.bytecode, (size_t)shader.bytecodeSize);
+}
+
+static void TestMissThenHit()
+{
+	ShaderCacheClass cache;
+	StubCompilerClass compiler;
+	ShaderCacheClass::ShaderType shader;
+	ShaderCacheClass::StatisticsType statistics;
+	std::string bytecode;
+
+	remove(CACHE_FILENAME);
+	WriteSources();
+
+	CHECK(cache.Initialize(CACHE_FILENAME, &compiler));
+	CHECK(GetShader(&cache, "main", "vs_5_0", 0, shader));
+	CHECK(!shader.cacheHit);
+	CHECK(compiler.m_compileCount == 1);
+	bytecode = Bytecode(shader);
+
+	// compiled but not saved yet, the copy in memory is handed out.
+	CHECK(GetShader(&cache, "main", "vs_5_0", 0, shader));
+	CHECK(shader.cacheHit);
+	CHECK(compiler.m_compileCount == 1);
+	CHECK(Bytecode(shader) == bytecode);
+
+	cache.GetStatistics(statistics);
+	CHECK(statistics.misses == 1 && statistics.hits == 1 && statistics.failures == 0 && statistics.entries == 1);
+
+	// a failed compile is counted and not cached.
+	CHECK(!GetShader(&cache, "broken", "vs_5_0", 0, shader));
+	CHECK(!GetShader(&cache, "broken", "vs_5_0", 0, shader));
+	CHECK(compiler.m_compileCount == 3);
+	cache.Shutdown();
+
+	// the next run finds it in the file and never calls the compiler.
+	compiler.m_compileCount = 0;
+	CHECK(cache.Initialize(CACHE_FILENAME, &compiler));
+	CHECK(GetShader(&cache, "main", "vs_5_0", 0, shader));
+	CHECK(shader.cacheHit);
+	CHECK(compiler.m_compileCount == 0);
+	CHECK(Bytecode(shader) == bytecode);
+	CHECK(shader.reflection.constantBuffers.size() == 1 && strcmp(shader.reflection.constantBuffers[0].name, "MatrixBuffer") == 0);
+	CHECK(shader.reflection.inputs.empty() && shader.reflection.resources.empty());
+
+	cache.GetStatistics(statistics);
+	CHECK(statistics.misses == 0 && statistics.hits == 1 && statistics.entries == 1);
+	cache.Shutdown();
+
+	// without a compiler there is no key, even for a shader that is in the file.
+	CHECK(cache.Initialize(CACHE_FILENAME, nullptr));
+	CHECK(!GetShader(&cache, "main", "vs_5_0", 0, shader));
+	cache.Shutdown();
+
+	return;
+}
+
+static void TestKey()
+{
+	ShaderCacheClass cache;
+	StubCompilerClass compiler;
+	ShaderCacheClass::ShaderType shader;
+	const char* defines[2] = { "SKINNED", "INSTANCED" };
+	const char* swapped[2] = { "INSTANCED", "SKINNED" };
+	std::string errors;
+	int count;
+
+	remove(CACHE_FILENAME);
+	WriteSources();
+
+	CHECK(cache.Initialize(CACHE_FILENAME, &compiler));
+	CHECK(GetShader(&cache, "main", "vs_5_0", 0, shader));
+	CHECK(cache.Save());
+	CHECK(compiler.m_compileCount == 1);
+
+	// every part of the key on its own is a miss.
+	CHECK(GetShader(&cache, "other", "vs_5_0", 0, shader) && !shader.cacheHit);
+	CHECK(compiler.m_compileCount == 2);
+	CHECK(GetShader(&cache, "main", "vs_4_0", 0, shader) && !shader.cacheHit);
+	CHECK(compiler.m_compileCount == 3);
+	CHECK(GetShader(&cache, "main", "vs_5_0", 1, shader) && !shader.cacheHit);
+	CHECK(compiler.m_compileCount == 4);
+	CHECK(cache.GetShader(SOURCE_FILENAME, defines, 2, "main", "vs_5_0", 0, shader, errors) && !shader.cacheHit);
+	CHECK(cache.GetShader(SOURCE_FILENAME, swapped, 2, "main", "vs_5_0", 0, shader, errors) && !shader.cacheHit);
+	CHECK(cache.GetShader(SOURCE_FILENAME, defines, 1, "main", "vs_5_0", 0, shader, errors) && !shader.cacheHit);
+	CHECK(compiler.m_compileCount == 7);
+
+	// so is editing the include, or what the include includes, the source itself is unchanged.
+	WriteText(INCLUDE_FILENAME, "#include \"shadercachetest_nested.hlsli\"\ncbuffer MatrixBuffer { float4 scale; float4 bias; };\n");
+	CHECK(GetShader(&cache, "main", "vs_5_0", 0, shader) && !shader.cacheHit);
+	CHECK(compiler.m_compileCount == 8);
+	WriteText(NESTED_FILENAME, "#define ONE 2\n");
+	CHECK(GetShader(&cache, "main", "vs_5_0", 0, shader) && !shader.cacheHit);
+	CHECK(compiler.m_compileCount == 9);
+
+	// putting everything back finds the first entry again, and nothing that was compiled since is compiled twice.
+	count = compiler.m_compileCount;
+	WriteSources();
+	CHECK(GetShader(&cache, "main", "vs_5_0", 0, shader) && shader.cacheHit);
+	CHECK(GetShader(&cache, "other", "vs_5_0", 0, shader) && shader.cacheHit);
+	CHECK(GetShader(&cache, "main", "vs_4_0", 0, shader) && shader.cacheHit);
+	CHECK(GetShader(&cache, "main", "vs_5_0", 1, shader) && shader.cacheHit);
+	CHECK(cache.GetShader(SOURCE_FILENAME, swapped, 2, "main", "vs_5_0", 0, shader, errors) && shader.cacheHit);
+	CHECK(compiler.m_compileCount == count);
+
+	cache.Shutdown();
+
+	return;
+}
+
+static void CheckRewritten(const char* what)
+{
+	ShaderCacheClass cache;
+	StubCompilerClass compiler;
+	ShaderCacheClass::ShaderType shader;
+	std::string contents;
+	unsigned int version;
+
+	// the broken file is ignored rather than failing the cache, the shader is compiled and the file written over.
+	CHECK(cache.Initialize(CACHE_FILENAME, &compiler));
+	CHECK(GetShader(&cache, "main", "vs_5_0", 0, shader));
+	CHECK(!shader.cacheHit);
+	CHECK(compiler.m_compileCount == 1);
+	cache.Shutdown();
+
+	contents = ReadText(CACHE_FILENAME);
+	CHECK(contents.size() > 8 && contents.compare(0, 4, "DXSC") == 0);
+	if(contents.size() > 8)
+	{
+		memcpy(&version, &contents[4], sizeof(version));
+		CHECK(version == SHADER_CACHE_VERSION);
+	}
+
+	CHECK(cache.Initialize(CACHE_FILENAME, &compiler));
+	CHECK(GetShader(&cache, "main", "vs_5_0", 0, shader));
+	if(!shader.cacheHit)
+	{
+		fprintf(stderr, "not rewritten after %s\n", what);
+	}
+	CHECK(shader.cacheHit);
+	CHECK(compiler.m_compileCount == 1);
+	cache.Shutdown();
+
+	return;
+}
+
+static void TestBrokenFile()
+{
+	ShaderCacheClass cache;
+	StubCompilerClass compiler;
+	ShaderCacheClass::ShaderType shader;
+	std::string contents;
+	unsigned int version;
+
+	WriteSources();
+
+	WriteText(CACHE_FILENAME, "this is not a shader cache, but it is long enough to have a header");
+	CheckRewritten("garbage");
+
+	WriteText(CACHE_FILENAME, "");
+	CheckRewritten("an empty file");
+
+	// a valid file of the previous version.
+	contents = ReadText(CACHE_FILENAME);
+	version = SHADER_CACHE_VERSION - 1;
+	memcpy(&contents[4], &version, sizeof(version));
+	WriteText(CACHE_FILENAME, contents);
+	CheckRewritten("an old version");
+
+	// cut off in the middle of the index.
+	contents = ReadText(CACHE_FILENAME);
+	WriteText(CACHE_FILENAME, contents.substr(0, contents.size() - 8));
+	CheckRewritten("a truncated index");
+
+	// the only entry's bytecode offset pointing far past the end of the file.
+	contents = ReadText(CACHE_FILENAME);
+	contents[contents.size() - 25] = (char)0x7F;
+	WriteText(CACHE_FILENAME, contents);
+	CheckRewritten("a bad offset");
+
+	return;
+}
+
+static void TestSave()
+{
+	ShaderCacheClass cache;
+	StubCompilerClass compiler;
+	ShaderCacheClass::ShaderType shader;
+	ShaderCacheClass::StatisticsType statistics;
+	std::string saved;
+	int result;
+
+	remove(CACHE_FILENAME);
+	remove(TEMPORARY_FILENAME);
+	WriteSources();
+
+	// nothing compiled, nothing written.
+	CHECK(cache.Initialize(CACHE_FILENAME, &compiler));
+	CHECK(cache.Save());
+	CHECK(!FileExists(CACHE_FILENAME));
+
+	// the file is written under the temporary name and moved over the real one, nothing is left behind.
+	CHECK(GetShader(&cache, "main", "vs_5_0", 0, shader));
+	CHECK(cache.Save());
+	CHECK(FileExists(CACHE_FILENAME));
+	CHECK(!FileExists(TEMPORARY_FILENAME));
+	saved = ReadText(CACHE_FILENAME);
+
+	// the saved shader is handed out of the new mapping.
+	CHECK(GetShader(&cache, "main", "vs_5_0", 0, shader) && shader.cacheHit);
+
+	// when the temporary file can not be written the cache file is left as it was and the shader stays pending for the next try.
+#ifdef _WIN32
+	result = _mkdir(TEMPORARY_FILENAME);
+#else
+	result = mkdir(TEMPORARY_FILENAME, 0755);
+#endif
+	CHECK(result == 0);
+	CHECK(GetShader(&cache, "other", "vs_5_0", 0, shader) && !shader.cacheHit);
+	CHECK(!cache.Save());
+	CHECK(ReadText(CACHE_FILENAME) == saved);
+	cache.GetStatistics(statistics);
+	CHECK(statistics.entries == 2);
+	CHECK(GetShader(&cache, "main", "vs_5_0", 0, shader) && shader.cacheHit);
+
+#ifdef _WIN32
+	_rmdir(TEMPORARY_FILENAME);
+#else
+	rmdir(TEMPORARY_FILENAME);
+#endif
+	CHECK(cache.Save());
+	CHECK(!FileExists(TEMPORARY_FILENAME));
+	CHECK(ReadText(CACHE_FILENAME).size() > saved.size());
+	cache.Shutdown();
+
+	// both are in the file now.
+	compiler.m_compileCount = 0;
+	CHECK(cache.Initialize(CACHE_FILENAME, &compiler));
+	CHECK(GetShader(&cache, "main", "vs_5_0", 0, shader) && shader.cacheHit);
+	CHECK(GetShader(&cache, "other", "vs_5_0", 0, shader) && shader.cacheHit);
+	CHECK(compiler.m_compileCount == 0);
+	cache.Shutdown();
+
+	return;
+}
+
+int main()
+{
+	TestMissThenHit();
+	TestKey();
+	TestBrokenFile();
+	TestSave();
+
+	remove(SOURCE_FILENAME);
+	remove(INCLUDE_FILENAME);
+	remove(NESTED_FILENAME);
+	remove(CACHE_FILENAME);
+
+	return s_failedChecks == 0 ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+#include "vertexformatclass.h"
+#include "check.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+// ModelClass::VertexType, what Encode reads.
+struct VertexType
+{
+	float position[3];
+	float color[4];
+};
+
+// float bit patterns are sampled this far apart, an odd step so every exponent and mantissa pattern turns up.
+static const unsigned int SAMPLE_STEP = 4099;
+
+static float FromBits(unsigned int bits)
+{
+	float value;
+
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+// round to nearest even, one value at a time.
+static unsigned short ReferenceHalf(float value)
+{
+	unsigned int bits, sign, exponent, mantissa, rest, half;
+
+	memcpy(&bits, &value, sizeof(bits));
+	sign = (bits >> 16) & 0x8000;
+	bits &= 0x7FFFFFFF;
+
+	if(bits > 0x7F800000)
+	{
+		return (unsigned short)(sign | 0x7E00);
+	}
+
+	// 65536 and up is past even the values that round to infinity.
+	if(bits >= 0x47800000)
+	{
+		return (unsigned short)(sign | 0x7C00);
+	}
+
+	// below the smallest normal half the value is a multiple of 2^-24, exact in a double.
+	if(bits < 0x38800000)
+	{
+		return (unsigned short)(sign | (unsigned int)nearbyint((double)FromBits(bits) * 16777216.0));
+	}
+
+	exponent = (bits >> 23) - 127 + 15;
+	mantissa = bits & 0x7FFFFF;
+	half = (exponent << 10) | (mantissa >> 13);
+	rest = mantissa & 0x1FFF;
+	if(rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+	{
+		half++;
+	}
+
+	return (unsigned short)(sign | half);
+}
+
+static bool SameHalf(unsigned short half, unsigned short reference)
+{
+	// nan only has to stay a nan, F16C keeps the payload where the SSE2 path does not.
+	if((reference & 0x7FFF) > 0x7C00)
+	{
+		return (half & 0x7FFF) > 0x7C00;
+	}
+
+	return half == reference;
+}
+
+int main()
+{
+	const float edges[] = { 0.0f, -0.0f, 1.0f, -1.0f, 65504.0f, 65519.0f, 65520.0f, 65536.0f, 6.103515625e-05f, 5.9604644775390625e-08f,
+		2.98023223876953125e-08f, 8.940696716308594e-08f, 1.00048828125f, 1.000732421875f, 1.0009765625f, 1.001220703125f,
+		std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(), std::numeric_limits<float>::quiet_NaN(),
+		std::numeric_limits<float>::denorm_min(), std::numeric_limits<float>::max() };
+	std::vector<float> values;
+	std::vector<VertexType> vertices;
+	std::vector<unsigned short> output;
+	XMMATRIX dequantizeMatrix;
+	unsigned long long bits;
+	unsigned int format, stride, i, k, mismatches;
+
+	values.assign(edges, edges + sizeof(edges) / sizeof(edges[0]));
+	for(bits = 0; bits <= 0xFFFFFFFFull; bits += SAMPLE_STEP)
+	{
+		values.push_back(FromBits((unsigned int)bits));
+	}
+	while(values.size() % 7 != 0)
+	{
+		values.push_back(0.5f);
+	}
+
+	// seven values per vertex, three in the position and four in the color.
+	vertices.resize(values.size() / 7);
+	for(i = 0; i < vertices.size(); i++)
+	{
+		memcpy(vertices[i].position, &values[i * 7], sizeof(vertices[i].position));
+		memcpy(vertices[i].color, &values[i * 7 + 3], sizeof(vertices[i].color));
+	}
+
+	format = VERTEX_FORMAT_POSITION_HALF | VERTEX_FORMAT_COLOR_HALF;
+	CHECK(VertexFormatClass::IsValid(format));
+	stride = VertexFormatClass::GetStride(format);
+	CHECK(stride == 16);
+
+	output.assign(vertices.size() * stride / sizeof(unsigned short), 0xFFFF);
+	CHECK(VertexFormatClass::Encode(format, vertices.data(), sizeof(VertexType), (unsigned int)vertices.size(), output.data(), dequantizeMatrix));
+
+	// the position's fourth half is padding and comes out as zero.
+	mismatches = 0;
+	for(i = 0; i < vertices.size(); i++)
+	{
+		for(k = 0; k < 3; k++)
+		{
+			mismatches += SameHalf(output[i * 8 + k], ReferenceHalf(vertices[i].position[k])) ? 0 : 1;
+		}
+		mismatches += output[i * 8 + 3] == 0 ? 0 : 1;
+
+		for(k = 0; k < 4; k++)
+		{
+			mismatches += SameHalf(output[i * 8 + 4 + k], ReferenceHalf(vertices[i].color[k])) ? 0 : 1;
+		}
+	}
+	CHECK(mismatches == 0);
+
+	return s_failedChecks == 0 ? 0 : 1;
+}